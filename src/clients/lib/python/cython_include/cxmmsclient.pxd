@@ -144,6 +144,13 @@ cdef extern from "xmmsclient/xmmsclient.h":
 	xmmsc_result_t *xmmsc_playback_status       (xmmsc_connection_t *c)
 	xmmsc_result_t *xmmsc_playback_volume_set   (xmmsc_connection_t *c, char *channel, int volume)
 	xmmsc_result_t *xmmsc_playback_volume_get   (xmmsc_connection_t *c)
+	xmmsc_result_t *xmmsc_playback_underruns    (xmmsc_connection_t *c)
+	xmmsc_result_t *xmmsc_playback_buffer_stats (xmmsc_connection_t *c)
+	xmmsc_result_t *xmmsc_playback_chain_stats  (xmmsc_connection_t *c)
+	xmmsc_result_t *xmmsc_playback_zone_list    (xmmsc_connection_t *c)
+	xmmsc_result_t *xmmsc_playback_sink_list    (xmmsc_connection_t *c)
+	xmmsc_result_t *xmmsc_playback_zone_start   (xmmsc_connection_t *c, char *zone)
+	xmmsc_result_t *xmmsc_playback_zone_stop    (xmmsc_connection_t *c, char *zone)
 
 	xmmsc_result_t *xmmsc_broadcast_playback_volume_changed (xmmsc_connection_t *c)
 	xmmsc_result_t *xmmsc_broadcast_playback_status         (xmmsc_connection_t *c)
@@ -206,6 +213,7 @@ cdef extern from "xmmsclient/xmmsclient.h":
 
 	xmmsc_result_t *xmmsc_xform_media_browse         (xmmsc_connection_t *c, char *url)
 	xmmsc_result_t *xmmsc_xform_media_browse_encoded (xmmsc_connection_t *c, char *url)
+	xmmsc_result_t *xmmsc_xform_effect_stats         (xmmsc_connection_t *c)
 
 	xmmsc_result_t *xmmsc_bindata_add      (xmmsc_connection_t *c, unsigned char *data, int len)
 	xmmsc_result_t *xmmsc_bindata_retrieve (xmmsc_connection_t *c, char *hash)
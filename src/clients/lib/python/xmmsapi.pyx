@@ -1201,6 +1201,68 @@ cdef class XmmsApi(XmmsCore):
 		"""
 		return self.create_result(cb, xmmsc_playback_volume_get(self.conn))
 
+	cpdef XmmsResult playback_underruns(self, cb = None):
+		"""
+		Get the number of output buffer underruns and when the most
+		recent ones happened.
+
+		:return: The result of the operation.
+		"""
+		return self.create_result(cb, xmmsc_playback_underruns(self.conn))
+
+	cpdef XmmsResult playback_buffer_stats(self, cb = None):
+		"""
+		Get the output buffer size, how often it was resized, and
+		seek counts and latencies.
+
+		:return: The result of the operation.
+		"""
+		return self.create_result(cb, xmmsc_playback_buffer_stats(self.conn))
+
+	cpdef XmmsResult playback_chain_stats(self, cb = None):
+		"""
+		Get profiling statistics for the chain currently being played.
+
+		:return: The result of the operation.
+		"""
+		return self.create_result(cb, xmmsc_playback_chain_stats(self.conn))
+
+	cpdef XmmsResult playback_zone_list(self, cb = None):
+		"""
+		List the output zones with their playlist, plugin and state.
+
+		:return: The result of the operation.
+		"""
+		return self.create_result(cb, xmmsc_playback_zone_list(self.conn))
+
+	cpdef XmmsResult playback_sink_list(self, cb = None):
+		"""
+		List the output sinks with their plugin, buffer and drop counts.
+
+		:return: The result of the operation.
+		"""
+		return self.create_result(cb, xmmsc_playback_sink_list(self.conn))
+
+	cpdef XmmsResult playback_zone_start(self, zone, cb = None):
+		"""
+		Start playback in an output zone.
+
+		:param zone: The name of the zone.
+		:return: The result of the operation.
+		"""
+		z = from_unicode(zone)
+		return self.create_result(cb, xmmsc_playback_zone_start(self.conn, z))
+
+	cpdef XmmsResult playback_zone_stop(self, zone, cb = None):
+		"""
+		Stop playback in an output zone.
+
+		:param zone: The name of the zone.
+		:return: The result of the operation.
+		"""
+		z = from_unicode(zone)
+		return self.create_result(cb, xmmsc_playback_zone_stop(self.conn, z))
+
 	cpdef XmmsResult broadcast_playback_volume_changed(self, cb = None):
 		"""
 		Set a broadcast callback for volume updates
@@ -1783,6 +1845,15 @@ cdef class XmmsApi(XmmsCore):
 		"""
 		return self.xform_media_browse(url, cb = cb, encoded = True)
 
+	cpdef XmmsResult xform_effect_stats(self, cb = None):
+		"""
+		Get the processing time spent in each configured effect while
+		output.profile was enabled.
+
+		:return: The result of the operation.
+		"""
+		return self.create_result(cb, xmmsc_xform_effect_stats(self.conn))
+
 	cpdef XmmsResult coll_get(self, name, ns = "Collections", cb = None):
 		"""
 		Retrieve a Collection
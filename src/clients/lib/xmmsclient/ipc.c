@@ -108,11 +108,20 @@ xmmsc_ipc_io_out_callback (xmmsc_ipc_t *ipc)
 	x_return_val_if_fail (!ipc->disconnect, false);
 
 	while (!x_queue_is_empty (ipc->out_msg)) {
-		xmms_ipc_msg_t *msg = x_queue_peek_head (ipc->out_msg);
-		if (xmms_ipc_msg_write_transport (msg, ipc->transport, &disco)) {
+		xmms_ipc_msg_t *msg = x_queue_pop_head (ipc->out_msg);
+		xmms_ipc_msg_t *next;
+
+		/* Pipeline everything queued so far into one write */
+		while ((next = x_queue_peek_head (ipc->out_msg)) &&
+		       xmms_ipc_msg_append (msg, next)) {
 			x_queue_pop_head (ipc->out_msg);
+			xmms_ipc_msg_destroy (next);
+		}
+
+		if (xmms_ipc_msg_write_transport (msg, ipc->transport, &disco)) {
 			xmms_ipc_msg_destroy (msg);
 		} else {
+			x_queue_push_head (ipc->out_msg, msg);
 			break;
 		}
 	}
@@ -233,6 +233,124 @@ xmmsc_playback_volume_get (xmmsc_connection_t *c)
 	                              XMMS_IPC_COMMAND_PLAYBACK_VOLUME_GET);
 }
 
+/**
+ * Get the number of output buffer underruns.
+ *
+ * Returns a dict with the total "count" and the "times" of the most
+ * recent underruns in microseconds since the epoch, oldest first.
+ */
+xmmsc_result_t *
+xmmsc_playback_underruns (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_msg_no_arg (c, XMMS_IPC_OBJECT_PLAYBACK,
+	                              XMMS_IPC_COMMAND_PLAYBACK_UNDERRUNS);
+}
+
+/**
+ * Get statistics about the output buffer and seeking.
+ *
+ * Returns a dict where "buffer_size" is the current output buffer size
+ * in bytes, and "buffer_grows" and "buffer_shrinks" count how often the
+ * adaptive buffer sizing changed it. "seeks" and "seeks_buffered" count
+ * the seeks and those served from the output buffer, and
+ * "seek_latency_last" and "seek_latency_max" give how long it took
+ * until playback resumed, in microseconds.
+ */
+xmmsc_result_t *
+xmmsc_playback_buffer_stats (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_msg_no_arg (c, XMMS_IPC_OBJECT_PLAYBACK,
+	                              XMMS_IPC_COMMAND_PLAYBACK_BUFFER_STATS);
+}
+
+/**
+ * Get profiling statistics for the chain currently being played.
+ *
+ * Returns a dict with the per xform statistics in "chain" and the time
+ * the output filler waited for buffer space. The server only collects
+ * them while the output.profile config value is set.
+ */
+xmmsc_result_t *
+xmmsc_playback_chain_stats (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_msg_no_arg (c, XMMS_IPC_OBJECT_PLAYBACK,
+	                              XMMS_IPC_COMMAND_PLAYBACK_CHAIN_STATS);
+}
+
+/**
+ * List the output zones and their state.
+ *
+ * Returns a list with a dict per zone, holding its name, the playlist
+ * and output plugin it uses, its playback status, playtime, current id
+ * and underrun count.
+ */
+xmmsc_result_t *
+xmmsc_playback_zone_list (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_msg_no_arg (c, XMMS_IPC_OBJECT_PLAYBACK,
+	                              XMMS_IPC_COMMAND_PLAYBACK_ZONE_LIST);
+}
+
+/**
+ * List the output sinks and their state.
+ *
+ * Returns a list with a dict per sink, holding its name, output plugin,
+ * playback status, buffer size and fill level, the number of bytes it
+ * dropped because its buffer was full and its underrun count.
+ */
+xmmsc_result_t *
+xmmsc_playback_sink_list (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_msg_no_arg (c, XMMS_IPC_OBJECT_PLAYBACK,
+	                              XMMS_IPC_COMMAND_PLAYBACK_SINK_LIST);
+}
+
+/**
+ * Start playback in an output zone.
+ *
+ * @param c The connection structure.
+ * @param zone The name of the zone, as listed in output.zones.
+ */
+xmmsc_result_t *
+xmmsc_playback_zone_start (xmmsc_connection_t *c, const char *zone)
+{
+	x_check_conn (c, NULL);
+	x_api_error_if (!zone, "with a NULL zone", NULL);
+
+	return xmmsc_send_cmd (c, XMMS_IPC_OBJECT_PLAYBACK,
+	                       XMMS_IPC_COMMAND_PLAYBACK_ZONE_START,
+	                       XMMSV_LIST_ENTRY_STR (zone),
+	                       XMMSV_LIST_END);
+}
+
+/**
+ * Stop playback in an output zone.
+ *
+ * @param c The connection structure.
+ * @param zone The name of the zone, as listed in output.zones.
+ */
+xmmsc_result_t *
+xmmsc_playback_zone_stop (xmmsc_connection_t *c, const char *zone)
+{
+	x_check_conn (c, NULL);
+	x_api_error_if (!zone, "with a NULL zone", NULL);
+
+	return xmmsc_send_cmd (c, XMMS_IPC_OBJECT_PLAYBACK,
+	                       XMMS_IPC_COMMAND_PLAYBACK_ZONE_STOP,
+	                       XMMSV_LIST_ENTRY_STR (zone),
+	                       XMMSV_LIST_END);
+}
+
 xmmsc_result_t *
 xmmsc_broadcast_playback_volume_changed (xmmsc_connection_t *c)
 {
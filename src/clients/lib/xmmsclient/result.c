@@ -46,6 +46,7 @@ typedef struct xmmsc_result_callback_St {
 } xmmsc_result_callback_t;
 
 static void xmmsc_result_restart (xmmsc_result_t *res);
+static void xmmsc_result_run_notifiers (xmmsc_result_t *res);
 static void xmmsc_result_notifier_add (xmmsc_result_t *res, xmmsc_result_callback_t *cb);
 static void xmmsc_result_notifier_remove (xmmsc_result_t *res, x_list_t *node);
 static void xmmsc_result_notifier_delete (xmmsc_result_t *res, x_list_t *node);
@@ -76,9 +77,18 @@ struct xmmsc_result_St {
 
 	xmmsv_t *data;
 
+	/** values collected by a batch result, and replies still missing */
+	xmmsv_t *batch_values;
+	int batch_pending;
+
 	xmmsc_visualization_t *visc;
 };
 
+typedef struct xmmsc_result_batch_entry_St {
+	xmmsc_result_t *batch;
+	int index;
+} xmmsc_result_batch_entry_t;
+
 /**
  * @defgroup Result Result
  * @brief Result manipulation and error handling
@@ -162,6 +172,10 @@ xmmsc_result_free (xmmsc_result_t *res)
 		xmmsv_unref (res->data);
 	}
 
+	if (res->batch_values) {
+		xmmsv_unref (res->batch_values);
+	}
+
 	xmmsc_result_notifier_delete_all (res);
 
 	free (res);
@@ -539,9 +553,6 @@ xmmsc_result_run_callback (xmmsc_result_t *res, xmmsc_result_callback_t *cb)
 void
 xmmsc_result_run (xmmsc_result_t *res, xmms_ipc_msg_t *msg)
 {
-	x_list_t *n, *next;
-	xmmsc_result_callback_t *cb;
-
 	x_return_if_fail (res);
 	x_return_if_fail (msg);
 
@@ -553,6 +564,19 @@ xmmsc_result_run (xmmsc_result_t *res, xmms_ipc_msg_t *msg)
 	xmms_ipc_msg_destroy (msg);
 
 	xmmsc_result_ref (res);
+	xmmsc_result_run_notifiers (res);
+	xmmsc_result_unref (res);
+}
+
+/**
+ * Run the notifiers of a result whose value has arrived.
+ * The caller must hold a reference to the result.
+ */
+static void
+xmmsc_result_run_notifiers (xmmsc_result_t *res)
+{
+	x_list_t *n, *next;
+	xmmsc_result_callback_t *cb;
 
 	/* Run all notifiers and check for positive return values */
 	n = res->notifiers;
@@ -589,8 +613,6 @@ xmmsc_result_run (xmmsc_result_t *res, xmms_ipc_msg_t *msg)
 		xmmsv_unref (res->data);
 		res->data = NULL;
 	}
-
-	xmmsc_result_unref (res);
 }
 
 /**
@@ -623,12 +645,113 @@ xmmsc_result_new (xmmsc_connection_t *c, xmmsc_result_type_t type,
 	/* Add it to the loop */
 	xmmsc_ipc_result_register (c->ipc, res);
 
+	if (c->batch_open && type == XMMSC_RESULT_CLASS_DEFAULT) {
+		c->batch = x_list_prepend (c->batch, xmmsc_result_ref (res));
+	}
+
 	/* For the destroy func */
 	res->ipc = c->ipc;
 
 	return res;
 }
 
+static int
+xmmsc_result_batch_collect (xmmsv_t *val, void *user_data)
+{
+	xmmsc_result_batch_entry_t *entry = user_data;
+	xmmsc_result_t *batch = entry->batch;
+
+	xmmsv_list_set (batch->batch_values, entry->index, val);
+
+	if (--batch->batch_pending == 0) {
+		batch->data = batch->batch_values;
+		batch->batch_values = NULL;
+		batch->parsed = true;
+
+		xmmsc_result_ref (batch);
+		xmmsc_result_run_notifiers (batch);
+		xmmsc_result_unref (batch);
+	}
+
+	return 0;
+}
+
+static void
+xmmsc_result_batch_entry_free (void *user_data)
+{
+	xmmsc_result_batch_entry_t *entry = user_data;
+
+	xmmsc_result_unref (entry->batch);
+	free (entry);
+}
+
+/**
+ * Allocates a result that completes once every result in the list
+ * has received its reply. The value is a list holding the values of
+ * the results in the same order, errors included. Takes over the
+ * references held by the list, and frees the list.
+ * @internal
+ */
+xmmsc_result_t *
+xmmsc_result_batch_new (xmmsc_connection_t *c, x_list_t *results)
+{
+	xmmsc_result_batch_entry_t *entry;
+	xmmsc_result_t *batch, *res;
+	xmmsv_t *none;
+	x_list_t *n;
+	int i = 0;
+
+	/* Never answered, the cookie only keeps the result waitable */
+	batch = xmmsc_result_new (c, XMMSC_RESULT_CLASS_DEFAULT, c->cookie++);
+	if (!batch) {
+		return NULL;
+	}
+
+	batch->batch_values = xmmsv_new_list ();
+	none = xmmsv_new_none ();
+
+	for (n = results; n; n = x_list_next (n), i++) {
+		res = n->data;
+
+		xmmsv_list_append (batch->batch_values, none);
+
+		if (res->parsed) {
+			/* waited for while the batch was still open */
+			xmmsv_list_set (batch->batch_values, i, res->data);
+			xmmsc_result_unref (res);
+			continue;
+		}
+
+		entry = x_new0 (xmmsc_result_batch_entry_t, 1);
+		if (!entry) {
+			x_oom ();
+			xmmsv_list_set (batch->batch_values, i,
+			                xmmsv_new_error ("Out of memory"));
+			xmmsc_result_unref (res);
+			continue;
+		}
+
+		entry->batch = xmmsc_result_ref (batch);
+		entry->index = i;
+		batch->batch_pending++;
+
+		xmmsc_result_notifier_set_raw_full (res, xmmsc_result_batch_collect,
+		                                    entry, xmmsc_result_batch_entry_free);
+		xmmsc_result_unref (res);
+	}
+
+	xmmsv_unref (none);
+	x_list_free (results);
+
+	if (!batch->batch_pending) {
+		batch->data = batch->batch_values;
+		batch->batch_values = NULL;
+		batch->parsed = true;
+	}
+
+	return batch;
+}
+
 void
 xmmsc_result_clear_weakrefs (xmmsc_result_t *result)
 {
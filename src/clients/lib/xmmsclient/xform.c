@@ -69,3 +69,20 @@ xmmsc_xform_media_browse_encoded (xmmsc_connection_t *c, const char *url)
 	return xmmsc_send_cmd (c, XMMS_IPC_OBJECT_XFORM, XMMS_IPC_COMMAND_XFORM_BROWSE,
 	                       XMMSV_LIST_ENTRY_STR (url), XMMSV_LIST_END);
 }
+
+/**
+ * Get the time spent in each configured effect.
+ *
+ * Returns a list of dicts with the effect name, the processing time
+ * in nanoseconds and the number of bytes processed since the server
+ * started. They only count while the output.profile config value is
+ * enabled.
+ */
+xmmsc_result_t *
+xmmsc_xform_effect_stats (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_msg_no_arg (c, XMMS_IPC_OBJECT_XFORM,
+	                              XMMS_IPC_COMMAND_XFORM_EFFECT_STATS);
+}
@@ -265,6 +265,13 @@ xmmsc_ref (xmmsc_connection_t *c)
 static void
 xmmsc_deinit (xmmsc_connection_t *c)
 {
+	x_list_t *n;
+
+	for (n = c->batch; n; n = x_list_next (n)) {
+		xmmsc_result_unref (n->data);
+	}
+	x_list_free (c->batch);
+
 	xmmsc_ipc_destroy (c->ipc);
 
 	if (c->sc_root) {
@@ -293,6 +300,55 @@ xmmsc_lock_set (xmmsc_connection_t *c, void *lock, void (*lockfunc)(void *), voi
 	xmmsc_ipc_lock_set (c->ipc, lock, lockfunc, unlockfunc);
 }
 
+/**
+ * Start collecting commands into a batch.
+ *
+ * Commands issued on the connection until #xmmsc_batch_end are
+ * pipelined: they are queued without waiting for each other and
+ * written to the server together. Each command still returns its
+ * own result which can be used as usual.
+ *
+ * @param c connection
+ */
+void
+xmmsc_batch_begin (xmmsc_connection_t *c)
+{
+	x_check_conn (c,);
+	x_api_error_if (c->batch_open, "with a batch already open",);
+
+	c->batch_open = true;
+}
+
+/**
+ * Finish the batch started with #xmmsc_batch_begin.
+ *
+ * The returned result completes once the server has answered every
+ * command in the batch, so a whole batch costs a single round trip
+ * when waited for. Its value is a list holding the value of each
+ * command in the order they were issued, error values included.
+ * Signals and broadcasts are not part of the batch.
+ *
+ * If the batch is empty the result is complete right away and its
+ * value is an empty list.
+ *
+ * @param c connection
+ * @return a result completing with the list of replies
+ */
+xmmsc_result_t *
+xmmsc_batch_end (xmmsc_connection_t *c)
+{
+	x_list_t *results;
+
+	x_check_conn (c, NULL);
+	x_api_error_if (!c->batch_open, "without an open batch", NULL);
+
+	results = x_list_reverse (c->batch);
+	c->batch = NULL;
+	c->batch_open = false;
+
+	return xmmsc_result_batch_new (c, results);
+}
+
 /**
  * Tell the server to quit. This will terminate the server.
  * If you only want to disconnect, use #xmmsc_unref()
@@ -155,7 +155,8 @@ CLI_SIMPLE_SETUP("server plugins", cli_server_plugins,
 CLI_SIMPLE_SETUP("server stats", cli_server_stats,
                  COMMAND_REQ_CONNECTION,
                  NULL,
-                 _("Display statistics about the server: uptime, version, size of the medialib, etc"))
+                 _("Display statistics about the server: uptime, version, size of the medialib, etc.\n"
+                   "With output.profile enabled, also the time spent in each xform of the current chain."))
 
 CLI_SIMPLE_SETUP("server sync", cli_server_sync,
                  COMMAND_REQ_CONNECTION,
@@ -273,25 +273,52 @@ cli_list_print_ids (cli_context_t *ctx, column_display_t *coldisp,
                     xmmsv_t *list, gpointer udata)
 {
 	xmmsc_connection_t *conn = cli_context_xmms_sync (ctx);
+	xmmsc_result_t *res;
 	xmmsv_list_iter_t *it;
+	xmmsv_t *positions, *infos, *info;
 	GTree *lookup = NULL;
-	gint id;
+	const gchar *message;
+	gint id, pos, i;
 
 	xmmsv_t *filter = (xmmsv_t *) udata;
 
 	if (filter != NULL)
 		lookup = g_tree_new_from_xmmsv (filter);
 
+	/* Fetch all entries in one round trip instead of one per entry */
+	positions = xmmsv_new_list ();
+	xmmsc_batch_begin (conn);
+
 	xmmsv_get_list_iter (list, &it);
 	while (xmmsv_list_iter_entry_int (it, &id)) {
-		column_display_set_position (coldisp, xmmsv_list_iter_tell (it));
 		if (lookup == NULL || g_tree_lookup (lookup, GINT_TO_POINTER (id)) != NULL) {
-			XMMS_CALL_CHAIN (XMMS_CALL_P (xmmsc_medialib_get_info, conn, id),
-			                 FUNC_CALL_P (cli_list_print_row, coldisp, XMMS_PREV_VALUE));
+			xmmsv_list_append_int (positions, xmmsv_list_iter_tell (it));
+			xmmsc_result_unref (xmmsc_medialib_get_info (conn, id));
 		}
 		xmmsv_list_iter_next (it);
 	}
 
+	res = xmmsc_batch_end (conn);
+	xmmsc_result_wait (res);
+	infos = xmmsc_result_get_value (res);
+
+	if (xmmsv_get_error (infos, &message)) {
+		g_printf (_("Server error: %s\n"), message);
+	}
+
+	for (i = 0; xmmsv_list_get (infos, i, &info); i++) {
+		if (xmmsv_get_error (info, &message)) {
+			g_printf (_("Server error: %s\n"), message);
+			continue;
+		}
+		xmmsv_list_get_int (positions, i, &pos);
+		column_display_set_position (coldisp, pos);
+		cli_list_print_row (coldisp, info);
+	}
+
+	xmmsc_result_unref (res);
+	xmmsv_unref (positions);
+
 	if (lookup)
 		g_tree_destroy (lookup);
 }
@@ -808,11 +808,213 @@ cli_server_stats_print (xmmsv_t *val)
 	          p_days, p_hours, p_minutes, p_seconds);
 }
 
+static void
+cli_server_underruns_print (xmmsv_t *val)
+{
+	xmmsv_t *times;
+	gint count = 0, n;
+	int64_t last;
+
+	xmmsv_dict_entry_get_int (val, "count", &count);
+	g_printf ("underruns = %d\n", count);
+
+	if (xmmsv_dict_get (val, "times", &times) &&
+	    (n = xmmsv_list_get_size (times)) > 0 &&
+	    xmmsv_list_get_int64 (times, n - 1, &last)) {
+		GDateTime *dt = g_date_time_new_from_unix_local (last / G_USEC_PER_SEC);
+		gchar *str = g_date_time_format (dt, "%Y-%m-%d %H:%M:%S");
+
+		g_printf ("last underrun = %s\n", str);
+
+		g_free (str);
+		g_date_time_unref (dt);
+	}
+}
+
+static void
+cli_server_buffer_stats_print (xmmsv_t *val)
+{
+	gint size, adaptive = 0, grows = 0, shrinks = 0;
+	gint seeks = 0, buffered = 0;
+	int64_t seek_last = 0, seek_max = 0;
+
+	if (xmmsv_dict_entry_get_int (val, "buffer_size", &size)) {
+		g_printf ("output buffer = %d bytes\n", size);
+	}
+
+	xmmsv_dict_entry_get_int (val, "adaptive", &adaptive);
+	if (adaptive) {
+		xmmsv_dict_entry_get_int (val, "buffer_grows", &grows);
+		xmmsv_dict_entry_get_int (val, "buffer_shrinks", &shrinks);
+		g_printf ("output buffer resizes = %d up, %d down\n", grows, shrinks);
+	}
+
+	if (xmmsv_dict_entry_get_int (val, "seeks", &seeks) && seeks > 0) {
+		xmmsv_dict_entry_get_int (val, "seeks_buffered", &buffered);
+		xmmsv_dict_entry_get_int64 (val, "seek_latency_last", &seek_last);
+		xmmsv_dict_entry_get_int64 (val, "seek_latency_max", &seek_max);
+		g_printf ("seeks = %d, %d within the output buffer\n", seeks, buffered);
+		g_printf ("seek latency = %.1f ms last, %.1f ms max\n",
+		          seek_last / 1000.0, seek_max / 1000.0);
+	}
+}
+
+static void
+cli_server_chain_stats_print (xmmsv_t *val)
+{
+	xmmsv_list_iter_t *it;
+	xmmsv_t *chain, *entry;
+	gint enabled = 0;
+	gint conversions;
+	int64_t waits, wait_time;
+
+	waits = wait_time = 0;
+
+	if (xmmsv_dict_entry_get_int (val, "conversions", &conversions)) {
+		g_printf ("sample conversions = %d\n", conversions);
+	}
+
+	/* read-ahead buffers are reported while profiling is disabled too */
+	if (xmmsv_dict_get (val, "chain", &chain)) {
+		xmmsv_get_list_iter (chain, &it);
+		while (xmmsv_list_iter_entry (it, &entry)) {
+			const gchar *name = "?";
+			gint fill;
+
+			if (xmmsv_dict_entry_get_int (entry, "buffer_fill", &fill)) {
+				xmmsv_dict_entry_get_string (entry, "name", &name);
+				g_printf ("%s buffer = %d%%\n", name, fill);
+			}
+			xmmsv_list_iter_next (it);
+		}
+	}
+
+	xmmsv_dict_entry_get_int (val, "enabled", &enabled);
+	if (!enabled) {
+		return;
+	}
+
+	xmmsv_dict_entry_get_int64 (val, "filler_waits", &waits);
+	xmmsv_dict_entry_get_int64 (val, "filler_wait_time", &wait_time);
+
+	g_printf ("filler waits = %" G_GINT64_FORMAT " (%.1f ms)\n",
+	          (gint64) waits, wait_time / 1000000.0);
+
+	if (!xmmsv_dict_get (val, "chain", &chain)) {
+		return;
+	}
+
+	g_printf ("%-16s %8s %12s %10s %10s %10s %6s %12s\n",
+	          "xform", "reads", "bytes", "time ms", "self ms",
+	          "cpu ms", "seeks", "moved");
+
+	xmmsv_get_list_iter (chain, &it);
+	while (xmmsv_list_iter_entry (it, &entry)) {
+		const gchar *name = "?";
+		int64_t reads, bytes, time, self_time, self_cpu_time, seeks, moved;
+
+		reads = bytes = time = self_time = self_cpu_time = seeks = moved = 0;
+
+		xmmsv_dict_entry_get_string (entry, "name", &name);
+		xmmsv_dict_entry_get_int64 (entry, "reads", &reads);
+		xmmsv_dict_entry_get_int64 (entry, "bytes", &bytes);
+		xmmsv_dict_entry_get_int64 (entry, "time", &time);
+		xmmsv_dict_entry_get_int64 (entry, "self_time", &self_time);
+		xmmsv_dict_entry_get_int64 (entry, "self_cpu_time", &self_cpu_time);
+		xmmsv_dict_entry_get_int64 (entry, "seeks", &seeks);
+		xmmsv_dict_entry_get_int64 (entry, "moved_bytes", &moved);
+
+		g_printf ("%-16s %8" G_GINT64_FORMAT " %12" G_GINT64_FORMAT
+		          " %10.2f %10.2f %10.2f %6" G_GINT64_FORMAT
+		          " %12" G_GINT64_FORMAT "\n",
+		          name, (gint64) reads, (gint64) bytes,
+		          time / 1000000.0, self_time / 1000000.0,
+		          self_cpu_time / 1000000.0, (gint64) seeks, (gint64) moved);
+
+		xmmsv_list_iter_next (it);
+	}
+}
+
+static void
+cli_server_zones_print (xmmsv_t *val)
+{
+	static const gchar *status_names[] = { "stopped", "playing", "paused" };
+	xmmsv_list_iter_t *it;
+	xmmsv_t *entry;
+
+	if (!xmmsv_get_list_iter (val, &it)) {
+		return;
+	}
+
+	while (xmmsv_list_iter_entry (it, &entry)) {
+		const gchar *name = "?", *playlist = "?", *plugin = "?";
+		gint status = 0, playtime = 0, id = 0, underruns = 0;
+
+		xmmsv_dict_entry_get_string (entry, "name", &name);
+		xmmsv_dict_entry_get_string (entry, "playlist", &playlist);
+		xmmsv_dict_entry_get_string (entry, "plugin", &plugin);
+		xmmsv_dict_entry_get_int (entry, "status", &status);
+		xmmsv_dict_entry_get_int (entry, "playtime", &playtime);
+		xmmsv_dict_entry_get_int (entry, "current_id", &id);
+		xmmsv_dict_entry_get_int (entry, "underruns", &underruns);
+
+		if (status < 0 || status >= (gint) G_N_ELEMENTS (status_names)) {
+			status = 0;
+		}
+
+		g_printf ("zone %s = %s, playlist %s, %s, id %d at %d:%02d, %d underruns\n",
+		          name, plugin, playlist, status_names[status], id,
+		          playtime / 60000, (playtime / 1000) % 60, underruns);
+
+		xmmsv_list_iter_next (it);
+	}
+}
+
+static void
+cli_server_sinks_print (xmmsv_t *val)
+{
+	xmmsv_list_iter_t *it;
+	xmmsv_t *entry;
+
+	if (!xmmsv_get_list_iter (val, &it)) {
+		return;
+	}
+
+	while (xmmsv_list_iter_entry (it, &entry)) {
+		const gchar *name = "?", *plugin = "?";
+		gint size = 0, used = 0, underruns = 0;
+		int64_t dropped = 0;
+
+		xmmsv_dict_entry_get_string (entry, "name", &name);
+		xmmsv_dict_entry_get_string (entry, "plugin", &plugin);
+		xmmsv_dict_entry_get_int (entry, "buffer_size", &size);
+		xmmsv_dict_entry_get_int (entry, "buffered", &used);
+		xmmsv_dict_entry_get_int64 (entry, "dropped", &dropped);
+		xmmsv_dict_entry_get_int (entry, "underruns", &underruns);
+
+		g_printf ("sink %s = %s, %d of %d bytes buffered, %" G_GINT64_FORMAT
+		          " bytes dropped, %d underruns\n",
+		          name, plugin, used, size, (gint64) dropped, underruns);
+
+		xmmsv_list_iter_next (it);
+	}
+}
+
 gboolean
 cli_server_stats (cli_context_t *ctx, command_t *cmd)
 {
 	XMMS_CALL_CHAIN (XMMS_CALL_P (xmmsc_main_stats, cli_context_xmms_sync (ctx)),
 	                 FUNC_CALL_P (cli_server_stats_print, XMMS_PREV_VALUE));
+	XMMS_CALL_CHAIN (XMMS_CALL_P (xmmsc_playback_underruns, cli_context_xmms_sync (ctx)),
+	                 FUNC_CALL_P (cli_server_underruns_print, XMMS_PREV_VALUE));
+	XMMS_CALL_CHAIN (XMMS_CALL_P (xmmsc_playback_buffer_stats, cli_context_xmms_sync (ctx)),
+	                 FUNC_CALL_P (cli_server_buffer_stats_print, XMMS_PREV_VALUE));
+	XMMS_CALL_CHAIN (XMMS_CALL_P (xmmsc_playback_sink_list, cli_context_xmms_sync (ctx)),
+	                 FUNC_CALL_P (cli_server_sinks_print, XMMS_PREV_VALUE));
+	XMMS_CALL_CHAIN (XMMS_CALL_P (xmmsc_playback_zone_list, cli_context_xmms_sync (ctx)),
+	                 FUNC_CALL_P (cli_server_zones_print, XMMS_PREV_VALUE));
+	XMMS_CALL_CHAIN (XMMS_CALL_P (xmmsc_playback_chain_stats, cli_context_xmms_sync (ctx)),
+	                 FUNC_CALL_P (cli_server_chain_stats_print, XMMS_PREV_VALUE));
 	return FALSE;
 }
 
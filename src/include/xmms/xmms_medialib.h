@@ -63,6 +63,7 @@
 #define XMMS_MEDIALIB_ENTRY_PROPERTY_BPM "bpm"
 #define XMMS_MEDIALIB_ENTRY_PROPERTY_LASTSTARTED "laststarted"
 #define XMMS_MEDIALIB_ENTRY_PROPERTY_SIZE "size"
+#define XMMS_MEDIALIB_ENTRY_PROPERTY_SEEKINDEX "seekindex"
 #define XMMS_MEDIALIB_ENTRY_PROPERTY_IS_VBR "isvbr"
 #define XMMS_MEDIALIB_ENTRY_PROPERTY_SUBTUNES "subtunes"
 #define XMMS_MEDIALIB_ENTRY_PROPERTY_CHAIN "chain"
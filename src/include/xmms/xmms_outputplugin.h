@@ -45,7 +45,7 @@ typedef struct xmms_output_St xmms_output_t;
 /**
  * The current API version.
  */
-#define XMMS_OUTPUT_API_VERSION 8
+#define XMMS_OUTPUT_API_VERSION 9
 
 struct xmms_output_plugin_St;
 typedef struct xmms_output_plugin_St xmms_output_plugin_t;
@@ -212,6 +212,23 @@ typedef struct xmms_output_methods_St {
 	 * @return the number of bytes in the soundcard buffer or 0 on failure
 	 */
 	guint (*latency_get)(xmms_output_t *);
+
+	/**
+	 * Fill the soundcard straight from the output buffer.
+	 *
+	 * Optional addition to #write for drivers that can map the device
+	 * buffer. The writer thread calls this instead of reading into a
+	 * buffer of its own, and the plugin moves the data with
+	 * #xmms_output_read_prepare and #xmms_output_read_direct.
+	 * It is called without holding the plugin lock, because
+	 * song changes may call #format_set and #flush from within
+	 * #xmms_output_read_prepare.
+	 *
+	 * @param output an output object
+	 * @param err an error struct
+	 * @return FALSE to have the data handled by #write this time
+	 */
+	gboolean (*fill)(xmms_output_t *output, xmms_error_t *err);
 } xmms_output_methods_t;
 
 /**
@@ -310,6 +327,35 @@ void xmms_output_stream_type_add (xmms_output_t *output, ...) XMMS_PUBLIC;
  */
 gint xmms_output_read (xmms_output_t *output, char *buffer, gint len) XMMS_PUBLIC;
 
+/**
+ * Prepare reading from the output buffer into memory that must stay
+ * valid, such as a mapped device buffer.
+ *
+ * Waits for len bytes of data and handles any song change or seek that
+ * is due, which may call #format_set or #flush. Afterwards up to the
+ * returned number of bytes can be read with #xmms_output_read_direct.
+ *
+ * @param output an output object
+ * @param len the number of bytes wanted
+ * @return the number of bytes that can be read, or -1 at the end of
+ * the stream
+ */
+gint xmms_output_read_prepare (xmms_output_t *output, gint len) XMMS_PUBLIC;
+
+/**
+ * Read from the output buffer after #xmms_output_read_prepare.
+ *
+ * Never blocks and never runs song changes or seeks, so it does not
+ * call back into the plugin. Reads less if the buffer was cleared in
+ * the meantime.
+ *
+ * @param output an output object
+ * @param buffer a buffer to store the read data in
+ * @param len the number of bytes to read
+ * @return the number of bytes read
+ */
+gint xmms_output_read_direct (xmms_output_t *output, char *buffer, gint len) XMMS_PUBLIC;
+
 /**
  * Gets Number of available bytes in the output buffer
  *
@@ -51,7 +51,7 @@
 
 
 
-#define XMMS_XFORM_API_VERSION 7
+#define XMMS_XFORM_API_VERSION 8
 
 #include <xmms/xmms_error.h>
 #include <xmms/xmms_plugin.h>
@@ -153,6 +153,16 @@ typedef struct xmms_xform_methods_St {
 	 * Called to read data from the xform.
 	 */
 	gint (*read)(xmms_xform_t *, gpointer, gint, xmms_error_t *);
+	/**
+	 * In-place processing method.
+	 *
+	 * Optional method for effects that modify audio/pcm data in
+	 * place without changing its format. Called with data read
+	 * from the previous xform and its length in bytes. Adjacent
+	 * effects implementing it are run over the same buffer in one
+	 * pass. An effect implementing this need not implement read.
+	 */
+	void (*process)(xmms_xform_t *, gpointer, gint);
 	/**
 	 * Seek method.
 	 *
@@ -261,6 +271,44 @@ gpointer xmms_xform_private_data_get (xmms_xform_t *xform) XMMS_PUBLIC;
  */
 void xmms_xform_private_data_set (xmms_xform_t *xform, gpointer data) XMMS_PUBLIC;
 
+/**
+ * Serve the output of this xform straight from memory.
+ *
+ * Reads, peeks and seeks on the xform are then answered from the
+ * given region without calling the read and seek methods, and peeked
+ * data is not buffered. Meant for transports that map their source
+ * into memory. The region must stay valid until the destroy method
+ * is called, and the xform must not set any auxdata.
+ *
+ * @param xform current xform
+ * @param data start of the region
+ * @param size size of the region in bytes
+ */
+void xmms_xform_mapping_set (xmms_xform_t *xform, gconstpointer data, gint64 size) XMMS_PUBLIC;
+
+/**
+ * Remember that decoding from byte offset of the input yields sample
+ * as the first output sample. Decoders call this for every frame they
+ * decode, only about one point per second is kept. The points are
+ * stored with the medialib entry when the xform is destroyed.
+ *
+ * @param xform current xform
+ * @param sample position in samples
+ * @param offset byte offset in the input where decoding can start
+ */
+void xmms_xform_seekpoint_add (xmms_xform_t *xform, gint64 sample, gint64 offset) XMMS_PUBLIC;
+
+/**
+ * Find the closest known seek point at or before sample.
+ *
+ * @param xform current xform
+ * @param sample wanted position in samples
+ * @param found where the sample position of the point is stored
+ * @param offset where the byte offset of the point is stored
+ * @returns TRUE if there is a point close enough to be worth using
+ */
+gboolean xmms_xform_seekpoint_find (xmms_xform_t *xform, gint64 sample, gint64 *found, gint64 *offset) XMMS_PUBLIC;
+
 
 void xmms_xform_outdata_type_add (xmms_xform_t *xform, ...) XMMS_PUBLIC;
 void xmms_xform_outdata_type_copy (xmms_xform_t *xform) XMMS_PUBLIC;
@@ -334,6 +382,16 @@ gboolean xmms_xform_metadata_parse_replay_gain (xmms_xform_t *xform, const gchar
  */
 gboolean xmms_xform_metadata_mapper_match (xmms_xform_t *xform, const gchar *key, const gchar *value, gsize length) XMMS_PUBLIC;
 
+/**
+ * Let adjacent gain effects apply their combined gain in one pass.
+ * An xform calling #xmms_xform_gain_accept from init must multiply
+ * what it reads by #xmms_xform_gain_get, and the xform before it may
+ * then skip its own multiply when #xmms_xform_gain_defer returns TRUE.
+ */
+void xmms_xform_gain_accept (xmms_xform_t *xform) XMMS_PUBLIC;
+gboolean xmms_xform_gain_defer (xmms_xform_t *xform, gfloat gain) XMMS_PUBLIC;
+gfloat xmms_xform_gain_get (xmms_xform_t *xform) XMMS_PUBLIC;
+
 void xmms_xform_auxdata_barrier (xmms_xform_t *xform) XMMS_PUBLIC;
 void xmms_xform_auxdata_set_int (xmms_xform_t *xform, const gchar *key, gint64 val) XMMS_PUBLIC;
 void xmms_xform_auxdata_set_str (xmms_xform_t *xform, const gchar *key, const gchar *val) XMMS_PUBLIC;
@@ -415,6 +473,17 @@ gint xmms_xform_read (xmms_xform_t *xform, gpointer buf, gint siz, xmms_error_t
 gint64 xmms_xform_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whence, xmms_error_t *err) XMMS_PUBLIC;
 gboolean xmms_xform_iseos (xmms_xform_t *xform) XMMS_PUBLIC;
 
+/**
+ * Report how full the read-ahead buffer of a transport is.
+ *
+ * The value is shown in the chain statistics of the output and is
+ * not stored anywhere, so it is cheap to update on every read.
+ *
+ * @param xform
+ * @param percent fill level from 0 to 100
+ */
+void xmms_xform_buffer_fill_set (xmms_xform_t *xform, gint percent) XMMS_PUBLIC;
+
 gboolean xmms_magic_add (const gchar *desc, const gchar *mime, ...) XMMS_PUBLIC;
 gboolean xmms_magic_extension_add (const gchar *mime, const gchar *ext) XMMS_PUBLIC;
 
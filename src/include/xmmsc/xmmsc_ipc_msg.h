@@ -27,6 +27,7 @@
 
 #define XMMS_IPC_MSG_DEFAULT_SIZE 128 /*32768*/
 #define XMMS_IPC_MSG_HEAD_LEN 16 /* all but data */
+#define XMMS_IPC_MSG_COALESCE_MAX 65536 /* max bytes per coalesced write */
 
 typedef struct xmms_ipc_msg_St xmms_ipc_msg_t;
 
@@ -40,6 +41,7 @@ xmms_ipc_msg_t * xmms_ipc_msg_alloc (void);
 void xmms_ipc_msg_destroy (xmms_ipc_msg_t *msg);
 
 bool xmms_ipc_msg_write_transport (xmms_ipc_msg_t *msg, xmms_ipc_transport_t *transport, bool *disconnected);
+bool xmms_ipc_msg_append (xmms_ipc_msg_t *msg, const xmms_ipc_msg_t *next);
 bool xmms_ipc_msg_read_transport (xmms_ipc_msg_t *msg, xmms_ipc_transport_t *transport, bool *disconnected);
 
 uint32_t xmms_ipc_msg_put_value (xmms_ipc_msg_t *msg, xmmsv_t* v);
@@ -50,6 +50,7 @@ const unsigned char *xmmsv_bitbuffer_buffer (xmmsv_t *v) XMMS_PUBLIC;
 int xmmsv_get_bitbuffer (const xmmsv_t *val, const unsigned char **r, unsigned int *rlen) XMMS_PUBLIC;
 int xmmsv_bitbuffer_serialize_value (xmmsv_t *bb, xmmsv_t *v);
 int xmmsv_bitbuffer_deserialize_value (xmmsv_t *bb, xmmsv_t **val);
+int xmmsv_bitbuffer_deserialize_value_view (xmmsv_t *bb, xmmsv_t **val);
 
 /** @} */
 
@@ -44,6 +44,9 @@ int xmmsv_dict_format (char *target, int len, const char *fmt, xmmsv_t *val) XMM
 
 xmmsv_t *xmmsv_serialize (xmmsv_t *v) XMMS_PUBLIC;
 xmmsv_t *xmmsv_deserialize (xmmsv_t *v) XMMS_PUBLIC;
+xmmsv_t *xmmsv_deserialize_view (xmmsv_t *v) XMMS_PUBLIC;
+
+void xmmsv_alloc_stats_get (int64_t *live, int64_t *allocations, int64_t *cache_hits) XMMS_PUBLIC;
 
 /** @} */
 
@@ -61,6 +61,9 @@ int xmmsc_io_fd_get (xmmsc_connection_t *c) XMMS_PUBLIC;
 
 char *xmmsc_get_last_error (xmmsc_connection_t *c) XMMS_PUBLIC;
 
+void xmmsc_batch_begin (xmmsc_connection_t *c) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_batch_end (xmmsc_connection_t *c) XMMS_PUBLIC;
+
 xmmsc_result_t *xmmsc_quit(xmmsc_connection_t *c) XMMS_PUBLIC;
 
 xmmsc_result_t *xmmsc_broadcast_quit (xmmsc_connection_t *c) XMMS_PUBLIC;
@@ -134,6 +137,13 @@ xmmsc_result_t *xmmsc_playback_playtime (xmmsc_connection_t *c) XMMS_PUBLIC;
 xmmsc_result_t *xmmsc_playback_status (xmmsc_connection_t *c) XMMS_PUBLIC;
 xmmsc_result_t *xmmsc_playback_volume_set (xmmsc_connection_t *c, const char *channel, int volume) XMMS_PUBLIC;
 xmmsc_result_t *xmmsc_playback_volume_get (xmmsc_connection_t *c) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_playback_underruns (xmmsc_connection_t *c) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_playback_buffer_stats (xmmsc_connection_t *c) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_playback_chain_stats (xmmsc_connection_t *c) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_playback_zone_list (xmmsc_connection_t *c) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_playback_sink_list (xmmsc_connection_t *c) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_playback_zone_start (xmmsc_connection_t *c, const char *zone) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_playback_zone_stop (xmmsc_connection_t *c, const char *zone) XMMS_PUBLIC;
 
 /* broadcasts */
 xmmsc_result_t *xmmsc_broadcast_playback_volume_changed (xmmsc_connection_t *c) XMMS_PUBLIC;
@@ -237,6 +247,7 @@ xmmsc_result_t *xmmsc_medialib_entry_property_remove_with_source (xmmsc_connecti
 /* XForm object */
 xmmsc_result_t *xmmsc_xform_media_browse (xmmsc_connection_t *c, const char *url) XMMS_PUBLIC;
 xmmsc_result_t *xmmsc_xform_media_browse_encoded (xmmsc_connection_t *c, const char *url) XMMS_PUBLIC;
+xmmsc_result_t *xmmsc_xform_effect_stats (xmmsc_connection_t *c) XMMS_PUBLIC;
 
 /* Bindata object */
 xmmsc_result_t *xmmsc_bindata_add (xmmsc_connection_t *c, const unsigned char *data, unsigned int len) XMMS_PUBLIC;
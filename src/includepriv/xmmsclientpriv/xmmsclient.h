@@ -52,6 +52,10 @@ struct xmmsc_connection_St {
 	char *error;
 	uint32_t cookie;
 
+	/* results of commands issued since xmmsc_batch_begin */
+	bool batch_open;
+	x_list_t *batch;
+
 	char *clientname;
 
 	/** data array for visualization connections */
@@ -69,6 +73,7 @@ struct xmmsc_connection_St {
 };
 
 xmmsc_result_t *xmmsc_result_new (xmmsc_connection_t *c, xmmsc_result_type_t type, uint32_t cookie);
+xmmsc_result_t *xmmsc_result_batch_new (xmmsc_connection_t *c, x_list_t *results);
 
 uint32_t xmmsc_result_cookie_get (xmmsc_result_t *result);
 void xmmsc_result_c2c_set (xmmsc_result_t *res);
@@ -17,6 +17,7 @@
 #ifndef __XMMSV_INTERNAL_H__
 #define __XMMSV_INTERNAL_H__
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <xmmsc/xmmsv.h>
@@ -52,9 +53,21 @@ struct xmmsv_St {
 	xmmsv_type_t type;
 
 	int ref;  /* refcounting */
+
+	/* string/bin data is borrowed from this buffer, NULL if owned */
+	xmmsv_t *owner;
 };
 
 xmmsv_t *_xmmsv_new (xmmsv_type_t type);
+xmmsv_t *_xmmsv_new_string_view (const char *s, xmmsv_t *owner);
+xmmsv_t *_xmmsv_new_bin_view (const unsigned char *data, unsigned int len, xmmsv_t *owner);
+
+void *_xmmsv_alloc (size_t size);
+void _xmmsv_release (void *ptr, size_t size);
+char *_xmmsv_strdup (const char *str);
+void _xmmsv_strfree (char *str);
+
+int _xmmsv_bitbuffer_get_data_ref (xmmsv_t *v, int len, const unsigned char **res);
 
 void _xmmsv_list_free (xmmsv_list_internal_t *dict);
 void _xmmsv_dict_free (xmmsv_dict_internal_t *dict);
@@ -20,5 +20,7 @@
 typedef struct xmms_bindata_St xmms_bindata_t;
 
 xmms_bindata_t *xmms_bindata_init (void);
+gboolean xmms_bindata_get (const gchar *hash, guchar **data, gsize *size);
+void xmms_bindata_remove (const gchar *hash);
 
 #endif
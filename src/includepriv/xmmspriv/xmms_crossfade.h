@@ -0,0 +1,35 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#ifndef __XMMS_CROSSFADE_H__
+#define __XMMS_CROSSFADE_H__
+
+#include <glib.h>
+#include <xmms/xmms_sample.h>
+
+typedef enum {
+	XMMS_CROSSFADE_CURVE_LINEAR,
+	XMMS_CROSSFADE_CURVE_EQUAL_POWER,
+	XMMS_CROSSFADE_CURVE_SCURVE,
+} xmms_crossfade_curve_t;
+
+xmms_crossfade_curve_t xmms_crossfade_curve_parse (const gchar *name);
+gboolean xmms_crossfade_format_supported (xmms_sample_format_t format);
+void xmms_crossfade_mix (xmms_sample_format_t format, gint channels,
+                         xmms_crossfade_curve_t curve, gpointer out,
+                         gconstpointer in, guint frames, guint pos, guint len);
+
+#endif
@@ -23,6 +23,7 @@
 
 xmms_plugin_t *xmms_output_plugin_new (void);
 gboolean xmms_output_plugin_verify (xmms_plugin_t *_plugin);
+xmms_output_plugin_t *xmms_output_plugin_instance_new (xmms_output_plugin_t *plugin);
 
 
 gboolean xmms_output_plugin_method_new (xmms_output_plugin_t *plugin, xmms_output_t *output);
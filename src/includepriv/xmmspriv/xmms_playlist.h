@@ -53,7 +53,11 @@ xmms_playlist_t * xmms_playlist_init (xmms_medialib_t *medialib, xmms_coll_dag_t
 void xmms_playlist_update (xmms_playlist_t *playlist, const gchar *plname);
 
 gboolean xmms_playlist_advance (xmms_playlist_t *playlist);
+gboolean xmms_playlist_advance_in (xmms_playlist_t *playlist, const gchar *plname);
+void xmms_playlist_retreat_in (xmms_playlist_t *playlist, const gchar *plname);
 xmms_medialib_entry_t xmms_playlist_current_entry (xmms_playlist_t *playlist);
+xmms_medialib_entry_t xmms_playlist_current_entry_in (xmms_playlist_t *playlist, const gchar *plname);
+xmms_medialib_entry_t xmms_playlist_next_entry_in (xmms_playlist_t *playlist, const gchar *plname);
 void xmms_playlist_add_entry_unlocked (xmms_playlist_t *playlist, const gchar *plname, xmmsv_t *plcoll, xmms_medialib_entry_t file, xmms_error_t *err);
 GList * xmms_playlist_list (xmms_playlist_t *playlist, const gchar *plname, xmms_error_t *err);
 
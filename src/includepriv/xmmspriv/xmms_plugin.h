@@ -35,6 +35,11 @@ typedef struct xmms_plugin_St {
 	const gchar *shortname;
 	const gchar *description;
 	const gchar *version;
+
+	/* set for plugins known from the manifest, until they are opened */
+	gchar *path;
+	/* opening it failed, accessed atomically */
+	gboolean failed;
 } xmms_plugin_t;
 
 /*
@@ -44,6 +49,8 @@ gboolean xmms_plugin_load (const xmms_plugin_desc_t *desc, GModule *module);
 gboolean xmms_plugin_init (const gchar *path);
 void xmms_plugin_shutdown (void);
 void xmms_plugin_destroy (xmms_plugin_t *plugin);
+gboolean xmms_plugin_ensure_loaded (xmms_plugin_t *plugin);
+gboolean xmms_plugin_failed (xmms_plugin_t *plugin);
 
 typedef gboolean (*xmms_plugin_foreach_func_t)(xmms_plugin_t *, gpointer);
 void xmms_plugin_foreach (xmms_plugin_type_t type, xmms_plugin_foreach_func_t func, gpointer user_data);
@@ -0,0 +1,28 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#ifndef __XMMS_REALTIME_H__
+#define __XMMS_REALTIME_H__
+
+#include <glib.h>
+
+gboolean xmms_realtime_thread_set (gboolean round_robin, gint priority);
+gboolean xmms_realtime_thread_nice (gint increment);
+gboolean xmms_realtime_thread_affinity_set (const gchar *cpus);
+gpointer xmms_realtime_locked_alloc (gsize length);
+void xmms_realtime_locked_free (gpointer mem, gsize length);
+
+#endif
@@ -26,6 +26,8 @@ typedef struct xmms_ringbuf_St xmms_ringbuf_t;
 
 xmms_ringbuf_t *xmms_ringbuf_new (guint size);
 void xmms_ringbuf_destroy (xmms_ringbuf_t *ringbuf);
+gboolean xmms_ringbuf_mlock (xmms_ringbuf_t *ringbuf);
+void xmms_ringbuf_resize (xmms_ringbuf_t *ringbuf, guint size);
 void xmms_ringbuf_clear (xmms_ringbuf_t *ringbuf);
 guint xmms_ringbuf_bytes_free (const xmms_ringbuf_t *ringbuf);
 guint xmms_ringbuf_bytes_used (const xmms_ringbuf_t *ringbuf);
@@ -33,9 +35,13 @@ guint xmms_ringbuf_size (xmms_ringbuf_t *ringbuf);
 
 guint xmms_ringbuf_read (xmms_ringbuf_t *ringbuf, gpointer data, guint length);
 guint xmms_ringbuf_read_wait (xmms_ringbuf_t *ringbuf, gpointer data, guint length, GMutex *mtx);
+guint xmms_ringbuf_read_nohotspots (xmms_ringbuf_t *ringbuf, gpointer data, guint length);
+guint xmms_ringbuf_hotspots_run (xmms_ringbuf_t *ringbuf);
+gboolean xmms_ringbuf_skip (xmms_ringbuf_t *ringbuf, guint length);
 guint xmms_ringbuf_peek (xmms_ringbuf_t *ringbuf, gpointer data, guint length);
 guint xmms_ringbuf_peek_wait (xmms_ringbuf_t *ringbuf, gpointer data, guint length, GMutex *mtx);
 void xmms_ringbuf_hotspot_set (xmms_ringbuf_t *ringbuf, gboolean (*cb) (void *), void (*destroy) (void *), void *arg);
+void xmms_ringbuf_hotspot_set_front (xmms_ringbuf_t *ringbuf, gboolean (*cb) (void *), void (*destroy) (void *), void *arg);
 guint xmms_ringbuf_write (xmms_ringbuf_t *ringbuf, gconstpointer data, guint length);
 guint xmms_ringbuf_write_wait (xmms_ringbuf_t *ringbuf, gconstpointer data, guint length, GMutex *mtx);
 
@@ -0,0 +1,40 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#ifndef __XMMS_SOFTVOL_H__
+#define __XMMS_SOFTVOL_H__
+
+#include <glib.h>
+#include <xmms/xmms_sample.h>
+
+typedef struct xmms_softvol_St {
+	/** The gain of the last frame scaled, and the one ramped to */
+	gfloat gain;
+	gfloat target;
+	/** Change of the gain per frame, and frames left to ramp */
+	gfloat step;
+	guint ramp;
+	/** Channel of the next sample, calls may end within a frame */
+	gint channel;
+} xmms_softvol_t;
+
+void xmms_softvol_init (xmms_softvol_t *vol, gfloat gain);
+void xmms_softvol_set (xmms_softvol_t *vol, gfloat gain, guint ramp);
+gfloat xmms_softvol_gain (gint volume);
+void xmms_softvol_apply (xmms_softvol_t *vol, xmms_sample_format_t format,
+                         gint channels, gpointer buf, guint samples);
+
+#endif
@@ -23,6 +23,10 @@
 xmms_stream_type_t *xmms_stream_type_parse (va_list ap);
 gboolean xmms_stream_type_match (const xmms_stream_type_t *in_type, const xmms_stream_type_t *out_type);
 xmms_stream_type_t *xmms_stream_type_coerce (const xmms_stream_type_t *in, const GList *goal_types);
+gchar *xmms_stream_type_signature (const xmms_stream_type_t *st);
+gboolean xmms_stream_type_matches_url_by_scheme (const xmms_stream_type_t *in_type);
+gchar **xmms_stream_type_to_strv (const xmms_stream_type_t *st);
+xmms_stream_type_t *xmms_stream_type_from_strv (gchar **strv);
 xmms_stream_type_t *_xmms_stream_type_new (const gchar *begin, ...);
 
 
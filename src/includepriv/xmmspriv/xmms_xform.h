@@ -50,6 +50,21 @@ xmmsv_t *xmms_xform_browse_method (xmms_xform_t *xform, const gchar *url, xmms_e
 
 const char *xmms_xform_indata_find_str (xmms_xform_t *xform, xmms_stream_type_key_t key);
 
+void xmms_xform_plan_cache_flush (void);
+void xmms_xform_plan_cache_stats (gint64 *hits, gint64 *misses);
+
+void xmms_xform_profile_set (gboolean enabled);
+gboolean xmms_xform_profile_enabled (void);
+xmmsv_t *xmms_xform_profile_get (xmms_xform_t *chain);
+
+void xmms_xform_chain_mlock (xmms_xform_t *chain);
+gint xmms_xform_chain_conversions (xmms_xform_t *chain);
+
+void xmms_magic_capture_begin (gboolean discard);
+GPtrArray *xmms_magic_capture_end (void);
+gboolean xmms_magic_replay (gchar **entry);
+const gchar *xmms_magic_identify (const gchar *buf, guint len, const gchar *url);
+
 #define XMMS_XFORM_BUILTIN_DEFINE(shname, name, ver, desc, setupfunc) XMMS_BUILTIN_DEFINE(XMMS_PLUGIN_TYPE_XFORM, XMMS_XFORM_API_VERSION, shname, name, ver, desc, (gboolean (*)(gpointer))setupfunc)
 
 #endif
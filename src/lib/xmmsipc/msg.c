@@ -225,6 +225,42 @@ xmms_ipc_msg_write_transport (xmms_ipc_msg_t *msg,
 	return (len == msg->xfered);
 }
 
+/**
+ * Append the wire data of next to msg, so that both messages are
+ * handed to the transport by a single #xmms_ipc_msg_write_transport.
+ * next is left untouched and is still owned by the caller.
+ *
+ * @returns FALSE if next has been partially written already or the
+ *          combined size would exceed #XMMS_IPC_MSG_COALESCE_MAX.
+ */
+bool
+xmms_ipc_msg_append (xmms_ipc_msg_t *msg, const xmms_ipc_msg_t *next)
+{
+	unsigned int len, next_len;
+
+	x_return_val_if_fail (msg, false);
+	x_return_val_if_fail (next, false);
+
+	if (next->xfered) {
+		return false;
+	}
+
+	xmmsv_bitbuffer_align (msg->bb);
+	xmmsv_bitbuffer_align (next->bb);
+
+	len = xmmsv_bitbuffer_len (msg->bb) / 8;
+	next_len = xmmsv_bitbuffer_len (next->bb) / 8;
+
+	if (len + next_len > XMMS_IPC_MSG_COALESCE_MAX) {
+		return false;
+	}
+
+	xmmsv_bitbuffer_end (msg->bb);
+	xmmsv_bitbuffer_put_data (msg->bb, xmmsv_bitbuffer_buffer (next->bb), next_len);
+
+	return true;
+}
+
 /**
  * Try to read message from transport into msg.
  *
@@ -295,8 +331,15 @@ xmms_ipc_msg_put_value (xmms_ipc_msg_t *msg, xmmsv_t *v)
 }
 
 
+/**
+ * Deserialize the message payload.
+ *
+ * Strings and binary data in the returned value reference the
+ * message buffer instead of being copied, so the buffer outlives
+ * the message until the last such value is unreferenced.
+ */
 bool
 xmms_ipc_msg_get_value (xmms_ipc_msg_t *msg, xmmsv_t **val)
 {
-	return xmmsv_bitbuffer_deserialize_value (msg->bb, val);
+	return xmmsv_bitbuffer_deserialize_value_view (msg->bb, val);
 }
@@ -19,6 +19,7 @@
 
 #include <xmmsc/xmmsc_stdbool.h>
 #include <xmmsc/xmmsv.h>
+#include <xmmscpriv/xmmsv.h>
 #include <xmmscpriv/xmmsc_util.h>
 
 static bool _internal_put_on_bb_bin (xmmsv_t *bb, const unsigned char *data, unsigned int len);
@@ -40,11 +41,15 @@ static bool _internal_get_from_bb_int32_positive (xmmsv_t *bb, int32_t *v);
 static bool _internal_get_from_bb_int64 (xmmsv_t *bb, int64_t *v);
 static bool _internal_get_from_bb_float (xmmsv_t *bb, float *v);
 static bool _internal_get_from_bb_string_alloc (xmmsv_t *bb, char **buf, unsigned int *len);
-static bool _internal_get_from_bb_collection_alloc (xmmsv_t *bb, xmmsv_t **coll);
-static bool _internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_t **val);
-static bool _internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_t **val);
+static bool _internal_get_from_bb_string_ref (xmmsv_t *bb, const char **buf, char **tmp);
+static bool _internal_get_from_bb_string_value (xmmsv_t *bb, xmmsv_t *owner, xmmsv_t **val);
+static bool _internal_get_from_bb_bin_value (xmmsv_t *bb, xmmsv_t *owner, xmmsv_t **val);
+static bool _internal_get_from_bb_collection_alloc (xmmsv_t *bb, xmmsv_t *owner, xmmsv_t **coll);
+static bool _internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_t *owner, xmmsv_t **val);
+static bool _internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_t *owner, xmmsv_t **val);
 
-static bool _internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_type_t type, xmmsv_t **val);
+static bool _internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_t *owner, xmmsv_type_t type, xmmsv_t **val);
+static bool _internal_get_from_bb_value_alloc (xmmsv_t *bb, xmmsv_t *owner, xmmsv_t **val);
 
 
 static bool
@@ -368,8 +373,128 @@ _internal_get_from_bb_bin_alloc (xmmsv_t *bb,
 	return true;
 }
 
+/**
+ * Get a string without copying it, if it is stored NUL-terminated
+ * in the bitbuffer. Otherwise a copy is made and returned in tmp,
+ * which must be freed by the caller.
+ */
+static bool
+_internal_get_from_bb_string_ref (xmmsv_t *bb, const char **buf, char **tmp)
+{
+	const unsigned char *data;
+	char *str;
+	int32_t l;
+
+	*tmp = NULL;
+
+	if (!_internal_get_from_bb_int32_positive (bb, &l)) {
+		return false;
+	}
+
+	if (_xmmsv_bitbuffer_get_data_ref (bb, l, &data)) {
+		if (l > 0 && data[l - 1] == '\0') {
+			*buf = (const char *) data;
+			return true;
+		}
+
+		str = x_malloc (l + 1);
+		if (!str) {
+			return false;
+		}
+		memcpy (str, data, l);
+	} else {
+		str = x_malloc (l + 1);
+		if (!str) {
+			return false;
+		}
+		if (!_internal_get_from_bb_data (bb, str, l)) {
+			free (str);
+			return false;
+		}
+	}
+
+	str[l] = '\0';
+
+	*buf = *tmp = str;
+
+	return true;
+}
+
+/**
+ * Create a string value, referencing the owner's buffer if one is
+ * given and the string can be used in place.
+ */
+static bool
+_internal_get_from_bb_string_value (xmmsv_t *bb, xmmsv_t *owner,
+                                    xmmsv_t **val)
+{
+	const char *s;
+	char *tmp;
+
+	if (!owner) {
+		unsigned int len;
+		if (!_internal_get_from_bb_string_alloc (bb, &tmp, &len)) {
+			return false;
+		}
+		*val = xmmsv_new_string (tmp);
+		free (tmp);
+		return *val != NULL;
+	}
+
+	if (!_internal_get_from_bb_string_ref (bb, &s, &tmp)) {
+		return false;
+	}
+
+	if (tmp) {
+		*val = xmmsv_new_string (tmp);
+		free (tmp);
+	} else {
+		*val = _xmmsv_new_string_view (s, owner);
+	}
+
+	return *val != NULL;
+}
+
+/**
+ * Create a binary value, referencing the owner's buffer if one is
+ * given and the data is byte aligned.
+ */
+static bool
+_internal_get_from_bb_bin_value (xmmsv_t *bb, xmmsv_t *owner, xmmsv_t **val)
+{
+	const unsigned char *data;
+	unsigned char *d;
+	unsigned int len;
+	int32_t l;
+
+	if (owner) {
+		int pos = xmmsv_bitbuffer_pos (bb);
+
+		if (!_internal_get_from_bb_int32_positive (bb, &l)) {
+			return false;
+		}
+
+		if (_xmmsv_bitbuffer_get_data_ref (bb, l, &data)) {
+			*val = _xmmsv_new_bin_view (data, l, owner);
+			return *val != NULL;
+		}
+
+		xmmsv_bitbuffer_goto (bb, pos);
+	}
+
+	if (!_internal_get_from_bb_bin_alloc (bb, &d, &len)) {
+		return false;
+	}
+
+	*val = xmmsv_new_bin (d, len);
+	free (d);
+
+	return *val != NULL;
+}
+
 static bool
-_internal_get_from_bb_collection_alloc (xmmsv_t *bb, xmmsv_t **coll)
+_internal_get_from_bb_collection_alloc (xmmsv_t *bb, xmmsv_t *owner,
+                                        xmmsv_t **coll)
 {
 	xmmsv_t *dict, *list;
 	int32_t type;
@@ -382,19 +507,19 @@ _internal_get_from_bb_collection_alloc (xmmsv_t *bb, xmmsv_t **coll)
 	*coll = xmmsv_new_coll (type);
 
 	/* Get the attributes */
-	if (!_internal_get_from_bb_value_dict_alloc (bb, &dict)) {
+	if (!_internal_get_from_bb_value_dict_alloc (bb, owner, &dict)) {
 		goto err;
 	}
 	xmmsv_coll_attributes_set (*coll, dict);
 	xmmsv_unref (dict);
 
-	if (!_internal_get_from_bb_value_list_alloc (bb, &list)) {
+	if (!_internal_get_from_bb_value_list_alloc (bb, owner, &list)) {
 		goto err;
 	}
 	xmmsv_coll_idlist_set (*coll, list);
 	xmmsv_unref (list);
 
-	if (!_internal_get_from_bb_value_list_alloc (bb, &list)) {
+	if (!_internal_get_from_bb_value_list_alloc (bb, owner, &list)) {
 		goto err;
 	}
 	xmmsv_coll_operands_set (*coll, list);
@@ -410,12 +535,13 @@ err:
 
 
 static bool
-_internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_t **val)
+_internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_t *owner,
+                                        xmmsv_t **val)
 {
 	xmmsv_t *dict;
 	int32_t len;
-	unsigned int ignore;
-	char *key;
+	const char *key;
+	char *tmp;
 
 	dict = xmmsv_new_dict ();
 
@@ -426,17 +552,18 @@ _internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_t **val)
 	while (len--) {
 		xmmsv_t *v;
 
-		if (!_internal_get_from_bb_string_alloc (bb, &key, &ignore)) {
+		/* the dict copies the key, no need for a temporary allocation */
+		if (!_internal_get_from_bb_string_ref (bb, &key, &tmp)) {
 			goto err;
 		}
 
-		if (!xmmsv_bitbuffer_deserialize_value (bb, &v)) {
-			free (key);
+		if (!_internal_get_from_bb_value_alloc (bb, owner, &v)) {
+			free (tmp);
 			goto err;
 		}
 
 		xmmsv_dict_set (dict, key, v);
-		free (key);
+		free (tmp);
 		xmmsv_unref (v);
 	}
 
@@ -451,7 +578,8 @@ err:
 }
 
 static bool
-_internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_t **val)
+_internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_t *owner,
+                                        xmmsv_t **val)
 {
 	xmmsv_t *list;
 	int32_t len, type;
@@ -472,7 +600,7 @@ _internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_t **val)
 
 		while (len--) {
 			xmmsv_t *v;
-			if (!_internal_get_from_bb_value_of_type_alloc (bb, type, &v)) {
+			if (!_internal_get_from_bb_value_of_type_alloc (bb, owner, type, &v)) {
 				goto err;
 			}
 			xmmsv_list_append (list, v);
@@ -481,7 +609,7 @@ _internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_t **val)
 	} else {
 		while (len--) {
 			xmmsv_t *v;
-			if (!xmmsv_bitbuffer_deserialize_value (bb, &v)) {
+			if (!_internal_get_from_bb_value_alloc (bb, owner, &v)) {
 				goto err;
 			}
 			xmmsv_list_append (list, v);
@@ -500,14 +628,13 @@ err:
 }
 
 static bool
-_internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_type_t type,
-                                           xmmsv_t **val)
+_internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_t *owner,
+                                           xmmsv_type_t type, xmmsv_t **val)
 {
 	int64_t i;
 	float f;
 	uint32_t len;
 	char *s;
-	unsigned char *d;
 
 	switch (type) {
 		case XMMSV_TYPE_ERROR:
@@ -530,36 +657,32 @@ _internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_type_t type,
 			*val = xmmsv_new_float (f);
 			break;
 		case XMMSV_TYPE_STRING:
-			if (!_internal_get_from_bb_string_alloc (bb, &s, &len)) {
+			if (!_internal_get_from_bb_string_value (bb, owner, val)) {
 				return false;
 			}
-			*val = xmmsv_new_string (s);
-			free (s);
 			break;
 		case XMMSV_TYPE_DICT:
-			if (!_internal_get_from_bb_value_dict_alloc (bb, val)) {
+			if (!_internal_get_from_bb_value_dict_alloc (bb, owner, val)) {
 				return false;
 			}
 			break;
 
 		case XMMSV_TYPE_LIST :
-			if (!_internal_get_from_bb_value_list_alloc (bb, val)) {
+			if (!_internal_get_from_bb_value_list_alloc (bb, owner, val)) {
 				return false;
 			}
 			break;
 
 		case XMMSV_TYPE_COLL:
-			if (!_internal_get_from_bb_collection_alloc (bb, val)) {
+			if (!_internal_get_from_bb_collection_alloc (bb, owner, val)) {
 				return false;
 			}
 			break;
 
 		case XMMSV_TYPE_BIN:
-			if (!_internal_get_from_bb_bin_alloc (bb, &d, &len)) {
+			if (!_internal_get_from_bb_bin_value (bb, owner, val)) {
 				return false;
 			}
-			*val = xmmsv_new_bin (d, len);
-			free (d);
 			break;
 
 		case XMMSV_TYPE_NONE:
@@ -646,8 +769,8 @@ xmmsv_bitbuffer_serialize_value (xmmsv_t *bb, xmmsv_t *v)
 }
 
 
-int
-xmmsv_bitbuffer_deserialize_value (xmmsv_t *bb, xmmsv_t **val)
+static bool
+_internal_get_from_bb_value_alloc (xmmsv_t *bb, xmmsv_t *owner, xmmsv_t **val)
 {
 	int32_t type;
 
@@ -655,7 +778,27 @@ xmmsv_bitbuffer_deserialize_value (xmmsv_t *bb, xmmsv_t **val)
 		return false;
 	}
 
-	return _internal_get_from_bb_value_of_type_alloc (bb, type, val);
+	return _internal_get_from_bb_value_of_type_alloc (bb, owner, type, val);
+}
+
+int
+xmmsv_bitbuffer_deserialize_value (xmmsv_t *bb, xmmsv_t **val)
+{
+	return _internal_get_from_bb_value_alloc (bb, NULL, val);
+}
+
+/**
+ * Deserialize a value without copying strings and binary data.
+ *
+ * Strings and binary data in the resulting value point straight into
+ * the bitbuffer, which is referenced until the last such value is
+ * freed. The bitbuffer must not be written to while views into it
+ * are alive. Use #xmmsv_copy to detach a value from the buffer.
+ */
+int
+xmmsv_bitbuffer_deserialize_value_view (xmmsv_t *bb, xmmsv_t **val)
+{
+	return _internal_get_from_bb_value_alloc (bb, bb, val);
 }
 
 
@@ -704,3 +847,34 @@ xmmsv_deserialize (xmmsv_t *v)
 	xmmsv_unref (bb);
 	return res;
 }
+
+/**
+ * Deserialize a value without copying strings and binary data.
+ *
+ * Like #xmmsv_deserialize but strings and binary data in the result
+ * reference the serialized data, keeping v alive until the last of
+ * them is freed.
+ *
+ * @param v The serialized value, as returned by #xmmsv_serialize.
+ * @return The deserialized value, or NULL on failure.
+ */
+xmmsv_t *
+xmmsv_deserialize_view (xmmsv_t *v)
+{
+	xmmsv_t *bb;
+	xmmsv_t *res;
+	const unsigned char *data;
+	uint32_t len;
+
+	if (!xmmsv_get_bin (v, &data, &len))
+		return NULL;
+
+	bb = xmmsv_new_bitbuffer_ro (data, len);
+
+	if (!_internal_get_from_bb_value_alloc (bb, v, &res)) {
+		xmmsv_unref (bb);
+		return NULL;
+	}
+	xmmsv_unref (bb);
+	return res;
+}
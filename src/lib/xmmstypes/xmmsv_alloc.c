@@ -0,0 +1,300 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/** @file
+ * Allocator for value headers and short strings.
+ *
+ * Values are created and destroyed in huge numbers, so freed chunks of
+ * the most common sizes are kept on per-thread free lists and handed
+ * out again without going through malloc. Each list is bounded, so a
+ * thread that frees a large tree returns most of it to the system.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <xmmscpriv/xmmsv.h>
+#include <xmmscpriv/xmmsc_util.h>
+
+#ifdef XMMSV_ALLOC_CACHE
+#include <pthread.h>
+#endif
+
+typedef struct xmmsv_alloc_chunk_St {
+	struct xmmsv_alloc_chunk_St *next;
+} xmmsv_alloc_chunk_t;
+
+/* size classes: value headers, then strings up to 16, 32 and 64 bytes */
+#define XMMSV_ALLOC_CLASSES 4
+#define XMMSV_ALLOC_MAX_STRING 64
+
+/* max number of free chunks kept around per class and thread */
+static const int xmmsv_alloc_cache_limit[XMMSV_ALLOC_CLASSES] = {
+	4096, 1024, 1024, 512
+};
+
+typedef struct xmmsv_alloc_cache_St {
+	xmmsv_alloc_chunk_t *free[XMMSV_ALLOC_CLASSES];
+	int count[XMMSV_ALLOC_CLASSES];
+
+	int64_t allocations;
+	int64_t releases;
+	int64_t cache_hits;
+
+	struct xmmsv_alloc_cache_St *next;
+} xmmsv_alloc_cache_t;
+
+/* totals of exited threads, and all live caches */
+static xmmsv_alloc_cache_t xmmsv_alloc_totals;
+
+#ifdef XMMSV_ALLOC_CACHE
+
+static __thread xmmsv_alloc_cache_t *xmmsv_alloc_thread_cache;
+static pthread_key_t xmmsv_alloc_key;
+static pthread_once_t xmmsv_alloc_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t xmmsv_alloc_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+_xmmsv_alloc_cache_destroy (void *data)
+{
+	xmmsv_alloc_cache_t *cache = data;
+	xmmsv_alloc_cache_t **prev;
+	xmmsv_alloc_chunk_t *chunk;
+	int i;
+
+	for (i = 0; i < XMMSV_ALLOC_CLASSES; i++) {
+		while ((chunk = cache->free[i])) {
+			cache->free[i] = chunk->next;
+			free (chunk);
+		}
+	}
+
+	pthread_mutex_lock (&xmmsv_alloc_mutex);
+	for (prev = &xmmsv_alloc_totals.next; *prev; prev = &(*prev)->next) {
+		if (*prev == cache) {
+			*prev = cache->next;
+			break;
+		}
+	}
+	xmmsv_alloc_totals.allocations += cache->allocations;
+	xmmsv_alloc_totals.releases += cache->releases;
+	xmmsv_alloc_totals.cache_hits += cache->cache_hits;
+	pthread_mutex_unlock (&xmmsv_alloc_mutex);
+
+	xmmsv_alloc_thread_cache = NULL;
+	free (cache);
+}
+
+static void
+_xmmsv_alloc_key_create (void)
+{
+	pthread_key_create (&xmmsv_alloc_key, _xmmsv_alloc_cache_destroy);
+}
+
+static xmmsv_alloc_cache_t *
+_xmmsv_alloc_cache_get (void)
+{
+	xmmsv_alloc_cache_t *cache = xmmsv_alloc_thread_cache;
+
+	if (cache) {
+		return cache;
+	}
+
+	pthread_once (&xmmsv_alloc_once, _xmmsv_alloc_key_create);
+
+	cache = x_new0 (xmmsv_alloc_cache_t, 1);
+	if (!cache) {
+		return NULL;
+	}
+
+	pthread_mutex_lock (&xmmsv_alloc_mutex);
+	cache->next = xmmsv_alloc_totals.next;
+	xmmsv_alloc_totals.next = cache;
+	pthread_mutex_unlock (&xmmsv_alloc_mutex);
+
+	pthread_setspecific (xmmsv_alloc_key, cache);
+	xmmsv_alloc_thread_cache = cache;
+
+	return cache;
+}
+
+#define xmmsv_alloc_lock() pthread_mutex_lock (&xmmsv_alloc_mutex)
+#define xmmsv_alloc_unlock() pthread_mutex_unlock (&xmmsv_alloc_mutex)
+
+#else
+
+/* Without thread local storage nothing is cached */
+#define _xmmsv_alloc_cache_get() NULL
+#define xmmsv_alloc_lock()
+#define xmmsv_alloc_unlock()
+
+#endif
+
+static int
+_xmmsv_alloc_class (size_t size)
+{
+	if (size == sizeof (xmmsv_t)) {
+		return 0;
+	} else if (size <= 16) {
+		return 1;
+	} else if (size <= 32) {
+		return 2;
+	} else if (size <= XMMSV_ALLOC_MAX_STRING) {
+		return 3;
+	}
+	return -1;
+}
+
+static const size_t xmmsv_alloc_class_size[XMMSV_ALLOC_CLASSES] = {
+	sizeof (xmmsv_t), 16, 32, XMMSV_ALLOC_MAX_STRING
+};
+
+/**
+ * Allocate size bytes, reusing a cached chunk if possible.
+ * Must be released with #_xmmsv_release passing the same size.
+ * @internal
+ */
+void *
+_xmmsv_alloc (size_t size)
+{
+	xmmsv_alloc_cache_t *cache;
+	xmmsv_alloc_chunk_t *chunk;
+	int cls;
+
+	cls = _xmmsv_alloc_class (size);
+	cache = _xmmsv_alloc_cache_get ();
+
+	if (!cache) {
+		return malloc (cls < 0 ? size : xmmsv_alloc_class_size[cls]);
+	}
+
+	cache->allocations++;
+
+	if (cls < 0) {
+		return malloc (size);
+	}
+
+	chunk = cache->free[cls];
+	if (chunk) {
+		cache->free[cls] = chunk->next;
+		cache->count[cls]--;
+		cache->cache_hits++;
+		return chunk;
+	}
+
+	return malloc (xmmsv_alloc_class_size[cls]);
+}
+
+/**
+ * Release memory allocated with #_xmmsv_alloc.
+ * @internal
+ */
+void
+_xmmsv_release (void *ptr, size_t size)
+{
+	xmmsv_alloc_cache_t *cache;
+	xmmsv_alloc_chunk_t *chunk = ptr;
+	int cls;
+
+	if (!ptr) {
+		return;
+	}
+
+	cls = _xmmsv_alloc_class (size);
+	cache = _xmmsv_alloc_cache_get ();
+
+	if (!cache) {
+		free (ptr);
+		return;
+	}
+
+	cache->releases++;
+
+	if (cls < 0 || cache->count[cls] >= xmmsv_alloc_cache_limit[cls]) {
+		free (ptr);
+		return;
+	}
+
+	chunk->next = cache->free[cls];
+	cache->free[cls] = chunk;
+	cache->count[cls]++;
+}
+
+/**
+ * Duplicate a string into memory from #_xmmsv_alloc.
+ * Must be freed with #_xmmsv_strfree.
+ * @internal
+ */
+char *
+_xmmsv_strdup (const char *str)
+{
+	size_t len = strlen (str) + 1;
+	char *ret;
+
+	ret = _xmmsv_alloc (len);
+	if (ret) {
+		memcpy (ret, str, len);
+	}
+
+	return ret;
+}
+
+/**
+ * Free a string returned by #_xmmsv_strdup.
+ * @internal
+ */
+void
+_xmmsv_strfree (char *str)
+{
+	if (str) {
+		_xmmsv_release (str, strlen (str) + 1);
+	}
+}
+
+/**
+ * Get statistics about the value allocator.
+ *
+ * Counters are only maintained when the thread cache is compiled in,
+ * otherwise they are all zero.
+ *
+ * @param live Number of chunks currently in use, or NULL.
+ * @param allocations Total number of allocations, or NULL.
+ * @param cache_hits Number of allocations served from the cache, or NULL.
+ */
+void
+xmmsv_alloc_stats_get (int64_t *live, int64_t *allocations, int64_t *cache_hits)
+{
+	xmmsv_alloc_cache_t sum, *cache;
+
+	xmmsv_alloc_lock ();
+	sum = xmmsv_alloc_totals;
+	for (cache = xmmsv_alloc_totals.next; cache; cache = cache->next) {
+		sum.allocations += cache->allocations;
+		sum.releases += cache->releases;
+		sum.cache_hits += cache->cache_hits;
+	}
+	xmmsv_alloc_unlock ();
+
+	if (live) {
+		*live = sum.allocations - sum.releases;
+	}
+	if (allocations) {
+		*allocations = sum.allocations;
+	}
+	if (cache_hits) {
+		*cache_hits = sum.cache_hits;
+	}
+}
@@ -15,7 +15,9 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #include <xmmscpriv/xmmsv.h>
 #include <xmmscpriv/xmmsc_util.h>
@@ -91,6 +93,20 @@ xmmsv_bitbuffer_get_bits (xmmsv_t *v, int bits, int64_t *res)
 		return 1;
 	}
 
+	if (bits % 8 == 0 && v->value.bit.pos % 8 == 0) {
+		const unsigned char *data;
+
+		if (!_xmmsv_bitbuffer_get_data_ref (v, bits / 8, &data))
+			return 0;
+
+		r = 0;
+		for (i = 0; i < bits / 8; i++) {
+			r = (r << 8) | data[i];
+		}
+		*res = r;
+		return 1;
+	}
+
 	r = 0;
 	for (i = 0; i < bits; i++) {
 		t = 0;
@@ -105,6 +121,14 @@ xmmsv_bitbuffer_get_bits (xmmsv_t *v, int bits, int64_t *res)
 int
 xmmsv_bitbuffer_get_data (xmmsv_t *v, unsigned char *b, int len)
 {
+	const unsigned char *data;
+
+	/* byte aligned reads are the common case, skip the bit twiddling */
+	if (_xmmsv_bitbuffer_get_data_ref (v, len, &data)) {
+		memcpy (b, data, len);
+		return 1;
+	}
+
 	while (len) {
 		int64_t t;
 		if (!xmmsv_bitbuffer_get_bits (v, 8, &t))
@@ -116,6 +140,40 @@ xmmsv_bitbuffer_get_data (xmmsv_t *v, unsigned char *b, int len)
 	return 1;
 }
 
+/* Make room for at least bits bits, positions are ints so the
+ * buffer can never hold more than INT_MAX bits.
+ */
+static int
+_xmmsv_bitbuffer_reserve (xmmsv_t *v, int64_t bits)
+{
+	int64_t ol, nl;
+	unsigned char *buf;
+
+	if (bits <= v->value.bit.alloclen)
+		return 1;
+
+	x_api_error_if (bits > (INT_MAX & ~7), "bitbuffer size overflow", 0);
+
+	ol = v->value.bit.alloclen;
+	nl = ol * 2;
+	nl = nl < 128 ? 128 : nl;
+	nl = nl < bits ? bits : nl;
+	nl = nl > (INT_MAX & ~7) ? (INT_MAX & ~7) : nl;
+	nl = (nl + 7) & ~7;
+
+	buf = realloc (v->value.bit.buf, nl / 8);
+	if (!buf) {
+		x_oom ();
+		return 0;
+	}
+
+	memset (buf + ol / 8, 0, (nl - ol) / 8);
+	v->value.bit.buf = buf;
+	v->value.bit.alloclen = nl;
+
+	return 1;
+}
+
 int
 xmmsv_bitbuffer_put_bits (xmmsv_t *v, int bits, int64_t d)
 {
@@ -129,16 +187,9 @@ xmmsv_bitbuffer_put_bits (xmmsv_t *v, int bits, int64_t d)
 	if (bits == 1) {
 		pos = v->value.bit.pos;
 
-		if (pos >= v->value.bit.alloclen) {
-			int ol, nl;
-			nl = v->value.bit.alloclen * 2;
-			ol = v->value.bit.alloclen;
-			nl = nl < 128 ? 128 : nl;
-			nl = (nl + 7) & ~7;
-			v->value.bit.buf = realloc (v->value.bit.buf, nl / 8);
-			memset (v->value.bit.buf + ol / 8, 0, (nl - ol) / 8);
-			v->value.bit.alloclen = nl;
-		}
+		if (!_xmmsv_bitbuffer_reserve (v, (int64_t) pos + 1))
+			return 0;
+
 		t = v->value.bit.buf[pos / 8];
 
 		t = (t & (~(1<<(7-(pos % 8))))) | (d << (7-(pos % 8)));
@@ -151,6 +202,20 @@ xmmsv_bitbuffer_put_bits (xmmsv_t *v, int bits, int64_t d)
 		return 1;
 	}
 
+	if (bits % 8 == 0 && v->value.bit.pos % 8 == 0) {
+		unsigned char data[8];
+		int n = bits / 8;
+
+		x_api_error_if (n > 8, "more than 64 bits requested", 0);
+
+		for (i = n - 1; i >= 0; i--) {
+			data[i] = d & 0xff;
+			d >>= 8;
+		}
+
+		return xmmsv_bitbuffer_put_data (v, data, n);
+	}
+
 	for (i = 0; i < bits; i++) {
 		if (!xmmsv_bitbuffer_put_bits (v, 1, !!(d & (1LL << (bits-i-1)))))
 			return 0;
@@ -174,6 +239,23 @@ xmmsv_bitbuffer_put_bits_at (xmmsv_t *v, int bits, int64_t d, int offset)
 int
 xmmsv_bitbuffer_put_data (xmmsv_t *v, const unsigned char *b, int len)
 {
+	x_api_error_if (v->value.bit.ro, "write to readonly bitbuffer", 0);
+
+	if (len > 0 && v->value.bit.pos % 8 == 0) {
+		int pos = v->value.bit.pos;
+		int64_t end = pos + (int64_t) len * 8;
+
+		if (!_xmmsv_bitbuffer_reserve (v, end))
+			return 0;
+
+		memcpy (v->value.bit.buf + pos / 8, b, len);
+
+		v->value.bit.pos = end;
+		if (v->value.bit.pos > v->value.bit.len)
+			v->value.bit.len = v->value.bit.pos;
+		return 1;
+	}
+
 	while (len) {
 		int t;
 		t = *b;
@@ -185,6 +267,33 @@ xmmsv_bitbuffer_put_data (xmmsv_t *v, const unsigned char *b, int len)
 	return 1;
 }
 
+/**
+ * Get a pointer to len bytes at the current position and advance past them.
+ *
+ * Only succeeds when the current position is byte aligned, which is
+ * always the case for values serialized by #xmmsv_bitbuffer_serialize_value.
+ * The returned data is owned by the bitbuffer.
+ * @internal
+ */
+int
+_xmmsv_bitbuffer_get_data_ref (xmmsv_t *v, int len, const unsigned char **res)
+{
+	int pos = v->value.bit.pos;
+
+	if (len < 0 || pos % 8 != 0) {
+		return 0;
+	}
+
+	if (len > (v->value.bit.len - pos) / 8) {
+		return 0;
+	}
+
+	*res = v->value.bit.buf + pos / 8;
+	v->value.bit.pos += len * 8;
+
+	return 1;
+}
+
 int
 xmmsv_bitbuffer_align (xmmsv_t *v)
 {
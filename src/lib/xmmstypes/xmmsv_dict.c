@@ -26,12 +26,17 @@ typedef struct xmmsv_dict_data_St {
 	xmmsv_t *value;
 } xmmsv_dict_data_t;
 
+#define START_SIZE 2
+
 struct xmmsv_dict_internal_St {
 	int elems;
 	int size;
 	xmmsv_dict_data_t *data;
 
 	x_list_t *iterators;
+
+	/* small dicts live in here, saving an allocation */
+	xmmsv_dict_data_t inline_data[1 << START_SIZE];
 };
 
 struct xmmsv_dict_iter_St {
@@ -45,7 +50,28 @@ static void _xmmsv_dict_iter_free (xmmsv_dict_iter_t *it);
 #define HASH_FILL_LIM 7
 #define DELETED_STR ((char*)-1)
 #define DICT_INIT_DATA(s) {.hash = _xmmsv_dict_hash (s, strlen (s)), .str = (char*)s}
-#define START_SIZE 2
+
+/* Keys that show up in nearly every dict built from medialib results,
+ * including the source names used as keys in property dicts. Entries
+ * with one of these keys point into this table instead of owning a
+ * copy of the key. Must be kept sorted.
+ */
+static const char _xmmsv_dict_shared_keys[][16] = {
+	"added", "album", "album_id", "albumartist", "artist", "artist_id",
+	"bitrate", "chain", "channels", "comment", "compilation", "date",
+	"duration", "filesize", "genre", "id", "key", "laststarted", "lmod",
+	"mime", "partofset", "performer", "picture_front", "plugin/apefile",
+	"plugin/avcodec", "plugin/cue", "plugin/file", "plugin/flac",
+	"plugin/id3v2", "plugin/mad", "plugin/mp4", "plugin/mpg123",
+	"plugin/nibbler", "plugin/opus", "plugin/playlist", "plugin/segment",
+	"plugin/sndfile", "plugin/vorbis", "plugin/wave", "publisher",
+	"sample_format", "samplerate", "server", "size", "source", "starttime",
+	"status", "timesplayed", "title", "tracknr", "type", "url", "value"
+};
+
+#define SHARED_KEYS_COUNT (sizeof (_xmmsv_dict_shared_keys) / sizeof (_xmmsv_dict_shared_keys[0]))
+#define IS_SHARED_KEY(s) ((const char *) (s) >= _xmmsv_dict_shared_keys[0] && \
+                          (const char *) (s) < _xmmsv_dict_shared_keys[SHARED_KEYS_COUNT])
 
 /* MurmurHash2, by Austin Appleby */
 static uint32_t
@@ -101,6 +127,40 @@ _xmmsv_dict_hash (const void *key, int len)
 	return h;
 }
 
+static int
+_xmmsv_dict_shared_key_cmp (const void *a, const void *b)
+{
+	return strcmp ((const char *) a, (const char *) b);
+}
+
+/* Returns the shared copy of key if there is one, or a new copy otherwise */
+static char *
+_xmmsv_dict_key_dup (const char *key)
+{
+	const char *shared;
+
+	if (IS_SHARED_KEY (key)) {
+		return (char *) key;
+	}
+
+	shared = bsearch (key, _xmmsv_dict_shared_keys, SHARED_KEYS_COUNT,
+	                  sizeof (_xmmsv_dict_shared_keys[0]),
+	                  _xmmsv_dict_shared_key_cmp);
+	if (shared) {
+		return (char *) shared;
+	}
+
+	return _xmmsv_strdup (key);
+}
+
+static void
+_xmmsv_dict_key_free (char *key)
+{
+	if (!IS_SHARED_KEY (key)) {
+		_xmmsv_strfree (key);
+	}
+}
+
 /* Searches the hash table for an entry matching the hash and string in data.
  * It will save the found position in pos.
  * If a deleted position was found before the key, it will be saved in deleted
@@ -124,7 +184,8 @@ _xmmsv_dict_search (xmmsv_dict_internal_t *dict, xmmsv_dict_data_t data,
 			}
 			/* If we found the entry we save it in the pos pointer */
 		} else if (dict->data[bucket].hash == data.hash
-		           && strcmp (dict->data[bucket].str, data.str) == 0) {
+		           && (dict->data[bucket].str == data.str
+		               || strcmp (dict->data[bucket].str, data.str) == 0)) {
 			*pos = bucket;
 			return 1;
 		}
@@ -160,7 +221,7 @@ _xmmsv_dict_insert (xmmsv_dict_internal_t *dict, xmmsv_dict_data_t data, int all
 	} else {
 		/* Otherwise we insert a new entry */
 		if (alloc)
-			data.str = strdup (data.str);
+			data.str = _xmmsv_dict_key_dup (data.str);
 		dict->elems++;
 		/* If we found a deleted entry before an empty one we use the free entry */
 		if (deleted != -1) {
@@ -176,7 +237,7 @@ _xmmsv_dict_insert (xmmsv_dict_internal_t *dict, xmmsv_dict_data_t data, int all
 static void
 _xmmsv_dict_remove (xmmsv_dict_internal_t *dict, int pos)
 {
-	free ((void*)dict->data[pos].str);
+	_xmmsv_dict_key_free (dict->data[pos].str);
 	dict->data[pos].str = DELETED_STR;
 	xmmsv_unref (dict->data[pos].value);
 	dict->data[pos].value = NULL;
@@ -205,7 +266,9 @@ _xmmsv_dict_resize (xmmsv_dict_internal_t *dict)
 		}
 	}
 
-	free (old_data);
+	if (old_data != dict->inline_data) {
+		free (old_data);
+	}
 }
 
 static xmmsv_dict_internal_t *
@@ -219,14 +282,8 @@ _xmmsv_dict_new (void)
 		return NULL;
 	}
 
-	dict->size = 2;
-	dict->data = x_new0 (xmmsv_dict_data_t, (1 << dict->size));
-
-	if (!dict->data) {
-		x_oom ();
-		free (dict);
-		return NULL;
-	}
+	dict->size = START_SIZE;
+	dict->data = dict->inline_data;
 
 	return dict;
 }
@@ -246,13 +303,15 @@ _xmmsv_dict_free (xmmsv_dict_internal_t *dict)
 	for (i = (1 << dict->size) - 1; i >= 0; i--) {
 		if (dict->data[i].str != NULL) {
 			if (dict->data[i].str != DELETED_STR) {
-				free (dict->data[i].str);
+				_xmmsv_dict_key_free (dict->data[i].str);
 				xmmsv_unref (dict->data[i].value);
 			}
 			dict->data[i].str = NULL;
 		}
 	}
-	free (dict->data);
+	if (dict->data != dict->inline_data) {
+		free (dict->data);
+	}
 	free (dict);
 }
 
@@ -483,12 +542,13 @@ xmmsv_dict_clear (xmmsv_t *dictv)
 	for (i = (1 << dict->size) - 1; i >= 0; i--) {
 		if (dict->data[i].str != NULL) {
 			if (dict->data[i].str != DELETED_STR) {
-				free (dict->data[i].str);
+				_xmmsv_dict_key_free (dict->data[i].str);
 				xmmsv_unref (dict->data[i].value);
 			}
 			dict->data[i].str = NULL;
 		}
 	}
+	dict->elems = 0;
 
 	return 1;
 }
@@ -48,12 +48,13 @@ _xmmsv_new (xmmsv_type_t type)
 {
 	xmmsv_t *val;
 
-	val = x_new0 (xmmsv_t, 1);
+	val = _xmmsv_alloc (sizeof (xmmsv_t));
 	if (!val) {
 		x_oom ();
 		return NULL;
 	}
 
+	memset (val, 0, sizeof (xmmsv_t));
 	val->type = type;
 
 	return xmmsv_ref (val);
@@ -75,11 +76,13 @@ _xmmsv_free (xmmsv_t *val)
 		case XMMSV_TYPE_FLOAT :
 			break;
 		case XMMSV_TYPE_ERROR :
-			free (val->value.error);
+			_xmmsv_strfree (val->value.error);
 			val->value.error = NULL;
 			break;
 		case XMMSV_TYPE_STRING :
-			free (val->value.string);
+			if (!val->owner) {
+				_xmmsv_strfree (val->value.string);
+			}
 			val->value.string = NULL;
 			break;
 		case XMMSV_TYPE_COLL:
@@ -87,7 +90,9 @@ _xmmsv_free (xmmsv_t *val)
 			val->value.coll = NULL;
 			break;
 		case XMMSV_TYPE_BIN :
-			free (val->value.bin.data);
+			if (!val->owner) {
+				free (val->value.bin.data);
+			}
 			val->value.bin.len = 0;
 			break;
 		case XMMSV_TYPE_LIST:
@@ -106,7 +111,12 @@ _xmmsv_free (xmmsv_t *val)
 			break;
 	}
 
-	free (val);
+	if (val->owner) {
+		xmmsv_unref (val->owner);
+		val->owner = NULL;
+	}
+
+	_xmmsv_release (val, sizeof (xmmsv_t));
 }
 
 
@@ -135,7 +145,7 @@ xmmsv_new_error (const char *errstr)
 	xmmsv_t *val = _xmmsv_new (XMMSV_TYPE_ERROR);
 
 	if (val) {
-		val->value.error = strdup (errstr);
+		val->value.error = _xmmsv_strdup (errstr);
 	}
 
 	return val;
@@ -194,7 +204,7 @@ xmmsv_new_string (const char *s)
 
 	val = _xmmsv_new (XMMSV_TYPE_STRING);
 	if (val) {
-		val->value.string = strdup (s);
+		val->value.string = _xmmsv_strdup (s);
 	}
 
 	return val;
@@ -216,7 +226,7 @@ xmmsv_new_bin (const unsigned char *data, unsigned int len)
 		/* copy the data! */
 		val->value.bin.data = x_malloc (len);
 		if (!val->value.bin.data) {
-			free (val);
+			_xmmsv_release (val, sizeof (xmmsv_t));
 			x_oom ();
 			return NULL;
 		}
@@ -227,6 +237,57 @@ xmmsv_new_bin (const unsigned char *data, unsigned int len)
 	return val;
 }
 
+/**
+ * Allocates a new string #xmmsv_t referencing the string data in
+ * place instead of copying it.
+ *
+ * The owner is referenced for as long as the new value is alive, so
+ * the string must be stored inside (and stay unmodified in) the owner.
+ * @internal
+ */
+xmmsv_t *
+_xmmsv_new_string_view (const char *s, xmmsv_t *owner)
+{
+	xmmsv_t *val;
+
+	x_return_val_if_fail (s, NULL);
+	x_return_val_if_fail (owner, NULL);
+	x_return_val_if_fail (xmmsv_utf8_validate (s), NULL);
+
+	val = _xmmsv_new (XMMSV_TYPE_STRING);
+	if (val) {
+		val->value.string = (char *) s;
+		val->owner = xmmsv_ref (owner);
+	}
+
+	return val;
+}
+
+/**
+ * Allocates a new binary data #xmmsv_t referencing the data in place
+ * instead of copying it.
+ *
+ * @see _xmmsv_new_string_view
+ * @internal
+ */
+xmmsv_t *
+_xmmsv_new_bin_view (const unsigned char *data, unsigned int len,
+                     xmmsv_t *owner)
+{
+	xmmsv_t *val;
+
+	x_return_val_if_fail (owner, NULL);
+
+	val = _xmmsv_new (XMMSV_TYPE_BIN);
+	if (val) {
+		val->value.bin.data = (unsigned char *) data;
+		val->value.bin.len = len;
+		val->owner = xmmsv_ref (owner);
+	}
+
+	return val;
+}
+
 /**
  * References the #xmmsv_t
  *
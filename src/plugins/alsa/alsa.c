@@ -21,11 +21,12 @@
 #include <alsa/pcm.h>
 
 #include <glib.h>
+#include <time.h>
 
 /*
  *  Defines
  */
-#define BUFFER_TIME        500000
+#define BUFFER_TIME        "500"
 #define MAX_CHANNELS       8
 
 /*
@@ -35,6 +36,11 @@ typedef struct xmms_alsa_data_St {
 	snd_pcm_t *pcm;
 	snd_mixer_t *mixer;
 	snd_mixer_elem_t *mixer_elem;
+
+	/* set if the device buffer is filled in place */
+	gboolean mmap;
+	snd_pcm_uframes_t period_size;
+	guint rate;
 } xmms_alsa_data_t;
 
 static const struct {
@@ -81,6 +87,9 @@ static const struct {
 static gboolean xmms_alsa_plugin_setup (xmms_output_plugin_t *plugin);
 static void xmms_alsa_flush (xmms_output_t *output);
 static void xmms_alsa_close (xmms_output_t *output);
+static gboolean xmms_alsa_fill (xmms_output_t *output, xmms_error_t *err);
+static gboolean xmms_alsa_recover (xmms_alsa_data_t *data, gint err,
+                                   xmms_error_t *error);
 static void xmms_alsa_write (xmms_output_t *output, gpointer buffer, gint len,
                              xmms_error_t *err);
 static guint xmms_alsa_buffer_bytes_get (xmms_output_t *output);
@@ -89,8 +98,10 @@ static gboolean xmms_alsa_new (xmms_output_t *output);
 static void xmms_alsa_destroy (xmms_output_t *output);
 static gboolean xmms_alsa_format_set (xmms_output_t *output,
                                       const xmms_stream_type_t *format);
-static gboolean xmms_alsa_set_hwparams (xmms_alsa_data_t *data,
+static gboolean xmms_alsa_set_hwparams (xmms_output_t *output,
+                                        xmms_alsa_data_t *data,
                                         const xmms_stream_type_t *format);
+static gboolean xmms_alsa_set_swparams (xmms_alsa_data_t *data);
 static gboolean xmms_alsa_volume_set (xmms_output_t *output,
                                       const gchar *channel,
                                       guint volume);
@@ -138,6 +149,7 @@ xmms_alsa_plugin_setup (xmms_output_plugin_t *plugin)
 	methods.volume_set = xmms_alsa_volume_set;
 
 	methods.write = xmms_alsa_write;
+	methods.fill = xmms_alsa_fill;
 
 	methods.latency_get = xmms_alsa_buffer_bytes_get;
 
@@ -155,6 +167,12 @@ xmms_alsa_plugin_setup (xmms_output_plugin_t *plugin)
 	xmms_output_plugin_config_property_register (plugin, "mixer_index", "0",
 	                                             NULL, NULL);
 
+	xmms_output_plugin_config_property_register (plugin, "buffer_time",
+	                                             BUFFER_TIME, NULL, NULL);
+
+	xmms_output_plugin_config_property_register (plugin, "mmap", "0",
+	                                             NULL, NULL);
+
 	return TRUE;
 }
 
@@ -384,6 +402,7 @@ xmms_alsa_close (xmms_output_t *output)
 		                snd_strerror (err));
 	} else {
 		data->pcm = NULL;
+		data->mmap = FALSE;
 		XMMS_DBG ("audio device closed.");
 	}
 }
@@ -391,21 +410,30 @@ xmms_alsa_close (xmms_output_t *output)
 /**
  * Setup hardware parameters.
  *
+ * The buffer time is read from the config each time, so a new value
+ * is picked up the next time the device is configured.
+ *
+ * @param output The output structure.
  * @param data Internal plugin structure.
  *
  * @return TRUE on success, FALSE on error
  */
 static gboolean
-xmms_alsa_set_hwparams (xmms_alsa_data_t *data,
+xmms_alsa_set_hwparams (xmms_output_t *output, xmms_alsa_data_t *data,
                         const xmms_stream_type_t *format)
 {
 	snd_pcm_format_t alsa_format = SND_PCM_FORMAT_UNKNOWN;
+	const xmms_config_property_t *cv;
 	gint err, tmp, i, fmt;
-	guint requested_buffer_time = BUFFER_TIME;
+	guint requested_buffer_time;
 	snd_pcm_hw_params_t *hwparams;
 
 	g_return_val_if_fail (data, FALSE);
 
+	cv = xmms_output_config_lookup (output, "buffer_time");
+	requested_buffer_time = CLAMP (xmms_config_property_get_int (cv),
+	                               10, 10000) * 1000;
+
 	snd_pcm_hw_params_alloca (&hwparams);
 
 	/* what alsa format does this format correspond to? */
@@ -427,13 +455,29 @@ xmms_alsa_set_hwparams (xmms_alsa_data_t *data,
 		return FALSE;
 	}
 
-	/* Set the interleaved read/write format */
-	err = snd_pcm_hw_params_set_access (data->pcm, hwparams,
-	                                    SND_PCM_ACCESS_RW_INTERLEAVED);
-	if (err < 0) {
-		xmms_log_error ("Access type not available for playback: %s",
-		                snd_strerror (err));
-		return FALSE;
+	/* Map the device buffer if asked to, else use interleaved read/write */
+	data->mmap = FALSE;
+
+	cv = xmms_output_config_lookup (output, "mmap");
+	if (xmms_config_property_get_int (cv)) {
+		err = snd_pcm_hw_params_set_access (data->pcm, hwparams,
+		                                    SND_PCM_ACCESS_MMAP_INTERLEAVED);
+		if (err < 0) {
+			xmms_log_info ("Mmap access not available, using read/write: %s",
+			               snd_strerror (err));
+		} else {
+			data->mmap = TRUE;
+		}
+	}
+
+	if (!data->mmap) {
+		err = snd_pcm_hw_params_set_access (data->pcm, hwparams,
+		                                    SND_PCM_ACCESS_RW_INTERLEAVED);
+		if (err < 0) {
+			xmms_log_error ("Access type not available for playback: %s",
+			                snd_strerror (err));
+			return FALSE;
+		}
 	}
 
 	/* Set the sample format */
@@ -458,6 +502,7 @@ xmms_alsa_set_hwparams (xmms_alsa_data_t *data,
 	 *       if the core passed an unsupported samplerate to us!
 	 */
 	tmp = xmms_stream_type_get_int (format, XMMS_STREAM_TYPE_FMT_SAMPLERATE);
+	data->rate = tmp;
 	err = snd_pcm_hw_params_set_rate (data->pcm, hwparams, tmp, 0);
 	if (err < 0) {
 		xmms_log_error ("Rate %iHz not available for playback: %s",
@@ -485,6 +530,53 @@ xmms_alsa_set_hwparams (xmms_alsa_data_t *data,
 		return FALSE;
 	}
 
+	snd_pcm_hw_params_get_period_size (hwparams, &data->period_size, NULL);
+
+	if (data->mmap && !xmms_alsa_set_swparams (data)) {
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Setup software parameters for mmap mode.
+ *
+ * Wake up once a period is free, and timestamp the hardware pointer
+ * so that the delay can be extrapolated to the current time.
+ *
+ * @param data Internal plugin structure.
+ *
+ * @return TRUE on success, FALSE on error
+ */
+static gboolean
+xmms_alsa_set_swparams (xmms_alsa_data_t *data)
+{
+	snd_pcm_sw_params_t *swparams;
+	gint err;
+
+	snd_pcm_sw_params_alloca (&swparams);
+
+	err = snd_pcm_sw_params_current (data->pcm, swparams);
+	if (err < 0) {
+		xmms_log_error ("Unable to get sw params for playback: %s",
+		                snd_strerror (err));
+		return FALSE;
+	}
+
+	snd_pcm_sw_params_set_avail_min (data->pcm, swparams, data->period_size);
+	snd_pcm_sw_params_set_tstamp_mode (data->pcm, swparams,
+	                                   SND_PCM_TSTAMP_ENABLE);
+	snd_pcm_sw_params_set_tstamp_type (data->pcm, swparams,
+	                                   SND_PCM_TSTAMP_TYPE_MONOTONIC);
+
+	err = snd_pcm_sw_params (data->pcm, swparams);
+	if (err < 0) {
+		xmms_log_error ("Unable to set sw params for playback: %s",
+		                snd_strerror (err));
+		return FALSE;
+	}
+
 	return TRUE;
 }
 
@@ -624,7 +716,7 @@ xmms_alsa_format_set (xmms_output_t *output, const xmms_stream_type_t *format)
 	}
 
 	/* Set new audio format*/
-	if (!xmms_alsa_set_hwparams (data, format)) {
+	if (!xmms_alsa_set_hwparams (output, data, format)) {
 		xmms_log_error ("Could not set hwparams, consult your local "
 		                "guru for meditation courses.");
 		return FALSE;
@@ -729,6 +821,51 @@ xmms_alsa_volume_get (xmms_output_t *output, const gchar **names,
 	return TRUE;
 }
 
+/**
+ * Get the delay in mmap mode.
+ *
+ * The delay reported by the driver is from the last hardware pointer
+ * update, which may be up to a period old. Subtract what has been
+ * played since, according to the timestamp of that update.
+ *
+ * @param data Internal plugin structure.
+ * @return The delay in bytes or 0 on failure.
+ */
+static guint
+xmms_alsa_mmap_delay_bytes (xmms_alsa_data_t *data)
+{
+	snd_pcm_status_t *status;
+	snd_htimestamp_t then;
+	struct timespec now;
+	snd_pcm_sframes_t delay;
+	gint64 elapsed;
+
+	snd_pcm_status_alloca (&status);
+
+	if (snd_pcm_status (data->pcm, status) < 0) {
+		return 0;
+	}
+
+	delay = snd_pcm_status_get_delay (status);
+
+	if (snd_pcm_status_get_state (status) == SND_PCM_STATE_RUNNING) {
+		snd_pcm_status_get_htstamp (status, &then);
+		clock_gettime (CLOCK_MONOTONIC, &now);
+
+		elapsed = (now.tv_sec - then.tv_sec) * G_GINT64_CONSTANT (1000000000) +
+		          (now.tv_nsec - then.tv_nsec);
+		if (then.tv_sec && elapsed > 0) {
+			delay -= elapsed * data->rate / 1000000000;
+		}
+	}
+
+	if (delay <= 0) {
+		return 0;
+	}
+
+	return snd_pcm_frames_to_bytes (data->pcm, delay);
+}
+
 /**
  * Get bytes in buffer.
  * Calculates bytes in buffer by subtract buffer size with available frames
@@ -749,6 +886,10 @@ xmms_alsa_buffer_bytes_get (xmms_output_t *output)
 	data = xmms_output_private_data_get (output);
 	g_return_val_if_fail (data, 0);
 
+	if (data->mmap) {
+		return xmms_alsa_mmap_delay_bytes (data);
+	}
+
 	ret = snd_pcm_delay (data->pcm, &avail);
 	if (ret != 0 || avail < 0) {
 		return 0;
@@ -809,25 +950,136 @@ xmms_alsa_write (xmms_output_t *output, gpointer buffer, gint len,
 	frames = snd_pcm_bytes_to_frames (data->pcm, len);
 
 	while (frames > 0) {
-		written = snd_pcm_writei (data->pcm, buffer, frames);
+		if (data->mmap) {
+			written = snd_pcm_mmap_writei (data->pcm, buffer, frames);
+		} else {
+			written = snd_pcm_writei (data->pcm, buffer, frames);
+		}
 
 		if (written > 0) {
 			frames -= written;
 			buffer += snd_pcm_frames_to_bytes (data->pcm, written);
 		} else if (written == -EAGAIN || written == -EINTR) {
 			snd_pcm_wait (data->pcm, 100);
-		} else if (written == -EPIPE || written == -ESTRPIPE) {
-			if (snd_pcm_recover (data->pcm, written, 0) < 0) {
-				gchar *message = g_strdup_printf ("Could not recover PCM device (%s)", snd_strerror (written));
-				xmms_error_set (error, XMMS_ERROR_GENERIC, message);
-				g_free (message);
-			}
 		} else {
-			gchar *message = g_strdup_printf ("Unexpected error from ALSA (%s)", snd_strerror (written));
-			xmms_error_set (error, XMMS_ERROR_GENERIC, message);
-			g_free (message);
+			xmms_alsa_recover (data, written, error);
+		}
+	}
+}
+
+/**
+ * Recover from an error returned by ALSA.
+ *
+ * @param data Internal plugin structure.
+ * @param err The error.
+ * @param error Set if the device could not be recovered.
+ * @return TRUE if the device can be used again.
+ */
+static gboolean
+xmms_alsa_recover (xmms_alsa_data_t *data, gint err, xmms_error_t *error)
+{
+	gchar *message;
+
+	if (err == -EPIPE || err == -ESTRPIPE) {
+		if (snd_pcm_recover (data->pcm, err, 0) >= 0) {
+			return TRUE;
+		}
+		message = g_strdup_printf ("Could not recover PCM device (%s)", snd_strerror (err));
+	} else {
+		message = g_strdup_printf ("Unexpected error from ALSA (%s)", snd_strerror (err));
+	}
+
+	xmms_error_set (error, XMMS_ERROR_GENERIC, message);
+	g_free (message);
+
+	return FALSE;
+}
+
+/**
+ * Fill the device buffer in place when it is mapped.
+ *
+ * Sleeps in poll until a period is free, then reads the output buffer
+ * straight into the mapped area. Song changes and seeks are handled
+ * before mapping, since they may reconfigure the device.
+ *
+ * @param output The output struct containing alsa data.
+ * @param error Set if the device failed.
+ * @return FALSE if not in mmap mode.
+ */
+static gboolean
+xmms_alsa_fill (xmms_output_t *output, xmms_error_t *error)
+{
+	const snd_pcm_channel_area_t *areas;
+	snd_pcm_uframes_t offset, frames;
+	snd_pcm_sframes_t avail, ret;
+	xmms_alsa_data_t *data;
+	gchar *area;
+	gint len;
+
+	g_return_val_if_fail (output, FALSE);
+	data = xmms_output_private_data_get (output);
+	g_return_val_if_fail (data, FALSE);
+
+	if (!data->mmap) {
+		return FALSE;
+	}
+
+	len = xmms_output_read_prepare (output, snd_pcm_frames_to_bytes (data->pcm, data->period_size));
+	if (len < 0) {
+		/* play what is left if the device never got started */
+		if (data->mmap && snd_pcm_state (data->pcm) == SND_PCM_STATE_PREPARED) {
+			snd_pcm_start (data->pcm);
 		}
+		return TRUE;
 	}
+
+	/* a song change may have reconfigured the device */
+	if (!data->mmap) {
+		return FALSE;
+	}
+
+	frames = snd_pcm_bytes_to_frames (data->pcm, len);
+	if (!frames) {
+		return TRUE;
+	}
+
+	while ((avail = snd_pcm_avail_update (data->pcm)) < (snd_pcm_sframes_t) frames) {
+		if (avail < 0) {
+			if (!xmms_alsa_recover (data, avail, error)) {
+				return TRUE;
+			}
+			continue;
+		}
+
+		/* a full buffer is the cue to start the device */
+		if (snd_pcm_state (data->pcm) == SND_PCM_STATE_PREPARED) {
+			ret = snd_pcm_start (data->pcm);
+			if (ret < 0 && !xmms_alsa_recover (data, ret, error)) {
+				return TRUE;
+			}
+		}
+
+		ret = snd_pcm_wait (data->pcm, 1000);
+		if (ret < 0 && !xmms_alsa_recover (data, ret, error)) {
+			return TRUE;
+		}
+	}
+
+	ret = snd_pcm_mmap_begin (data->pcm, &areas, &offset, &frames);
+	if (ret < 0) {
+		xmms_alsa_recover (data, ret, error);
+		return TRUE;
+	}
+
+	area = (gchar *) areas[0].addr + (areas[0].first + offset * areas[0].step) / 8;
+	len = xmms_output_read_direct (output, area, snd_pcm_frames_to_bytes (data->pcm, frames));
+
+	ret = snd_pcm_mmap_commit (data->pcm, offset, snd_pcm_bytes_to_frames (data->pcm, len));
+	if (ret < 0) {
+		xmms_alsa_recover (data, ret, error);
+	}
+
+	return TRUE;
 }
 
 static snd_mixer_elem_t *
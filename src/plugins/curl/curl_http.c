@@ -32,25 +32,43 @@
  * Type definitions
  */
 
+/* longest the fetch thread sleeps in select before checking for stop */
+#define FETCH_POLL_MS 200
+
 typedef struct {
 	CURL *curl_easy;
 	CURLM *curl_multi;
 
 	guint meta_offset;
+	gint bitrate;
 
 	gchar *url;
 
 	struct curl_slist *http_200_aliases;
 	struct curl_slist *http_req_headers;
 
+	/* ring buffer filled by the fetch thread, protected by mutex */
 	gchar *buffer;
-	guint bufferpos, bufferlen;
+	guint buffersize, bufferpos, bufferlen;
+
+	GThread *thread;
+	GMutex mutex;
+	GCond cond;
+	gboolean stop;
+	guint paused;
 
 	gint curl_code;
 
 	gboolean done;
+	const gchar *failure;
 
-	xmms_error_t status;
+	/* content length and body bytes received, for resuming */
+	gint64 size;
+	gint64 received;
+	gint64 skip;
+	gboolean headers_done;
+	gboolean resumed;
+	gint reconnects, max_reconnects;
 
 	gboolean broken_version;
 } xmms_curl_data_t;
@@ -61,6 +79,7 @@ static void header_handler_contentlength (xmms_xform_t *xform, gchar *header);
 static void header_handler_icy_metaint (xmms_xform_t *xform, gchar *header);
 static void header_handler_icy_name (xmms_xform_t *xform, gchar *header);
 static void header_handler_icy_genre (xmms_xform_t *xform, gchar *header);
+static void header_handler_icy_br (xmms_xform_t *xform, gchar *header);
 static handler_func_t header_handler_find (gchar *header);
 
 typedef struct {
@@ -73,6 +92,7 @@ handler_t handlers[] = {
 	{ "icy-metaint", header_handler_icy_metaint },
 	{ "icy-name", header_handler_icy_name },
 	{ "icy-genre", header_handler_icy_genre },
+	{ "icy-br", header_handler_icy_br },
 /*	{ "\r\n", header_handler_last }, */
 	{ NULL, NULL }
 };
@@ -84,7 +104,12 @@ handler_t handlers[] = {
 static gboolean xmms_curl_plugin_setup (xmms_xform_plugin_t *xform_plugin);
 static gboolean xmms_curl_init (xmms_xform_t *xform);
 static void xmms_curl_destroy (xmms_xform_t *xform);
-static gint fill_buffer (xmms_xform_t *xform, xmms_curl_data_t *data, xmms_error_t *error);
+static gint xmms_curl_perform (xmms_curl_data_t *data);
+static gboolean xmms_curl_reconnect (xmms_curl_data_t *data);
+static gpointer xmms_curl_fetch_thread (gpointer udata);
+static void ring_read (xmms_curl_data_t *data, gchar *buffer, guint len);
+static void ring_write (xmms_curl_data_t *data, const gchar *buffer, guint len);
+static void ring_resize (xmms_curl_data_t *data, guint size);
 static gint xmms_curl_read (xmms_xform_t *xform, void *buffer, gint len, xmms_error_t *error);
 /* static gint64 xmms_curl_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whence, xmms_error_t *error); */
 static size_t xmms_curl_callback_write (void *ptr, size_t size, size_t nmemb, void *stream);
@@ -141,6 +166,15 @@ xmms_curl_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 	                                            "user", NULL, NULL);
 	xmms_xform_plugin_config_property_register (xform_plugin, "proxypass",
 	                                            "password", NULL, NULL);
+	/* KiB fetched ahead of the decoder by a background thread */
+	xmms_xform_plugin_config_property_register (xform_plugin, "prefetch",
+	                                            "256", NULL, NULL);
+	/* seconds fetched ahead, for stations announcing their bitrate */
+	xmms_xform_plugin_config_property_register (xform_plugin, "prefetch_seconds",
+	                                            "0", NULL, NULL);
+	/* how many times a dropped download is resumed where it stopped */
+	xmms_xform_plugin_config_property_register (xform_plugin, "reconnect",
+	                                            "5", NULL, NULL);
 
 	xmms_xform_plugin_indata_add (xform_plugin,
 	                              XMMS_STREAM_TYPE_MIMETYPE,
@@ -168,8 +202,9 @@ xmms_curl_init (xmms_xform_t *xform)
 {
 	xmms_curl_data_t *data;
 	xmms_config_property_t *val;
-	xmms_error_t error;
 	gint metaint, verbose, connecttimeout, readtimeout, useproxy, authproxy;
+	gint prefetch, prefetch_seconds, ret;
+	guint window;
 	const gchar *proxyaddress, *proxyuser, *proxypass;
 	gchar proxyuserpass[90];
 	const gchar *url;
@@ -181,6 +216,10 @@ xmms_curl_init (xmms_xform_t *xform)
 
 	data = g_new0 (xmms_curl_data_t, 1);
 	data->broken_version = FALSE;
+	data->size = -1;
+
+	g_mutex_init (&data->mutex);
+	g_cond_init (&data->cond);
 
 	val = xmms_xform_config_lookup (xform, "connecttimeout");
 	connecttimeout = xmms_config_property_get_int (val);
@@ -209,10 +248,22 @@ xmms_curl_init (xmms_xform_t *xform)
 	val = xmms_xform_config_lookup (xform, "proxypass");
 	proxypass = xmms_config_property_get_string (val);
 
+	val = xmms_xform_config_lookup (xform, "prefetch");
+	prefetch = xmms_config_property_get_int (val);
+
+	val = xmms_xform_config_lookup (xform, "prefetch_seconds");
+	prefetch_seconds = xmms_config_property_get_int (val);
+
+	val = xmms_xform_config_lookup (xform, "reconnect");
+	data->max_reconnects = xmms_config_property_get_int (val);
+
 	g_snprintf (proxyuserpass, sizeof (proxyuserpass), "%s:%s", proxyuser,
 	            proxypass);
 
-	data->buffer = g_malloc (CURL_MAX_WRITE_SIZE);
+	/* room for at least two chunks, so curl is never paused on a
+	 * buffer holding less than one */
+	data->buffersize = MAX (prefetch * 1024, 2 * CURL_MAX_WRITE_SIZE);
+	data->buffer = g_malloc (data->buffersize);
 	data->url = g_strdup (url);
 
 	/* check for broken version of curl here */
@@ -245,7 +296,7 @@ xmms_curl_init (xmms_xform_t *xform)
 	curl_easy_setopt (data->curl_easy, CURLOPT_USERAGENT,
 	                  "XMMS2/" XMMS_VERSION);
 	curl_easy_setopt (data->curl_easy, CURLOPT_WRITEHEADER, xform);
-	curl_easy_setopt (data->curl_easy, CURLOPT_WRITEDATA, xform);
+	curl_easy_setopt (data->curl_easy, CURLOPT_WRITEDATA, data);
 	curl_easy_setopt (data->curl_easy, CURLOPT_WRITEFUNCTION,
 	                  xmms_curl_callback_write);
 	curl_easy_setopt (data->curl_easy, CURLOPT_HEADERFUNCTION,
@@ -289,13 +340,36 @@ xmms_curl_init (xmms_xform_t *xform)
 	xmms_xform_private_data_set (xform, data);
 
 	/* perform initial fill to see if it contains shoutcast metadata or not */
-	if (fill_buffer (xform, data, &error) <= 0) {
+	do {
+		ret = xmms_curl_perform (data);
+	} while (ret > 0 && !data->bufferlen);
+
+	if (!data->bufferlen) {
 		/* something went wrong */
 		xmms_xform_private_data_set (xform, NULL);
 		xmms_curl_free_data (data);
 		return FALSE;
 	}
 
+	/* headers of later requests belong to resumed ranges */
+	data->headers_done = TRUE;
+
+	window = data->buffersize;
+	if (prefetch_seconds > 0 && data->bitrate > 0) {
+		window = MAX (window, prefetch_seconds * data->bitrate * 1000 / 8);
+	}
+
+	if (window > data->buffersize) {
+		ring_resize (data, window);
+	}
+
+	if (ret <= 0 && !xmms_curl_reconnect (data)) {
+		data->done = TRUE;
+	} else {
+		data->thread = g_thread_new ("x2 curl fetch", xmms_curl_fetch_thread,
+		                             data);
+	}
+
 	if (data->meta_offset > 0) {
 		XMMS_DBG ("icy-metadata detected");
 		xmms_xform_auxdata_set_int (xform, "meta_offset", data->meta_offset);
@@ -314,83 +388,202 @@ xmms_curl_init (xmms_xform_t *xform)
 	return TRUE;
 }
 
+/* Drive the transfer for a while.
+ * Returns 1 while it is running, 0 once it completed and -1 if it
+ * failed, with data->failure set.
+ */
 static gint
-fill_buffer (xmms_xform_t *xform, xmms_curl_data_t *data, xmms_error_t *error)
+xmms_curl_perform (xmms_curl_data_t *data)
 {
 	gint handles;
 
-	g_return_val_if_fail (xform, -1);
-	g_return_val_if_fail (data, -1);
-	g_return_val_if_fail (error, -1);
+	if (data->curl_code == CURLM_OK) {
+		fd_set fdread, fdwrite, fdexcp;
+		struct timeval timeout;
+		gint ret, maxfd;
+		glong milliseconds;
 
-	while (TRUE) {
-		if (data->curl_code == CURLM_OK) {
-			fd_set fdread, fdwrite, fdexcp;
-			struct timeval timeout;
-			gint ret, maxfd;
-			glong milliseconds;
+		FD_ZERO (&fdread);
+		FD_ZERO (&fdwrite);
+		FD_ZERO (&fdexcp);
 
-			FD_ZERO (&fdread);
-			FD_ZERO (&fdwrite);
-			FD_ZERO (&fdexcp);
+		curl_multi_fdset (data->curl_multi, &fdread, &fdwrite, &fdexcp,
+		                  &maxfd);
+		curl_multi_timeout (data->curl_multi, &milliseconds);
 
-			curl_multi_fdset (data->curl_multi, &fdread, &fdwrite, &fdexcp,
-			                  &maxfd);
-			curl_multi_timeout (data->curl_multi, &milliseconds);
+		if (milliseconds <= 0 || milliseconds > FETCH_POLL_MS) {
+			milliseconds = FETCH_POLL_MS;
+		}
 
-			if (milliseconds <= 0) {
-				milliseconds = 1000;
-			}
+		timeout.tv_sec = milliseconds / 1000;
+		timeout.tv_usec = (milliseconds % 1000) * 1000;
+
+		ret = select (maxfd + 1, &fdread, &fdwrite, &fdexcp, &timeout);
+
+		if (ret == -1) {
+			data->failure = "Error select";
+			return -1;
+		}
+	}
+
+	data->curl_code = curl_multi_perform (data->curl_multi, &handles);
 
-			timeout.tv_sec = milliseconds / 1000;
-			timeout.tv_usec = (milliseconds % 1000) * 1000;
+	if (data->curl_code != CURLM_CALL_MULTI_PERFORM &&
+	    data->curl_code != CURLM_OK) {
+		data->failure = curl_multi_strerror (data->curl_code);
+		return -1;
+	}
+
+	/* done */
+	if (handles == 0) {
+		CURLMsg *curlmsg;
+		gint messages;
 
-			ret = select (maxfd + 1, &fdread, &fdwrite, &fdexcp, &timeout);
+		do {
+			curlmsg = curl_multi_info_read (data->curl_multi, &messages);
 
-			if (ret == -1) {
-				xmms_error_set (error, XMMS_ERROR_GENERIC, "Error select");
-				return -1;
+			if (curlmsg == NULL)
+				break;
+
+			if (curlmsg->msg == CURLMSG_DONE && curlmsg->data.result != CURLE_OK) {
+				xmms_log_error ("Curl transfer returned error: (%d) %s",
+				                curlmsg->data.result,
+				                curl_easy_strerror (curlmsg->data.result));
+				data->failure = curl_easy_strerror (curlmsg->data.result);
+			} else if (curlmsg->msg != CURLMSG_DONE) {
+				XMMS_DBG ("Curl transfer returned unknown message (%d)", curlmsg->msg);
 			}
-		}
+		} while (messages > 0);
 
-		data->curl_code = curl_multi_perform (data->curl_multi, &handles);
+		return data->failure ? -1 : 0;
+	}
 
-		if (data->curl_code != CURLM_CALL_MULTI_PERFORM &&
-		    data->curl_code != CURLM_OK) {
+	return 1;
+}
 
-			xmms_error_set (error, XMMS_ERROR_GENERIC,
-			                curl_multi_strerror (data->curl_code));
-			return -1;
-		}
+/* Restart a transfer that ended before the whole resource was
+ * received, asking for the remaining range. Only possible when the
+ * length is known and there is no interleaved shoutcast metadata.
+ */
+static gboolean
+xmms_curl_reconnect (xmms_curl_data_t *data)
+{
+	if (data->meta_offset || data->size <= 0 ||
+	    data->received >= data->size ||
+	    data->reconnects >= data->max_reconnects) {
+		return FALSE;
+	}
+
+	data->reconnects++;
 
-		/* done */
-		if (handles == 0) {
-			CURLMsg *curlmsg;
-			gint messages;
+	xmms_log_info ("Connection to %s lost, resuming at byte %" G_GINT64_FORMAT
+	               " (attempt %d)", data->url, data->received, data->reconnects);
 
-			do {
-				curlmsg = curl_multi_info_read (data->curl_multi, &messages);
+	curl_multi_remove_handle (data->curl_multi, data->curl_easy);
+	curl_easy_setopt (data->curl_easy, CURLOPT_RESUME_FROM_LARGE,
+	                  (curl_off_t) data->received);
+	curl_multi_add_handle (data->curl_multi, data->curl_easy);
 
-				if (curlmsg == NULL)
-					break;
+	data->curl_code = CURLM_CALL_MULTI_PERFORM;
+	data->failure = NULL;
+	data->resumed = TRUE;
 
-				if (curlmsg->msg == CURLMSG_DONE && curlmsg->data.result != CURLE_OK) {
-					xmms_log_error ("Curl fill_buffer returned error: (%d) %s",
-					                curlmsg->data.result,
-					                curl_easy_strerror (curlmsg->data.result));
-				} else {
-					XMMS_DBG ("Curl fill_buffer returned unknown message (%d)", curlmsg->msg);
-				}
-			} while (messages > 0);
+	return TRUE;
+}
 
-			data->done = TRUE;
-			return 0;
+/* Keep the ring buffer filled until the transfer ends or we are
+ * told to stop. Curl is paused while the buffer is full.
+ */
+static gpointer
+xmms_curl_fetch_thread (gpointer udata)
+{
+	xmms_curl_data_t *data = udata;
+	gint64 until;
+	gint ret;
+
+	g_mutex_lock (&data->mutex);
+
+	while (!data->stop) {
+		if (data->paused) {
+			if (data->buffersize - data->bufferlen < data->paused) {
+				g_cond_wait (&data->cond, &data->mutex);
+				continue;
+			}
+
+			/* the write callback takes the lock, unpausing calls it */
+			data->paused = 0;
+			g_mutex_unlock (&data->mutex);
+			curl_easy_pause (data->curl_easy, CURLPAUSE_CONT);
+			g_mutex_lock (&data->mutex);
+			continue;
+		}
+
+		g_mutex_unlock (&data->mutex);
+		ret = xmms_curl_perform (data);
+		g_mutex_lock (&data->mutex);
+
+		if (ret > 0) {
+			continue;
 		}
 
-		if (data->bufferlen > 0) {
-			return 1;
+		if (xmms_curl_reconnect (data)) {
+			/* back off a little longer for each attempt */
+			until = g_get_monotonic_time () + data->reconnects * G_TIME_SPAN_SECOND;
+			while (!data->stop &&
+			       g_cond_wait_until (&data->cond, &data->mutex, until));
+			continue;
 		}
+
+		data->done = TRUE;
+		g_cond_broadcast (&data->cond);
+		break;
 	}
+
+	g_mutex_unlock (&data->mutex);
+
+	return NULL;
+}
+
+static void
+ring_read (xmms_curl_data_t *data, gchar *buffer, guint len)
+{
+	guint first;
+
+	first = MIN (len, data->buffersize - data->bufferpos);
+	memcpy (buffer, data->buffer + data->bufferpos, first);
+	memcpy (buffer + first, data->buffer, len - first);
+
+	data->bufferpos = (data->bufferpos + len) % data->buffersize;
+	data->bufferlen -= len;
+}
+
+static void
+ring_write (xmms_curl_data_t *data, const gchar *buffer, guint len)
+{
+	guint pos, first;
+
+	pos = (data->bufferpos + data->bufferlen) % data->buffersize;
+	first = MIN (len, data->buffersize - pos);
+	memcpy (data->buffer + pos, buffer, first);
+	memcpy (data->buffer, buffer + first, len - first);
+
+	data->bufferlen += len;
+}
+
+static void
+ring_resize (xmms_curl_data_t *data, guint size)
+{
+	gchar *buffer;
+	guint len = data->bufferlen;
+
+	buffer = g_malloc (size);
+	ring_read (data, buffer, len);
+
+	g_free (data->buffer);
+	data->buffer = buffer;
+	data->buffersize = size;
+	data->bufferpos = 0;
+	data->bufferlen = len;
 }
 
 static gint
@@ -398,7 +591,7 @@ xmms_curl_read (xmms_xform_t *xform, void *buffer, gint len,
                 xmms_error_t *error)
 {
 	xmms_curl_data_t *data;
-	gint ret;
+	gint fill;
 
 	g_return_val_if_fail (xform, -1);
 	g_return_val_if_fail (buffer, -1);
@@ -407,29 +600,30 @@ xmms_curl_read (xmms_xform_t *xform, void *buffer, gint len,
 	data = xmms_xform_private_data_get (xform);
 	g_return_val_if_fail (data, -1);
 
-	if (data->done)
-		return 0;
+	g_mutex_lock (&data->mutex);
 
-	while (TRUE) {
+	while (!data->bufferlen && !data->done) {
+		g_cond_wait (&data->cond, &data->mutex);
+	}
 
-		/* if we have data available, just pick it up (even if there's
-		   less bytes available than was requested) */
-		if (data->bufferlen) {
-			len = MIN (len, data->bufferlen);
-			memcpy (buffer, data->buffer, len);
-			data->bufferlen -= len;
-			if (data->bufferlen) {
-				memmove (data->buffer, data->buffer + len, data->bufferlen);
-			}
-			return len;
-		}
+	/* pick up what is available (even if there's less bytes available
+	   than was requested) */
+	len = MIN (len, data->bufferlen);
+	if (len) {
+		ring_read (data, buffer, len);
+		g_cond_broadcast (&data->cond);
+	} else if (data->failure) {
+		xmms_error_set (error, XMMS_ERROR_GENERIC, data->failure);
+		len = -1;
+	}
 
-		ret = fill_buffer (xform, data, error);
+	fill = (gint64) data->bufferlen * 100 / data->buffersize;
 
-		if (ret == 0 || ret == -1) {
-			return ret;
-		}
-	}
+	g_mutex_unlock (&data->mutex);
+
+	xmms_xform_buffer_fill_set (xform, fill);
+
+	return len;
 }
 
 static void
@@ -452,21 +646,47 @@ xmms_curl_destroy (xmms_xform_t *xform)
 static size_t
 xmms_curl_callback_write (void *ptr, size_t size, size_t nmemb, void *stream)
 {
-	xmms_curl_data_t *data;
-	xmms_xform_t *xform = (xmms_xform_t *) stream;
-	gint len;
-
-	g_return_val_if_fail (xform, 0);
+	xmms_curl_data_t *data = (xmms_curl_data_t *) stream;
+	const gchar *buffer = ptr;
+	gsize len, skip;
 
-	data = xmms_xform_private_data_get (xform);
 	g_return_val_if_fail (data, 0);
 
 	len = size * nmemb;
 
-	g_return_val_if_fail ((data->bufferlen + len) <= CURL_MAX_WRITE_SIZE, 0);
+	if (data->resumed) {
+		glong code = 0;
+
+		data->resumed = FALSE;
+		curl_easy_getinfo (data->curl_easy, CURLINFO_RESPONSE_CODE, &code);
+		if (code != 206) {
+			/* range ignored, drop what we already have */
+			data->skip = data->received;
+		}
+	}
+
+	skip = MIN (len, data->skip);
+
+	g_mutex_lock (&data->mutex);
+
+	if (len - skip > data->buffersize) {
+		ring_resize (data, len - skip);
+	}
+
+	/* curl hands the same data over again once unpaused */
+	if (len - skip > data->buffersize - data->bufferlen) {
+		data->paused = len - skip;
+		g_mutex_unlock (&data->mutex);
+		return CURL_WRITEFUNC_PAUSE;
+	}
+
+	ring_write (data, buffer + skip, len - skip);
+	g_cond_broadcast (&data->cond);
+
+	g_mutex_unlock (&data->mutex);
 
-	memcpy (data->buffer + data->bufferlen, ptr, len);
-	data->bufferlen = data->bufferlen + len;
+	data->skip -= skip;
+	data->received += len - skip;
 
 	return len;
 }
@@ -486,6 +706,7 @@ static size_t
 xmms_curl_callback_header (void *ptr, size_t size, size_t nmemb, void *stream)
 {
 	xmms_xform_t *xform = (xmms_xform_t *) stream;
+	xmms_curl_data_t *data;
 	handler_func_t func;
 	gchar *header;
 
@@ -494,6 +715,12 @@ xmms_curl_callback_header (void *ptr, size_t size, size_t nmemb, void *stream)
 	g_return_val_if_fail (xform, 0);
 	g_return_val_if_fail (ptr, 0);
 
+	data = xmms_xform_private_data_get (xform);
+	if (data && data->headers_done) {
+		/* a resumed request, runs in the fetch thread */
+		return size * nmemb;
+	}
+
 	header = g_strndup ((gchar*)ptr, size * nmemb);
 
 	func = header_handler_find (header);
@@ -533,11 +760,15 @@ static void
 header_handler_contentlength (xmms_xform_t *xform,
                               gchar *header)
 {
+	xmms_curl_data_t *data;
 	int length;
 	const gchar *metakey;
 
 	length = strtoul (header, NULL, 10);
 
+	data = xmms_xform_private_data_get (xform);
+	data->size = length;
+
 	metakey = XMMS_MEDIALIB_ENTRY_PROPERTY_SIZE,
 	xmms_xform_metadata_set_int (xform, metakey, length);
 }
@@ -569,11 +800,34 @@ header_handler_icy_genre (xmms_xform_t *xform,
 	xmms_xform_metadata_set_str (xform, metakey, header);
 }
 
+static void
+header_handler_icy_br (xmms_xform_t *xform,
+                       gchar *header)
+{
+	xmms_curl_data_t *data;
+
+	data = xmms_xform_private_data_get (xform);
+
+	data->bitrate = strtoul (header, NULL, 10);
+}
+
 static void
 xmms_curl_free_data (xmms_curl_data_t *data)
 {
 	g_return_if_fail (data);
 
+	if (data->thread) {
+		g_mutex_lock (&data->mutex);
+		data->stop = TRUE;
+		g_cond_broadcast (&data->cond);
+		g_mutex_unlock (&data->mutex);
+
+		g_thread_join (data->thread);
+	}
+
+	g_mutex_clear (&data->mutex);
+	g_cond_clear (&data->cond);
+
 	curl_multi_cleanup (data->curl_multi);
 	curl_easy_cleanup (data->curl_easy);
 
@@ -29,8 +29,7 @@
 static gboolean xmms_eq_plugin_setup (xmms_xform_plugin_t *xform_plugin);
 static gboolean xmms_eq_init (xmms_xform_t *xform);
 static void xmms_eq_destroy (xmms_xform_t *xform);
-static gint xmms_eq_read (xmms_xform_t *xform, xmms_sample_t *buf, gint len,
-                          xmms_error_t *error);
+static void xmms_eq_process (xmms_xform_t *xform, xmms_sample_t *buf, gint len);
 static gint64 xmms_eq_seek (xmms_xform_t *xform, gint64 offset,
                             xmms_xform_seek_mode_t whence, xmms_error_t *err);
 static void xmms_eq_gain_changed (xmms_object_t *object, xmmsv_t *_data,
@@ -45,6 +44,9 @@ typedef struct xmms_equalizer_priv_St {
 	xmms_config_property_t *gain[EQ_MAX_BANDS];
 	xmms_config_property_t *legacy[EQ_BANDS_LEGACY];
 	gboolean enabled;
+	xmms_sample_format_t format;
+	gint channels;
+	iir_state_t *iir;
 } xmms_equalizer_data_t;
 
 XMMS_XFORM_PLUGIN_DEFINE ("equalizer",
@@ -56,15 +58,21 @@ XMMS_XFORM_PLUGIN_DEFINE ("equalizer",
 static gboolean
 xmms_eq_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 {
+	static const xmms_sample_format_t formats[] = {
+		XMMS_SAMPLE_FORMAT_S16,
+		XMMS_SAMPLE_FORMAT_S32,
+		XMMS_SAMPLE_FORMAT_FLOAT
+	};
+	static const gint rates[] = { 48000, 44100, 22050, 11025 };
 	xmms_xform_methods_t methods;
 	gchar buf[16];
-	gint i;
+	gint i, j;
 
 	XMMS_XFORM_METHODS_INIT (methods);
 
 	methods.init = xmms_eq_init;
 	methods.destroy = xmms_eq_destroy;
-	methods.read = xmms_eq_read;
+	methods.process = xmms_eq_process;
 	methods.seek = xmms_eq_seek;
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
@@ -89,41 +97,21 @@ xmms_eq_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 		                                            NULL, NULL);
 	}
 
-	xmms_xform_plugin_indata_add (xform_plugin,
-	                              XMMS_STREAM_TYPE_MIMETYPE,
-	                              "audio/pcm",
-	                              XMMS_STREAM_TYPE_FMT_FORMAT,
-	                              XMMS_SAMPLE_FORMAT_S16,
-	                              XMMS_STREAM_TYPE_FMT_SAMPLERATE,
-	                              48000,
-	                              XMMS_STREAM_TYPE_END);
-
-	xmms_xform_plugin_indata_add (xform_plugin,
-	                              XMMS_STREAM_TYPE_MIMETYPE,
-	                              "audio/pcm",
-	                              XMMS_STREAM_TYPE_FMT_FORMAT,
-	                              XMMS_SAMPLE_FORMAT_S16,
-	                              XMMS_STREAM_TYPE_FMT_SAMPLERATE,
-	                              44100,
-	                              XMMS_STREAM_TYPE_END);
-
-	xmms_xform_plugin_indata_add (xform_plugin,
-	                              XMMS_STREAM_TYPE_MIMETYPE,
-	                              "audio/pcm",
-	                              XMMS_STREAM_TYPE_FMT_FORMAT,
-	                              XMMS_SAMPLE_FORMAT_S16,
-	                              XMMS_STREAM_TYPE_FMT_SAMPLERATE,
-	                              22050,
-	                              XMMS_STREAM_TYPE_END);
-
-	xmms_xform_plugin_indata_add (xform_plugin,
-	                              XMMS_STREAM_TYPE_MIMETYPE,
-	                              "audio/pcm",
-	                              XMMS_STREAM_TYPE_FMT_FORMAT,
-	                              XMMS_SAMPLE_FORMAT_S16,
-	                              XMMS_STREAM_TYPE_FMT_SAMPLERATE,
-	                              11025,
-	                              XMMS_STREAM_TYPE_END);
+	for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+		for (j = 0; j < G_N_ELEMENTS (rates); j++) {
+			xmms_xform_plugin_indata_add (xform_plugin,
+			                              XMMS_STREAM_TYPE_MIMETYPE,
+			                              "audio/pcm",
+			                              XMMS_STREAM_TYPE_FMT_FORMAT,
+			                              formats[i],
+			                              XMMS_STREAM_TYPE_FMT_SAMPLERATE,
+			                              rates[j],
+			                              XMMS_STREAM_TYPE_END);
+		}
+	}
+
+	/* the coefficient tables are shared by all instances */
+	init_iir ();
 
 	return TRUE;
 }
@@ -141,6 +129,17 @@ xmms_eq_init (xmms_xform_t *xform)
 	priv = g_new0 (xmms_equalizer_data_t, 1);
 	g_return_val_if_fail (priv, FALSE);
 
+	priv->format = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_FORMAT);
+	priv->channels = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_CHANNELS);
+	if (priv->channels > EQ_CHANNELS) {
+		xmms_log_error ("Equalizer supports at most %d channels", EQ_CHANNELS);
+		g_free (priv);
+		return FALSE;
+	}
+
+	priv->iir = iir_new ();
+	g_return_val_if_fail (priv->iir, FALSE);
+
 	xmms_xform_private_data_set (xform, priv);
 
 	config = xmms_xform_config_lookup (xform, "enabled");
@@ -169,7 +168,7 @@ xmms_eq_init (xmms_xform_t *xform)
 	gain = xmms_config_property_get_float (config);
 
 	for (i=0; i<EQ_CHANNELS; i++) {
-		set_preamp (i, xmms_eq_gain_scale (gain, TRUE));
+		set_preamp (priv->iir, i, xmms_eq_gain_scale (gain, TRUE));
 	}
 
 	for (i=0; i<EQ_BANDS_LEGACY; i++) {
@@ -185,7 +184,7 @@ xmms_eq_init (xmms_xform_t *xform)
 		gain = xmms_config_property_get_float (config);
 		if (priv->use_legacy) {
 			for (j = 0; j < EQ_CHANNELS; j++) {
-				set_gain (i, j, xmms_eq_gain_scale (gain, FALSE));
+				set_gain (priv->iir, i, j, xmms_eq_gain_scale (gain, FALSE));
 			}
 		}
 	}
@@ -203,17 +202,16 @@ xmms_eq_init (xmms_xform_t *xform)
 		gain = xmms_config_property_get_float (config);
 		if (!priv->use_legacy) {
 			for (j = 0; j < EQ_CHANNELS; j++) {
-				set_gain (i, j, xmms_eq_gain_scale (gain, FALSE));
+				set_gain (priv->iir, i, j, xmms_eq_gain_scale (gain, FALSE));
 			}
 		}
 	}
 
-	init_iir ();
 	srate = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_SAMPLERATE);
 	if (priv->use_legacy) {
-		config_iir (srate, EQ_BANDS_LEGACY, 1);
+		config_iir (priv->iir, srate, EQ_BANDS_LEGACY, 1);
 	} else {
-		config_iir (srate, priv->bands, 0);
+		config_iir (priv->iir, srate, priv->bands, 0);
 	}
 
 	xmms_xform_outdata_type_copy (xform);
@@ -227,7 +225,7 @@ static void
 xmms_eq_destroy (xmms_xform_t *xform)
 {
 	xmms_config_property_t *config;
-	gpointer priv;
+	xmms_equalizer_data_t *priv;
 	gchar buf[16];
 	gint i;
 
@@ -262,34 +260,57 @@ xmms_eq_destroy (xmms_xform_t *xform)
 		xmms_config_property_callback_remove (config, xmms_eq_gain_changed, priv);
 	}
 
+	iir_free (priv->iir);
 	g_free (priv);
 }
 
-static gint
-xmms_eq_read (xmms_xform_t *xform, xmms_sample_t *buf, gint len,
-              xmms_error_t *error)
+static void
+xmms_eq_process (xmms_xform_t *xform, xmms_sample_t *buf, gint len)
 {
 	xmms_equalizer_data_t *priv;
-	gint read, chan;
+	gint samples;
 
-	g_return_val_if_fail (xform, -1);
+	g_return_if_fail (xform);
 
 	priv = xmms_xform_private_data_get (xform);
-	g_return_val_if_fail (priv, -1);
+	g_return_if_fail (priv);
 
-	read = xmms_xform_read (xform, buf, len, error);
-	chan = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_CHANNELS);
-	if (read > 0 && priv->enabled) {
-		iir (buf, read, chan, priv->extra_filtering);
+	if (!priv->enabled) {
+		return;
 	}
 
-	return read;
+	samples = len / xmms_sample_size_get (priv->format);
+
+	switch (priv->format) {
+	case XMMS_SAMPLE_FORMAT_S16:
+		iir_s16 (priv->iir, buf, samples, priv->channels, priv->extra_filtering);
+		break;
+	case XMMS_SAMPLE_FORMAT_S32:
+		iir_s32 (priv->iir, buf, samples, priv->channels, priv->extra_filtering);
+		break;
+	case XMMS_SAMPLE_FORMAT_FLOAT:
+		iir_float (priv->iir, buf, samples, priv->channels, priv->extra_filtering);
+		break;
+	default:
+		break;
+	}
 }
 
 static gint64
 xmms_eq_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whence, xmms_error_t *err)
 {
-	return xmms_xform_seek (xform, offset, whence, err);
+	xmms_equalizer_data_t *priv;
+	gint64 ret;
+
+	ret = xmms_xform_seek (xform, offset, whence, err);
+
+	/* the filter history belongs to the old position */
+	priv = xmms_xform_private_data_get (xform);
+	if (ret != -1 && priv) {
+		clean_history (priv->iir);
+	}
+
+	return ret;
 }
 
 static void
@@ -332,7 +353,7 @@ xmms_eq_gain_changed (xmms_object_t *object, xmmsv_t *_data,
 	if (!strcmp (name, "preamp")) {
 		/* scale the -20.0 - 20.0 value to correct one */
 		for (i=0; i<EQ_CHANNELS; i++) {
-			set_preamp (i, xmms_eq_gain_scale (gain, TRUE));
+			set_preamp (priv->iir, i, xmms_eq_gain_scale (gain, TRUE));
 		}
 	} else {
 		gint band = -1;
@@ -346,7 +367,7 @@ xmms_eq_gain_changed (xmms_object_t *object, xmmsv_t *_data,
 		if (band >= 0) {
 			/* scale the -20.0 - 20.0 value to correct one */
 			for (i=0; i<EQ_CHANNELS; i++) {
-				set_gain (band, i, xmms_eq_gain_scale (gain, FALSE));
+				set_gain (priv->iir, band, i, xmms_eq_gain_scale (gain, FALSE));
 			}
 		}
 	}
@@ -389,14 +410,14 @@ xmms_eq_config_changed (xmms_object_t * object, xmmsv_t *_data, gpointer userdat
 			for (i=0; i<EQ_BANDS_LEGACY; i++) {
 				gain = xmms_config_property_get_float (priv->legacy[i]);
 				for (j=0; j<EQ_CHANNELS; j++) {
-					set_gain (j, i, xmms_eq_gain_scale (gain, FALSE));
+					set_gain (priv->iir, i, j, xmms_eq_gain_scale (gain, FALSE));
 				}
 			}
 		} else {
 			for (i=0; i<priv->bands; i++) {
 				gain = xmms_config_property_get_float (priv->gain[i]);
 				for (j=0; j<EQ_CHANNELS; j++) {
-					set_gain (j, i, xmms_eq_gain_scale (gain, FALSE));
+					set_gain (priv->iir, i, j, xmms_eq_gain_scale (gain, FALSE));
 				}
 			}
 		}
@@ -413,7 +434,7 @@ xmms_eq_config_changed (xmms_object_t * object, xmmsv_t *_data, gpointer userdat
 				xmms_config_property_set_data (priv->gain[i], "0.0");
 				if (!priv->use_legacy) {
 					for (j=0; j<EQ_CHANNELS; j++) {
-						set_gain (j, i, xmms_eq_gain_scale (0.0, FALSE));
+						set_gain (priv->iir, i, j, xmms_eq_gain_scale (0.0, FALSE));
 					}
 				}
 			}
@@ -20,61 +20,183 @@
  *   $Id: iir.c,v 1.16 2006/01/15 00:26:32 liebremx Exp $
  */
 
+#include <stdlib.h>
+#include <math.h>
 #include "iir.h"
+#include "iir_fpu.h"
+#include "iir_sse.h"
 
-/* Coefficients */
-sIIRCoefficients *iir_cf;
+/* Compute the coefficient tables, only needed once */
+void init_iir(void)
+{
+  calc_coeffs();
+}
+
+/* Create an equalizer instance using the fastest band kernel the
+ * CPU supports */
+iir_state_t *iir_new(void)
+{
+  iir_state_t *st;
+  int n;
 
-/* Volume gain
- * values should be between 0.0 and 1.0
- * Use the preamp from XMMS for now
- * */
-float preamp[EQ_CHANNELS];
+  st = calloc(1, sizeof(iir_state_t));
+  if (!st)
+    return NULL;
 
-#ifdef BENCHMARK
-#include "benchmark.h"
-double timex = 0.0;
-int count = 0;
-unsigned int blength = 0;
+  st->bands_func = iir_bands_fpu;
+#ifdef IIR_HAVE_SSE
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx"))
+    st->bands_func = iir_bands_avx;
+  else if (__builtin_cpu_supports("sse2"))
+    st->bands_func = iir_bands_sse2;
 #endif
 
-/*
- * Global vars
- */
-int band_count;
+  for (n = 0; n < EQ_CHANNELS; n++)
+    st->preamp[n] = 1.0;
+
+  for (n = 0; n < 256; n++)
+    st->dither[n] = (rand() % 4) - 2;
+
+  return st;
+}
 
-void set_preamp(int chn, float val)
+void iir_free(iir_state_t *st)
 {
-  preamp[chn] = val;
+  free(st);
 }
 
-/* Init the filters */
-void init_iir(void)
+void config_iir(iir_state_t *st, int srate, int bands, int original)
 {
-  calc_coeffs();
+  sIIRCoefficients *iir_cf;
+  int n;
+
+  st->band_count = bands;
+  iir_cf = get_coeffs(&st->band_count, srate, original);
+  st->vector_bands = (st->band_count + 3) & ~3;
+
+  memset(&st->cf, 0, sizeof(st->cf));
+  for (n = 0; n < st->band_count; n++) {
+    st->cf.alpha[n] = iir_cf[n].alpha;
+    st->cf.beta[n] = iir_cf[n].beta;
+    st->cf.gamma[n] = iir_cf[n].gamma;
+  }
+
+  clean_history(st);
+}
+
+void clean_history(iir_state_t *st)
+{
+  /* Zero the history arrays */
+  memset(st->history, 0, sizeof(st->history));
+  memset(st->history2, 0, sizeof(st->history2));
+  st->di = 0;
+}
+
+void set_gain(iir_state_t *st, int index, int chn, float val)
+{
+  st->gain[chn][index] = val;
 }
 
-void config_iir(int srate, int bands, int original)
+void set_preamp(iir_state_t *st, int chn, float val)
 {
-  band_count = bands;
-  iir_cf = get_coeffs(&band_count, srate, original);
-  clean_history();
+  st->preamp[chn] = val;
 }
 
-#ifdef ARCH_X86
-/* Round function provided by Frank Klemm which saves around 100K
- * CPU cycles in my PIII for each call to the IIR function with 4K samples
+/**
+ * IIR filter equation is
+ * y[n] = 2 * (alpha*(x[n]-x[n-2]) + gamma*y[n-1] - beta*y[n-2])
+ *
+ * NOTE: The 2 factor was introduced in the coefficients to save
+ * 			a multiplication
+ *
+ * This algorithm cascades two filters to get nice filtering
+ * at the expense of extra CPU cycles
  */
-int round_trick(float floatvalue_to_round)
+static inline double iir_sample(iir_state_t *st, int channel, double pcm,
+                                int extra_filtering)
 {
-  float   floattmp ;
-  int     rounded_value ;
+  double out;
 
-  floattmp      = (int) 0x00FD8000L + (floatvalue_to_round);
-  rounded_value = *(int*)(&floattmp) - (int)0x4B7D8000L;
+  out = st->bands_func(&st->cf, st->gain[channel], &st->history[channel],
+                       pcm, st->vector_bands);
 
-  if ( rounded_value != (short) rounded_value )
-    rounded_value = ( rounded_value >> 31 ) ^ 0x7FFF;
-  return rounded_value;
+  /* Filter the sample again */
+  if (extra_filtering)
+    out += st->bands_func(&st->cf, st->gain[channel], &st->history2[channel],
+                          out, st->vector_bands);
+
+  /* Volume stuff
+     Scale down original PCM sample and add it to the filters
+     output. This substitutes the multiplication by 0.25
+     */
+  return out + pcm * 0.25;
+}
+
+void iir_s16(iir_state_t *st, int16_t *data, int samples, int nch, int extra_filtering)
+{
+  int index, channel;
+  double out;
+
+  for (index = 0; index + nch <= samples; index += nch)
+  {
+    for (channel = 0; channel < nch; channel++)
+    {
+      /* Preamp gain, and random noise to decorrelate the rounding */
+      out = iir_sample(st, channel,
+                       data[index+channel] * st->preamp[channel] + st->dither[st->di],
+                       extra_filtering);
+
+      /* remove random noise */
+      out -= st->dither[st->di] * 0.25;
+
+      /* Limit the output */
+      if (out < -32768.)
+        data[index+channel] = -32768;
+      else if (out > 32767.)
+        data[index+channel] = 32767;
+      else
+        data[index+channel] = lrint(out);
+    }
+
+    /* random noise index */
+    st->di = (st->di + 1) % 256;
+  }
+}
+
+void iir_s32(iir_state_t *st, int32_t *data, int samples, int nch, int extra_filtering)
+{
+  int index, channel;
+  double out;
+
+  for (index = 0; index + nch <= samples; index += nch)
+  {
+    for (channel = 0; channel < nch; channel++)
+    {
+      out = iir_sample(st, channel, data[index+channel] * st->preamp[channel],
+                       extra_filtering);
+
+      if (out < -2147483648.)
+        data[index+channel] = INT32_MIN;
+      else if (out > 2147483647.)
+        data[index+channel] = INT32_MAX;
+      else
+        data[index+channel] = lrint(out);
+    }
+  }
+}
+
+void iir_float(iir_state_t *st, float *data, int samples, int nch, int extra_filtering)
+{
+  int index, channel;
+
+  for (index = 0; index + nch <= samples; index += nch)
+  {
+    for (channel = 0; channel < nch; channel++)
+    {
+      data[index+channel] = iir_sample(st, channel,
+                                       data[index+channel] * st->preamp[channel],
+                                       extra_filtering);
+    }
+  }
 }
-#endif
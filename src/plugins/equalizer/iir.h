@@ -23,62 +23,69 @@
 #define IIR_H
 
 #include <string.h>
+#include <stdint.h>
 #include "iir_cfs.h"
 
-/*
- * Flush-to-zero to avoid flooding the CPU with underflow exceptions 
- */
-#ifdef SSE_MATH
-#define FTZ 0x8000
-#define FTZ_ON { \
-    unsigned int mxcsr; \
-  __asm__  __volatile__ ("stmxcsr %0" : "=m" (*&mxcsr)); \
-  mxcsr |= FTZ; \
-  __asm__  __volatile__ ("ldmxcsr %0" : : "m" (*&mxcsr)); \
-}
-#define FTZ_OFF { \
-    unsigned int mxcsr; \
-  __asm__  __volatile__ ("stmxcsr %0" : "=m" (*&mxcsr)); \
-  mxcsr &= ~FTZ; \
-  __asm__  __volatile__ ("ldmxcsr %0" : : "m" (*&mxcsr)); \
-}
-#else
-#define FTZ_ON
-#define FTZ_OFF
-#endif
+#define EQ_CHANNELS 8
+#define EQ_MAX_BANDS 31
 
-/*
- * Function prototypes
- */
-void init_iir(void);
-void config_iir(int srate, int bands, int original);
-void clean_history(void);
-void set_gain(int index, int chn, float val);
-void set_preamp(int chn, float val);
+/* band arrays are padded so the vector kernels never need a tail loop */
+#define EQ_VECTOR_BANDS 32
 
+/* Coefficients of all bands, as structure of arrays */
+typedef struct
+{
+  double alpha[EQ_VECTOR_BANDS];
+  double beta[EQ_VECTOR_BANDS];
+  double gamma[EQ_VECTOR_BANDS];
+} iir_coeffs_t;
 
-int iir(void *d, int length, int nch, int extra_filtering);
+/* History of one cascade for one channel, the input is the same for
+ * all bands so it is only kept once */
+typedef struct
+{
+  double y1[EQ_VECTOR_BANDS]; /* y[n-1] */
+  double y2[EQ_VECTOR_BANDS]; /* y[n-2] */
+  double x1, x2;              /* x[n-1], x[n-2] */
+} iir_history_t;
 
-#ifdef ARCH_X86
-int round_trick(float floatvalue_to_round);
-#endif
-#ifdef ARCH_PPC
-int round_ppc(float x);
-#endif
+/* Filter one sample through all bands, returning the sum of the band
+ * outputs weighted by gain */
+typedef double (*iir_bands_func_t) (const iir_coeffs_t *cf, const double *gain,
+                                    iir_history_t *h, double x, int bands);
 
-#define EQ_CHANNELS 2
-#define EQ_MAX_BANDS 31
+/* State of one equalizer instance */
+typedef struct iir_state_St
+{
+  iir_coeffs_t cf;
+  double gain[EQ_CHANNELS][EQ_VECTOR_BANDS];
+  double preamp[EQ_CHANNELS];
+  iir_history_t history[EQ_CHANNELS];
+  iir_history_t history2[EQ_CHANNELS];
 
-extern float preamp[EQ_CHANNELS];
-extern sIIRCoefficients *iir_cf;
-extern int rate;
-extern int band_count;
+  int band_count;
+  int vector_bands; /* band_count rounded up to a multiple of 4 */
+  iir_bands_func_t bands_func;
 
-#ifdef BENCHMARK
-extern double timex;
-extern int count;
-extern unsigned int blength;
-#endif
+  /* random noise */
+  double dither[256];
+  int di;
+} iir_state_t;
 
-#endif /* #define IIR_H */
+/*
+ * Function prototypes
+ */
+void init_iir(void);
+
+iir_state_t *iir_new(void);
+void iir_free(iir_state_t *st);
+void config_iir(iir_state_t *st, int srate, int bands, int original);
+void clean_history(iir_state_t *st);
+void set_gain(iir_state_t *st, int index, int chn, float val);
+void set_preamp(iir_state_t *st, int chn, float val);
 
+void iir_s16(iir_state_t *st, int16_t *data, int samples, int nch, int extra_filtering);
+void iir_s32(iir_state_t *st, int32_t *data, int samples, int nch, int extra_filtering);
+void iir_float(iir_state_t *st, float *data, int samples, int nch, int extra_filtering);
+
+#endif /* #define IIR_H */
@@ -22,18 +22,9 @@
 #ifndef IIR_FPU_H
 #define IIR_FPU_H
 
-#define sample_t double
+#include "iir.h"
 
-/*
- * Normal FPU implementation data structures
- */
-/* Coefficient history for the IIR filter */
-typedef struct
-{
-    sample_t x[3]; /* x[n], x[n-1], x[n-2] */
-    sample_t y[3]; /* y[n], y[n-1], y[n-2] */
-    sample_t dummy1; // Word alignment
-    sample_t dummy2;
-}sXYData;
+double iir_bands_fpu(const iir_coeffs_t *cf, const double *gain,
+                     iir_history_t *h, double x, int bands);
 
 #endif
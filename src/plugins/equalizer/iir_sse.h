@@ -22,58 +22,18 @@
 #ifndef IIR_SSE_H
 #define IIR_SSE_H
 
+#include "iir.h"
+
 /*
- * SSE filter implementation data structures
+ * SSE2 and AVX band kernels, selected at runtime
  */
-#define MAX_SSE_VECTORS 8
-typedef float v4sf __attribute__ ((vector_size(16))); /* vector of four single floats */
-union f4vector 
-{
-  v4sf v;
-  float f[4];
-};
-typedef struct
-{
-  union f4vector sse_iir_cf_alpha[MAX_SSE_VECTORS]; 
-  union f4vector sse_iir_cf_beta[MAX_SSE_VECTORS]; 
-  union f4vector sse_iir_cf_gamma[MAX_SSE_VECTORS];
-  union f4vector sse_acc;
-  union f4vector dummy[MAX_SSE_VECTORS]; /* Word alignment */
-}sSupport;
-
-typedef struct
-{
-  union f4vector sse_Y_n[MAX_SSE_VECTORS];
-  union f4vector sse_Y_n1[MAX_SSE_VECTORS]; 
-  union f4vector sse_Y_n2[MAX_SSE_VECTORS]; 
-  union f4vector sse_X_n; 
-  union f4vector sse_X_n1; 
-  union f4vector sse_X_n2;
-  union f4vector sse_Y2_n[MAX_SSE_VECTORS]; 
-  union f4vector sse_Y2_n1[MAX_SSE_VECTORS]; 
-  union f4vector sse_Y2_n2[MAX_SSE_VECTORS]; 
-  union f4vector sse_X2_n; 
-  union f4vector sse_X2_n1; 
-  union f4vector sse_X2_n2;
-  union f4vector dummy[10]; /* Word alignment */
-}sHistory;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IIR_HAVE_SSE
 
-typedef struct
-{ 
-  union f4vector *p_sse_Y_n[EQ_CHANNELS];
-  union f4vector *p_sse_Y_n1[EQ_CHANNELS];
-  union f4vector *p_sse_Y_n2[EQ_CHANNELS];
-  union f4vector *p_sse_X_n[EQ_CHANNELS];
-  union f4vector *p_sse_X_n1[EQ_CHANNELS];
-  union f4vector *p_sse_X_n2[EQ_CHANNELS];
-  union f4vector *p_sse_Y2_n[EQ_CHANNELS];
-  union f4vector *p_sse_Y2_n1[EQ_CHANNELS];
-  union f4vector *p_sse_Y2_n2[EQ_CHANNELS];
-  union f4vector *p_sse_X2_n[EQ_CHANNELS];
-  union f4vector *p_sse_X2_n1[EQ_CHANNELS];
-  union f4vector *p_sse_X2_n2[EQ_CHANNELS];
-  union f4vector *p_sse_tmp;
-  union f4vector *dummy[7]; /* Word alignment */
-}sPtrs;
+double iir_bands_sse2(const iir_coeffs_t *cf, const double *gain,
+                      iir_history_t *h, double x, int bands);
+double iir_bands_avx(const iir_coeffs_t *cf, const double *gain,
+                     iir_history_t *h, double x, int bands);
+#endif
 
 #endif
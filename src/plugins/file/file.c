@@ -25,6 +25,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef _POSIX_MAPPED_FILES
+#include <sys/mman.h>
+#endif
+
 #include "browse/browse.h"
 
 /* not available everywhere. */
@@ -37,6 +41,14 @@
 
 typedef struct {
 	gint fd;
+
+	/* read position, and how far the kernel was asked to read ahead */
+	gint64 pos;
+	gint64 readahead_end;
+	gint readahead;
+
+	void *map;
+	gsize map_size;
 } xmms_file_data_t;
 
 /*
@@ -48,6 +60,8 @@ static void xmms_file_destroy (xmms_xform_t *xform);
 static gint xmms_file_read (xmms_xform_t *xform, void *buffer, gint len, xmms_error_t *error);
 static gint64 xmms_file_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whence, xmms_error_t *error);
 static gboolean xmms_file_plugin_setup (xmms_xform_plugin_t *xform_plugin);
+static void xmms_file_map (xmms_xform_t *xform, xmms_file_data_t *data);
+static void xmms_file_readahead (xmms_file_data_t *data);
 
 /*
  * Plugin header
@@ -79,6 +93,15 @@ xmms_file_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 	                              "file://*",
 	                              XMMS_STREAM_TYPE_END);
 
+	/* KiB to prefetch ahead of the read position, 0 leaves it to the OS */
+	xmms_xform_plugin_config_property_register (xform_plugin, "readahead",
+	                                            "1024", NULL, NULL);
+
+	/* map files into memory instead of reading them. Faster on slow
+	 * storage, but a file truncated while playing crashes the server */
+	xmms_xform_plugin_config_property_register (xform_plugin, "mmap",
+	                                            "0", NULL, NULL);
+
 	return TRUE;
 }
 
@@ -90,6 +113,7 @@ xmms_file_init (xmms_xform_t *xform)
 {
 	gint fd;
 	xmms_file_data_t *data;
+	xmms_config_property_t *cfgv;
 	const gchar *url;
 	const gchar *metakey;
 	struct stat st;
@@ -121,6 +145,20 @@ xmms_file_init (xmms_xform_t *xform)
 	data->fd = fd;
 	xmms_xform_private_data_set (xform, data);
 
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	cfgv = xmms_xform_config_lookup (xform, "readahead");
+	data->readahead = MAX (0, xmms_config_property_get_int (cfgv)) * 1024;
+
+	cfgv = xmms_xform_config_lookup (xform, "mmap");
+	if (xmms_config_property_get_int (cfgv) && st.st_size > 0 &&
+	    (guint64) st.st_size <= G_MAXSIZE) {
+		data->map_size = st.st_size;
+		xmms_file_map (xform, data);
+	}
+
 	xmms_xform_outdata_type_add (xform,
 	                             XMMS_STREAM_TYPE_MIMETYPE,
 	                             "application/octet-stream",
@@ -145,12 +183,64 @@ xmms_file_destroy (xmms_xform_t *xform)
 	if (!data)
 		return;
 
+#ifdef _POSIX_MAPPED_FILES
+	if (data->map)
+		munmap (data->map, data->map_size);
+#endif
+
 	if (data->fd != -1)
 		close (data->fd);
 
 	g_free (data);
 }
 
+/* Map the whole file and let the xform serve reads, peeks and seeks
+ * from the mapping. Falls back to plain reads if mapping fails.
+ */
+static void
+xmms_file_map (xmms_xform_t *xform, xmms_file_data_t *data)
+{
+#ifdef _POSIX_MAPPED_FILES
+	void *map;
+
+	map = mmap (NULL, data->map_size, PROT_READ, MAP_PRIVATE, data->fd, 0);
+	if (map == MAP_FAILED) {
+		XMMS_DBG ("Couldn't map file: %s", strerror (errno));
+		return;
+	}
+
+#ifdef MADV_SEQUENTIAL
+	madvise (map, data->map_size, MADV_SEQUENTIAL);
+#endif
+
+	data->map = map;
+	xmms_xform_mapping_set (xform, map, data->map_size);
+#endif
+}
+
+/* Ask the kernel for the next readahead window once the read position
+ * is half way through the current one, so it is already in the page
+ * cache when we get there.
+ */
+static void
+xmms_file_readahead (xmms_file_data_t *data)
+{
+#ifdef POSIX_FADV_WILLNEED
+	gint64 start;
+
+	if (!data->readahead ||
+	    data->pos + data->readahead / 2 < data->readahead_end) {
+		return;
+	}
+
+	start = MAX (data->pos, data->readahead_end);
+	posix_fadvise (data->fd, start, data->pos + data->readahead - start,
+	               POSIX_FADV_WILLNEED);
+
+	data->readahead_end = data->pos + data->readahead;
+#endif
+}
+
 static gint
 xmms_file_read (xmms_xform_t *xform, void *buffer, gint len, xmms_error_t *error)
 {
@@ -164,11 +254,15 @@ xmms_file_read (xmms_xform_t *xform, void *buffer, gint len, xmms_error_t *error
 	data = xmms_xform_private_data_get (xform);
 	g_return_val_if_fail (data, -1);
 
+	xmms_file_readahead (data);
+
 	ret = read (data->fd, buffer, len);
 
 	if (ret == -1) {
 		xmms_log_error ("errno(%d) %s", errno, strerror (errno));
 		xmms_error_set (error, XMMS_ERROR_GENERIC, strerror (errno));
+	} else {
+		data->pos += ret;
 	}
 
 	return ret;
@@ -202,5 +296,10 @@ xmms_file_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whenc
 		xmms_error_set (error, XMMS_ERROR_INVAL, "Couldn't seek");
 		return -1;
 	}
+
+	/* start a new readahead window at the new position */
+	data->pos = res;
+	data->readahead_end = res;
+
 	return res;
 }
@@ -31,7 +31,8 @@
 typedef struct {
 	gboolean enabled;
 
-	/* samplerate and channels */
+	/* sample format, samplerate and channels */
+	xmms_sample_format_t format;
 	gint srate;
 	gint channels;
 
@@ -51,8 +52,8 @@ static gboolean xmms_karaoke_plugin_setup (xmms_xform_plugin_t *xform_plugin);
 static gboolean xmms_karaoke_init (xmms_xform_t *xform);
 static void xmms_karaoke_destroy (xmms_xform_t *xform);
 static void xmms_karaoke_config_changed (xmms_object_t *object, xmmsv_t *d, gpointer userdata);
-static gint xmms_karaoke_read (xmms_xform_t *xform, xmms_sample_t *buf, gint len,
-                               xmms_error_t *err);
+static void xmms_karaoke_process (xmms_xform_t *xform, xmms_sample_t *buf,
+                                  gint len);
 static gint64 xmms_karaoke_seek (xmms_xform_t *xform, gint64 offset,
                                  xmms_xform_seek_mode_t whence,
                                  xmms_error_t *err);
@@ -70,12 +71,17 @@ XMMS_XFORM_PLUGIN_DEFINE ("karaoke",
 static gboolean
 xmms_karaoke_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 {
+	static const xmms_sample_format_t formats[] = {
+		XMMS_SAMPLE_FORMAT_S16,
+		XMMS_SAMPLE_FORMAT_FLOAT
+	};
 	xmms_xform_methods_t methods;
+	gint i;
 
 	XMMS_XFORM_METHODS_INIT (methods);
 	methods.init = xmms_karaoke_init;
 	methods.destroy = xmms_karaoke_destroy;
-	methods.read = xmms_karaoke_read;
+	methods.process = xmms_karaoke_process;
 	methods.seek = xmms_karaoke_seek;
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
@@ -92,12 +98,14 @@ xmms_karaoke_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 	xmms_xform_plugin_config_property_register (xform_plugin, "width", "92.0",
 	                                            NULL, NULL);
 
-	xmms_xform_plugin_indata_add (xform_plugin,
-	                              XMMS_STREAM_TYPE_MIMETYPE,
-	                              "audio/pcm",
-	                              XMMS_STREAM_TYPE_FMT_FORMAT,
-	                              XMMS_SAMPLE_FORMAT_S16,
-	                              XMMS_STREAM_TYPE_END);
+	for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+		xmms_xform_plugin_indata_add (xform_plugin,
+		                              XMMS_STREAM_TYPE_MIMETYPE,
+		                              "audio/pcm",
+		                              XMMS_STREAM_TYPE_FMT_FORMAT,
+		                              formats[i],
+		                              XMMS_STREAM_TYPE_END);
+	}
 
 	return TRUE;
 }
@@ -138,6 +146,7 @@ xmms_karaoke_init (xmms_xform_t *xform)
 	xmms_config_property_callback_set (config, xmms_karaoke_config_changed, priv);
 	priv->width = xmms_config_property_get_float (config);
 
+	priv->format = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_FORMAT);
 	priv->srate = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_SAMPLERATE);
 	priv->channels = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_CHANNELS);
 
@@ -215,28 +224,55 @@ xmms_karaoke_config_changed (xmms_object_t *object, xmmsv_t *_val, gpointer user
 	}
 }
 
-static gint
-xmms_karaoke_read (xmms_xform_t *xform, xmms_sample_t *buffer, gint len,
-                   xmms_error_t *error)
+static void
+xmms_karaoke_process_float (xmms_karaoke_data_t *data, gfloat *buf, gint len)
+{
+	gfloat l, r, out;
+	gdouble y;
+	gint i;
+
+	for (i = 0; i < len; i += data->channels) {
+		l = buf[i];
+		r = buf[i+1];
+
+		y = (data->a*(l+r)/2 - data->b*data->y1) - data->c*data->y2;
+		data->y2 = data->y1;
+		data->y1 = y;
+
+		/* the same levels as for 16 bit samples, which saturate the
+		 * filtered signal at full scale */
+		out = CLAMP (y * (data->mono_level/10.0), -1.0, 1.0);
+		out = out * data->level / 32;
+
+		buf[i]   = l - r * data->level / 32 + out;
+		buf[i+1] = r - l * data->level / 32 + out;
+	}
+}
+
+static void
+xmms_karaoke_process (xmms_xform_t *xform, xmms_sample_t *buffer, gint len)
 {
 	xmms_karaoke_data_t *data;
 	gint16 *buf = buffer;
 	gint l, r, nl, nr, out, tmp;
 	gdouble y;
-	gint i, ret;
+	gint i;
 
-	g_return_val_if_fail (xform, -1);
+	g_return_if_fail (xform);
 
 	data = xmms_xform_private_data_get (xform);
-	g_return_val_if_fail (data, -1);
+	g_return_if_fail (data);
 
-	ret = xmms_xform_read (xform, buffer, len, error);
+	if (!data->enabled || data->channels < 2) {
+		return;
+	}
 
-	if (!data->enabled || data->channels < 2 || ret <= 0) {
-		return ret;
+	if (data->format == XMMS_SAMPLE_FORMAT_FLOAT) {
+		xmms_karaoke_process_float (data, buffer, len / sizeof (gfloat));
+		return;
 	}
 
-	for (i=0; i<(ret/2); i+=data->channels) {
+	for (i=0; i<(len/2); i+=data->channels) {
 		/* get left and right inputs */
 		l = buf[i];
 		r = buf[i+1];
@@ -260,8 +296,6 @@ xmms_karaoke_read (xmms_xform_t *xform, xmms_sample_t *buffer, gint len,
 		buf[i]   = SAT (nl);
 		buf[i+1] = SAT (nr);
 	}
-
-	return ret;
 }
 
 static gint64
@@ -60,6 +60,13 @@ typedef struct xmms_mad_data_St {
 	gint samples_to_skip;
 	gint64 samples_to_play;
 	gint frames_to_skip;
+	gint start_delay;
+
+	/* input offset of buffer[0] and position of the next frame,
+	 * only known exactly when indexing */
+	gint64 bufpos;
+	gint64 samplepos;
+	gboolean indexing;
 
 	xmms_xing_t *xing;
 } xmms_mad_data_t;
@@ -153,6 +160,7 @@ static gint64
 xmms_mad_seek (xmms_xform_t *xform, gint64 samples, xmms_xform_seek_mode_t whence, xmms_error_t *err)
 {
 	xmms_mad_data_t *data;
+	gint64 want, found, offset;
 	guint bytes;
 	gint64 res;
 
@@ -161,6 +169,36 @@ xmms_mad_seek (xmms_xform_t *xform, gint64 samples, xmms_xform_seek_mode_t whenc
 
 	data = xmms_xform_private_data_get (xform);
 
+	/* drop whatever was buffered for the old position */
+	data->buffer_length = 0;
+	mad_stream_buffer (&data->stream, data->buffer, 0);
+	mad_frame_mute (&data->frame);
+	mad_synth_mute (&data->synth);
+	data->synthpos = 0x7fffffff;
+	data->frames_to_skip = 0;
+	data->samples_to_play = -1;
+
+	/* positions in the index count the encoder delay too */
+	want = samples + data->start_delay;
+
+	if (xmms_xform_seekpoint_find (xform, want, &found, &offset)) {
+		XMMS_DBG ("Seek %" G_GINT64_FORMAT " samples via index -> %"
+		          G_GINT64_FORMAT " bytes", samples, offset);
+
+		res = xmms_xform_seek (xform, offset, XMMS_XFORM_SEEK_SET, err);
+		if (res == -1) {
+			return -1;
+		}
+
+		/* the index is exact, so decode up to the wanted sample */
+		data->bufpos = offset;
+		data->samplepos = found;
+		data->samples_to_skip = want - found;
+		data->indexing = TRUE;
+
+		return samples;
+	}
+
 	if (data->xing &&
 	    xmms_xing_has_flag (data->xing, XMMS_XING_FRAMES) &&
 	    xmms_xing_has_flag (data->xing, XMMS_XING_TOC)) {
@@ -183,7 +221,7 @@ xmms_mad_seek (xmms_xform_t *xform, gint64 samples, xmms_xform_seek_mode_t whenc
 	/* we don't have sample accuracy when seeking,
 	   so there is no use trying */
 	data->samples_to_skip = 0;
-	data->samples_to_play = -1;
+	data->indexing = FALSE;
 
 	return samples;
 }
@@ -278,6 +316,7 @@ xmms_mad_init (xmms_xform_t *xform)
 			/* FIXME: add a check for ignore_lame_headers from the medialib */
 			data->frames_to_skip = 1;
 			data->samples_to_skip = lame->start_delay;
+			data->start_delay = lame->start_delay;
 			data->samples_to_play = ((guint64) xmms_xing_get_frames (data->xing) * 1152ULL) -
 			                        lame->start_delay - lame->end_padding;
 			XMMS_DBG ("Samples to skip in the beginning: %d, total: %" G_GINT64_FORMAT,
@@ -318,6 +357,9 @@ xmms_mad_init (xmms_xform_t *xform)
 	/* seeking needs bitrate */
 	data->bitrate = frame.header.bitrate;
 
+	/* decoding starts at the beginning, so frame positions are exact */
+	data->indexing = TRUE;
+
 	if (xmms_id3v1_get_tags (xform) < 0) {
 		mad_stream_finish (&data->stream);
 		mad_frame_finish (&data->frame);
@@ -393,6 +435,12 @@ xmms_mad_read (xmms_xform_t *xform, gpointer buf, gint len, xmms_error_t *err)
 			/* mad_synthpop_frame - go Depeche! */
 			mad_synth_frame (&data->synth, &data->frame);
 
+			if (data->indexing && !data->frames_to_skip) {
+				xmms_xform_seekpoint_add (xform, data->samplepos,
+				                          data->bufpos + (data->stream.this_frame - data->buffer));
+				data->samplepos += data->synth.pcm.length;
+			}
+
 			if (data->frames_to_skip) {
 				data->frames_to_skip--;
 				data->synthpos = 0x7fffffff;
@@ -419,10 +467,21 @@ xmms_mad_read (xmms_xform_t *xform, gpointer buf, gint len, xmms_error_t *err)
 		}
 
 
+		/* the first frame after a seek lacks the data it refers back to,
+		   so its samples are lost rather than decoded */
+		if (data->stream.error == MAD_ERROR_BADDATAPTR) {
+			gint lost = 32 * MAD_NSBSAMPLES (&data->frame.header);
+
+			data->samplepos += lost;
+			data->samples_to_skip = MAX (0, data->samples_to_skip - lost);
+		}
+
 		/* if there is no frame to decode stream more data */
 		if (data->stream.next_frame) {
 			guchar *buffer = data->buffer;
 			const guchar *nf = data->stream.next_frame;
+
+			data->bufpos += nf - buffer;
 			memmove (data->buffer, data->stream.next_frame,
 			         data->buffer_length = (&buffer[data->buffer_length] - nf));
 		}
@@ -73,15 +73,28 @@ compress_free (compress_t *compress)
 	g_free (compress);
 }
 
+/* pregain is a constant gain handed over by the effect in front of us,
+** it is applied together with the compressor gain in the same pass
+*/
 void
-compress_do (compress_t *compress, void *data, guint length)
+compress_do (compress_t *compress, void *data, guint length, gfloat pregain)
 {
 	gint16 *audio = (gint16 *)data, *ap;
 	gint peak, pos;
 	gint i;
 	gint gr, gf, gn;
+	gint64 pre;
 
+	/* no history to compress with, the gain is all that is left */
 	if (!compress->peaks) {
+		if (pregain != 1.0) {
+			pre = pregain*65536;
+			ap = audio;
+			for (i = 0; i < length/2; i++) {
+				gint sample = ((gint64) *ap)*pre >> 16;
+				*ap++ = CLAMP (sample, -32768, 32767);
+			}
+		}
 		return;
 	}
 
@@ -118,6 +131,14 @@ compress_do (compress_t *compress, void *data, guint length)
 		ap++;
 	}
 
+	/* The peak we would have seen had the gain been applied already */
+	if (pregain != 1.0) {
+		peak = peak*pregain;
+		if (peak < 1) {
+			peak = 1;
+		}
+	}
+
 	compress->peaks[compress->pn] = peak;
 
 	for (i = 0; i < compress->prefs.buckets; i++) {
@@ -176,6 +197,7 @@ compress_do (compress_t *compress, void *data, guint length)
 
 	/* Do the shiznit */
 	gf = compress->gain_current << 16;
+	pre = pregain*65536;
 
 #ifdef STATS
 	fprintf (stderr, "\r%d gain = %2.2f%+.2e ", compress->gain_current,
@@ -197,7 +219,7 @@ compress_do (compress_t *compress, void *data, guint length)
 		}
 
 		/* Amplify */
-		sample = (*ap)*compress->gain_current >> GAINSHIFT;
+		sample = ((gint64) *ap)*compress->gain_current*pre >> (GAINSHIFT + 16);
 		if (sample < -32768) {
 #ifdef STATS
 			compress->clip++;
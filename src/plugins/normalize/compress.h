@@ -44,7 +44,7 @@ void compress_reconfigure (compress_t *compress,
                            int buckets);
 
 void compress_do (compress_t *compress, void *data,
-                  unsigned num_samples);
+                  unsigned num_samples, float pregain);
 
 void compress_free (compress_t *compress);
 
@@ -51,8 +51,8 @@ typedef struct {
 static gboolean xmms_normalize_plugin_setup (xmms_xform_plugin_t *xform_plugin);
 static gboolean xmms_normalize_init (xmms_xform_t *xform);
 static void xmms_normalize_destroy (xmms_xform_t *xform);
-static gint xmms_normalize_read (xmms_xform_t *xform, xmms_sample_t *buf,
-                                 gint len, xmms_error_t *error);
+static void xmms_normalize_process (xmms_xform_t *xform, xmms_sample_t *buf,
+                                    gint len);
 static void xmms_normalize_config_changed (xmms_object_t *obj, xmmsv_t *value, gpointer udata);
 
 XMMS_XFORM_PLUGIN_DEFINE ("normalize",
@@ -71,7 +71,7 @@ xmms_normalize_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 
 	methods.init = xmms_normalize_init;
 	methods.destroy = xmms_normalize_destroy;
-	methods.read = xmms_normalize_read;
+	methods.process = xmms_normalize_process;
 	methods.seek = xmms_xform_seek; /* we're not using this */
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
@@ -116,6 +116,9 @@ xmms_normalize_init (xmms_xform_t *xform)
 
 	xmms_xform_outdata_type_copy (xform);
 
+	/* a gain effect in front of us can leave its multiply to us */
+	xmms_xform_gain_accept (xform);
+
 	data->dirty = FALSE;
 
 	data->compress = compress_new (data->use_anticlip,
@@ -155,34 +158,27 @@ xmms_normalize_destroy (xmms_xform_t *xform)
 
 }
 
-static gint
-xmms_normalize_read (xmms_xform_t *xform, xmms_sample_t *buf, gint len,
-                     xmms_error_t *error)
+static void
+xmms_normalize_process (xmms_xform_t *xform, xmms_sample_t *buf, gint len)
 {
 	xmms_normalize_data_t *data;
-	gint read;
 
-	g_return_val_if_fail (xform, -1);
+	g_return_if_fail (xform);
 
 	data = xmms_xform_private_data_get (xform);
 
-	read = xmms_xform_read (xform, buf, len, error);
-
-	if (read > 0) {
-		if (data->dirty) {
-			compress_reconfigure (data->compress,
-			                      data->use_anticlip,
-			                      data->target,
-			                      data->max_gain,
-			                      data->smooth,
-			                      data->buckets);
-			data->dirty = FALSE;
-		}
-
-		compress_do (data->compress, buf, read);
+	if (data->dirty) {
+		compress_reconfigure (data->compress,
+		                      data->use_anticlip,
+		                      data->target,
+		                      data->max_gain,
+		                      data->smooth,
+		                      data->buckets);
+		data->dirty = FALSE;
 	}
 
-	return read;
+	compress_do (data->compress, buf, len,
+	             xmms_xform_gain_get (xform));
 }
 
 static void
@@ -28,8 +28,18 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 typedef void (*xmms_replaygain_apply_func_t)
-	(void *buf, gint len, gfloat gain);
+	(void *buf, gint len, gfloat gain, gboolean soft_clip);
+
+/* Fraction of full scale where the soft clipper starts to bend the
+ * signal. Above it, samples approach full scale asymptotically instead
+ * of being cut flat.
+ */
+#define SOFT_CLIP_KNEE 0.9
 
 /**
  * Replaygain modes.
@@ -47,6 +57,8 @@ typedef struct xmms_replaygain_data_St {
 	gfloat gain;
 	gboolean has_replaygain;
 	gboolean enabled;
+	gboolean soft_clip;
+	gint sample_size;
 	xmms_replaygain_apply_func_t apply;
 } xmms_replaygain_data_t;
 
@@ -64,8 +76,8 @@ static const xmms_sample_format_t formats[] = {
 static gboolean xmms_replaygain_plugin_setup (xmms_xform_plugin_t *xform_plugin);
 static gboolean xmms_replaygain_init (xmms_xform_t *xform);
 static void xmms_replaygain_destroy (xmms_xform_t *xform);
-static gint xmms_replaygain_read (xmms_xform_t *xform, xmms_sample_t *buf,
-                                  gint len, xmms_error_t *error);
+static void xmms_replaygain_process (xmms_xform_t *xform, xmms_sample_t *buf,
+                                     gint len);
 static gint64 xmms_replaygain_seek (xmms_xform_t *xform, gint64 samples,
                                     xmms_xform_seek_mode_t whence,
                                     xmms_error_t *error);
@@ -74,14 +86,14 @@ static void xmms_replaygain_config_changed (xmms_object_t *obj, xmmsv_t *_val, g
 static void compute_gain (xmms_xform_t *xform, xmms_replaygain_data_t *data);
 static xmms_replaygain_mode_t parse_mode (const char *s);
 
-static void apply_s8 (void *buf, gint len, gfloat gain);
-static void apply_u8 (void *buf, gint len, gfloat gain);
-static void apply_s16 (void *buf, gint len, gfloat gain);
-static void apply_u16 (void *buf, gint len, gfloat gain);
-static void apply_s32 (void *buf, gint len, gfloat gain);
-static void apply_u32 (void *buf, gint len, gfloat gain);
-static void apply_float (void *buf, gint len, gfloat gain);
-static void apply_double (void *buf, gint len, gfloat gain);
+static void apply_s8 (void *buf, gint len, gfloat gain, gboolean soft_clip);
+static void apply_u8 (void *buf, gint len, gfloat gain, gboolean soft_clip);
+static void apply_s16 (void *buf, gint len, gfloat gain, gboolean soft_clip);
+static void apply_u16 (void *buf, gint len, gfloat gain, gboolean soft_clip);
+static void apply_s32 (void *buf, gint len, gfloat gain, gboolean soft_clip);
+static void apply_u32 (void *buf, gint len, gfloat gain, gboolean soft_clip);
+static void apply_float (void *buf, gint len, gfloat gain, gboolean soft_clip);
+static void apply_double (void *buf, gint len, gfloat gain, gboolean soft_clip);
 
 /*
  * Plugin header
@@ -103,7 +115,7 @@ xmms_replaygain_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 
 	methods.init = xmms_replaygain_init;
 	methods.destroy = xmms_replaygain_destroy;
-	methods.read = xmms_replaygain_read;
+	methods.process = xmms_replaygain_process;
 	methods.seek = xmms_replaygain_seek;
 
 	xmms_xform_plugin_methods_set (xform_plugin, &methods);
@@ -127,6 +139,9 @@ xmms_replaygain_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 	xmms_xform_plugin_config_property_register (xform_plugin,
 	                                            "preamp", "6.0",
 	                                            NULL, NULL);
+	xmms_xform_plugin_config_property_register (xform_plugin,
+	                                            "soft_clip", "0",
+	                                            NULL, NULL);
 
 	return TRUE;
 }
@@ -173,11 +188,22 @@ xmms_replaygain_init (xmms_xform_t *xform)
 
 	data->enabled = !!xmms_config_property_get_int (cfgv);
 
+	cfgv = xmms_xform_config_lookup (xform, "soft_clip");
+	xmms_config_property_callback_set (cfgv,
+	                                   xmms_replaygain_config_changed,
+	                                   xform);
+
+	data->soft_clip = !!xmms_config_property_get_int (cfgv);
+
 	xmms_xform_outdata_type_copy (xform);
 
+	/* a gain effect in front of us can leave its multiply to us */
+	xmms_xform_gain_accept (xform);
+
 	compute_gain (xform, data);
 
 	fmt = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_FORMAT);
+	data->sample_size = xmms_sample_size_get (fmt);
 
 	switch (fmt) {
 		case XMMS_SAMPLE_FORMAT_S8:
@@ -239,33 +265,39 @@ xmms_replaygain_destroy (xmms_xform_t *xform)
 	cfgv = xmms_xform_config_lookup (xform, "enabled");
 	xmms_config_property_callback_remove (cfgv,
 	                                      xmms_replaygain_config_changed, xform);
+
+	cfgv = xmms_xform_config_lookup (xform, "soft_clip");
+	xmms_config_property_callback_remove (cfgv,
+	                                      xmms_replaygain_config_changed, xform);
 }
 
-static gint
-xmms_replaygain_read (xmms_xform_t *xform, xmms_sample_t *buf, gint len,
-                      xmms_error_t *error)
+static void
+xmms_replaygain_process (xmms_xform_t *xform, xmms_sample_t *buf, gint len)
 {
 	xmms_replaygain_data_t *data;
-	xmms_sample_format_t fmt;
-	gint read;
+	gfloat gain;
 
-	g_return_val_if_fail (xform, -1);
+	g_return_if_fail (xform);
 
 	data = xmms_xform_private_data_get (xform);
-	g_return_val_if_fail (data, -1);
-
-	read = xmms_xform_read (xform, buf, len, error);
+	g_return_if_fail (data);
 
-	if (!data->has_replaygain || !data->enabled) {
-		return read;
+	/* fold in whatever gain the previous effect handed over */
+	gain = xmms_xform_gain_get (xform);
+	if (data->has_replaygain && data->enabled) {
+		gain *= data->gain;
 	}
 
-	fmt = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_FORMAT);
-	len /= xmms_sample_size_get (fmt);
+	/* and hand the product on if the next one can apply it */
+	if (xmms_xform_gain_defer (xform, gain)) {
+		return;
+	}
 
-	data->apply (buf, len, data->gain);
+	if (fabs (gain - 1.0) <= 0.001) {
+		return;
+	}
 
-	return read;
+	data->apply (buf, len / data->sample_size, gain, data->soft_clip);
 }
 
 static gint64
@@ -303,6 +335,8 @@ xmms_replaygain_config_changed (xmms_object_t *obj, xmmsv_t *_val, gpointer udat
 		dirty = TRUE;
 	} else if (!g_ascii_strcasecmp (name, "replaygain.enabled")) {
 		data->enabled = !!atoi (value);
+	} else if (!g_ascii_strcasecmp (name, "replaygain.soft_clip")) {
+		data->soft_clip = !!atoi (value);
 	}
 
 	if (dirty) {
@@ -363,99 +397,227 @@ parse_mode (const char *s)
 	}
 }
 
+/* Bend a sample above the knee towards full scale, see SOFT_CLIP_KNEE.
+ * Continuous and monotonic, the output never exceeds full.
+ */
+static inline gdouble
+soft_clip_sample (gdouble x, gdouble full)
+{
+	gdouble a, knee, over;
+
+	a = fabs (x);
+	knee = SOFT_CLIP_KNEE * full;
+
+	if (a <= knee) {
+		return x;
+	}
+
+	over = a - knee;
+	a = knee + over / (1.0 + over / ((1.0 - SOFT_CLIP_KNEE) * full));
+
+	return x < 0 ? -a : a;
+}
+
+/* Integer samples are scaled in double precision, which is exact for
+ * every format up to 32 bits, then clipped to [-full - 1, full].
+ */
+static inline gdouble
+apply_int_sample (gdouble x, gdouble full, gfloat gain, gboolean soft_clip)
+{
+	x *= gain;
+
+	if (soft_clip) {
+		x = soft_clip_sample (x, full);
+	}
+
+	return CLAMP (x, -full - 1, full);
+}
+
+#ifdef __SSE2__
+static inline __m128
+soft_clip_ps (__m128 x, __m128 knee, __m128 k)
+{
+	const __m128 sign = _mm_set1_ps (-0.0f);
+	__m128 a, over;
+
+	a = _mm_andnot_ps (sign, x);
+	over = _mm_max_ps (_mm_sub_ps (a, knee), _mm_setzero_ps ());
+	over = _mm_div_ps (over, _mm_add_ps (_mm_set1_ps (1.0f),
+	                                     _mm_mul_ps (over, k)));
+	a = _mm_add_ps (_mm_min_ps (a, knee), over);
+
+	return _mm_or_ps (a, _mm_and_ps (sign, x));
+}
+#endif
+
 static void
-apply_s8 (void *buf, gint len, gfloat gain)
+apply_s8 (void *buf, gint len, gfloat gain, gboolean soft_clip)
 {
 	xmms_samples8_t *samples = (xmms_samples8_t *) buf;
 	gint i;
 
 	for (i = 0; i < len; i++) {
-		gfloat sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, XMMS_SAMPLES8_MIN,
-		                    XMMS_SAMPLES8_MAX);
+		samples[i] = lrint (apply_int_sample (samples[i], XMMS_SAMPLES8_MAX,
+		                                      gain, soft_clip));
 	}
 }
 
 static void
-apply_u8 (void *buf, gint len, gfloat gain)
+apply_u8 (void *buf, gint len, gfloat gain, gboolean soft_clip)
 {
 	xmms_sampleu8_t *samples = (xmms_sampleu8_t *) buf;
+	const gdouble mid = XMMS_SAMPLEU8_MAX / 2 + 1;
 	gint i;
 
 	for (i = 0; i < len; i++) {
-		gfloat sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, 0, XMMS_SAMPLEU8_MAX);
+		samples[i] = lrint (apply_int_sample (samples[i] - mid, mid - 1,
+		                                      gain, soft_clip) + mid);
 	}
 }
 
 static void
-apply_s16 (void *buf, gint len, gfloat gain)
+apply_s16 (void *buf, gint len, gfloat gain, gboolean soft_clip)
 {
 	xmms_samples16_t *samples = (xmms_samples16_t *) buf;
-	gint i;
+	gint i = 0;
 
-	for (i = 0; i < len; i++) {
-		gfloat sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, XMMS_SAMPLES16_MIN,
-		                    XMMS_SAMPLES16_MAX);
+#ifdef __SSE2__
+	const __m128 g = _mm_set1_ps (gain);
+	const __m128 knee = _mm_set1_ps (SOFT_CLIP_KNEE * XMMS_SAMPLES16_MAX);
+	const __m128 k = _mm_set1_ps (1.0 / ((1.0 - SOFT_CLIP_KNEE) * XMMS_SAMPLES16_MAX));
+
+	for (; i + 8 <= len; i += 8) {
+		__m128i v, lo, hi;
+		__m128 flo, fhi;
+
+		v = _mm_loadu_si128 ((__m128i *) &samples[i]);
+		lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16);
+		hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16);
+
+		flo = _mm_mul_ps (_mm_cvtepi32_ps (lo), g);
+		fhi = _mm_mul_ps (_mm_cvtepi32_ps (hi), g);
+
+		if (soft_clip) {
+			flo = soft_clip_ps (flo, knee, k);
+			fhi = soft_clip_ps (fhi, knee, k);
+		}
+
+		/* gain is at most 15, so the products fit in 32 bits and the
+		 * signed saturating pack does the clamping */
+		v = _mm_packs_epi32 (_mm_cvtps_epi32 (flo), _mm_cvtps_epi32 (fhi));
+		_mm_storeu_si128 ((__m128i *) &samples[i], v);
+	}
+#endif
+
+	for (; i < len; i++) {
+		samples[i] = lrint (apply_int_sample (samples[i], XMMS_SAMPLES16_MAX,
+		                                      gain, soft_clip));
 	}
 }
 
 static void
-apply_u16 (void *buf, gint len, gfloat gain)
+apply_u16 (void *buf, gint len, gfloat gain, gboolean soft_clip)
 {
 	xmms_sampleu16_t *samples = (xmms_sampleu16_t *) buf;
+	const gdouble mid = XMMS_SAMPLEU16_MAX / 2 + 1;
 	gint i;
 
 	for (i = 0; i < len; i++) {
-		gfloat sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, 0, XMMS_SAMPLEU16_MAX);
+		samples[i] = lrint (apply_int_sample (samples[i] - mid, mid - 1,
+		                                      gain, soft_clip) + mid);
 	}
 }
 
 static void
-apply_s32 (void *buf, gint len, gfloat gain)
+apply_s32 (void *buf, gint len, gfloat gain, gboolean soft_clip)
 {
 	xmms_samples32_t *samples = (xmms_samples32_t *) buf;
-	gint i;
+	gint i = 0;
 
-	for (i = 0; i < len; i++) {
-		gdouble sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, XMMS_SAMPLES32_MIN,
-		                    XMMS_SAMPLES32_MAX);
+#ifdef __SSE2__
+	const __m128d g = _mm_set1_pd (gain);
+	const __m128d min = _mm_set1_pd (XMMS_SAMPLES32_MIN);
+	const __m128d max = _mm_set1_pd (XMMS_SAMPLES32_MAX);
+
+	/* the soft clipper is rarely used with 32 bit sources, leave
+	 * it to the scalar loop */
+	for (; !soft_clip && i + 4 <= len; i += 4) {
+		__m128i v;
+		__m128d lo, hi;
+
+		v = _mm_loadu_si128 ((__m128i *) &samples[i]);
+		lo = _mm_mul_pd (_mm_cvtepi32_pd (v), g);
+		hi = _mm_mul_pd (_mm_cvtepi32_pd (_mm_shuffle_epi32 (v, 0x0e)), g);
+
+		lo = _mm_min_pd (_mm_max_pd (lo, min), max);
+		hi = _mm_min_pd (_mm_max_pd (hi, min), max);
+
+		v = _mm_unpacklo_epi64 (_mm_cvtpd_epi32 (lo), _mm_cvtpd_epi32 (hi));
+		_mm_storeu_si128 ((__m128i *) &samples[i], v);
+	}
+#endif
+
+	for (; i < len; i++) {
+		samples[i] = llrint (apply_int_sample (samples[i], XMMS_SAMPLES32_MAX,
+		                                       gain, soft_clip));
 	}
 }
 
 static void
-apply_u32 (void *buf, gint len, gfloat gain)
+apply_u32 (void *buf, gint len, gfloat gain, gboolean soft_clip)
 {
 	xmms_sampleu32_t *samples = (xmms_sampleu32_t *) buf;
+	const gdouble mid = XMMS_SAMPLEU32_MAX / 2 + 1.0;
 	gint i;
 
 	for (i = 0; i < len; i++) {
-		gdouble sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, 0, XMMS_SAMPLEU32_MAX);
+		samples[i] = llrint (apply_int_sample (samples[i] - mid, mid - 1,
+		                                       gain, soft_clip) + mid);
 	}
 }
 
+/* Floating point samples have headroom, so they are only limited when
+ * soft clipping is enabled. */
 static void
-apply_float (void *buf, gint len, gfloat gain)
+apply_float (void *buf, gint len, gfloat gain, gboolean soft_clip)
 {
 	xmms_samplefloat_t *samples = (xmms_samplefloat_t *) buf;
-	gint i;
+	gint i = 0;
 
-	for (i = 0; i < len; i++) {
+#ifdef __SSE2__
+	const __m128 g = _mm_set1_ps (gain);
+	const __m128 knee = _mm_set1_ps (SOFT_CLIP_KNEE);
+	const __m128 k = _mm_set1_ps (1.0 / (1.0 - SOFT_CLIP_KNEE));
+
+	for (; i + 4 <= len; i += 4) {
+		__m128 v;
+
+		v = _mm_mul_ps (_mm_loadu_ps (&samples[i]), g);
+		if (soft_clip) {
+			v = soft_clip_ps (v, knee, k);
+		}
+		_mm_storeu_ps (&samples[i], v);
+	}
+#endif
+
+	for (; i < len; i++) {
 		samples[i] *= gain;
+		if (soft_clip) {
+			samples[i] = soft_clip_sample (samples[i], 1.0);
+		}
 	}
 }
 
 static void
-apply_double (void *buf, gint len, gfloat gain)
+apply_double (void *buf, gint len, gfloat gain, gboolean soft_clip)
 {
 	xmms_sampledouble_t *samples = (xmms_sampledouble_t *) buf;
 	gint i;
 
 	for (i = 0; i < len; i++) {
 		samples[i] *= gain;
+		if (soft_clip) {
+			samples[i] = soft_clip_sample (samples[i], 1.0);
+		}
 	}
 }
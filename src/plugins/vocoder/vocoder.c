@@ -311,5 +311,18 @@ static gint64
 xmms_vocoder_seek (xmms_xform_t *xform, gint64 offset,
                    xmms_xform_seek_mode_t whence, xmms_error_t *err)
 {
-	return xmms_xform_seek (xform, offset, whence, err);
+	xmms_vocoder_data_t *data;
+	gint64 ret;
+
+	ret = xmms_xform_seek (xform, offset, whence, err);
+
+	/* drop what was processed for the old position */
+	data = xmms_xform_private_data_get (xform);
+	if (ret != -1 && data) {
+		g_string_truncate (data->outbuf, 0);
+		data->resdata.input_frames = 0;
+		src_reset (data->resampler);
+	}
+
+	return ret;
 }
@@ -144,6 +144,30 @@ xmms_bindata_plugin_add (const guchar *data, gsize size, gchar hash[33])
 	return _xmms_bindata_add (global_bindata, data, size, hash, &err);
 }
 
+/** Read back binary data stored with #xmms_bindata_plugin_add */
+gboolean
+xmms_bindata_get (const gchar *hash, guchar **data, gsize *size)
+{
+	gboolean ret;
+	gchar *path;
+
+	path = xmms_bindata_build_path (global_bindata, hash);
+	ret = g_file_get_contents (path, (gchar **) data, size, NULL);
+	g_free (path);
+
+	return ret;
+}
+
+/** Remove binary data stored with #xmms_bindata_plugin_add */
+void
+xmms_bindata_remove (const gchar *hash)
+{
+	xmms_error_t err;
+
+	xmms_error_reset (&err);
+	xmms_bindata_client_remove (global_bindata, hash, &err);
+}
+
 static gboolean
 _xmms_bindata_add (xmms_bindata_t *bindata, const guchar *data, gsize len, gchar hash[33], xmms_error_t *err)
 {
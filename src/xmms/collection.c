@@ -390,6 +390,11 @@ xmms_collection_client_save (xmms_coll_dag_t *dag, const gchar *name, const gcha
 		return;
 	}
 
+	/* The strings of a collection read from a client point into the
+	 * message it came in, keep a copy of its own instead of the
+	 * whole message */
+	coll = xmmsv_copy (coll);
+
 	g_mutex_lock (&dag->mutex);
 
 	/* Unreference previously saved collection */
@@ -431,6 +436,8 @@ xmms_collection_client_save (xmms_coll_dag_t *dag, const gchar *name, const gcha
 	}
 
 	g_mutex_unlock (&dag->mutex);
+
+	xmmsv_unref (coll);
 }
 
 
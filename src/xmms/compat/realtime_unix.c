@@ -0,0 +1,226 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+
+/** @file
+ * Real-time scheduling, CPU affinity and memory locking for the
+ * threads that feed the sound card.
+ */
+
+#define _GNU_SOURCE
+
+#include <xmmspriv/xmms_realtime.h>
+#include <xmms/xmms_log.h>
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+/**
+ * Switch the calling thread to SCHED_FIFO, or SCHED_RR if round_robin
+ * is set. Without privileges the priority is capped to RLIMIT_RTPRIO,
+ * raising the soft limit to the hard one if needed, so no helper
+ * daemon is required when the administrator granted a limit.
+ */
+gboolean
+xmms_realtime_thread_set (gboolean round_robin, gint priority)
+{
+#if defined(_POSIX_THREAD_PRIORITY_SCHEDULING) && _POSIX_THREAD_PRIORITY_SCHEDULING > 0
+	struct sched_param param;
+	gint policy, min, max, err;
+#ifdef RLIMIT_RTPRIO
+	struct rlimit rl;
+#endif
+
+	policy = round_robin ? SCHED_RR : SCHED_FIFO;
+
+	min = sched_get_priority_min (policy);
+	max = sched_get_priority_max (policy);
+	priority = CLAMP (priority, min, max);
+
+#ifdef RLIMIT_RTPRIO
+	if (geteuid () != 0 && getrlimit (RLIMIT_RTPRIO, &rl) == 0) {
+		if (rl.rlim_cur < rl.rlim_max && rl.rlim_cur < (rlim_t) priority) {
+			rl.rlim_cur = MIN (rl.rlim_max, (rlim_t) priority);
+			setrlimit (RLIMIT_RTPRIO, &rl);
+		}
+		if (rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur < (rlim_t) priority) {
+			priority = rl.rlim_cur;
+		}
+		if (priority < min) {
+			xmms_log_info ("Not allowed to use real-time scheduling, "
+			               "raise RLIMIT_RTPRIO to enable it");
+			return FALSE;
+		}
+	}
+#endif
+
+	memset (&param, 0, sizeof (param));
+	param.sched_priority = priority;
+
+	err = pthread_setschedparam (pthread_self (), policy, &param);
+	if (err) {
+		xmms_log_error ("Couldn't switch to real-time scheduling: %s",
+		                strerror (err));
+		return FALSE;
+	}
+
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+/**
+ * Lower the priority of the calling thread by increment nice levels,
+ * for housekeeping that shouldn't compete with the threads feeding
+ * the sound card. Only Linux has per-thread nice values.
+ */
+gboolean
+xmms_realtime_thread_nice (gint increment)
+{
+#if defined(__linux__) && defined(SYS_gettid)
+	pid_t tid = syscall (SYS_gettid);
+	gint prio;
+
+	errno = 0;
+	prio = getpriority (PRIO_PROCESS, tid);
+	if (prio == -1 && errno) {
+		return FALSE;
+	}
+
+	if (setpriority (PRIO_PROCESS, tid, MIN (prio + increment, 19)) == -1) {
+		xmms_log_error ("Couldn't lower thread priority: %s", strerror (errno));
+		return FALSE;
+	}
+
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+/**
+ * Bind the calling thread to the CPUs in a list like "0,2-3".
+ */
+gboolean
+xmms_realtime_thread_affinity_set (const gchar *cpus)
+{
+#if defined(__linux__) && defined(CPU_SET)
+	cpu_set_t set;
+	gchar **parts;
+	gint i, err;
+
+	CPU_ZERO (&set);
+
+	parts = g_strsplit (cpus, ",", 0);
+	for (i = 0; parts[i]; i++) {
+		gchar *end;
+		glong first, last;
+
+		first = last = strtol (parts[i], &end, 10);
+		if (*end == '-') {
+			last = strtol (end + 1, &end, 10);
+		}
+
+		if (end == parts[i] || first < 0 || last < first) {
+			continue;
+		}
+
+		for (; first <= last && first < CPU_SETSIZE; first++) {
+			CPU_SET (first, &set);
+		}
+	}
+	g_strfreev (parts);
+
+	if (!CPU_COUNT (&set)) {
+		xmms_log_error ("No CPUs in affinity list '%s'", cpus);
+		return FALSE;
+	}
+
+	err = pthread_setaffinity_np (pthread_self (), sizeof (set), &set);
+	if (err) {
+		xmms_log_error ("Couldn't set CPU affinity to '%s': %s",
+		                cpus, strerror (err));
+		return FALSE;
+	}
+
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+#if defined(_POSIX_MEMLOCK_RANGE) && _POSIX_MEMLOCK_RANGE > 0
+static gsize
+page_round (gsize length, gsize page)
+{
+	return (length + page - 1) / page * page;
+}
+#endif
+
+/**
+ * Allocate length bytes that stay resident, so touching them never
+ * waits for I/O. Locks cover whole pages and don't nest, so the memory
+ * gets pages of its own; unlocking it can't release another buffer.
+ *
+ * @returns the memory, or NULL if it couldn't be locked
+ */
+gpointer
+xmms_realtime_locked_alloc (gsize length)
+{
+#if defined(_POSIX_MEMLOCK_RANGE) && _POSIX_MEMLOCK_RANGE > 0
+	gsize page = sysconf (_SC_PAGESIZE);
+	gpointer mem;
+
+	length = page_round (length, page);
+
+	if (posix_memalign (&mem, page, length)) {
+		return NULL;
+	}
+
+	if (mlock (mem, length) == -1) {
+		xmms_log_error ("Couldn't lock %" G_GSIZE_FORMAT " bytes in memory: %s",
+		                length, strerror (errno));
+		free (mem);
+		return NULL;
+	}
+
+	return mem;
+#else
+	return NULL;
+#endif
+}
+
+/**
+ * Unlock and free memory from #xmms_realtime_locked_alloc.
+ */
+void
+xmms_realtime_locked_free (gpointer mem, gsize length)
+{
+#if defined(_POSIX_MEMLOCK_RANGE) && _POSIX_MEMLOCK_RANGE > 0
+	if (mem) {
+		munlock (mem, page_round (length, sysconf (_SC_PAGESIZE)));
+		free (mem);
+	}
+#endif
+}
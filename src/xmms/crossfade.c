@@ -0,0 +1,232 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/**
+ * @file
+ * Mixing of two streams during a crossfade.
+ */
+
+#include <math.h>
+#include <glib.h>
+
+#include <xmmspriv/xmms_crossfade.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* number of samples the gains are computed for at a time */
+#define GAIN_BLOCK 1024
+
+typedef void (*xmms_crossfade_mix_func_t)
+	(gpointer out, gconstpointer in, const gfloat *gout,
+	 const gfloat *gin, gint len);
+
+/**
+ * Get the curve called name, linear when it is unknown.
+ */
+xmms_crossfade_curve_t
+xmms_crossfade_curve_parse (const gchar *name)
+{
+	if (name && g_ascii_strcasecmp (name, "equal_power") == 0) {
+		return XMMS_CROSSFADE_CURVE_EQUAL_POWER;
+	} else if (name && g_ascii_strcasecmp (name, "scurve") == 0) {
+		return XMMS_CROSSFADE_CURVE_SCURVE;
+	}
+	return XMMS_CROSSFADE_CURVE_LINEAR;
+}
+
+static void
+mix_s16 (gpointer out, gconstpointer in, const gfloat *gout,
+         const gfloat *gin, gint len)
+{
+	xmms_samples16_t *a = (xmms_samples16_t *) out;
+	const xmms_samples16_t *b = (const xmms_samples16_t *) in;
+	gint i = 0;
+
+#ifdef __SSE2__
+	for (; i + 8 <= len; i += 8) {
+		__m128i va, vb;
+		__m128 alo, ahi, blo, bhi;
+
+		va = _mm_loadu_si128 ((const __m128i *) &a[i]);
+		vb = _mm_loadu_si128 ((const __m128i *) &b[i]);
+
+		alo = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (va, va), 16));
+		ahi = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpackhi_epi16 (va, va), 16));
+		blo = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (vb, vb), 16));
+		bhi = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpackhi_epi16 (vb, vb), 16));
+
+		alo = _mm_add_ps (_mm_mul_ps (alo, _mm_loadu_ps (&gout[i])),
+		                  _mm_mul_ps (blo, _mm_loadu_ps (&gin[i])));
+		ahi = _mm_add_ps (_mm_mul_ps (ahi, _mm_loadu_ps (&gout[i + 4])),
+		                  _mm_mul_ps (bhi, _mm_loadu_ps (&gin[i + 4])));
+
+		/* the signed saturating pack does the clamping */
+		va = _mm_packs_epi32 (_mm_cvtps_epi32 (alo), _mm_cvtps_epi32 (ahi));
+		_mm_storeu_si128 ((__m128i *) &a[i], va);
+	}
+#endif
+
+	for (; i < len; i++) {
+		gfloat v = a[i] * gout[i] + b[i] * gin[i];
+		a[i] = lrintf (CLAMP (v, XMMS_SAMPLES16_MIN, XMMS_SAMPLES16_MAX));
+	}
+}
+
+static void
+mix_s32 (gpointer out, gconstpointer in, const gfloat *gout,
+         const gfloat *gin, gint len)
+{
+	xmms_samples32_t *a = (xmms_samples32_t *) out;
+	const xmms_samples32_t *b = (const xmms_samples32_t *) in;
+	gint i;
+
+	/* single precision would lose the low bits, and a double only
+	 * holds two samples per register, so leave it to the compiler */
+	for (i = 0; i < len; i++) {
+		gdouble v = (gdouble) a[i] * gout[i] + (gdouble) b[i] * gin[i];
+		a[i] = llrint (CLAMP (v, XMMS_SAMPLES32_MIN, XMMS_SAMPLES32_MAX));
+	}
+}
+
+static void
+mix_float (gpointer out, gconstpointer in, const gfloat *gout,
+           const gfloat *gin, gint len)
+{
+	xmms_samplefloat_t *a = (xmms_samplefloat_t *) out;
+	const xmms_samplefloat_t *b = (const xmms_samplefloat_t *) in;
+	gint i = 0;
+
+#ifdef __SSE2__
+	for (; i + 4 <= len; i += 4) {
+		__m128 va, vb;
+
+		va = _mm_mul_ps (_mm_loadu_ps (&a[i]), _mm_loadu_ps (&gout[i]));
+		vb = _mm_mul_ps (_mm_loadu_ps (&b[i]), _mm_loadu_ps (&gin[i]));
+		_mm_storeu_ps (&a[i], _mm_add_ps (va, vb));
+	}
+#endif
+
+	/* float samples are left unclamped, as everywhere else */
+	for (; i < len; i++) {
+		a[i] = a[i] * gout[i] + b[i] * gin[i];
+	}
+}
+
+static xmms_crossfade_mix_func_t
+mix_func_get (xmms_sample_format_t format)
+{
+	switch (format) {
+		case XMMS_SAMPLE_FORMAT_S16:
+			return mix_s16;
+		case XMMS_SAMPLE_FORMAT_S32:
+			return mix_s32;
+		case XMMS_SAMPLE_FORMAT_FLOAT:
+			return mix_float;
+		default:
+			return NULL;
+	}
+}
+
+/**
+ * Check if streams of the given sample format can be mixed.
+ */
+gboolean
+xmms_crossfade_format_supported (xmms_sample_format_t format)
+{
+	return mix_func_get (format) != NULL;
+}
+
+/**
+ * Fill in the gains of both streams for each sample of frames
+ * frames, starting at frame pos of a fade over len frames.
+ */
+static void
+gains_fill (xmms_crossfade_curve_t curve, gint channels, guint frames,
+            guint pos, guint len, gfloat *gout, gfloat *gin)
+{
+	guint f;
+	gint c, i = 0;
+
+	for (f = 0; f < frames; f++) {
+		gfloat t, o, n;
+
+		t = MIN ((gfloat) (pos + f) / len, 1.0f);
+
+		switch (curve) {
+			case XMMS_CROSSFADE_CURVE_EQUAL_POWER:
+				o = cosf (t * G_PI_2);
+				n = sinf (t * G_PI_2);
+				break;
+			case XMMS_CROSSFADE_CURVE_SCURVE:
+				n = t * t * (3.0f - 2.0f * t);
+				o = 1.0f - n;
+				break;
+			default:
+				n = t;
+				o = 1.0f - t;
+				break;
+		}
+
+		for (c = 0; c < channels; c++, i++) {
+			gout[i] = o;
+			gin[i] = n;
+		}
+	}
+}
+
+/**
+ * Mix frames frames of in into out, fading out from out to in.
+ *
+ * The frames are taken to start at frame pos of a fade that lasts
+ * len frames. Both buffers hold interleaved samples of the given
+ * format, which must be supported by #xmms_crossfade_format_supported.
+ *
+ * @param out the stream fading out, the result is written back here
+ * @param in the stream fading in
+ */
+void
+xmms_crossfade_mix (xmms_sample_format_t format, gint channels,
+                    xmms_crossfade_curve_t curve, gpointer out,
+                    gconstpointer in, guint frames, guint pos, guint len)
+{
+	xmms_crossfade_mix_func_t mix;
+	gfloat gout[GAIN_BLOCK], gin[GAIN_BLOCK];
+	guint block, n;
+	gint size;
+
+	mix = mix_func_get (format);
+
+	g_return_if_fail (mix);
+	g_return_if_fail (channels > 0 && channels <= GAIN_BLOCK);
+	g_return_if_fail (len > 0);
+
+	size = xmms_sample_size_get (format) * channels;
+	block = GAIN_BLOCK / channels;
+
+	while (frames > 0) {
+		n = MIN (frames, block);
+
+		gains_fill (curve, channels, n, pos, len, gout, gin);
+		mix (out, in, gout, gin, n * channels);
+
+		out = (gchar *) out + n * size;
+		in = (const gchar *) in + n * size;
+		frames -= n;
+		pos += n;
+	}
+}
@@ -329,10 +329,18 @@ xmms_ipc_client_write_cb (GIOChannel *iochan,
 	g_return_val_if_fail (client, FALSE);
 
 	while (TRUE) {
-		xmms_ipc_msg_t *msg;
+		xmms_ipc_msg_t *msg, *next;
 
 		g_mutex_lock (&client->lock);
 		msg = g_queue_peek_head (client->out_msg);
+		if (msg) {
+			/* Replies to pipelined commands go out in one write */
+			while ((next = g_queue_peek_nth (client->out_msg, 1)) &&
+			       xmms_ipc_msg_append (msg, next)) {
+				g_queue_pop_nth (client->out_msg, 1);
+				xmms_ipc_msg_destroy (next);
+			}
+		}
 		g_mutex_unlock (&client->lock);
 
 		if (!msg)
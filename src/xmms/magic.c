@@ -25,6 +25,12 @@
 
 static GList *magic_list, *ext_list;
 
+/* magic_list compiled for matching, see xmms_magic_compile */
+static GPtrArray *magic_trees;
+static GArray *magic_dispatch[256];
+static GArray *magic_generic;
+static guint magic_needed;
+
 #define SWAP16(v, endian) \
 	if (endian == G_LITTLE_ENDIAN) { \
 		v = GUINT16_TO_LE (v); \
@@ -343,6 +349,128 @@ xmms_magic_add_node (GNode *tree, const gchar *s, GNode *prev_node)
 	}
 }
 
+/**
+ * Get the bytes a magic entry requires at the start of the stream.
+ * @return The number of alternatives stored in bytes, or 0 if the
+ * entry doesn't pin down the first byte.
+ */
+static gint
+xmms_magic_entry_first_bytes (const xmms_magic_entry_t *entry, guint8 *bytes)
+{
+	if (entry->offset != 0 || entry->len == 0) {
+		return 0;
+	}
+
+	switch (entry->type) {
+		case XMMS_MAGIC_ENTRY_TYPE_STRING:
+			bytes[0] = entry->value.s[0];
+			return 1;
+		case XMMS_MAGIC_ENTRY_TYPE_STRINGC:
+			bytes[0] = g_ascii_tolower (entry->value.s[0]);
+			bytes[1] = g_ascii_toupper (entry->value.s[0]);
+			return bytes[0] == bytes[1] ? 1 : 2;
+		default:
+			break;
+	}
+
+	if (entry->oper != XMMS_MAGIC_ENTRY_OPERATOR_EQUAL ||
+	    entry->pre_test_and_op) {
+		return 0;
+	}
+
+	switch (entry->type) {
+		case XMMS_MAGIC_ENTRY_TYPE_BYTE:
+			bytes[0] = entry->value.i8;
+			return 1;
+		case XMMS_MAGIC_ENTRY_TYPE_INT16:
+			bytes[0] = entry->endian == G_BIG_ENDIAN
+			         ? entry->value.i16 >> 8 : entry->value.i16 & 0xff;
+			return 1;
+		case XMMS_MAGIC_ENTRY_TYPE_INT32:
+			bytes[0] = entry->endian == G_BIG_ENDIAN
+			         ? entry->value.i32 >> 24 : entry->value.i32 & 0xff;
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+static gboolean
+xmms_magic_node_needed (GNode *node, guint *needed)
+{
+	xmms_magic_entry_t *entry = node->data;
+
+	if (!G_NODE_IS_ROOT (node)) {
+		*needed = MAX (*needed, entry->offset + entry->len);
+	}
+
+	return FALSE; /* continue traversal */
+}
+
+/**
+ * Rebuild the matching tables from magic_list.
+ *
+ * Most formats are recognized by a fixed first byte, so every set is
+ * filed under the first bytes its top level entries accept, and only
+ * those sets plus the ones that can't be keyed have to be tried.
+ * Indices into magic_trees keep the order of magic_list, so the
+ * result is the same as walking the whole list.
+ */
+static void
+xmms_magic_compile (void)
+{
+	const GList *l;
+	guint i, b;
+
+	if (magic_trees) {
+		g_ptr_array_free (magic_trees, TRUE);
+		g_array_free (magic_generic, TRUE);
+		for (b = 0; b < G_N_ELEMENTS (magic_dispatch); b++) {
+			g_array_free (magic_dispatch[b], TRUE);
+		}
+	}
+
+	magic_trees = g_ptr_array_new ();
+	magic_generic = g_array_new (FALSE, FALSE, sizeof (guint));
+	for (b = 0; b < G_N_ELEMENTS (magic_dispatch); b++) {
+		magic_dispatch[b] = g_array_new (FALSE, FALSE, sizeof (guint));
+	}
+	magic_needed = 0;
+
+	for (l = magic_list, i = 0; l; l = g_list_next (l), i++) {
+		GNode *tree = l->data, *n;
+		gboolean accepted[256] = { FALSE };
+		gboolean keyed = !!tree->children;
+		guint8 bytes[2];
+		gint count;
+
+		g_ptr_array_add (magic_trees, tree);
+
+		g_node_traverse (tree, G_PRE_ORDER, G_TRAVERSE_ALL, -1,
+		                 (GNodeTraverseFunc) xmms_magic_node_needed,
+		                 &magic_needed);
+
+		for (n = tree->children; n && keyed; n = n->next) {
+			count = xmms_magic_entry_first_bytes (n->data, bytes);
+			keyed = count > 0;
+			while (count--) {
+				accepted[bytes[count]] = TRUE;
+			}
+		}
+
+		if (!keyed) {
+			g_array_append_val (magic_generic, i);
+			continue;
+		}
+
+		for (b = 0; b < G_N_ELEMENTS (accepted); b++) {
+			if (accepted[b]) {
+				g_array_append_val (magic_dispatch[b], i);
+			}
+		}
+	}
+}
+
 static gint
 read_data (xmms_magic_checker_t *c, guint needed)
 {
@@ -366,23 +494,13 @@ node_match (xmms_magic_checker_t *c, GNode *node)
 	guint8 i8;
 	guint16 i16;
 	guint32 i32;
-	gint tmp;
 	gchar *ptr;
 
-	/* do we have enough data ready for this check?
-	 * if not, read some more
+	/* everything any entry can need was peeked up front, so
+	 * missing data means the stream is too short
 	 */
 	if (c->read < needed) {
-		tmp = read_data (c, needed);
-		if (tmp == -1) {
-			return FALSE;
-		}
-
-		c->read = tmp;
-		if (c->read < needed) {
-			/* couldn't read enough data */
-			return FALSE;
-		}
+		return FALSE;
 	}
 
 	ptr = &c->buf[c->offset + entry->offset];
@@ -427,25 +545,68 @@ tree_match (xmms_magic_checker_t *c, GNode *tree)
 	return FALSE;
 }
 
+/**
+ * Find the first magic set matching the data in c, trying the sets
+ * filed under its first byte and the unkeyed ones in list order.
+ */
+static GNode *
+xmms_magic_match_trees (xmms_magic_checker_t *c)
+{
+	GArray *keyed = NULL;
+	guint i = 0, j = 0, idx;
+
+	if (!magic_trees) {
+		return NULL;
+	}
+
+	if (c->read > 0) {
+		keyed = magic_dispatch[(guint8) c->buf[c->offset]];
+	}
+
+	for (;;) {
+		gboolean have_keyed = keyed && i < keyed->len;
+		gboolean have_generic = j < magic_generic->len;
+
+		if (have_keyed && (!have_generic ||
+		                   g_array_index (keyed, guint, i) <
+		                   g_array_index (magic_generic, guint, j))) {
+			idx = g_array_index (keyed, guint, i++);
+		} else if (have_generic) {
+			idx = g_array_index (magic_generic, guint, j++);
+		} else {
+			return NULL;
+		}
+
+		if (tree_match (c, g_ptr_array_index (magic_trees, idx))) {
+			return g_ptr_array_index (magic_trees, idx);
+		}
+	}
+}
+
 static gchar *
 xmms_magic_match (xmms_magic_checker_t *c, const gchar *uri)
 {
 	const GList *l;
+	GNode *tree;
 	gchar *u, *dump;
+	gint tmp;
 	int i;
 
 	g_return_val_if_fail (c, NULL);
 
+	/* peek everything the rules can look at in one go */
+	if (c->xform && c->offset + magic_needed > c->read) {
+		tmp = read_data (c, c->offset + magic_needed);
+		c->read = MAX (tmp, 0);
+	}
+
 	/* only one of the contained sets has to match */
-	for (l = magic_list; l; l = g_list_next (l)) {
-		GNode *tree = l->data;
-
-		if (tree_match (c, tree)) {
-			gpointer *data = tree->data;
-			XMMS_DBG ("magic plugin detected '%s' (%s)",
-			          (char *)data[1], (char *)data[0]);
-			return (char *) (data[1]);
-		}
+	tree = xmms_magic_match_trees (c);
+	if (tree) {
+		gpointer *data = tree->data;
+		XMMS_DBG ("magic plugin detected '%s' (%s)",
+		          (char *)data[1], (char *)data[0]);
+		return (char *) (data[1]);
 	}
 
 	if (!uri)
@@ -479,6 +640,23 @@ xmms_magic_match (xmms_magic_checker_t *c, const gchar *uri)
 	return NULL;
 }
 
+/**
+ * @internal Identify a stream from data peeked from its start, and
+ * its URL if the data doesn't match.
+ * @return The mimetype, or NULL if nothing matched.
+ */
+const gchar *
+xmms_magic_identify (const gchar *buf, guint len, const gchar *url)
+{
+	xmms_magic_checker_t c;
+
+	memset (&c, 0, sizeof (c));
+	c.buf = (gchar *) buf;
+	c.alloc = c.read = len;
+
+	return xmms_magic_match (&c, url);
+}
+
 static guint
 xmms_magic_complexity (GNode *tree)
 {
@@ -503,13 +681,63 @@ cb_sort_magic_list (GNode *a, GNode *b)
 }
 
 
-gboolean
-xmms_magic_extension_add (const gchar *mime, const gchar *ext)
+/* registrations recorded for the plugin manifest, see
+ * xmms_magic_capture_begin */
+static GPtrArray *capture;
+static gboolean capture_discard;
+
+/**
+ * @internal Start recording magic registrations, so they can be
+ * replayed with #xmms_magic_replay without loading the plugin that
+ * made them. If discard is set, the registrations are only recorded
+ * because they have been replayed before.
+ */
+void
+xmms_magic_capture_begin (gboolean discard)
 {
-	xmms_magic_ext_data_t *e;
+	g_return_if_fail (!capture);
 
-	g_return_val_if_fail (mime, FALSE);
-	g_return_val_if_fail (ext, FALSE);
+	capture = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+	capture_discard = discard;
+}
+
+/**
+ * @internal Stop recording magic registrations.
+ * @return An array of string vectors, one per registration.
+ */
+GPtrArray *
+xmms_magic_capture_end (void)
+{
+	GPtrArray *ret = capture;
+
+	capture = NULL;
+	capture_discard = FALSE;
+
+	return ret;
+}
+
+static void
+xmms_magic_capture (const gchar *kind, const gchar *first, const gchar *second,
+                    gchar **rest)
+{
+	GPtrArray *entry;
+
+	entry = g_ptr_array_new ();
+	g_ptr_array_add (entry, g_strdup (kind));
+	g_ptr_array_add (entry, g_strdup (first));
+	g_ptr_array_add (entry, g_strdup (second));
+	for (; rest && *rest; rest++) {
+		g_ptr_array_add (entry, g_strdup (*rest));
+	}
+	g_ptr_array_add (entry, NULL);
+
+	g_ptr_array_add (capture, g_ptr_array_free (entry, FALSE));
+}
+
+static gboolean
+xmms_magic_extension_register (const gchar *mime, const gchar *ext)
+{
+	xmms_magic_ext_data_t *e;
 
 	e = g_new0 (xmms_magic_ext_data_t, 1);
 	e->pattern = g_strdup (ext);
@@ -521,23 +749,29 @@ xmms_magic_extension_add (const gchar *mime, const gchar *ext)
 }
 
 gboolean
-xmms_magic_add (const gchar *desc, const gchar *mime, ...)
+xmms_magic_extension_add (const gchar *mime, const gchar *ext)
+{
+	g_return_val_if_fail (mime, FALSE);
+	g_return_val_if_fail (ext, FALSE);
+
+	if (capture) {
+		xmms_magic_capture ("extension", mime, ext, NULL);
+		if (capture_discard) {
+			return TRUE;
+		}
+	}
+
+	return xmms_magic_extension_register (mime, ext);
+}
+
+static gboolean
+xmms_magic_register (const gchar *desc, const gchar *mime, gchar **specs)
 {
 	GNode *tree, *node = NULL;
-	va_list ap;
-	gchar *s;
 	gpointer *root_props;
 	gboolean ret = TRUE;
 
-	g_return_val_if_fail (desc, FALSE);
-	g_return_val_if_fail (mime, FALSE);
-
-	/* now process the magic specs in the argument list */
-	va_start (ap, mime);
-
-	s = va_arg (ap, gchar *);
-	if (!s) { /* no magic specs passed -> failure */
-		va_end (ap);
+	if (!*specs) { /* no magic specs passed -> failure */
 		return FALSE;
 	}
 
@@ -547,33 +781,28 @@ xmms_magic_add (const gchar *desc, const gchar *mime, ...)
 	root_props[1] = g_strdup (mime);
 	tree = g_node_new (root_props);
 
-	do {
-		if (!*s) {
+	for (; *specs; specs++) {
+		if (!**specs) {
 			ret = FALSE;
-			xmms_log_error ("invalid magic spec: '%s'", s);
+			xmms_log_error ("invalid magic spec: '%s'", *specs);
 			break;
 		}
 
-		s = g_strdup (s); /* we need our own copy */
-		node = xmms_magic_add_node (tree, s, node);
+		node = xmms_magic_add_node (tree, *specs, node);
 
 		if (!node) {
-			xmms_log_error ("invalid magic spec: '%s'", s);
+			xmms_log_error ("invalid magic spec: '%s'", *specs);
 			ret = FALSE;
-
-			g_free (s);
 			break;
 		}
-		g_free (s);
-	} while ((s = va_arg (ap, gchar *)));
-
-	va_end (ap);
+	}
 
 	/* only add this tree to the list if all spec chunks are valid */
 	if (ret) {
 		magic_list =
 			g_list_insert_sorted (magic_list, tree,
 			                      (GCompareFunc) cb_sort_magic_list);
+		xmms_magic_compile ();
 	} else {
 		xmms_magic_tree_free (tree);
 	}
@@ -581,6 +810,62 @@ xmms_magic_add (const gchar *desc, const gchar *mime, ...)
 	return ret;
 }
 
+gboolean
+xmms_magic_add (const gchar *desc, const gchar *mime, ...)
+{
+	GPtrArray *specs;
+	va_list ap;
+	gchar *s;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail (desc, FALSE);
+	g_return_val_if_fail (mime, FALSE);
+
+	/* now process the magic specs in the argument list */
+	specs = g_ptr_array_new ();
+
+	va_start (ap, mime);
+	while ((s = va_arg (ap, gchar *))) {
+		g_ptr_array_add (specs, s);
+	}
+	va_end (ap);
+
+	g_ptr_array_add (specs, NULL);
+
+	if (capture) {
+		xmms_magic_capture ("magic", desc, mime, (gchar **) specs->pdata);
+	}
+
+	if (!capture || !capture_discard) {
+		ret = xmms_magic_register (desc, mime, (gchar **) specs->pdata);
+	}
+
+	g_ptr_array_free (specs, TRUE);
+
+	return ret;
+}
+
+/**
+ * @internal Register magic recorded by #xmms_magic_capture_begin.
+ */
+gboolean
+xmms_magic_replay (gchar **entry)
+{
+	g_return_val_if_fail (entry, FALSE);
+
+	if (g_strv_length (entry) < 3) {
+		return FALSE;
+	}
+
+	if (strcmp (entry[0], "extension") == 0) {
+		return xmms_magic_extension_register (entry[1], entry[2]);
+	} else if (strcmp (entry[0], "magic") == 0) {
+		return xmms_magic_register (entry[1], entry[2], entry + 3);
+	}
+
+	return FALSE;
+}
+
 static gboolean
 xmms_magic_plugin_init (xmms_xform_t *xform)
 {
@@ -45,6 +45,7 @@
 #include <xmmspriv/xmms_ipc.h>
 #include <xmmspriv/xmms_log.h>
 #include <xmmspriv/xmms_xform_object.h>
+#include <xmmspriv/xmms_xform.h>
 #include <xmmspriv/xmms_bindata.h>
 #include <xmmspriv/xmms_utils.h>
 #include <xmmspriv/xmms_visualization.h>
@@ -217,17 +218,22 @@ xmms_main_client_stats (xmms_object_t *object, xmms_error_t *error)
 	xmms_main_t *mainobj = (xmms_main_t *) object;
 	gint uptime = time (NULL) - mainobj->starttime;
 	int64_t size, duration, playtime;
+	gint64 plan_hits, plan_misses;
 
 	size = duration = playtime = 0;
 
 	query_total_playtime (mainobj, error, &playtime);
 	query_total_size_duration (mainobj, error, &size, &duration);
 
+	xmms_xform_plan_cache_stats (&plan_hits, &plan_misses);
+
 	return xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("version", XMMS_VERSION),
 	                         XMMSV_DICT_ENTRY_INT ("uptime", uptime),
 	                         XMMSV_DICT_ENTRY_INT ("size", size),
 	                         XMMSV_DICT_ENTRY_INT ("duration", duration),
 	                         XMMSV_DICT_ENTRY_INT ("playtime", playtime),
+	                         XMMSV_DICT_ENTRY_INT ("chain_plan_hits", plan_hits),
+	                         XMMSV_DICT_ENTRY_INT ("chain_plan_misses", plan_misses),
 	                         XMMSV_DICT_END);
 }
 
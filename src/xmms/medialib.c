@@ -17,6 +17,7 @@
 #include <xmms_configuration.h>
 #include <xmmspriv/xmms_medialib.h>
 #include <xmmspriv/xmms_xform.h>
+#include <xmmspriv/xmms_bindata.h>
 #include <xmmspriv/xmms_utils.h>
 #include <xmms/xmms_error.h>
 #include <xmms/xmms_config.h>
@@ -566,6 +567,25 @@ xmms_medialib_client_remove_entry (xmms_medialib_t *medialib,
 	} while (!xmms_medialib_session_commit (session));
 }
 
+/**
+ * Drop data stored outside the database along with a property.
+ *
+ * The seek index blob is only referenced by the entry it was built
+ * for, so it goes away with the property.
+ */
+static void
+xmms_medialib_property_unset_data (const gchar *key, const s4_val_t *value)
+{
+	const gchar *hash;
+
+	if (strcmp (key, XMMS_MEDIALIB_ENTRY_PROPERTY_SEEKINDEX) != 0)
+		return;
+
+	if (s4_val_get_str (value, &hash)) {
+		xmms_bindata_remove (hash);
+	}
+}
+
 /**
  * Remove a medialib entry from the database
  *
@@ -589,6 +609,8 @@ xmms_medialib_entry_remove (xmms_medialib_session_t *session,
 
 		res = s4_resultset_get_result (set, i, 0);
 		while (res != NULL) {
+			xmms_medialib_property_unset_data (s4_result_get_key (res),
+			                                   s4_result_get_val (res));
 			xmms_medialib_session_property_unset (session, entry,
 			                                      s4_result_get_key (res),
 			                                      s4_result_get_val (res),
@@ -659,6 +681,7 @@ xmms_medialib_entry_cleanup (xmms_medialib_session_t *session,
 
 			if (entry_attribute_is_derived (src, key)) {
 				const s4_val_t *value = s4_result_get_val (res);
+				xmms_medialib_property_unset_data (key, value);
 				xmms_medialib_session_property_unset (session, entry, key,
 				                                      value, src);
 			}
@@ -1130,6 +1153,7 @@ xmms_medialib_property_remove (xmms_medialib_session_t *session,
 
 	res = s4_resultset_get_result (set, 0, 0);
 	if (res != NULL) {
+		xmms_medialib_property_unset_data (key, s4_result_get_val (res));
 		xmms_medialib_session_property_unset (session, entry, key,
 		                                      s4_result_get_val (res),
 		                                      source);
@@ -28,7 +28,11 @@
 #include <xmmspriv/xmms_xform.h>
 #include <xmmspriv/xmms_medialib.h>
 #include <xmmspriv/xmms_outputplugin.h>
+#include <xmmspriv/xmms_converter.h>
+#include <xmmspriv/xmms_crossfade.h>
+#include <xmmspriv/xmms_softvol.h>
 #include <xmmspriv/xmms_thread_name.h>
+#include <xmmspriv/xmms_realtime.h>
 #include <xmms/xmms_sample.h>
 #include <xmms/xmms_log.h>
 #include <xmms/xmms_ipc.h>
@@ -37,6 +41,14 @@
 
 #define VOLUME_MAX_CHANNELS 128
 
+/* the volume channel of outputs without a mixer, and how long a
+ * change of it is ramped over */
+#define SOFTVOL_CHANNEL "master"
+#define SOFTVOL_RAMP_MS 10
+
+/* nice levels the notifier thread is lowered by */
+#define NOTIFIER_NICE 5
+
 typedef struct xmms_volume_map_St {
 	const gchar **names;
 	guint *values;
@@ -46,6 +58,7 @@ typedef struct xmms_volume_map_St {
 
 static gboolean xmms_output_format_set (xmms_output_t *output, xmms_stream_type_t *fmt);
 static gpointer xmms_output_monitor_volume_thread (gpointer data);
+static gpointer xmms_output_notifier_thread (gpointer data);
 
 static void xmms_playback_client_start (xmms_output_t *output, xmms_error_t *err);
 static void xmms_playback_client_stop (xmms_output_t *output, xmms_error_t *err);
@@ -67,8 +80,17 @@ typedef enum xmms_output_filler_state_E {
 
 static void xmms_playback_client_volume_set (xmms_output_t *output, const gchar *channel, gint32 volume, xmms_error_t *error);
 static xmmsv_t *xmms_playback_client_volume_get (xmms_output_t *output, xmms_error_t *error);
+static xmmsv_t *xmms_playback_client_chain_stats (xmms_output_t *output, xmms_error_t *error);
+static xmmsv_t *xmms_playback_client_underruns (xmms_output_t *output, xmms_error_t *error);
+static xmmsv_t *xmms_playback_client_buffer_stats (xmms_output_t *output, xmms_error_t *error);
+static xmmsv_t *xmms_playback_client_zone_list (xmms_output_t *output, xmms_error_t *error);
+static void xmms_playback_client_zone_start (xmms_output_t *output, const gchar *zone, xmms_error_t *error);
+static void xmms_playback_client_zone_stop (xmms_output_t *output, const gchar *zone, xmms_error_t *error);
+static xmmsv_t *xmms_playback_client_sink_list (xmms_output_t *output, xmms_error_t *error);
 static void xmms_output_filler_state (xmms_output_t *output, xmms_output_filler_state_t state);
 static void xmms_output_filler_state_nolock (xmms_output_t *output, xmms_output_filler_state_t state);
+static void xmms_output_buffer_adapt_reset (xmms_output_t *output);
+static void xmms_output_buffer_adapt (xmms_output_t *output);
 
 static void xmms_volume_map_init (xmms_volume_map_t *vl);
 static void xmms_volume_map_free (xmms_volume_map_t *vl);
@@ -76,6 +98,15 @@ static void xmms_volume_map_copy (xmms_volume_map_t *src, xmms_volume_map_t *dst
 static xmmsv_t *xmms_volume_map_to_dict (xmms_volume_map_t *vl);
 static gboolean xmms_output_status_set (xmms_output_t *output, gint status);
 static gboolean set_plugin (xmms_output_t *output, xmms_output_plugin_t *plugin);
+static void xmms_output_zones_init (xmms_output_t *output);
+static void on_zone_changed (xmms_object_t *object, xmmsv_t *_data, gpointer udata);
+static void xmms_output_sinks_init (xmms_output_t *output);
+static void xmms_output_sinks_chain_set (xmms_output_t *output, xmms_xform_t *chain, gboolean flush);
+static void xmms_output_sinks_write (xmms_output_t *output, gchar *buf, gint len);
+static void xmms_output_sinks_seek (xmms_output_t *output);
+static void xmms_output_sinks_clear (xmms_output_t *output);
+static void xmms_output_sinks_status_set (xmms_output_t *output, gint status);
+static void xmms_output_sink_format_clear (xmms_output_t *sink);
 
 static void xmms_output_format_list_free_elem (gpointer data, gpointer user_data);
 static void xmms_output_format_list_clear (xmms_output_t *output);
@@ -97,10 +128,23 @@ xmms_medialib_entry_t xmms_output_current_id (xmms_output_t *output);
 /*
  *
  * locking order: status_mutex > write_mutex
- *                filler_mutex
+ *                filler_mutex > filler_mutex of a sink
  *                playtime_mutex is leaflock.
+ *                notifier_mutex is leaflock.
+ *                zones_mutex is leaflock.
+ *                sinks_mutex is leaflock.
  */
 
+/* number of underrun timestamps remembered */
+#define UNDERRUN_HISTORY 32
+
+/* how often the adaptive buffer sizing looks at the telemetry, in us */
+#define ADAPT_PERIOD G_USEC_PER_SEC
+/* healthy periods in a row before the buffer is shrunk */
+#define ADAPT_SHRINK_PERIODS 30
+/* never shrink the buffer below this many bytes */
+#define ADAPT_MIN_SIZE 16384
+
 struct xmms_output_St {
 	xmms_object_t object;
 
@@ -110,10 +154,21 @@ struct xmms_output_St {
 	/* */
 	GMutex playtime_mutex;
 	guint played;
-	guint played_time;
+	gint played_time; /* atomic */
 	xmms_medialib_entry_t current_entry;
 	guint toskip;
 
+	/* The output thread only publishes the position and song changes,
+	 * the notifier broadcasts them so that slow clients can't stall it */
+	GThread *notifier_thread;
+	GMutex notifier_mutex;
+	GCond notifier_cond;
+	gboolean notifier_running;
+	gint notify_interval; /* atomic, ms */
+	/** Entries changed to and not yet broadcast, protected by
+	    notifier_mutex */
+	GQueue notify_entries;
+
 	/* */
 	GThread *filler_thread;
 	GMutex filler_mutex;
@@ -125,6 +180,41 @@ struct xmms_output_St {
 	guint32 filler_seek;
 	gint filler_skip;
 
+	/** When the pending seek was asked for, and how many seeks were
+	    done in the buffer without touching the chain */
+	gint64 seek_requested;
+	gint seeks_buffered;
+
+	/** The chain being read, and how long the filler waited for
+	    room in the buffer, only counted while profiling */
+	xmms_xform_t *filler_chain;
+	gint64 filler_wait_time;
+	gint64 filler_waits;
+
+	/** Adaptive buffer sizing, protected by filler_mutex. The fill
+	    level is only sampled once the filler has topped up the buffer */
+	gint adapt_enabled; /* atomic */
+	gboolean adapt_primed;
+	guint adapt_fill_min;
+	gint64 adapt_read_max;
+	gint64 adapt_last;
+	gint adapt_underruns;
+	gint adapt_healthy;
+	gint adapt_grows;
+	gint adapt_shrinks;
+
+	/** Length of the crossfade between songs in ms, 0 for none */
+	gint crossfade_ms; /* atomic */
+
+	/** With output.float_pipeline, the converter from the chain's
+	    float samples to the format the plugin plays, NULL while the
+	    plugin takes the chain's format. conversions counts the sample
+	    conversions of the current chain. Protected by filler_mutex. */
+	xmms_sample_converter_t *pipeline_conv;
+	xmms_stream_type_t *pipeline_from;
+	xmms_stream_type_t *pipeline_to;
+	gint conversions;
+
 	/** Internal status, tells which state the
 	    output really is in */
 	GMutex status_mutex;
@@ -133,8 +223,43 @@ struct xmms_output_St {
 	xmms_playlist_t *playlist;
 	xmms_medialib_t *medialib;
 
+	/** The playlist this output plays, the active one for the main
+	    output and none for a sink. Zones and sinks are named, the
+	    main output has no name. Their config values go below
+	    config_prefix. */
+	gchar *playlist_name;
+	gchar *name;
+	gchar *config_prefix;
+
+	/** Sinks fed from the chain of this output. Changed with both
+	    filler_mutex and sinks_mutex held, so either one protects
+	    reading it. */
+	GMutex sinks_mutex;
+	GList *sinks;
+
+	/** For a sink, the format it is fed in and the converter to it,
+	    NULL when the chain's format is used as is. Protected by
+	    the filler_mutex of the feeding output. The generation counts
+	    chains, a sink that can't set the format sits out the rest of
+	    the chain. */
+	xmms_stream_type_t *sink_from;
+	xmms_stream_type_t *sink_to;
+	xmms_sample_converter_t *sink_conv;
+	gint sink_gen;
+	gint sink_failed_gen; /* atomic */
+	/** Bytes that didn't fit into the buffer, protected by filler_mutex */
+	gint64 sink_dropped;
+
+	/** Zones of the main output by name, and the names whose config
+	    values are watched already. Protected by zones_mutex. */
+	GMutex zones_mutex;
+	GHashTable *zones;
+	GHashTable *zones_watched;
+
 	/** Supported formats */
 	GList *format_list;
+	/** The supported formats with float samples, for the float pipeline */
+	GList *float_format_list;
 	/** Active format */
 	xmms_stream_type_t *format;
 
@@ -145,12 +270,30 @@ struct xmms_output_St {
 	guint64 bytes_written;
 
 	/**
-	 * How many times didn't we have enough data in the buffer?
+	 * How many times didn't we have enough data in the buffer,
+	 * and when the last ones happened. Protected by playtime_mutex.
 	 */
 	gint32 buffer_underruns;
+	gint64 underrun_times[UNDERRUN_HISTORY];
+
+	/**
+	 * Number of seeks, and how long it took until the first sample
+	 * after one was handed to the plugin, in us. Protected by
+	 * playtime_mutex.
+	 */
+	gint seeks;
+	gint64 seek_latency_last;
+	gint64 seek_latency_max;
 
 	GThread *monitor_volume_thread;
 	gboolean monitor_volume_running;
+
+	/** Volume in percent when the plugin has no mixer and the volume
+	    is done in software, -1 otherwise. softvol and the volume it
+	    was last set to are only used by the thread reading the buffer. */
+	gint softvol_volume; /* atomic */
+	gint softvol_applied;
+	xmms_softvol_t softvol;
 };
 
 /** @} */
@@ -207,6 +350,13 @@ xmms_output_format_list_free_elem (gpointer data, gpointer user_data)
 static void
 xmms_output_format_list_clear(xmms_output_t *output)
 {
+	g_list_foreach (output->float_format_list,
+	                xmms_output_format_list_free_elem,
+	                NULL);
+
+	g_list_free (output->float_format_list);
+	output->float_format_list = NULL;
+
 	if (output->format_list == NULL)
 		return;
 
@@ -218,37 +368,82 @@ xmms_output_format_list_clear(xmms_output_t *output)
 	output->format_list = NULL;
 }
 
+/**
+ * The formats the chain is set up for in the float pipeline, those of
+ * the plugin with float samples. Decoders and effects then work on
+ * float, and the samples are converted once, right before the buffer.
+ */
+static GList *
+xmms_output_float_format_list (xmms_output_t *output)
+{
+	xmms_stream_type_t *f;
+	GList *n, *m;
+	gint channels, rate;
+
+	if (output->float_format_list) {
+		return output->float_format_list;
+	}
+
+	for (n = output->format_list; n; n = g_list_next (n)) {
+		channels = xmms_stream_type_get_int (n->data, XMMS_STREAM_TYPE_FMT_CHANNELS);
+		rate = xmms_stream_type_get_int (n->data, XMMS_STREAM_TYPE_FMT_SAMPLERATE);
+
+		if (channels == -1 || rate == -1) {
+			f = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+			                           XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+			                           XMMS_STREAM_TYPE_FMT_FORMAT, XMMS_SAMPLE_FORMAT_FLOAT,
+			                           XMMS_STREAM_TYPE_END);
+		} else {
+			f = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+			                           XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+			                           XMMS_STREAM_TYPE_FMT_FORMAT, XMMS_SAMPLE_FORMAT_FLOAT,
+			                           XMMS_STREAM_TYPE_FMT_CHANNELS, channels,
+			                           XMMS_STREAM_TYPE_FMT_SAMPLERATE, rate,
+			                           XMMS_STREAM_TYPE_END);
+		}
+
+		/* plugins list the same layout once per sample format */
+		for (m = output->float_format_list; m; m = g_list_next (m)) {
+			if (xmms_stream_type_match (m->data, f) &&
+			    xmms_stream_type_match (f, m->data)) {
+				break;
+			}
+		}
+
+		if (m) {
+			xmms_object_unref (f);
+		} else {
+			output->float_format_list = g_list_append (output->float_format_list, f);
+		}
+	}
+
+	return output->float_format_list;
+}
+
 static void
 update_playtime (xmms_output_t *output, int advance)
 {
 	guint buffersize = 0;
+	guint played;
 
 	g_mutex_lock (&output->playtime_mutex);
 	output->played += advance;
+	played = output->played;
 	g_mutex_unlock (&output->playtime_mutex);
 
 	buffersize = xmms_output_plugin_method_latency_get (output->plugin, output);
 
-	if (output->played < buffersize) {
-		buffersize = output->played;
+	if (played < buffersize) {
+		buffersize = played;
 	}
 
-	g_mutex_lock (&output->playtime_mutex);
-
 	if (output->format) {
 		guint ms = xmms_sample_bytes_to_ms (output->format,
-		                                    output->played - buffersize);
-		if ((ms / 100) != (output->played_time / 100)) {
-			xmms_object_emit (XMMS_OBJECT (output),
-			                  XMMS_IPC_SIGNAL_PLAYBACK_PLAYTIME,
-			                  xmmsv_new_int (ms));
-		}
-		output->played_time = ms;
+		                                    played - buffersize);
 
+		/* broadcast by the notifier thread */
+		g_atomic_int_set (&output->played_time, ms);
 	}
-
-	g_mutex_unlock (&output->playtime_mutex);
-
 }
 
 void
@@ -268,6 +463,7 @@ xmms_output_set_error (xmms_output_t *output, xmms_error_t *error)
 typedef struct {
 	xmms_output_t *output;
 	xmms_xform_t *chain;
+	xmms_stream_type_t *type;
 	gboolean flush;
 } xmms_output_song_changed_arg_t;
 
@@ -276,6 +472,7 @@ song_changed_arg_free (void *data)
 {
 	xmms_output_song_changed_arg_t *arg = (xmms_output_song_changed_arg_t *)data;
 	xmms_object_unref (arg->chain);
+	xmms_object_unref (arg->type);
 	g_free (arg);
 }
 
@@ -294,7 +491,7 @@ song_changed (void *data)
 	arg->output->played = 0;
 	arg->output->current_entry = entry;
 
-	type = xmms_xform_outtype_get (arg->chain);
+	type = arg->type;
 
 	if (!xmms_output_format_set (arg->output, type)) {
 		gint fmt, rate, chn;
@@ -314,9 +511,15 @@ song_changed (void *data)
 	if (arg->flush)
 		xmms_output_flush (arg->output);
 
-	xmms_object_emit (XMMS_OBJECT (arg->output),
-	                  XMMS_IPC_SIGNAL_PLAYBACK_CURRENT_ID,
-	                  xmmsv_new_int (entry));
+	/* broadcast by the notifier thread, which is woken up right away.
+	 * Only the main output has one, zones and sinks report their
+	 * current id through their stats. */
+	if (arg->output->notifier_thread) {
+		g_mutex_lock (&arg->output->notifier_mutex);
+		g_queue_push_tail (&arg->output->notify_entries, GINT_TO_POINTER (entry));
+		g_cond_signal (&arg->output->notifier_cond);
+		g_mutex_unlock (&arg->output->notifier_mutex);
+	}
 
 	return TRUE;
 }
@@ -324,17 +527,131 @@ song_changed (void *data)
 static gboolean
 seek_done (void *data)
 {
+	/* executes in the output thread, with filler_mutex held */
 	xmms_output_t *output = (xmms_output_t *)data;
+	gint64 latency;
 
 	g_mutex_lock (&output->playtime_mutex);
 	output->played = output->filler_seek * xmms_sample_frame_size_get (output->format);
-	output->toskip = output->filler_skip * xmms_sample_frame_size_get (output->format);
 	g_mutex_unlock (&output->playtime_mutex);
 
 	xmms_output_flush (output);
+
+	/* the first sample after the seek is read right after this */
+	if (output->seek_requested) {
+		latency = g_get_monotonic_time () - output->seek_requested;
+		output->seek_requested = 0;
+
+		g_mutex_lock (&output->playtime_mutex);
+		output->seeks++;
+		output->seek_latency_last = latency;
+		output->seek_latency_max = MAX (output->seek_latency_max, latency);
+		g_mutex_unlock (&output->playtime_mutex);
+	}
+
 	return TRUE;
 }
 
+/**
+ * Start a new telemetry window for the adaptive buffer sizing,
+ * called with filler_mutex held whenever the buffer was emptied.
+ */
+static void
+xmms_output_buffer_adapt_reset (xmms_output_t *output)
+{
+	output->adapt_primed = FALSE;
+	output->adapt_fill_min = G_MAXUINT;
+	output->adapt_read_max = 0;
+	output->adapt_last = g_get_monotonic_time ();
+	output->adapt_healthy = 0;
+
+	g_mutex_lock (&output->playtime_mutex);
+	output->adapt_underruns = output->buffer_underruns;
+	g_mutex_unlock (&output->playtime_mutex);
+}
+
+/**
+ * Grow the buffer when the output ran dry, came close to it or the
+ * chain is too slow for the current size, and shrink it again after
+ * a long stable period. Called by the filler with filler_mutex held.
+ */
+static void
+xmms_output_buffer_adapt (xmms_output_t *output)
+{
+	xmms_config_property_t *prop;
+	const gchar *reason = NULL;
+	gint64 now, size_ms, read_ms, min_size, max_size;
+	guint size, target;
+	gint underruns, frame_size;
+
+	now = g_get_monotonic_time ();
+	if (now - output->adapt_last < ADAPT_PERIOD || !output->format) {
+		return;
+	}
+
+	g_mutex_lock (&output->playtime_mutex);
+	underruns = output->buffer_underruns;
+	g_mutex_unlock (&output->playtime_mutex);
+
+	size = xmms_ringbuf_size (output->filler_buffer);
+	size_ms = xmms_sample_bytes_to_ms (output->format, size);
+	read_ms = output->adapt_read_max / 1000;
+	target = size;
+
+	if (underruns != output->adapt_underruns) {
+		reason = "underrun";
+		target = size * 2;
+	} else if (output->adapt_fill_min < size / 4) {
+		reason = "buffer nearly drained";
+		target = size * 2;
+	} else if (read_ms * 4 > size_ms) {
+		reason = "slow read from chain";
+		target = size * 2;
+	} else if (++output->adapt_healthy >= ADAPT_SHRINK_PERIODS &&
+	           read_ms * 8 < size_ms) {
+		reason = "stable";
+		target = size / 2;
+	}
+
+	prop = xmms_config_lookup ("output.buffer_min_ms");
+	min_size = xmms_sample_ms_to_bytes (output->format,
+	                                    xmms_config_property_get_int (prop));
+	prop = xmms_config_lookup ("output.buffer_max_ms");
+	max_size = xmms_sample_ms_to_bytes (output->format,
+	                                    xmms_config_property_get_int (prop));
+
+	min_size = MAX (min_size, ADAPT_MIN_SIZE);
+	max_size = MAX (max_size, min_size);
+	target = CLAMP (target, min_size, max_size);
+
+	frame_size = xmms_sample_frame_size_get (output->format);
+	target -= target % frame_size;
+
+	if (target != size) {
+		xmms_log_info ("Resizing output buffer from %d to %d ms (%s)",
+		               (gint) size_ms,
+		               (gint) xmms_sample_bytes_to_ms (output->format, target),
+		               reason);
+
+		xmms_ringbuf_resize (output->filler_buffer, target);
+
+		if (target > size) {
+			output->adapt_grows++;
+		} else {
+			output->adapt_shrinks++;
+		}
+	}
+
+	if (target != size || reason) {
+		output->adapt_healthy = 0;
+	}
+
+	output->adapt_fill_min = G_MAXUINT;
+	output->adapt_read_max = 0;
+	output->adapt_last = now;
+	output->adapt_underruns = underruns;
+}
+
 static void
 xmms_output_filler_state_nolock (xmms_output_t *output, xmms_output_filler_state_t state)
 {
@@ -342,6 +659,8 @@ xmms_output_filler_state_nolock (xmms_output_t *output, xmms_output_filler_state
 	g_cond_signal (&output->filler_state_cond);
 	if (state == FILLER_QUIT || state == FILLER_STOP || state == FILLER_KILL) {
 		xmms_ringbuf_clear (output->filler_buffer);
+		xmms_output_buffer_adapt_reset (output);
+		xmms_output_sinks_clear (output);
 	}
 	if (state != FILLER_STOP) {
 		xmms_ringbuf_set_eos (output->filler_buffer, FALSE);
@@ -361,622 +680,2443 @@ xmms_output_filler_seek_state (xmms_output_t *output, guint32 samples)
 	g_mutex_lock (&output->filler_mutex);
 	output->filler_state = FILLER_SEEK;
 	output->filler_seek = samples;
+	output->seek_requested = g_get_monotonic_time ();
 	g_cond_signal (&output->filler_state_cond);
 	g_mutex_unlock (&output->filler_mutex);
 }
 
-static void *
-xmms_output_filler (void *arg)
-{
-	xmms_output_t *output = (xmms_output_t *)arg;
-	xmms_xform_t *chain = NULL;
-	gboolean last_was_kill = FALSE;
+/**
+ * Crossfade state of the filler, only used by the filler thread.
+ *
+ * Near the end of a chain the next chain is opened ahead of time. If
+ * both produce the same format the playlist is advanced and they are
+ * mixed until the old one ends, otherwise the next one is kept around
+ * and played after a hard cut.
+ */
+typedef struct xmms_output_crossfade_St {
+	/** The next chain, and whether it is mixed in already */
+	xmms_xform_t *next;
+	/** The next chain was looked for */
+	gboolean prepared;
+	/** The playlist was advanced past the current chain, last is set
+	    if there was nothing to advance to */
+	gboolean advanced;
+	gboolean last;
+
+	/** Frames read from the current and the next chain */
+	gint64 pos;
+	gint64 next_pos;
+
+	/** Frames mixed so far, and the length of the fade. len is 0 when
+	    not fading, next is NULL while the rest of it is faded in
+	    after the old chain ended. */
+	guint fade_pos;
+	guint fade_len;
+	xmms_crossfade_curve_t curve;
+
+	/** Format of the current chain */
+	xmms_sample_format_t format;
+	gint rate;
+	gint channels;
+	gint frame_size;
+
 	char buf[4096];
-	xmms_error_t err;
-	gint ret;
+} xmms_output_crossfade_t;
 
-	xmms_error_reset (&err);
+static void
+xmms_output_crossfade_chain_set (xmms_output_crossfade_t *xfade,
+                                 xmms_xform_t *chain)
+{
+	xmms_stream_type_t *type = xmms_xform_outtype_get (chain);
+
+	xfade->format = xmms_stream_type_get_int (type, XMMS_STREAM_TYPE_FMT_FORMAT);
+	xfade->rate = xmms_stream_type_get_int (type, XMMS_STREAM_TYPE_FMT_SAMPLERATE);
+	xfade->channels = xmms_stream_type_get_int (type, XMMS_STREAM_TYPE_FMT_CHANNELS);
+	xfade->frame_size = MAX (xmms_sample_frame_size_get (type), 1);
+	xfade->pos = 0;
+	xfade->prepared = FALSE;
+	xfade->advanced = FALSE;
+	xfade->last = FALSE;
+}
 
-	g_mutex_lock (&output->filler_mutex);
-	while (output->filler_state != FILLER_QUIT) {
-		if (output->filler_state == FILLER_STOP) {
-			if (chain) {
-				xmms_object_unref (chain);
-				chain = NULL;
-			}
-			xmms_ringbuf_set_eos (output->filler_buffer, TRUE);
-			g_cond_wait (&output->filler_state_cond, &output->filler_mutex);
-			last_was_kill = FALSE;
-			continue;
-		}
-		if (output->filler_state == FILLER_KILL) {
-			if (chain) {
-				xmms_object_unref (chain);
-				chain = NULL;
-				output->filler_state = FILLER_RUN;
-				last_was_kill = TRUE;
-			} else {
-				output->filler_state = FILLER_STOP;
-			}
-			continue;
-		}
-		if (output->filler_state == FILLER_SEEK) {
-			if (!chain) {
-				XMMS_DBG ("Seek without chain, ignoring..");
-				output->filler_state = FILLER_STOP;
-				continue;
-			}
+static void
+xmms_output_crossfade_reset (xmms_output_crossfade_t *xfade)
+{
+	if (xfade->next) {
+		xmms_object_unref (xfade->next);
+		xfade->next = NULL;
+	}
+	xfade->prepared = FALSE;
+	xfade->advanced = FALSE;
+	xfade->last = FALSE;
+	xfade->fade_len = 0;
+}
 
-			ret = xmms_xform_this_seek (chain, output->filler_seek, XMMS_XFORM_SEEK_SET, &err);
-			if (ret == -1) {
-				XMMS_DBG ("Seeking failed: %s", xmms_error_message_get (&err));
-			} else {
-				XMMS_DBG ("Seek ok! %d", ret);
+/**
+ * Switch from the current chain to the one faded in. Returns the
+ * new current chain.
+ */
+static xmms_xform_t *
+xmms_output_crossfade_promote (xmms_output_t *output,
+                               xmms_output_crossfade_t *xfade,
+                               xmms_xform_t *chain)
+{
+	xmms_object_unref (chain);
+	chain = xfade->next;
+	xfade->next = NULL;
 
-				output->filler_skip = output->filler_seek - ret;
-				if (output->filler_skip < 0) {
-					XMMS_DBG ("Seeked %d samples too far! Updating position...",
-					          -output->filler_skip);
+	xmms_output_crossfade_chain_set (xfade, chain);
+	xfade->pos = xfade->next_pos;
+	output->filler_chain = chain;
 
-					output->filler_skip = 0;
-					output->filler_seek = ret;
-				}
+	return chain;
+}
 
-				xmms_ringbuf_clear (output->filler_buffer);
-				xmms_ringbuf_hotspot_set (output->filler_buffer, seek_done, NULL, output);
-			}
-			output->filler_state = FILLER_RUN;
+/**
+ * Called before seeking in chain or stopping, ends a fade right away.
+ * The chain the listener currently hears as the song is kept, the
+ * other one is dropped. Returns the chain to go on with.
+ */
+static xmms_xform_t *
+xmms_output_crossfade_settle (xmms_output_t *output,
+                              xmms_output_crossfade_t *xfade,
+                              xmms_xform_t *chain)
+{
+	if (xfade->next && xfade->fade_len &&
+	    xmms_output_current_id (output) == xmms_xform_entry_get (xfade->next)) {
+		chain = xmms_output_crossfade_promote (output, xfade, chain);
+	} else if (xfade->next) {
+		/* the playlist was advanced when the fade started, the
+		 * current song is the old one again */
+		if (xfade->fade_len) {
+			xmms_playlist_retreat_in (output->playlist, output->playlist_name);
+			xfade->advanced = FALSE;
 		}
+		xmms_object_unref (xfade->next);
+		xfade->next = NULL;
+		output->filler_chain = chain;
+	}
 
-		if (!chain) {
-			xmms_medialib_entry_t entry;
-			xmms_output_song_changed_arg_t *hsarg;
+	/* the next chain is looked for again near the end */
+	if (!xfade->advanced) {
+		xfade->prepared = FALSE;
+	}
+	xfade->fade_len = 0;
 
-			g_mutex_unlock (&output->filler_mutex);
+	return chain;
+}
 
-			entry = xmms_playlist_current_entry (output->playlist);
-			if (!entry) {
-				XMMS_DBG ("No entry from playlist!");
-				output->filler_state = FILLER_STOP;
-				g_mutex_lock (&output->filler_mutex);
-				continue;
-			}
+/**
+ * Make the song opened ahead the current one of the playlist, called
+ * when the fade into it starts. If the playlist changed meanwhile, the
+ * next chain is dropped and FALSE returned, the old one then plays to
+ * its end before whatever the playlist has moved to is played.
+ */
+static gboolean
+xmms_output_crossfade_advance (xmms_output_t *output,
+                               xmms_output_crossfade_t *xfade)
+{
+	xmms_medialib_entry_t entry;
 
-			chain = xmms_xform_chain_setup (output->medialib, entry, output->format_list, FALSE);
-			if (!chain) {
-				xmms_medialib_session_t *session;
+	xfade->advanced = TRUE;
 
-				do {
-					session = xmms_medialib_session_begin (output->medialib);
-					if (xmms_medialib_entry_property_get_int (session, entry, XMMS_MEDIALIB_ENTRY_PROPERTY_STATUS) == XMMS_MEDIALIB_ENTRY_STATUS_NEW) {
-						xmms_medialib_entry_remove (session, entry);
-					} else {
-						xmms_medialib_entry_status_set (session, entry, XMMS_MEDIALIB_ENTRY_STATUS_NOT_AVAILABLE);
-					}
-				} while (!xmms_medialib_session_commit (session));
+	if (!xmms_playlist_advance_in (output->playlist, output->playlist_name)) {
+		xfade->last = TRUE;
+	} else {
+		entry = xmms_playlist_current_entry_in (output->playlist,
+		                                        output->playlist_name);
+		if (entry == xmms_xform_entry_get (xfade->next)) {
+			return TRUE;
+		}
+	}
 
-				if (!xmms_playlist_advance (output->playlist)) {
-					XMMS_DBG ("End of playlist");
-					output->filler_state = FILLER_STOP;
-				}
-				g_mutex_lock (&output->filler_mutex);
-				continue;
-			}
+	xmms_object_unref (xfade->next);
+	xfade->next = NULL;
 
-			hsarg = g_new0 (xmms_output_song_changed_arg_t, 1);
-			hsarg->output = output;
-			hsarg->chain = chain;
-			hsarg->flush = last_was_kill;
-			xmms_object_ref (chain);
+	return FALSE;
+}
 
-			last_was_kill = FALSE;
+/**
+ * Open the chain for entry.
+ */
+static xmms_xform_t *
+xmms_output_chain_setup (xmms_output_t *output, xmms_medialib_entry_t entry)
+{
+	xmms_xform_t *chain;
+	GList *goal_formats = output->format_list;
 
-			g_mutex_lock (&output->filler_mutex);
-			xmms_ringbuf_hotspot_set (output->filler_buffer, song_changed, song_changed_arg_free, hsarg);
-		}
+	if (xmms_config_property_get_int (xmms_config_lookup ("output.float_pipeline"))) {
+		goal_formats = xmms_output_float_format_list (output);
+	}
 
-		xmms_ringbuf_wait_free (output->filler_buffer, sizeof (buf), &output->filler_mutex);
+	chain = xmms_xform_chain_setup (output->medialib, entry, goal_formats, FALSE);
+	if (chain && xmms_config_property_get_int (xmms_config_lookup ("output.mlock"))) {
+		xmms_xform_chain_mlock (chain);
+	}
 
-		if (output->filler_state != FILLER_RUN) {
-			XMMS_DBG ("State changed while waiting...");
-			continue;
-		}
-		g_mutex_unlock (&output->filler_mutex);
+	return chain;
+}
 
-		ret = xmms_xform_this_read (chain, buf, sizeof (buf), &err);
+static void
+xmms_output_pipeline_clear (xmms_output_t *output)
+{
+	if (output->pipeline_conv) {
+		xmms_object_unref (output->pipeline_conv);
+		xmms_object_unref (output->pipeline_from);
+		xmms_object_unref (output->pipeline_to);
+		output->pipeline_conv = NULL;
+		output->pipeline_from = NULL;
+		output->pipeline_to = NULL;
+	}
+}
 
-		g_mutex_lock (&output->filler_mutex);
+/**
+ * Pick the format the output of chain is buffered and played in. A
+ * chain set up for the float pipeline is converted to the closest
+ * format the plugin supports, any other chain ends in such a format
+ * already. Returns a new reference to the format.
+ */
+static xmms_stream_type_t *
+xmms_output_pipeline_set (xmms_output_t *output, xmms_xform_t *chain)
+{
+	xmms_stream_type_t *from, *to;
+	GList *n;
 
-		if (ret > 0) {
-			gint skip = MIN (ret, output->toskip);
+	from = xmms_xform_outtype_get (chain);
 
-			output->toskip -= skip;
-			if (ret > skip) {
-				xmms_ringbuf_write_wait (output->filler_buffer,
-				                         buf + skip,
-				                         ret - skip,
-				                         &output->filler_mutex);
-			}
-		} else {
-			if (ret == -1) {
-				/* print error */
-				xmms_error_reset (&err);
-			}
-			xmms_object_unref (chain);
-			chain = NULL;
-			if (!xmms_playlist_advance (output->playlist)) {
-				XMMS_DBG ("End of playlist");
-				output->filler_state = FILLER_STOP;
-			}
+	/* chains faded into each other share the converter */
+	if (output->pipeline_conv && xmms_stream_type_match (output->pipeline_from, from)) {
+		xmms_object_ref (output->pipeline_to);
+		return output->pipeline_to;
+	}
+
+	xmms_output_pipeline_clear (output);
+
+	for (n = output->format_list; n; n = g_list_next (n)) {
+		if (xmms_stream_type_match (n->data, from)) {
+			xmms_object_ref (from);
+			return from;
 		}
+	}
 
+	to = xmms_stream_type_coerce (from, output->format_list);
+	if (!to) {
+		/* song_changed stops the filler when the format is refused */
+		xmms_object_ref (from);
+		return from;
 	}
 
-	if (chain)
-		xmms_object_unref (chain);
+	output->pipeline_conv = xmms_sample_converter_init (from, to);
+	if (!output->pipeline_conv) {
+		xmms_object_unref (to);
+		xmms_object_ref (from);
+		return from;
+	}
 
-	g_mutex_unlock (&output->filler_mutex);
+	xmms_object_ref (from);
+	xmms_object_ref (to);
+	output->pipeline_from = from;
+	output->pipeline_to = to;
 
-	return NULL;
+	return to;
 }
 
-gint
-xmms_output_read (xmms_output_t *output, char *buffer, gint len)
+/**
+ * Write what was read from the chain to the buffer, converted to the
+ * format the plugin plays. Called by the filler with filler_mutex held.
+ */
+static void
+xmms_output_pipeline_write (xmms_output_t *output, gchar *buf, gint len)
 {
-	gint ret;
-	xmms_error_t err;
+	xmms_sample_t *out = (xmms_sample_t *) buf;
+	guint outlen = len;
 
-	xmms_error_reset (&err);
+	if (output->pipeline_conv) {
+		xmms_sample_convert (output->pipeline_conv, buf, len, &out, &outlen);
+	}
 
-	g_return_val_if_fail (output, -1);
-	g_return_val_if_fail (buffer, -1);
+	xmms_ringbuf_write_wait (output->filler_buffer, out, outlen,
+	                         &output->filler_mutex);
+}
 
-	g_mutex_lock (&output->filler_mutex);
-	xmms_ringbuf_wait_used (output->filler_buffer, len, &output->filler_mutex);
-	ret = xmms_ringbuf_read (output->filler_buffer, buffer, len);
-	if (ret == 0 && xmms_ringbuf_iseos (output->filler_buffer)) {
-		xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
-		g_mutex_unlock (&output->filler_mutex);
-		return -1;
+/**
+ * Make chain the one played from the current write position of the
+ * buffer on, called by the filler with filler_mutex held.
+ */
+static void
+xmms_output_chain_start (xmms_output_t *output, xmms_xform_t *chain,
+                         gboolean flush)
+{
+	xmms_output_song_changed_arg_t *hsarg;
+
+	hsarg = g_new0 (xmms_output_song_changed_arg_t, 1);
+	hsarg->output = output;
+	hsarg->chain = chain;
+	hsarg->type = xmms_output_pipeline_set (output, chain);
+	hsarg->flush = flush;
+	xmms_object_ref (chain);
+
+	output->conversions = xmms_xform_chain_conversions (chain);
+	if (output->pipeline_conv) {
+		output->conversions++;
+	}
+
+	xmms_ringbuf_hotspot_set (output->filler_buffer, song_changed, song_changed_arg_free, hsarg);
+
+	output->filler_chain = chain;
+	xmms_output_sinks_chain_set (output, chain, flush);
+}
+
+/**
+ * Open the next chain once the current one comes within the
+ * crossfade length of its end, and start mixing it in if possible.
+ * The playlist is only advanced once the fade starts. Called by the
+ * filler with filler_mutex held, which is dropped while the chain is
+ * set up.
+ */
+static void
+xmms_output_crossfade_prepare (xmms_output_t *output,
+                               xmms_output_crossfade_t *xfade,
+                               xmms_xform_t *chain)
+{
+	xmms_config_property_t *prop;
+	xmms_medialib_entry_t entry;
+	xmms_xform_t *next = NULL;
+	gint fade_ms, duration;
+	gint64 remaining;
+
+	fade_ms = g_atomic_int_get (&output->crossfade_ms);
+	if (fade_ms <= 0 || xfade->prepared || xfade->rate <= 0) {
+		return;
+	}
+
+	if (!xmms_xform_metadata_get_int (chain, XMMS_MEDIALIB_ENTRY_PROPERTY_DURATION,
+	                                  &duration)) {
+		return;
 	}
+
+	remaining = (gint64) duration * xfade->rate / 1000 - xfade->pos;
+	if (remaining > (gint64) fade_ms * xfade->rate / 1000) {
+		return;
+	}
+
+	xfade->prepared = TRUE;
+
 	g_mutex_unlock (&output->filler_mutex);
 
-	update_playtime (output, ret);
+	entry = xmms_playlist_next_entry_in (output->playlist, output->playlist_name);
+	if (entry) {
+		/* on failure the entry is dealt with at the end of chain */
+		next = xmms_output_chain_setup (output, entry);
+	}
 
-	if (ret < len) {
-		XMMS_DBG ("Underrun %d of %d (%d)", ret, len, xmms_sample_frame_size_get (output->format));
+	g_mutex_lock (&output->filler_mutex);
 
-		if ((ret % xmms_sample_frame_size_get (output->format)) != 0) {
-			xmms_log_error ("***********************************");
-			xmms_log_error ("* Read non-multiple of sample size,");
-			xmms_log_error ("*  you probably hear noise now :)");
-			xmms_log_error ("***********************************");
+	if (!next) {
+		return;
+	}
+
+	xfade->next = next;
+	xfade->next_pos = 0;
+
+	if (output->filler_state != FILLER_RUN || remaining <= 0 ||
+	    !xmms_crossfade_format_supported (xfade->format) ||
+	    xmms_xform_outtype_get_int (next, XMMS_STREAM_TYPE_FMT_FORMAT) != xfade->format ||
+	    xmms_xform_outtype_get_int (next, XMMS_STREAM_TYPE_FMT_SAMPLERATE) != xfade->rate ||
+	    xmms_xform_outtype_get_int (next, XMMS_STREAM_TYPE_FMT_CHANNELS) != xfade->channels) {
+		XMMS_DBG ("Can't crossfade into the next song, cutting over");
+		return;
+	}
+
+	if (!xmms_output_crossfade_advance (output, xfade)) {
+		return;
+	}
+
+	prop = xmms_config_lookup ("output.crossfade_curve");
+	xfade->curve = xmms_crossfade_curve_parse (xmms_config_property_get_string (prop));
+	xfade->fade_pos = 0;
+	xfade->fade_len = remaining;
+
+	XMMS_DBG ("Crossfading over %d frames", xfade->fade_len);
+
+	xmms_output_chain_start (output, next, FALSE);
+}
+
+/**
+ * Read from chain into buf, mixed with the next chain while fading.
+ * Called by the filler without filler_mutex held.
+ */
+static gint
+xmms_output_crossfade_read (xmms_output_crossfade_t *xfade,
+                            xmms_xform_t *chain, gchar *buf, gint len,
+                            xmms_error_t *err)
+{
+	gint ret, got, n, frames, rest;
+
+	if (!xfade->fade_len) {
+		/* the usual case, no copying */
+		ret = xmms_xform_this_read (chain, buf, len, err);
+		if (ret > 0) {
+			xfade->pos += ret / xfade->frame_size;
 		}
-		output->buffer_underruns++;
+		return ret;
+	}
+
+	len = MIN (len, (gint64) (xfade->fade_len - xfade->fade_pos) * xfade->frame_size);
+	len = MAX (len - len % xfade->frame_size, xfade->frame_size);
+
+	if (xfade->next) {
+		ret = xmms_xform_this_read (chain, buf, len, err);
+		if (ret <= 0) {
+			return ret;
+		}
+
+		for (got = 0; got < ret; got += n) {
+			n = xmms_xform_this_read (xfade->next, xfade->buf + got,
+			                          ret - got, err);
+			if (n <= 0) {
+				memset (xfade->buf + got, 0, ret - got);
+				break;
+			}
+		}
+		xfade->next_pos += got / xfade->frame_size;
+	} else {
+		/* the old chain ended, fade in the rest from silence */
+		ret = xmms_xform_this_read (chain, xfade->buf, len, err);
+		if (ret <= 0) {
+			return ret;
+		}
+		memset (buf, 0, ret);
+	}
+
+	xfade->pos += ret / xfade->frame_size;
+
+	frames = ret / xfade->frame_size;
+	xmms_crossfade_mix (xfade->format, xfade->channels, xfade->curve,
+	                    buf, xfade->buf, frames, xfade->fade_pos,
+	                    xfade->fade_len);
+	xfade->fade_pos += frames;
+
+	/* a partial frame is passed on as it is */
+	rest = ret - frames * xfade->frame_size;
+	if (rest && !xfade->next) {
+		memcpy (buf + ret - rest, xfade->buf + ret - rest, rest);
+	}
+
+	return ret;
+}
+
+/**
+ * Seek by dropping data from the buffer if the wanted position was
+ * decoded already. The chain isn't touched, so decoders and effects
+ * keep their state and nothing is decoded twice. Called by the filler
+ * with filler_mutex held.
+ *
+ * @returns FALSE if the chain has to seek
+ */
+static gboolean
+xmms_output_filler_seek_buffered (xmms_output_t *output,
+                                  xmms_output_crossfade_t *xfade)
+{
+	gint64 start, skip;
+	gint frame_size = xfade->frame_size;
+
+	/* the buffer holds data of one chain only, without gaps */
+	if (output->toskip || xfade->next || xfade->fade_len) {
+		return FALSE;
+	}
+
+	/* sinks drain their buffers at their own pace, what they still
+	 * hold of the stretch kept here is unknown */
+	if (output->sinks) {
+		return FALSE;
+	}
+
+	if (output->pipeline_conv) {
+		frame_size = xmms_sample_frame_size_get (output->pipeline_to);
+	}
+
+	start = xfade->pos - xmms_ringbuf_bytes_used (output->filler_buffer) / frame_size;
+	if (start < 0 || output->filler_seek < start || output->filler_seek > xfade->pos) {
+		return FALSE;
+	}
+
+	skip = (output->filler_seek - start) * frame_size;
+	if (!xmms_ringbuf_skip (output->filler_buffer, skip)) {
+		return FALSE;
 	}
 
-	output->bytes_written += ret;
+	output->seeks_buffered++;
+
+	xmms_ringbuf_hotspot_set_front (output->filler_buffer, seek_done, NULL, output);
+
+	return TRUE;
+}
+
+static void *
+xmms_output_filler (void *arg)
+{
+	xmms_output_t *output = (xmms_output_t *)arg;
+	xmms_xform_t *chain = NULL;
+	xmms_output_crossfade_t xfade = { 0 };
+	gboolean last_was_kill = FALSE;
+	char buf[4096];
+	xmms_error_t err;
+	gint ret;
+
+	xmms_error_reset (&err);
+
+	xmms_output_realtime_enter ("filler", -1);
+
+	g_mutex_lock (&output->filler_mutex);
+	while (output->filler_state != FILLER_QUIT) {
+		if (output->filler_state == FILLER_STOP) {
+			if (chain) {
+				chain = xmms_output_crossfade_settle (output, &xfade, chain);
+				xmms_object_unref (chain);
+				chain = NULL;
+				output->filler_chain = NULL;
+			}
+			xmms_output_crossfade_reset (&xfade);
+			xmms_ringbuf_set_eos (output->filler_buffer, TRUE);
+			g_cond_wait (&output->filler_state_cond, &output->filler_mutex);
+			last_was_kill = FALSE;
+			continue;
+		}
+		if (output->filler_state == FILLER_KILL) {
+			xmms_output_crossfade_reset (&xfade);
+			if (chain) {
+				xmms_object_unref (chain);
+				chain = NULL;
+				output->filler_chain = NULL;
+				output->filler_state = FILLER_RUN;
+				last_was_kill = TRUE;
+			} else {
+				output->filler_state = FILLER_STOP;
+			}
+			continue;
+		}
+		if (output->filler_state == FILLER_SEEK) {
+			if (!chain) {
+				XMMS_DBG ("Seek without chain, ignoring..");
+				output->filler_state = FILLER_STOP;
+				continue;
+			}
+
+			if (xmms_output_filler_seek_buffered (output, &xfade)) {
+				XMMS_DBG ("Seek ok within the buffer! %u", output->filler_seek);
+				output->filler_state = FILLER_RUN;
+				continue;
+			}
+
+			chain = xmms_output_crossfade_settle (output, &xfade, chain);
+
+			ret = xmms_xform_this_seek (chain, output->filler_seek, XMMS_XFORM_SEEK_SET, &err);
+			if (ret == -1) {
+				XMMS_DBG ("Seeking failed: %s", xmms_error_message_get (&err));
+				output->seek_requested = 0;
+			} else {
+				XMMS_DBG ("Seek ok! %d", ret);
+
+				output->filler_skip = output->filler_seek - ret;
+				if (output->filler_skip < 0) {
+					XMMS_DBG ("Seeked %d samples too far! Updating position...",
+					          -output->filler_skip);
+
+					output->filler_skip = 0;
+					output->filler_seek = ret;
+				}
+				xfade.pos = ret;
+
+				/* dropped by the filler, before anything is written
+				 * after the seek */
+				output->toskip = output->filler_skip * xfade.frame_size;
+
+				if (output->pipeline_conv) {
+					xmms_sample_convert_reset (output->pipeline_conv);
+				}
+
+				xmms_ringbuf_clear (output->filler_buffer);
+				xmms_output_buffer_adapt_reset (output);
+				xmms_ringbuf_hotspot_set (output->filler_buffer, seek_done, NULL, output);
+				xmms_output_sinks_seek (output);
+			}
+			output->filler_state = FILLER_RUN;
+		}
+
+		if (!chain && xfade.next) {
+			/* opened ahead, but couldn't be mixed in. The playlist
+			 * may have changed since, so check it is still next. */
+			if (xmms_playlist_current_entry_in (output->playlist,
+			                                    output->playlist_name) ==
+			    xmms_xform_entry_get (xfade.next)) {
+				chain = xfade.next;
+				xmms_output_crossfade_chain_set (&xfade, chain);
+				xmms_output_chain_start (output, chain, FALSE);
+			} else {
+				xmms_object_unref (xfade.next);
+			}
+			xfade.next = NULL;
+		}
+
+		if (!chain) {
+			xmms_medialib_entry_t entry;
+
+			g_mutex_unlock (&output->filler_mutex);
+
+			entry = xmms_playlist_current_entry_in (output->playlist,
+			                                        output->playlist_name);
+			if (!entry) {
+				XMMS_DBG ("No entry from playlist!");
+				output->filler_state = FILLER_STOP;
+				g_mutex_lock (&output->filler_mutex);
+				continue;
+			}
+
+			chain = xmms_output_chain_setup (output, entry);
+			if (!chain) {
+				xmms_medialib_session_t *session;
+
+				do {
+					session = xmms_medialib_session_begin (output->medialib);
+					if (xmms_medialib_entry_property_get_int (session, entry, XMMS_MEDIALIB_ENTRY_PROPERTY_STATUS) == XMMS_MEDIALIB_ENTRY_STATUS_NEW) {
+						xmms_medialib_entry_remove (session, entry);
+					} else {
+						xmms_medialib_entry_status_set (session, entry, XMMS_MEDIALIB_ENTRY_STATUS_NOT_AVAILABLE);
+					}
+				} while (!xmms_medialib_session_commit (session));
+
+				if (!xmms_playlist_advance_in (output->playlist,
+				                               output->playlist_name)) {
+					XMMS_DBG ("End of playlist");
+					output->filler_state = FILLER_STOP;
+				}
+				g_mutex_lock (&output->filler_mutex);
+				continue;
+			}
+
+			g_mutex_lock (&output->filler_mutex);
+			xmms_output_crossfade_chain_set (&xfade, chain);
+			xmms_output_chain_start (output, chain, last_was_kill);
+
+			last_was_kill = FALSE;
+		}
+
+		xmms_output_crossfade_prepare (output, &xfade, chain);
+		if (output->filler_state != FILLER_RUN) {
+			continue;
+		}
+
+		if (xmms_ringbuf_bytes_free (output->filler_buffer) < sizeof (buf)) {
+			output->adapt_primed = TRUE;
+		}
+
+		if (xmms_xform_profile_enabled () &&
+		    xmms_ringbuf_bytes_free (output->filler_buffer) < sizeof (buf)) {
+			gint64 start = g_get_monotonic_time ();
+
+			xmms_ringbuf_wait_free (output->filler_buffer, sizeof (buf), &output->filler_mutex);
+
+			output->filler_wait_time += g_get_monotonic_time () - start;
+			output->filler_waits++;
+		} else {
+			xmms_ringbuf_wait_free (output->filler_buffer, sizeof (buf), &output->filler_mutex);
+		}
+
+		if (output->filler_state != FILLER_RUN) {
+			XMMS_DBG ("State changed while waiting...");
+			continue;
+		}
+		g_mutex_unlock (&output->filler_mutex);
+
+		if (g_atomic_int_get (&output->adapt_enabled)) {
+			gint64 start = g_get_monotonic_time ();
+
+			ret = xmms_output_crossfade_read (&xfade, chain, buf, sizeof (buf), &err);
+
+			g_mutex_lock (&output->filler_mutex);
+			output->adapt_read_max = MAX (output->adapt_read_max,
+			                              g_get_monotonic_time () - start);
+			xmms_output_buffer_adapt (output);
+		} else {
+			ret = xmms_output_crossfade_read (&xfade, chain, buf, sizeof (buf), &err);
+
+			g_mutex_lock (&output->filler_mutex);
+		}
+
+		if (ret > 0) {
+			gint skip = MIN (ret, output->toskip);
+
+			output->toskip -= skip;
+			if (ret > skip) {
+				xmms_output_sinks_write (output, buf + skip, ret - skip);
+				xmms_output_pipeline_write (output, buf + skip, ret - skip);
+			}
+
+			if (xfade.fade_len && xfade.fade_pos >= xfade.fade_len) {
+				/* done, drop what is left of the old chain */
+				if (xfade.next) {
+					chain = xmms_output_crossfade_promote (output, &xfade, chain);
+				}
+				xfade.fade_len = 0;
+			}
+		} else {
+			if (ret == -1) {
+				/* print error */
+				xmms_error_reset (&err);
+			}
+			if (xfade.next && xfade.fade_len) {
+				chain = xmms_output_crossfade_promote (output, &xfade, chain);
+				continue;
+			}
+			xmms_object_unref (chain);
+			chain = NULL;
+			output->filler_chain = NULL;
+			if (xfade.advanced) {
+				if (xfade.last) {
+					XMMS_DBG ("End of playlist");
+					output->filler_state = FILLER_STOP;
+				}
+				xfade.advanced = FALSE;
+				xfade.last = FALSE;
+			} else if (!xmms_playlist_advance_in (output->playlist,
+			                                      output->playlist_name)) {
+				XMMS_DBG ("End of playlist");
+				output->filler_state = FILLER_STOP;
+			}
+		}
+
+	}
+
+	if (chain)
+		xmms_object_unref (chain);
+	xmms_output_crossfade_reset (&xfade);
+	xmms_output_pipeline_clear (output);
+	output->filler_chain = NULL;
+
+	g_mutex_unlock (&output->filler_mutex);
+
+	return NULL;
+}
+
+/**
+ * Bookkeeping after len bytes were asked for and ret bytes were read
+ * from the output buffer.
+ */
+static void
+xmms_output_read_done (xmms_output_t *output, gint ret, gint len)
+{
+	update_playtime (output, ret);
+
+	if (ret < len) {
+		XMMS_DBG ("Underrun %d of %d (%d)", ret, len, xmms_sample_frame_size_get (output->format));
+
+		if ((ret % xmms_sample_frame_size_get (output->format)) != 0) {
+			xmms_log_error ("***********************************");
+			xmms_log_error ("* Read non-multiple of sample size,");
+			xmms_log_error ("*  you probably hear noise now :)");
+			xmms_log_error ("***********************************");
+		}
+		g_mutex_lock (&output->playtime_mutex);
+		output->underrun_times[output->buffer_underruns % UNDERRUN_HISTORY] = g_get_real_time ();
+		output->buffer_underruns++;
+		g_mutex_unlock (&output->playtime_mutex);
+	}
+
+	output->bytes_written += ret;
+}
+
+/**
+ * Apply the software volume to len bytes read from the buffer, in
+ * the format they were read in.
+ */
+static void
+xmms_output_softvol_apply (xmms_output_t *output, gchar *buffer, gint len)
+{
+	gint volume, rate, format;
+	guint ramp;
+
+	volume = g_atomic_int_get (&output->softvol_volume);
+	if (volume != output->softvol_applied) {
+		gfloat gain = volume < 0 ? 1.0f : xmms_softvol_gain (volume);
+
+		/* the first volume is set right away */
+		ramp = 0;
+		if (output->format && output->softvol_applied != G_MININT) {
+			rate = xmms_stream_type_get_int (output->format, XMMS_STREAM_TYPE_FMT_SAMPLERATE);
+			ramp = MAX (rate, 0) * SOFTVOL_RAMP_MS / 1000;
+		}
+
+		xmms_softvol_set (&output->softvol, gain, ramp);
+		output->softvol_applied = volume;
+	}
+
+	if (len <= 0 || !output->format) {
+		return;
+	}
+
+	format = xmms_stream_type_get_int (output->format, XMMS_STREAM_TYPE_FMT_FORMAT);
+	xmms_softvol_apply (&output->softvol, format,
+	                    xmms_stream_type_get_int (output->format, XMMS_STREAM_TYPE_FMT_CHANNELS),
+	                    buffer, len / xmms_sample_size_get (format));
+}
+
+/**
+ * Wait for len bytes in the output buffer, with filler_mutex held.
+ */
+static void
+xmms_output_read_wait (xmms_output_t *output, gint len)
+{
+	if (output->adapt_primed) {
+		output->adapt_fill_min = MIN (output->adapt_fill_min,
+		                              xmms_ringbuf_bytes_used (output->filler_buffer));
+	}
+	xmms_ringbuf_wait_used (output->filler_buffer, len, &output->filler_mutex);
+}
+
+gint
+xmms_output_read (xmms_output_t *output, char *buffer, gint len)
+{
+	gint ret;
+
+	g_return_val_if_fail (output, -1);
+	g_return_val_if_fail (buffer, -1);
+
+	g_mutex_lock (&output->filler_mutex);
+	xmms_output_read_wait (output, len);
+	ret = xmms_ringbuf_read (output->filler_buffer, buffer, len);
+	if (ret == 0 && xmms_ringbuf_iseos (output->filler_buffer)) {
+		xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
+		g_mutex_unlock (&output->filler_mutex);
+		return -1;
+	}
+	g_mutex_unlock (&output->filler_mutex);
+
+	xmms_output_softvol_apply (output, buffer, ret);
+	xmms_output_read_done (output, ret, len);
+
+	return ret;
+}
+
+gint
+xmms_output_read_prepare (xmms_output_t *output, gint len)
+{
+	gint ret;
+
+	g_return_val_if_fail (output, -1);
+	g_return_val_if_fail (len > 0, -1);
+
+	g_mutex_lock (&output->filler_mutex);
+	xmms_output_read_wait (output, len);
+	ret = xmms_ringbuf_hotspots_run (output->filler_buffer);
+	if (ret == 0 && xmms_ringbuf_iseos (output->filler_buffer)) {
+		xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
+		g_mutex_unlock (&output->filler_mutex);
+		return -1;
+	}
+	g_mutex_unlock (&output->filler_mutex);
+
+	return MIN (ret, len);
+}
+
+gint
+xmms_output_read_direct (xmms_output_t *output, char *buffer, gint len)
+{
+	gint ret;
+
+	g_return_val_if_fail (output, -1);
+	g_return_val_if_fail (buffer, -1);
+	g_return_val_if_fail (len > 0, -1);
+
+	g_mutex_lock (&output->filler_mutex);
+	ret = xmms_ringbuf_read_nohotspots (output->filler_buffer, buffer, len);
+	g_mutex_unlock (&output->filler_mutex);
+
+	xmms_output_softvol_apply (output, buffer, ret);
+	xmms_output_read_done (output, ret, len);
+
+	return ret;
+}
+
+gint
+xmms_output_bytes_available (xmms_output_t *output)
+{
+	return xmms_ringbuf_bytes_used (output->filler_buffer);
+}
+
+xmms_config_property_t *
+xmms_output_config_property_register (xmms_output_t *output, const gchar *name, const gchar *default_value, xmms_object_handler_t cb, gpointer userdata)
+{
+	g_return_val_if_fail (output->plugin, NULL);
+	return xmms_plugin_config_property_register ((xmms_plugin_t *)output->plugin, name, default_value, cb, userdata);
+}
+
+xmms_config_property_t *
+xmms_output_config_lookup (xmms_output_t *output, const gchar *path)
+{
+	xmms_config_property_t *prop;
+	gchar *zpath;
+
+	g_return_val_if_fail (output->plugin, NULL);
+
+	prop = xmms_plugin_config_lookup ((xmms_plugin_t *)output->plugin, path);
+	if (!output->config_prefix || !prop) {
+		return prop;
+	}
+
+	/* zones and sinks get their own copy of the plugin's values, so
+	 * that they can be routed to another device */
+	zpath = g_strdup_printf ("%s.%s", output->config_prefix, path);
+	prop = xmms_config_property_register (zpath,
+	                                      xmms_config_property_get_string (prop),
+	                                      NULL, NULL);
+	g_free (zpath);
+
+	return prop;
+}
+
+xmms_medialib_entry_t
+xmms_output_current_id (xmms_output_t *output)
+{
+	g_return_val_if_fail (output, 0);
+	return output->current_entry;
+}
+
+
+/** @addtogroup Output
+ * @{
+ */
+/** Methods */
+static void
+xmms_playback_client_tickle (xmms_output_t *output, xmms_error_t *error)
+{
+	xmms_output_filler_state (output, FILLER_KILL);
+}
+
+static void
+xmms_playback_client_seek_ms (xmms_output_t *output, gint32 ms, gint32 whence, xmms_error_t *error)
+{
+	guint samples;
+
+	g_return_if_fail (output);
+
+	if (whence == XMMS_PLAYBACK_SEEK_CUR) {
+		ms += g_atomic_int_get (&output->played_time);
+		if (ms < 0) {
+			ms = 0;
+		}
+	}
+
+	if (output->format) {
+		samples = xmms_sample_ms_to_samples (output->format, ms);
+
+		xmms_playback_client_seek_samples (output, samples,
+		                                   XMMS_PLAYBACK_SEEK_SET, error);
+	}
+}
+
+static void
+xmms_playback_client_seek_samples (xmms_output_t *output, gint32 samples, gint32 whence, xmms_error_t *error)
+{
+	if (whence == XMMS_PLAYBACK_SEEK_CUR) {
+		g_mutex_lock (&output->playtime_mutex);
+		samples += output->played / xmms_sample_frame_size_get (output->format);
+		if (samples < 0) {
+			samples = 0;
+		}
+		g_mutex_unlock (&output->playtime_mutex);
+	}
+
+	/* "just" tell filler */
+	xmms_output_filler_seek_state (output, samples);
+}
+
+static void
+xmms_playback_client_start (xmms_output_t *output, xmms_error_t *err)
+{
+	g_return_if_fail (output);
+
+	xmms_output_filler_state (output, FILLER_RUN);
+	if (!xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_PLAY)) {
+		xmms_output_filler_state (output, FILLER_STOP);
+		xmms_error_set (err, XMMS_ERROR_GENERIC, "Could not start playback");
+	}
+
+}
+
+static void
+xmms_playback_client_stop (xmms_output_t *output, xmms_error_t *err)
+{
+	g_return_if_fail (output);
+
+	xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
+
+	xmms_output_filler_state (output, FILLER_STOP);
+}
+
+static void
+xmms_playback_client_pause (xmms_output_t *output, xmms_error_t *err)
+{
+	g_return_if_fail (output);
+
+	xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_PAUSE);
+}
+
+
+static gint32
+xmms_playback_client_status (xmms_output_t *output, xmms_error_t *error)
+{
+	gint32 ret;
+	g_return_val_if_fail (output, XMMS_PLAYBACK_STATUS_STOP);
+
+	g_mutex_lock (&output->status_mutex);
+	ret = output->status;
+	g_mutex_unlock (&output->status_mutex);
+	return ret;
+}
+
+static gint
+xmms_playback_client_current_id (xmms_output_t *output, xmms_error_t *error)
+{
+	return output->current_entry;
+}
+
+static void
+xmms_playback_client_volume_set (xmms_output_t *output, const gchar *channel,
+                                 gint32 volume, xmms_error_t *error)
+{
+	gchar buf[16];
+
+	if (!output->plugin) {
+		xmms_error_set (error, XMMS_ERROR_GENERIC,
+		                "couldn't set volume, output plugin not loaded");
+		return;
+	}
+
+	if (!xmms_output_plugin_method_volume_set_available (output->plugin) &&
+	    g_atomic_int_get (&output->softvol_volume) < 0) {
+		xmms_error_set (error, XMMS_ERROR_GENERIC,
+		                "operation not supported");
+		return;
+	}
+
+	if (volume > 100 || volume < 0) {
+		xmms_error_set (error, XMMS_ERROR_INVAL, "volume out of range");
+		return;
+	}
+
+	if (g_atomic_int_get (&output->softvol_volume) >= 0) {
+		if (strcmp (channel, SOFTVOL_CHANNEL) != 0) {
+			xmms_error_set (error, XMMS_ERROR_INVAL, "no such channel");
+			return;
+		}
+
+		/* on_software_volume_changed takes it from here */
+		g_snprintf (buf, sizeof (buf), "%d", volume);
+		xmms_config_property_set_data (xmms_config_lookup ("output.software_volume"), buf);
+		return;
+	}
+
+	if (!xmms_output_plugin_methods_volume_set (output->plugin, output, channel, volume)) {
+		xmms_error_set (error, XMMS_ERROR_GENERIC,
+		                "couldn't set volume");
+	}
+}
+
+static xmmsv_t *
+xmms_playback_client_volume_get (xmms_output_t *output, xmms_error_t *error)
+{
+	xmmsv_t *ret;
+	xmms_volume_map_t map;
+	gint volume;
+
+	if (!output->plugin) {
+		xmms_error_set (error, XMMS_ERROR_GENERIC,
+		                "couldn't get volume, output plugin not loaded");
+		return NULL;
+	}
+
+	volume = g_atomic_int_get (&output->softvol_volume);
+	if (volume >= 0) {
+		return xmmsv_build_dict (XMMSV_DICT_ENTRY_INT (SOFTVOL_CHANNEL, volume),
+		                         XMMSV_DICT_END);
+	}
+
+	if (!xmms_output_plugin_method_volume_get_available (output->plugin)) {
+		xmms_error_set (error, XMMS_ERROR_GENERIC,
+		                "operation not supported");
+		return NULL;
+	}
+
+	xmms_error_set (error, XMMS_ERROR_GENERIC,
+	                "couldn't get volume");
+
+	xmms_volume_map_init (&map);
+
+	/* ask the plugin how much channels it would like to set */
+	if (!xmms_output_plugin_method_volume_get (output->plugin, output,
+	                                           NULL, NULL, &map.num_channels)) {
+		return NULL;
+	}
+
+	/* check for sane values */
+	g_return_val_if_fail (map.num_channels > 0, NULL);
+	g_return_val_if_fail (map.num_channels <= VOLUME_MAX_CHANNELS, NULL);
+
+	map.names = g_new (const gchar *, map.num_channels);
+	map.values = g_new (guint, map.num_channels);
+
+	map.status = xmms_output_plugin_method_volume_get (output->plugin, output,
+	                                                   map.names, map.values,
+	                                                   &map.num_channels);
+
+	if (!map.status || !map.num_channels) {
+		return NULL; /* error is set (-> no leak) */
+	}
+
+	ret = xmms_volume_map_to_dict (&map);
+
+	/* success! */
+	xmms_error_reset (error);
+
+	return ret;
+}
+
+static xmmsv_t *
+xmms_playback_client_underruns (xmms_output_t *output, xmms_error_t *error)
+{
+	xmmsv_t *times;
+	gint i, count;
+
+	times = xmmsv_new_list ();
+
+	g_mutex_lock (&output->playtime_mutex);
+
+	count = output->buffer_underruns;
+	for (i = MAX (0, count - UNDERRUN_HISTORY); i < count; i++) {
+		xmmsv_list_append_int (times, output->underrun_times[i % UNDERRUN_HISTORY]);
+	}
+
+	g_mutex_unlock (&output->playtime_mutex);
+
+	return xmmsv_build_dict (XMMSV_DICT_ENTRY_INT ("count", count),
+	                         XMMSV_DICT_ENTRY ("times", times),
+	                         XMMSV_DICT_END);
+}
+
+static xmmsv_t *
+xmms_playback_client_buffer_stats (xmms_output_t *output, xmms_error_t *error)
+{
+	gint size, grows, shrinks, seeks, seeks_buffered;
+	gint64 seek_last, seek_max;
+
+	g_mutex_lock (&output->filler_mutex);
+	size = xmms_ringbuf_size (output->filler_buffer);
+	grows = output->adapt_grows;
+	shrinks = output->adapt_shrinks;
+	seeks_buffered = output->seeks_buffered;
+	g_mutex_unlock (&output->filler_mutex);
+
+	g_mutex_lock (&output->playtime_mutex);
+	seeks = output->seeks;
+	seek_last = output->seek_latency_last;
+	seek_max = output->seek_latency_max;
+	g_mutex_unlock (&output->playtime_mutex);
+
+	return xmmsv_build_dict (XMMSV_DICT_ENTRY_INT ("adaptive", g_atomic_int_get (&output->adapt_enabled)),
+	                         XMMSV_DICT_ENTRY_INT ("buffer_size", size),
+	                         XMMSV_DICT_ENTRY_INT ("buffer_grows", grows),
+	                         XMMSV_DICT_ENTRY_INT ("buffer_shrinks", shrinks),
+	                         XMMSV_DICT_ENTRY_INT ("seeks", seeks),
+	                         XMMSV_DICT_ENTRY_INT ("seeks_buffered", seeks_buffered),
+	                         XMMSV_DICT_ENTRY_INT ("seek_latency_last", seek_last),
+	                         XMMSV_DICT_ENTRY_INT ("seek_latency_max", seek_max),
+	                         XMMSV_DICT_END);
+}
+
+static xmmsv_t *
+xmms_playback_client_chain_stats (xmms_output_t *output, xmms_error_t *error)
+{
+	xmms_xform_t *chain;
+	xmmsv_t *ret, *xforms;
+	gint64 wait_time, waits;
+	gint conversions = 0;
+
+	g_mutex_lock (&output->filler_mutex);
+	chain = output->filler_chain;
+	if (chain) {
+		xmms_object_ref (chain);
+		conversions = output->conversions;
+	}
+	wait_time = output->filler_wait_time;
+	waits = output->filler_waits;
+	g_mutex_unlock (&output->filler_mutex);
+
+	if (chain) {
+		xforms = xmms_xform_profile_get (chain);
+		xmms_object_unref (chain);
+	} else {
+		xforms = xmmsv_new_list ();
+	}
+
+	ret = xmmsv_build_dict (XMMSV_DICT_ENTRY_INT ("enabled", xmms_xform_profile_enabled ()),
+	                        XMMSV_DICT_ENTRY ("chain", xforms),
+	                        XMMSV_DICT_ENTRY_INT ("filler_waits", waits),
+	                        XMMSV_DICT_ENTRY_INT ("filler_wait_time", wait_time * 1000),
+	                        XMMSV_DICT_ENTRY_INT ("conversions", conversions),
+	                        XMMSV_DICT_END);
+
+	return ret;
+}
+
+static xmms_output_t *
+xmms_output_zone_get (xmms_output_t *output, const gchar *name,
+                      xmms_error_t *error)
+{
+	xmms_output_t *zone = NULL;
+
+	g_mutex_lock (&output->zones_mutex);
+	if (output->zones) {
+		zone = g_hash_table_lookup (output->zones, name);
+	}
+	if (zone) {
+		xmms_object_ref (zone);
+	}
+	g_mutex_unlock (&output->zones_mutex);
+
+	if (!zone) {
+		xmms_error_set (error, XMMS_ERROR_NOENT, "no such zone");
+	}
+
+	return zone;
+}
+
+static xmmsv_t *
+xmms_output_zone_stats (xmms_output_t *zone)
+{
+	const gchar *plugin = "";
+	gint size, underruns;
+
+	if (zone->plugin) {
+		plugin = xmms_plugin_shortname_get ((xmms_plugin_t *) zone->plugin);
+	}
+
+	g_mutex_lock (&zone->filler_mutex);
+	size = xmms_ringbuf_size (zone->filler_buffer);
+	g_mutex_unlock (&zone->filler_mutex);
+
+	g_mutex_lock (&zone->playtime_mutex);
+	underruns = zone->buffer_underruns;
+	g_mutex_unlock (&zone->playtime_mutex);
+
+	return xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("name", zone->name),
+	                         XMMSV_DICT_ENTRY_STR ("playlist", zone->playlist_name),
+	                         XMMSV_DICT_ENTRY_STR ("plugin", plugin),
+	                         XMMSV_DICT_ENTRY_INT ("status", xmms_playback_client_status (zone, NULL)),
+	                         XMMSV_DICT_ENTRY_INT ("playtime", g_atomic_int_get (&zone->played_time)),
+	                         XMMSV_DICT_ENTRY_INT ("current_id", zone->current_entry),
+	                         XMMSV_DICT_ENTRY_INT ("underruns", underruns),
+	                         XMMSV_DICT_ENTRY_INT ("buffer_size", size),
+	                         XMMSV_DICT_END);
+}
+
+static xmmsv_t *
+xmms_playback_client_zone_list (xmms_output_t *output, xmms_error_t *error)
+{
+	GList *zones, *n;
+	xmmsv_t *ret;
+
+	g_mutex_lock (&output->zones_mutex);
+	zones = output->zones ? g_hash_table_get_values (output->zones) : NULL;
+	for (n = zones; n; n = g_list_next (n)) {
+		xmms_object_ref (n->data);
+	}
+	g_mutex_unlock (&output->zones_mutex);
+
+	ret = xmmsv_new_list ();
+
+	for (n = zones; n; n = g_list_next (n)) {
+		xmmsv_t *stats = xmms_output_zone_stats (n->data);
+
+		xmmsv_list_append (ret, stats);
+		xmmsv_unref (stats);
+		xmms_object_unref (n->data);
+	}
+	g_list_free (zones);
+
+	return ret;
+}
+
+static void
+xmms_playback_client_zone_start (xmms_output_t *output, const gchar *name,
+                                 xmms_error_t *error)
+{
+	xmms_output_t *zone;
+
+	zone = xmms_output_zone_get (output, name, error);
+	if (zone) {
+		xmms_playback_client_start (zone, error);
+		xmms_object_unref (zone);
+	}
+}
+
+static void
+xmms_playback_client_zone_stop (xmms_output_t *output, const gchar *name,
+                                xmms_error_t *error)
+{
+	xmms_output_t *zone;
+
+	zone = xmms_output_zone_get (output, name, error);
+	if (zone) {
+		xmms_playback_client_stop (zone, error);
+		xmms_object_unref (zone);
+	}
+}
+
+/**
+ * Get a referenced copy of the list of sinks.
+ */
+static GList *
+xmms_output_sinks_get (xmms_output_t *output)
+{
+	GList *sinks = NULL, *n;
+
+	g_mutex_lock (&output->sinks_mutex);
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_object_ref (n->data);
+		sinks = g_list_prepend (sinks, n->data);
+	}
+	g_mutex_unlock (&output->sinks_mutex);
+
+	return g_list_reverse (sinks);
+}
+
+static xmmsv_t *
+xmms_output_sink_stats (xmms_output_t *sink)
+{
+	const gchar *plugin = "";
+	gint size, used, underruns;
+	gint64 dropped;
+
+	if (sink->plugin) {
+		plugin = xmms_plugin_shortname_get ((xmms_plugin_t *) sink->plugin);
+	}
+
+	g_mutex_lock (&sink->filler_mutex);
+	size = xmms_ringbuf_size (sink->filler_buffer);
+	used = xmms_ringbuf_bytes_used (sink->filler_buffer);
+	dropped = sink->sink_dropped;
+	g_mutex_unlock (&sink->filler_mutex);
+
+	g_mutex_lock (&sink->playtime_mutex);
+	underruns = sink->buffer_underruns;
+	g_mutex_unlock (&sink->playtime_mutex);
+
+	return xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("name", sink->name),
+	                         XMMSV_DICT_ENTRY_STR ("plugin", plugin),
+	                         XMMSV_DICT_ENTRY_INT ("status", xmms_playback_client_status (sink, NULL)),
+	                         XMMSV_DICT_ENTRY_INT ("buffer_size", size),
+	                         XMMSV_DICT_ENTRY_INT ("buffered", used),
+	                         XMMSV_DICT_ENTRY_INT ("dropped", dropped),
+	                         XMMSV_DICT_ENTRY_INT ("underruns", underruns),
+	                         XMMSV_DICT_END);
+}
+
+static xmmsv_t *
+xmms_playback_client_sink_list (xmms_output_t *output, xmms_error_t *error)
+{
+	GList *sinks, *n;
+	xmmsv_t *ret;
+
+	sinks = xmms_output_sinks_get (output);
+
+	ret = xmmsv_new_list ();
+
+	for (n = sinks; n; n = g_list_next (n)) {
+		xmmsv_t *stats = xmms_output_sink_stats (n->data);
+
+		xmmsv_list_append (ret, stats);
+		xmmsv_unref (stats);
+	}
+	g_list_free_full (sinks, xmms_object_unref);
+
+	return ret;
+}
+
+/**
+ * Get the current playtime in milliseconds.
+ */
+static gint32
+xmms_playback_client_playtime (xmms_output_t *output, xmms_error_t *error)
+{
+	g_return_val_if_fail (output, 0);
+
+	return g_atomic_int_get (&output->played_time);
+}
+
+/* returns the current latency: time left in ms until the data currently read
+ *                              from the latest xform in the chain will actually be played
+ */
+guint32
+xmms_output_latency (xmms_output_t *output)
+{
+	guint ret = 0;
+	guint buffersize = 0;
+
+	if (output->format) {
+		/* data already waiting in the ringbuffer */
+		buffersize += xmms_ringbuf_bytes_used (output->filler_buffer);
+
+		/* latency of the soundcard */
+		buffersize += xmms_output_plugin_method_latency_get (output->plugin, output);
+
+		ret = xmms_sample_bytes_to_ms (output->format, buffersize);
+	}
+
+	return ret;
+}
+
+/**
+ * @internal
+ */
+
+static gboolean
+xmms_output_status_set (xmms_output_t *output, gint status)
+{
+	gboolean ret = TRUE;
+
+	if (!output->plugin) {
+		XMMS_DBG ("No plugin to set status on..");
+		return FALSE;
+	}
+
+	g_mutex_lock (&output->status_mutex);
+
+	if (output->status != status) {
+		if (status == XMMS_PLAYBACK_STATUS_PAUSE &&
+		    output->status != XMMS_PLAYBACK_STATUS_PLAY) {
+			XMMS_DBG ("Can only pause from play.");
+			ret = FALSE;
+		} else {
+			output->status = status;
+
+			if (status == XMMS_PLAYBACK_STATUS_STOP) {
+				xmms_object_unref (output->format);
+				output->format = NULL;
+			}
+			if (!xmms_output_plugin_method_status (output->plugin, output, status)) {
+				xmms_log_error ("Status method returned an error!");
+				output->status = XMMS_PLAYBACK_STATUS_STOP;
+				ret = FALSE;
+			}
+
+			xmms_object_emit (XMMS_OBJECT (output),
+			                  XMMS_IPC_SIGNAL_PLAYBACK_STATUS,
+			                  xmmsv_new_int (output->status));
+		}
+	}
+
+	g_mutex_unlock (&output->status_mutex);
+
+	/* sinks follow the output feeding them */
+	if (ret) {
+		xmms_output_sinks_status_set (output, status);
+	}
+
+	return ret;
+}
+
+static void
+xmms_output_destroy (xmms_object_t *object)
+{
+	xmms_output_t *output = (xmms_output_t *)object;
+
+	XMMS_DBG ("Deactivating output object.");
+
+	if (output->zones) {
+		g_hash_table_destroy (output->zones);
+		g_hash_table_destroy (output->zones_watched);
+	}
+
+	output->monitor_volume_running = FALSE;
+	if (output->monitor_volume_thread) {
+		g_thread_join (output->monitor_volume_thread);
+		output->monitor_volume_thread = NULL;
+	}
+
+	if (output->filler_thread) {
+		xmms_output_filler_state (output, FILLER_QUIT);
+		g_thread_join (output->filler_thread);
+	}
+
+	/* nothing feeds the sinks anymore */
+	xmms_output_sinks_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
+	g_list_free_full (output->sinks, xmms_object_unref);
+
+	if (output->notifier_thread) {
+		g_mutex_lock (&output->notifier_mutex);
+		output->notifier_running = FALSE;
+		g_cond_signal (&output->notifier_cond);
+		g_mutex_unlock (&output->notifier_mutex);
+		g_thread_join (output->notifier_thread);
+	}
+
+	if (output->plugin) {
+		xmms_output_plugin_method_destroy (output->plugin, output);
+		xmms_object_unref (output->plugin);
+	}
+	xmms_output_format_list_clear (output);
+
+	xmms_object_unref (output->playlist);
+	xmms_object_unref (output->medialib);
+
+	g_free (output->playlist_name);
+	g_free (output->name);
+	g_free (output->config_prefix);
+
+	if (output->sink_to) {
+		xmms_output_sink_format_clear (output);
+	}
+
+	g_mutex_clear (&output->zones_mutex);
+	g_mutex_clear (&output->sinks_mutex);
+	g_mutex_clear (&output->status_mutex);
+	g_mutex_clear (&output->playtime_mutex);
+	g_queue_clear (&output->notify_entries);
+	g_mutex_clear (&output->notifier_mutex);
+	g_cond_clear (&output->notifier_cond);
+	g_mutex_clear (&output->filler_mutex);
+	g_cond_clear (&output->filler_state_cond);
+	xmms_ringbuf_destroy (output->filler_buffer);
+
+	if (!output->name) {
+		xmms_playback_unregister_ipc_commands ();
+	}
+}
+
+/**
+ * Switch to another output plugin.
+ * @param output output pointer
+ * @param new_plugin the new #xmms_plugin_t to use as output.
+ * @returns TRUE on success and FALSE on failure
+ */
+gboolean
+xmms_output_plugin_switch (xmms_output_t *output, xmms_output_plugin_t *new_plugin)
+{
+	xmms_output_plugin_t *old_plugin;
+	gboolean ret;
+
+	g_return_val_if_fail (output, FALSE);
+	g_return_val_if_fail (new_plugin, FALSE);
+
+	xmms_playback_client_stop (output, NULL);
+
+	g_mutex_lock (&output->status_mutex);
+
+	old_plugin = output->plugin;
+
+	ret = set_plugin (output, new_plugin);
+
+	/* if the switch succeeded, release the reference to the old plugin
+	 * now.
+	 * if we couldn't switch to the new plugin, but we had a working
+	 * plugin before, switch back to the old plugin.
+	 */
+	if (ret) {
+		xmms_object_unref (old_plugin);
+	} else if (old_plugin) {
+		XMMS_DBG ("cannot switch plugin, going back to old one");
+		set_plugin (output, old_plugin);
+	}
+
+	g_mutex_unlock (&output->status_mutex);
+
+	return ret;
+}
+
+static void
+on_profile_changed (xmms_object_t *object, xmmsv_t *_data, gpointer udata)
+{
+	xmms_output_t *output = udata;
+	gint value;
+
+	value = xmms_config_property_get_int ((xmms_config_property_t *) object);
+
+	g_mutex_lock (&output->filler_mutex);
+	output->filler_wait_time = 0;
+	output->filler_waits = 0;
+	g_mutex_unlock (&output->filler_mutex);
+
+	xmms_xform_profile_set (value);
+}
+
+/**
+ * Apply the output.realtime and output.cpu_affinity settings to the
+ * calling thread. Called by the threads that feed the sound card when
+ * they start, changes take effect the next time they are started.
+ *
+ * @param name thread name for the log
+ * @param offset added to the configured priority, so the writer can
+ * run above the filler
+ */
+void
+xmms_output_realtime_enter (const gchar *name, gint offset)
+{
+	xmms_config_property_t *prop;
+	const gchar *cpus, *policy;
+	gint priority;
+
+	prop = xmms_config_lookup ("output.cpu_affinity");
+	cpus = prop ? xmms_config_property_get_string (prop) : NULL;
+	if (cpus && *cpus && xmms_realtime_thread_affinity_set (cpus)) {
+		XMMS_DBG ("Output %s thread bound to CPUs %s", name, cpus);
+	}
+
+	prop = xmms_config_lookup ("output.realtime");
+	if (!prop || !xmms_config_property_get_int (prop)) {
+		return;
+	}
+
+	prop = xmms_config_lookup ("output.realtime_policy");
+	policy = xmms_config_property_get_string (prop);
+
+	prop = xmms_config_lookup ("output.realtime_priority");
+	priority = xmms_config_property_get_int (prop) + offset;
+
+	if (xmms_realtime_thread_set (g_ascii_strcasecmp (policy, "rr") == 0,
+	                              priority)) {
+		XMMS_DBG ("Output %s thread running at real-time priority %d",
+		          name, priority);
+	}
+}
+
+static void
+on_notify_interval_changed (xmms_object_t *object, xmmsv_t *_data,
+                            gpointer udata)
+{
+	xmms_output_t *output = udata;
+	gint value;
+
+	value = xmms_config_property_get_int ((xmms_config_property_t *) object);
+
+	g_atomic_int_set (&output->notify_interval, CLAMP (value, 10, 1000));
+}
+
+static void
+on_adaptive_buffer_changed (xmms_object_t *object, xmmsv_t *_data,
+                            gpointer udata)
+{
+	xmms_output_t *output = udata;
+	xmms_config_property_t *prop;
+	gint value;
+
+	value = xmms_config_property_get_int ((xmms_config_property_t *) object);
 
-	return ret;
+	g_mutex_lock (&output->filler_mutex);
+	xmms_output_buffer_adapt_reset (output);
+	if (!value) {
+		/* back to the configured size */
+		prop = xmms_config_lookup ("output.buffersize");
+		xmms_ringbuf_resize (output->filler_buffer,
+		                     xmms_config_property_get_int (prop));
+	}
+	g_mutex_unlock (&output->filler_mutex);
+
+	g_atomic_int_set (&output->adapt_enabled, value);
 }
 
-gint
-xmms_output_bytes_available (xmms_output_t *output)
+static void
+on_crossfade_changed (xmms_object_t *object, xmmsv_t *_data, gpointer udata)
 {
-	return xmms_ringbuf_bytes_used (output->filler_buffer);
+	xmms_output_t *output = udata;
+	gint value;
+
+	value = xmms_config_property_get_int ((xmms_config_property_t *) object);
+
+	g_atomic_int_set (&output->crossfade_ms, MAX (value, 0));
 }
 
-xmms_config_property_t *
-xmms_output_config_property_register (xmms_output_t *output, const gchar *name, const gchar *default_value, xmms_object_handler_t cb, gpointer userdata)
+static void
+on_software_volume_changed (xmms_object_t *object, xmmsv_t *_data, gpointer udata)
 {
-	g_return_val_if_fail (output->plugin, NULL);
-	return xmms_plugin_config_property_register ((xmms_plugin_t *)output->plugin, name, default_value, cb, userdata);
+	xmms_output_t *output = udata;
+	gint value;
+
+	/* a plugin with a mixer doesn't use it */
+	if (g_atomic_int_get (&output->softvol_volume) < 0) {
+		return;
+	}
+
+	value = CLAMP (xmms_config_property_get_int ((xmms_config_property_t *) object), 0, 100);
+	g_atomic_int_set (&output->softvol_volume, value);
+
+	xmms_object_emit (XMMS_OBJECT (output),
+	                  XMMS_IPC_SIGNAL_PLAYBACK_VOLUME_CHANGED,
+	                  xmmsv_build_dict (XMMSV_DICT_ENTRY_INT (SOFTVOL_CHANNEL, value),
+	                                    XMMSV_DICT_END));
 }
 
-xmms_config_property_t *
-xmms_output_config_lookup (xmms_output_t *output, const gchar *path)
+/**
+ * Set up an output playing the given playlist, or a sink fed by
+ * another output when playlist_name is NULL. Only the main output,
+ * which has no config section, watches the output config values and
+ * broadcasts its state.
+ *
+ * @param section "zones" or "sinks", NULL for the main output
+ * @param name the name of the zone or sink
+ */
+static xmms_output_t *
+xmms_output_create (xmms_output_plugin_t *plugin, xmms_playlist_t *playlist,
+                    xmms_medialib_t *medialib, const gchar *section,
+                    const gchar *name, const gchar *playlist_name)
 {
-	g_return_val_if_fail (output->plugin, NULL);
-	return xmms_plugin_config_lookup ((xmms_plugin_t *)output->plugin, path);
+	xmms_output_t *output;
+	xmms_config_property_t *prop;
+	gboolean main_output = !section;
+	gint size;
+
+	output = xmms_object_new (xmms_output_t, xmms_output_destroy);
+
+	xmms_object_ref (playlist);
+	output->playlist = playlist;
+
+	xmms_object_ref (medialib);
+	output->medialib = medialib;
+
+	output->name = g_strdup (name);
+	output->playlist_name = g_strdup (playlist_name);
+	if (section) {
+		output->config_prefix = g_strdup_printf ("%s.%s", section, name);
+	}
+
+	g_mutex_init (&output->zones_mutex);
+	g_mutex_init (&output->sinks_mutex);
+	g_mutex_init (&output->status_mutex);
+	g_mutex_init (&output->playtime_mutex);
+
+	prop = xmms_config_property_register ("output.buffersize", "32768", NULL, NULL);
+	if (!playlist_name) {
+		prop = xmms_config_property_register ("output.sink_buffersize",
+		                                      "131072", NULL, NULL);
+	}
+	size = xmms_config_property_get_int (prop);
+	XMMS_DBG ("Using buffersize %d", size);
+
+	xmms_config_property_register ("output.realtime", "0", NULL, NULL);
+	xmms_config_property_register ("output.realtime_policy", "fifo", NULL, NULL);
+	xmms_config_property_register ("output.realtime_priority", "10", NULL, NULL);
+	xmms_config_property_register ("output.cpu_affinity", "", NULL, NULL);
+	prop = xmms_config_property_register ("output.mlock", "0", NULL, NULL);
+	xmms_config_property_register ("output.float_pipeline", "0", NULL, NULL);
+
+	g_mutex_init (&output->filler_mutex);
+	output->filler_state = FILLER_STOP;
+	g_cond_init (&output->filler_state_cond);
+	output->filler_buffer = xmms_ringbuf_new (size);
+	if (xmms_config_property_get_int (prop)) {
+		xmms_ringbuf_mlock (output->filler_buffer);
+	}
+	xmms_output_buffer_adapt_reset (output);
+
+	xmms_config_property_register ("output.buffer_min_ms", "100", NULL, NULL);
+	xmms_config_property_register ("output.buffer_max_ms", "2000", NULL, NULL);
+	prop = xmms_config_property_register ("output.adaptive_buffer", "0",
+	                                      main_output ? on_adaptive_buffer_changed : NULL,
+	                                      output);
+	output->adapt_enabled = xmms_config_property_get_int (prop);
+
+	prop = xmms_config_property_register ("output.crossfade_ms", "0",
+	                                      main_output ? on_crossfade_changed : NULL,
+	                                      output);
+	output->crossfade_ms = MAX (xmms_config_property_get_int (prop), 0);
+	xmms_config_property_register ("output.crossfade_curve", "equal_power", NULL, NULL);
+
+	if (playlist_name) {
+		output->filler_thread = g_thread_new ("x2 out filler", xmms_output_filler, output);
+	}
+
+	xmms_config_property_register ("output.flush_on_pause", "1", NULL, NULL);
+
+	g_mutex_init (&output->notifier_mutex);
+	g_cond_init (&output->notifier_cond);
+	g_queue_init (&output->notify_entries);
+
+	output->softvol_volume = -1;
+	output->softvol_applied = G_MININT;
+	xmms_softvol_init (&output->softvol, 1.0f);
+
+	if (main_output) {
+		xmms_config_property_register ("output.software_volume", "100",
+		                               on_software_volume_changed, output);
+
+		prop = xmms_config_property_register ("output.profile", "0",
+		                                      on_profile_changed, output);
+		xmms_xform_profile_set (xmms_config_property_get_int (prop));
+
+		prop = xmms_config_property_register ("output.notify_interval", "100",
+		                                      on_notify_interval_changed, output);
+		on_notify_interval_changed (XMMS_OBJECT (prop), NULL, output);
+
+		output->notifier_running = TRUE;
+		output->notifier_thread = g_thread_new ("x2 out notifier",
+		                                        xmms_output_notifier_thread,
+		                                        output);
+	}
+
+	output->status = XMMS_PLAYBACK_STATUS_STOP;
+
+	if (plugin) {
+		if (!set_plugin (output, plugin)) {
+			xmms_log_error ("Could not initialize output plugin");
+		}
+	} else {
+		xmms_log_error ("initialized output without a plugin, please fix!");
+	}
+
+	return output;
 }
 
-xmms_medialib_entry_t
-xmms_output_current_id (xmms_output_t *output)
+/**
+ * Allocate a new #xmms_output_t
+ */
+xmms_output_t *
+xmms_output_new (xmms_output_plugin_t *plugin, xmms_playlist_t *playlist, xmms_medialib_t *medialib)
 {
-	g_return_val_if_fail (output, 0);
-	return output->current_entry;
-}
+	xmms_output_t *output;
 
+	g_return_val_if_fail (playlist, NULL);
 
-/** @addtogroup Output
- * @{
+	XMMS_DBG ("Trying to open output");
+
+	output = xmms_output_create (plugin, playlist, medialib, NULL, NULL,
+	                             XMMS_ACTIVE_PLAYLIST);
+
+	xmms_playback_register_ipc_commands (XMMS_OBJECT (output));
+
+	xmms_output_sinks_init (output);
+	xmms_output_zones_init (output);
+
+	return output;
+}
+
+/**
+ * Create the zone called name from its zones.<name>.plugin and
+ * zones.<name>.playlist config values, replacing the old one.
  */
-/** Methods */
 static void
-xmms_playback_client_tickle (xmms_output_t *output, xmms_error_t *error)
+xmms_output_zone_add (xmms_output_t *output, const gchar *name)
 {
-	xmms_output_filler_state (output, FILLER_KILL);
+	xmms_output_plugin_t *plugin, *instance = NULL;
+	xmms_config_property_t *plugin_prop, *playlist_prop;
+	xmms_object_handler_t cb = NULL;
+	xmms_output_t *zone;
+	const gchar *plugin_name;
+	gchar *path;
+
+	g_mutex_lock (&output->zones_mutex);
+	if (!g_hash_table_contains (output->zones_watched, name)) {
+		g_hash_table_add (output->zones_watched, g_strdup (name));
+		cb = on_zone_changed;
+	}
+	g_mutex_unlock (&output->zones_mutex);
+
+	path = g_strdup_printf ("zones.%s.plugin", name);
+	plugin_prop = xmms_config_property_register (path, "", cb, output);
+	g_free (path);
+
+	path = g_strdup_printf ("zones.%s.playlist", name);
+	playlist_prop = xmms_config_property_register (path, name, cb, output);
+	g_free (path);
+
+	/* an empty plugin name means the same plugin as the main output */
+	plugin_name = xmms_config_property_get_string (plugin_prop);
+	if (!*plugin_name) {
+		plugin_name = xmms_config_property_get_string (xmms_config_lookup ("output.plugin"));
+	}
+
+	plugin = (xmms_output_plugin_t *) xmms_plugin_find (XMMS_PLUGIN_TYPE_OUTPUT,
+	                                                    plugin_name);
+	if (plugin) {
+		instance = xmms_output_plugin_instance_new (plugin);
+		xmms_object_unref (plugin);
+	} else {
+		xmms_log_error ("Zone %s: no output plugin '%s'", name, plugin_name);
+	}
+
+	zone = xmms_output_create (instance, output->playlist, output->medialib,
+	                           "zones", name,
+	                           xmms_config_property_get_string (playlist_prop));
+
+	xmms_log_info ("Zone %s plays playlist %s with %s", name,
+	               zone->playlist_name, plugin_name);
+
+	g_mutex_lock (&output->zones_mutex);
+	g_hash_table_replace (output->zones, zone->name, zone);
+	g_mutex_unlock (&output->zones_mutex);
 }
 
 static void
-xmms_playback_client_seek_ms (xmms_output_t *output, gint32 ms, gint32 whence, xmms_error_t *error)
+xmms_output_zone_remove (xmms_output_t *output, const gchar *name)
 {
-	guint samples;
-
-	g_return_if_fail (output);
+	xmms_output_t *zone;
 
-	if (whence == XMMS_PLAYBACK_SEEK_CUR) {
-		g_mutex_lock (&output->playtime_mutex);
-		ms += output->played_time;
-		if (ms < 0) {
-			ms = 0;
-		}
-		g_mutex_unlock (&output->playtime_mutex);
+	g_mutex_lock (&output->zones_mutex);
+	zone = g_hash_table_lookup (output->zones, name);
+	if (zone) {
+		g_hash_table_steal (output->zones, name);
 	}
+	g_mutex_unlock (&output->zones_mutex);
 
-	if (output->format) {
-		samples = xmms_sample_ms_to_samples (output->format, ms);
-
-		xmms_playback_client_seek_samples (output, samples,
-		                                   XMMS_PLAYBACK_SEEK_SET, error);
+	if (zone) {
+		xmms_log_info ("Removing zone %s", name);
+		xmms_playback_client_stop (zone, NULL);
+		xmms_object_unref (zone);
 	}
 }
 
 static void
-xmms_playback_client_seek_samples (xmms_output_t *output, gint32 samples, gint32 whence, xmms_error_t *error)
+on_zone_changed (xmms_object_t *object, xmmsv_t *_data, gpointer udata)
 {
-	if (whence == XMMS_PLAYBACK_SEEK_CUR) {
-		g_mutex_lock (&output->playtime_mutex);
-		samples += output->played / xmms_sample_frame_size_get (output->format);
-		if (samples < 0) {
-			samples = 0;
-		}
-		g_mutex_unlock (&output->playtime_mutex);
+	xmms_output_t *output = udata;
+	const gchar *path;
+	gboolean exists;
+	gchar *name;
+
+	/* zones.<name>.<key> */
+	path = xmms_config_property_get_name ((xmms_config_property_t *) object);
+	name = g_strndup (path + strlen ("zones."),
+	                  strrchr (path, '.') - path - strlen ("zones."));
+
+	g_mutex_lock (&output->zones_mutex);
+	exists = g_hash_table_contains (output->zones, name);
+	g_mutex_unlock (&output->zones_mutex);
+
+	/* the plugin and playlist are fixed for the life of a zone */
+	if (exists) {
+		xmms_output_zone_remove (output, name);
+		xmms_output_zone_add (output, name);
 	}
 
-	/* "just" tell filler */
-	xmms_output_filler_seek_state (output, samples);
+	g_free (name);
 }
 
-static void
-xmms_playback_client_start (xmms_output_t *output, xmms_error_t *err)
+static gboolean
+xmms_output_zone_wanted (gchar **wanted, const gchar *name)
 {
-	g_return_if_fail (output);
+	gint i;
 
-	xmms_output_filler_state (output, FILLER_RUN);
-	if (!xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_PLAY)) {
-		xmms_output_filler_state (output, FILLER_STOP);
-		xmms_error_set (err, XMMS_ERROR_GENERIC, "Could not start playback");
+	for (i = 0; wanted[i]; i++) {
+		if (strcmp (wanted[i], name) == 0) {
+			return TRUE;
+		}
 	}
 
+	return FALSE;
 }
 
 static void
-xmms_playback_client_stop (xmms_output_t *output, xmms_error_t *err)
+on_zones_changed (xmms_object_t *object, xmmsv_t *_data, gpointer udata)
 {
-	g_return_if_fail (output);
+	xmms_output_t *output = udata;
+	GList *names, *n;
+	gchar **wanted;
+	gint i;
 
-	xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_STOP);
+	wanted = g_strsplit (xmms_config_property_get_string ((xmms_config_property_t *) object), ",", 0);
+	for (i = 0; wanted[i]; i++) {
+		g_strstrip (wanted[i]);
+	}
 
-	xmms_output_filler_state (output, FILLER_STOP);
+	g_mutex_lock (&output->zones_mutex);
+	names = g_hash_table_get_keys (output->zones);
+	for (n = names; n; n = g_list_next (n)) {
+		n->data = g_strdup (n->data);
+	}
+	g_mutex_unlock (&output->zones_mutex);
+
+	for (n = names; n; n = g_list_next (n)) {
+		if (!xmms_output_zone_wanted (wanted, n->data)) {
+			xmms_output_zone_remove (output, n->data);
+		}
+	}
+	g_list_free_full (names, g_free);
+
+	for (i = 0; wanted[i]; i++) {
+		gboolean exists;
+
+		if (!*wanted[i] || strchr (wanted[i], '.')) {
+			continue;
+		}
+
+		g_mutex_lock (&output->zones_mutex);
+		exists = g_hash_table_contains (output->zones, wanted[i]);
+		g_mutex_unlock (&output->zones_mutex);
+
+		if (!exists) {
+			xmms_output_zone_add (output, wanted[i]);
+		}
+	}
+
+	g_strfreev (wanted);
 }
 
+/**
+ * Start the zones listed in output.zones, a comma separated list of
+ * names. Zones share the medialib, the playlists and the plugins with
+ * the main output, but have their own filler, buffer and plugin
+ * instance.
+ */
 static void
-xmms_playback_client_pause (xmms_output_t *output, xmms_error_t *err)
+xmms_output_zones_init (xmms_output_t *output)
 {
-	g_return_if_fail (output);
+	xmms_config_property_t *prop;
 
-	xmms_output_status_set (output, XMMS_PLAYBACK_STATUS_PAUSE);
+	output->zones = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+	                                       xmms_object_unref);
+	output->zones_watched = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                               g_free, NULL);
+
+	prop = xmms_config_property_register ("output.zones", "",
+	                                      on_zones_changed, output);
+	on_zones_changed (XMMS_OBJECT (prop), NULL, output);
 }
 
+typedef struct {
+	xmms_output_t *sink;
+	xmms_stream_type_t *type;
+	xmms_medialib_entry_t entry;
+	gint gen;
+	gboolean flush;
+} xmms_output_sink_changed_arg_t;
 
-static gint32
-xmms_playback_client_status (xmms_output_t *output, xmms_error_t *error)
+static void
+sink_changed_arg_free (void *data)
 {
-	gint32 ret;
-	g_return_val_if_fail (output, XMMS_PLAYBACK_STATUS_STOP);
+	xmms_output_sink_changed_arg_t *arg = data;
 
-	g_mutex_lock (&output->status_mutex);
-	ret = output->status;
-	g_mutex_unlock (&output->status_mutex);
-	return ret;
+	xmms_object_unref (arg->type);
+	g_free (arg);
 }
 
-static gint
-xmms_playback_client_current_id (xmms_output_t *output, xmms_error_t *error)
+static gboolean
+sink_changed (void *data)
 {
-	return output->current_entry;
-}
+	/* executes in the writer of the sink */
+	xmms_output_sink_changed_arg_t *arg = data;
+	xmms_output_t *sink = arg->sink;
 
-static void
-xmms_playback_client_volume_set (xmms_output_t *output, const gchar *channel,
-                                 gint32 volume, xmms_error_t *error)
-{
+	g_mutex_lock (&sink->playtime_mutex);
+	sink->played = 0;
+	g_mutex_unlock (&sink->playtime_mutex);
 
-	if (!output->plugin) {
-		xmms_error_set (error, XMMS_ERROR_GENERIC,
-		                "couldn't set volume, output plugin not loaded");
-		return;
-	}
+	sink->current_entry = arg->entry;
 
-	if (!xmms_output_plugin_method_volume_set_available (output->plugin)) {
-		xmms_error_set (error, XMMS_ERROR_GENERIC,
-		                "operation not supported");
-		return;
+	if (!xmms_output_format_set (sink, arg->type)) {
+		xmms_log_error ("Sink %s couldn't set the format, skipping the song",
+		                sink->name);
+		g_atomic_int_set (&sink->sink_failed_gen, arg->gen);
+		xmms_ringbuf_clear (sink->filler_buffer);
+		return FALSE;
 	}
 
-	if (volume > 100 || volume < 0) {
-		xmms_error_set (error, XMMS_ERROR_INVAL, "volume out of range");
-		return;
+	if (arg->flush) {
+		xmms_output_flush (sink);
 	}
 
-	if (!xmms_output_plugin_methods_volume_set (output->plugin, output, channel, volume)) {
-		xmms_error_set (error, XMMS_ERROR_GENERIC,
-		                "couldn't set volume");
-	}
+	return TRUE;
 }
 
-static xmmsv_t *
-xmms_playback_client_volume_get (xmms_output_t *output, xmms_error_t *error)
+static void
+xmms_output_sink_format_clear (xmms_output_t *sink)
 {
-	xmmsv_t *ret;
-	xmms_volume_map_t map;
-
-	if (!output->plugin) {
-		xmms_error_set (error, XMMS_ERROR_GENERIC,
-		                "couldn't get volume, output plugin not loaded");
-		return NULL;
+	if (sink->sink_conv) {
+		xmms_object_unref (sink->sink_conv);
+		sink->sink_conv = NULL;
 	}
-
-	if (!xmms_output_plugin_method_volume_get_available (output->plugin)) {
-		xmms_error_set (error, XMMS_ERROR_GENERIC,
-		                "operation not supported");
-		return NULL;
+	if (sink->sink_to) {
+		xmms_object_unref (sink->sink_to);
+		xmms_object_unref (sink->sink_from);
+		sink->sink_to = NULL;
+		sink->sink_from = NULL;
 	}
+}
 
-	xmms_error_set (error, XMMS_ERROR_GENERIC,
-	                "couldn't get volume");
-
-	xmms_volume_map_init (&map);
+/**
+ * Queue a format change at the write position of the sink.
+ * Called with the filler_mutex of the feeding output held.
+ */
+static void
+xmms_output_sink_hotspot_set (xmms_output_t *sink, xmms_medialib_entry_t entry,
+                              gboolean flush)
+{
+	xmms_output_sink_changed_arg_t *arg;
+
+	arg = g_new0 (xmms_output_sink_changed_arg_t, 1);
+	arg->sink = sink;
+	arg->type = sink->sink_to;
+	arg->entry = entry;
+	arg->gen = sink->sink_gen;
+	arg->flush = flush;
+	xmms_object_ref (arg->type);
+
+	g_mutex_lock (&sink->filler_mutex);
+	xmms_ringbuf_hotspot_set (sink->filler_buffer, sink_changed,
+	                          sink_changed_arg_free, arg);
+	g_mutex_unlock (&sink->filler_mutex);
+}
 
-	/* ask the plugin how much channels it would like to set */
-	if (!xmms_output_plugin_method_volume_get (output->plugin, output,
-	                                           NULL, NULL, &map.num_channels)) {
-		return NULL;
-	}
+/**
+ * Pick the format the sink gets the chain's output in, the closest
+ * one its plugin supports. Called with the filler_mutex of the
+ * feeding output held.
+ */
+static void
+xmms_output_sink_chain_set (xmms_output_t *sink, xmms_xform_t *chain,
+                            gboolean flush)
+{
+	xmms_stream_type_t *from, *to;
 
-	/* check for sane values */
-	g_return_val_if_fail (map.num_channels > 0, NULL);
-	g_return_val_if_fail (map.num_channels <= VOLUME_MAX_CHANNELS, NULL);
+	xmms_output_sink_format_clear (sink);
+	sink->sink_gen++;
 
-	map.names = g_new (const gchar *, map.num_channels);
-	map.values = g_new (guint, map.num_channels);
+	from = xmms_xform_outtype_get (chain);
 
-	map.status = xmms_output_plugin_method_volume_get (output->plugin, output,
-	                                                   map.names, map.values,
-	                                                   &map.num_channels);
+	to = xmms_stream_type_coerce (from, sink->format_list);
+	if (!to) {
+		xmms_log_error ("Sink %s supports no format close to the chain's",
+		                sink->name);
+		return;
+	}
 
-	if (!map.status || !map.num_channels) {
-		return NULL; /* error is set (-> no leak) */
+	if (!xmms_stream_type_match (from, to)) {
+		sink->sink_conv = xmms_sample_converter_init (from, to);
+		if (!sink->sink_conv) {
+			xmms_object_unref (to);
+			return;
+		}
 	}
 
-	ret = xmms_volume_map_to_dict (&map);
+	xmms_object_ref (from);
+	sink->sink_from = from;
+	sink->sink_to = to;
 
-	/* success! */
-	xmms_error_reset (error);
+	xmms_output_sink_hotspot_set (sink, xmms_xform_entry_get (chain), flush);
+}
 
-	return ret;
+static void
+xmms_output_sinks_chain_set (xmms_output_t *output, xmms_xform_t *chain,
+                             gboolean flush)
+{
+	GList *n;
+
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_output_sink_chain_set (n->data, chain, flush);
+	}
 }
 
 /**
- * Get the current playtime in milliseconds.
+ * Hand what was read from the chain to the sinks. A sink whose buffer
+ * is full loses the data instead of holding up the output.
  */
-static gint32
-xmms_playback_client_playtime (xmms_output_t *output, xmms_error_t *error)
+static void
+xmms_output_sinks_write (xmms_output_t *output, gchar *buf, gint len)
 {
-	guint32 ret;
-	g_return_val_if_fail (output, 0);
+	GList *n;
 
-	g_mutex_lock (&output->playtime_mutex);
-	ret = output->played_time;
-	g_mutex_unlock (&output->playtime_mutex);
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_output_t *sink = n->data;
+		xmms_sample_t *out = (xmms_sample_t *) buf;
+		guint outlen = len;
 
-	return ret;
+		if (!sink->sink_to ||
+		    g_atomic_int_get (&sink->sink_failed_gen) == sink->sink_gen) {
+			continue;
+		}
+
+		if (sink->sink_conv) {
+			xmms_sample_convert (sink->sink_conv, buf, len, &out, &outlen);
+		}
+
+		g_mutex_lock (&sink->filler_mutex);
+		if (xmms_ringbuf_bytes_free (sink->filler_buffer) >= outlen) {
+			xmms_ringbuf_write (sink->filler_buffer, out, outlen);
+		} else {
+			sink->sink_dropped += outlen;
+		}
+		g_mutex_unlock (&sink->filler_mutex);
+	}
 }
 
-/* returns the current latency: time left in ms until the data currently read
- *                              from the latest xform in the chain will actually be played
- */
-guint32
-xmms_output_latency (xmms_output_t *output)
+static void
+xmms_output_sinks_seek (xmms_output_t *output)
 {
-	guint ret = 0;
-	guint buffersize = 0;
+	GList *n;
 
-	if (output->format) {
-		/* data already waiting in the ringbuffer */
-		buffersize += xmms_ringbuf_bytes_used (output->filler_buffer);
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_output_t *sink = n->data;
 
-		/* latency of the soundcard */
-		buffersize += xmms_output_plugin_method_latency_get (output->plugin, output);
+		g_mutex_lock (&sink->filler_mutex);
+		xmms_ringbuf_clear (sink->filler_buffer);
+		g_mutex_unlock (&sink->filler_mutex);
 
-		ret = xmms_sample_bytes_to_ms (output->format, buffersize);
+		if (!sink->sink_to) {
+			continue;
+		}
+
+		if (sink->sink_conv) {
+			xmms_sample_convert_reset (sink->sink_conv);
+		}
+
+		/* the clear may have dropped a pending format change */
+		xmms_output_sink_hotspot_set (sink, sink->current_entry, TRUE);
 	}
+}
 
-	return ret;
+static void
+xmms_output_sinks_clear (xmms_output_t *output)
+{
+	GList *n;
+
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_output_t *sink = n->data;
+
+		g_mutex_lock (&sink->filler_mutex);
+		xmms_ringbuf_clear (sink->filler_buffer);
+		g_mutex_unlock (&sink->filler_mutex);
+	}
 }
 
 /**
- * @internal
+ * Set the status of a sink. A stopped sink gets no more data, so its
+ * buffer is marked as ending to let the writer drain it and close.
  */
+static void
+xmms_output_sink_status_set (xmms_output_t *sink, gint status)
+{
+	if (status == XMMS_PLAYBACK_STATUS_PLAY) {
+		g_mutex_lock (&sink->filler_mutex);
+		xmms_ringbuf_set_eos (sink->filler_buffer, FALSE);
+		g_mutex_unlock (&sink->filler_mutex);
+	}
 
-static gboolean
-xmms_output_status_set (xmms_output_t *output, gint status)
+	xmms_output_status_set (sink, status);
+
+	if (status == XMMS_PLAYBACK_STATUS_STOP) {
+		g_mutex_lock (&sink->filler_mutex);
+		xmms_ringbuf_set_eos (sink->filler_buffer, TRUE);
+		g_mutex_unlock (&sink->filler_mutex);
+	}
+}
+
+static void
+xmms_output_sinks_status_set (xmms_output_t *output, gint status)
 {
-	gboolean ret = TRUE;
+	GList *sinks, *n;
 
-	if (!output->plugin) {
-		XMMS_DBG ("No plugin to set status on..");
-		return FALSE;
+	sinks = xmms_output_sinks_get (output);
+
+	for (n = sinks; n; n = g_list_next (n)) {
+		xmms_output_sink_status_set (n->data, status);
 	}
 
-	g_mutex_lock (&output->status_mutex);
+	g_list_free_full (sinks, xmms_object_unref);
+}
 
-	if (output->status != status) {
-		if (status == XMMS_PLAYBACK_STATUS_PAUSE &&
-		    output->status != XMMS_PLAYBACK_STATUS_PLAY) {
-			XMMS_DBG ("Can only pause from play.");
-			ret = FALSE;
-		} else {
-			output->status = status;
+static xmms_output_t *
+xmms_output_sink_find (xmms_output_t *output, const gchar *name)
+{
+	GList *n;
 
-			if (status == XMMS_PLAYBACK_STATUS_STOP) {
-				xmms_object_unref (output->format);
-				output->format = NULL;
-			}
-			if (!xmms_output_plugin_method_status (output->plugin, output, status)) {
-				xmms_log_error ("Status method returned an error!");
-				output->status = XMMS_PLAYBACK_STATUS_STOP;
-				ret = FALSE;
-			}
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		xmms_output_t *sink = n->data;
 
-			xmms_object_emit (XMMS_OBJECT (output),
-			                  XMMS_IPC_SIGNAL_PLAYBACK_STATUS,
-			                  xmmsv_new_int (output->status));
+		if (strcmp (sink->name, name) == 0) {
+			return sink;
 		}
 	}
 
-	g_mutex_unlock (&output->status_mutex);
-
-	return ret;
+	return NULL;
 }
 
 static void
-xmms_output_destroy (xmms_object_t *object)
+xmms_output_sink_remove (xmms_output_t *output, const gchar *name)
 {
-	xmms_output_t *output = (xmms_output_t *)object;
+	xmms_output_t *sink;
 
-	XMMS_DBG ("Deactivating output object.");
-
-	output->monitor_volume_running = FALSE;
-	if (output->monitor_volume_thread) {
-		g_thread_join (output->monitor_volume_thread);
-		output->monitor_volume_thread = NULL;
+	g_mutex_lock (&output->filler_mutex);
+	g_mutex_lock (&output->sinks_mutex);
+	sink = xmms_output_sink_find (output, name);
+	if (sink) {
+		output->sinks = g_list_remove (output->sinks, sink);
 	}
+	g_mutex_unlock (&output->sinks_mutex);
+	g_mutex_unlock (&output->filler_mutex);
 
-	xmms_output_filler_state (output, FILLER_QUIT);
-	g_thread_join (output->filler_thread);
-
-	if (output->plugin) {
-		xmms_output_plugin_method_destroy (output->plugin, output);
-		xmms_object_unref (output->plugin);
+	if (sink) {
+		xmms_log_info ("Removing sink %s", name);
+		xmms_output_sink_status_set (sink, XMMS_PLAYBACK_STATUS_STOP);
+		xmms_object_unref (sink);
 	}
-	xmms_output_format_list_clear (output);
-
-	xmms_object_unref (output->playlist);
-	xmms_object_unref (output->medialib);
-
-	g_mutex_clear (&output->status_mutex);
-	g_mutex_clear (&output->playtime_mutex);
-	g_mutex_clear (&output->filler_mutex);
-	g_cond_clear (&output->filler_state_cond);
-	xmms_ringbuf_destroy (output->filler_buffer);
-
-	xmms_playback_unregister_ipc_commands ();
 }
 
+static void on_sink_changed (xmms_object_t *object, xmmsv_t *_data, gpointer udata);
+
 /**
- * Switch to another output plugin.
- * @param output output pointer
- * @param new_plugin the new #xmms_plugin_t to use as output.
- * @returns TRUE on success and FALSE on failure
+ * Create the sink called name, playing through the plugin in
+ * sinks.<name>.plugin, which defaults to the name itself.
  */
-gboolean
-xmms_output_plugin_switch (xmms_output_t *output, xmms_output_plugin_t *new_plugin)
+static void
+xmms_output_sink_add (xmms_output_t *output, const gchar *name)
 {
-	xmms_output_plugin_t *old_plugin;
-	gboolean ret;
+	xmms_output_plugin_t *plugin, *instance;
+	xmms_config_property_t *prop;
+	xmms_object_handler_t cb = NULL;
+	const gchar *plugin_name;
+	xmms_output_t *sink;
+	gint status;
+	gchar *path;
+
+	path = g_strdup_printf ("sinks.%s", name);
+	g_mutex_lock (&output->zones_mutex);
+	if (!g_hash_table_contains (output->zones_watched, path)) {
+		g_hash_table_add (output->zones_watched, path);
+		cb = on_sink_changed;
+	} else {
+		g_free (path);
+	}
+	g_mutex_unlock (&output->zones_mutex);
 
-	g_return_val_if_fail (output, FALSE);
-	g_return_val_if_fail (new_plugin, FALSE);
+	path = g_strdup_printf ("sinks.%s.plugin", name);
+	prop = xmms_config_property_register (path, name, cb, output);
+	g_free (path);
 
-	xmms_playback_client_stop (output, NULL);
+	plugin_name = xmms_config_property_get_string (prop);
+	plugin = (xmms_output_plugin_t *) xmms_plugin_find (XMMS_PLUGIN_TYPE_OUTPUT,
+	                                                    plugin_name);
+	if (!plugin) {
+		xmms_log_error ("Sink %s: no output plugin '%s'", name, plugin_name);
+		return;
+	}
 
-	g_mutex_lock (&output->status_mutex);
+	instance = xmms_output_plugin_instance_new (plugin);
+	xmms_object_unref (plugin);
 
-	old_plugin = output->plugin;
+	sink = xmms_output_create (instance, output->playlist, output->medialib,
+	                           "sinks", name, NULL);
+	if (!sink->plugin) {
+		xmms_object_unref (sink);
+		return;
+	}
 
-	ret = set_plugin (output, new_plugin);
+	xmms_log_info ("Sink %s plays through %s", name, plugin_name);
 
-	/* if the switch succeeded, release the reference to the old plugin
-	 * now.
-	 * if we couldn't switch to the new plugin, but we had a working
-	 * plugin before, switch back to the old plugin.
-	 */
-	if (ret) {
-		xmms_object_unref (old_plugin);
-	} else if (old_plugin) {
-		XMMS_DBG ("cannot switch plugin, going back to old one");
-		set_plugin (output, old_plugin);
+	g_mutex_lock (&output->filler_mutex);
+	g_mutex_lock (&output->sinks_mutex);
+	output->sinks = g_list_append (output->sinks, sink);
+	g_mutex_unlock (&output->sinks_mutex);
+	if (output->filler_chain) {
+		xmms_output_sink_chain_set (sink, output->filler_chain, FALSE);
 	}
+	g_mutex_unlock (&output->filler_mutex);
 
+	g_mutex_lock (&output->status_mutex);
+	status = output->status;
 	g_mutex_unlock (&output->status_mutex);
 
-	return ret;
+	if (status == XMMS_PLAYBACK_STATUS_PLAY) {
+		xmms_output_sink_status_set (sink, status);
+	}
 }
 
-/**
- * Allocate a new #xmms_output_t
- */
-xmms_output_t *
-xmms_output_new (xmms_output_plugin_t *plugin, xmms_playlist_t *playlist, xmms_medialib_t *medialib)
+static void
+on_sink_changed (xmms_object_t *object, xmmsv_t *_data, gpointer udata)
 {
-	xmms_output_t *output;
-	xmms_config_property_t *prop;
-	gint size;
-
-	g_return_val_if_fail (playlist, NULL);
-
-	XMMS_DBG ("Trying to open output");
-
-	output = xmms_object_new (xmms_output_t, xmms_output_destroy);
+	xmms_output_t *output = udata;
+	const gchar *path;
+	gboolean exists;
+	gchar *name;
+
+	/* sinks.<name>.plugin */
+	path = xmms_config_property_get_name ((xmms_config_property_t *) object);
+	name = g_strndup (path + strlen ("sinks."),
+	                  strrchr (path, '.') - path - strlen ("sinks."));
+
+	g_mutex_lock (&output->sinks_mutex);
+	exists = xmms_output_sink_find (output, name) != NULL;
+	g_mutex_unlock (&output->sinks_mutex);
+
+	if (exists) {
+		xmms_output_sink_remove (output, name);
+		xmms_output_sink_add (output, name);
+	}
 
-	xmms_object_ref (playlist);
-	output->playlist = playlist;
+	g_free (name);
+}
 
-	xmms_object_ref (medialib);
-	output->medialib = medialib;
+static void
+on_sinks_changed (xmms_object_t *object, xmmsv_t *_data, gpointer udata)
+{
+	xmms_output_t *output = udata;
+	GList *names = NULL, *n;
+	gchar **wanted;
+	gint i;
 
-	g_mutex_init (&output->status_mutex);
-	g_mutex_init (&output->playtime_mutex);
+	wanted = g_strsplit (xmms_config_property_get_string ((xmms_config_property_t *) object), ",", 0);
+	for (i = 0; wanted[i]; i++) {
+		g_strstrip (wanted[i]);
+	}
 
-	prop = xmms_config_property_register ("output.buffersize", "32768", NULL, NULL);
-	size = xmms_config_property_get_int (prop);
-	XMMS_DBG ("Using buffersize %d", size);
+	g_mutex_lock (&output->sinks_mutex);
+	for (n = output->sinks; n; n = g_list_next (n)) {
+		names = g_list_prepend (names, g_strdup (((xmms_output_t *) n->data)->name));
+	}
+	g_mutex_unlock (&output->sinks_mutex);
 
-	g_mutex_init (&output->filler_mutex);
-	output->filler_state = FILLER_STOP;
-	g_cond_init (&output->filler_state_cond);
-	output->filler_buffer = xmms_ringbuf_new (size);
-	output->filler_thread = g_thread_new ("x2 out filler", xmms_output_filler, output);
+	for (n = names; n; n = g_list_next (n)) {
+		if (!xmms_output_zone_wanted (wanted, n->data)) {
+			xmms_output_sink_remove (output, n->data);
+		}
+	}
+	g_list_free_full (names, g_free);
 
-	xmms_config_property_register ("output.flush_on_pause", "1", NULL, NULL);
+	for (i = 0; wanted[i]; i++) {
+		gboolean exists;
 
-	xmms_playback_register_ipc_commands (XMMS_OBJECT (output));
+		if (!*wanted[i] || strchr (wanted[i], '.')) {
+			continue;
+		}
 
-	output->status = XMMS_PLAYBACK_STATUS_STOP;
+		g_mutex_lock (&output->sinks_mutex);
+		exists = xmms_output_sink_find (output, wanted[i]) != NULL;
+		g_mutex_unlock (&output->sinks_mutex);
 
-	if (plugin) {
-		if (!set_plugin (output, plugin)) {
-			xmms_log_error ("Could not initialize output plugin");
+		if (!exists) {
+			xmms_output_sink_add (output, wanted[i]);
 		}
-	} else {
-		xmms_log_error ("initialized output without a plugin, please fix!");
 	}
 
+	g_strfreev (wanted);
+}
+
+/**
+ * Start the sinks listed in output.sinks, a comma separated list of
+ * names. Sinks get the output of the main output's chain, so it is
+ * only decoded and processed once, converted to a format each sink's
+ * plugin supports. Each sink has its own buffer of
+ * output.sink_buffersize bytes and drops data when that is full, so a
+ * slow sink doesn't hold up the others.
+ */
+static void
+xmms_output_sinks_init (xmms_output_t *output)
+{
+	xmms_config_property_t *prop;
 
+	xmms_config_property_register ("output.sink_buffersize", "131072",
+	                               NULL, NULL);
 
-	return output;
+	prop = xmms_config_property_register ("output.sinks", "",
+	                                      on_sinks_changed, output);
+	on_sinks_changed (XMMS_OBJECT (prop), NULL, output);
 }
 
 /**
@@ -1035,6 +3175,7 @@ xmms_output_format_set (xmms_output_t *output, xmms_stream_type_t *fmt)
 static gboolean
 set_plugin (xmms_output_t *output, xmms_output_plugin_t *plugin)
 {
+	xmms_config_property_t *prop;
 	gboolean ret;
 
 	g_assert (output);
@@ -1058,6 +3199,16 @@ set_plugin (xmms_output_t *output, xmms_output_plugin_t *plugin)
 	output->plugin = plugin;
 	ret = xmms_output_plugin_method_new (output->plugin, output);
 
+	/* the main output does the volume itself if the plugin can't */
+	if (ret && !output->name &&
+	    !xmms_output_plugin_method_volume_set_available (plugin)) {
+		prop = xmms_config_lookup ("output.software_volume");
+		g_atomic_int_set (&output->softvol_volume,
+		                  CLAMP (xmms_config_property_get_int (prop), 0, 100));
+	} else {
+		g_atomic_int_set (&output->softvol_volume, -1);
+	}
+
 	if (!ret) {
 		output->plugin = NULL;
 	} else if (!output->monitor_volume_thread) {
@@ -1165,13 +3316,73 @@ xmms_volume_map_to_dict (xmms_volume_map_t *vl)
 	return ret;
 }
 
+/* Broadcasts what the output thread published. Every song change is
+ * sent, the playtime at most once per notify_interval, dropping the
+ * values in between. The thread runs at a lower priority, it's
+ * woken up often and clients waiting a little longer is harmless. */
+static gpointer
+xmms_output_notifier_thread (gpointer data)
+{
+	xmms_output_t *output = data;
+	GQueue entries;
+	gint ms, last_ms = 0;
+	gint64 wakeup;
+
+	xmms_realtime_thread_nice (NOTIFIER_NICE);
+
+	g_mutex_lock (&output->notifier_mutex);
+
+	while (output->notifier_running) {
+		/* take them all, emitting must not be done with the lock held */
+		entries = output->notify_entries;
+		g_queue_init (&output->notify_entries);
+		ms = g_atomic_int_get (&output->played_time);
+
+		g_mutex_unlock (&output->notifier_mutex);
+
+		while (!g_queue_is_empty (&entries)) {
+			gint entry = GPOINTER_TO_INT (g_queue_pop_head (&entries));
+
+			xmms_object_emit (XMMS_OBJECT (output),
+			                  XMMS_IPC_SIGNAL_PLAYBACK_CURRENT_ID,
+			                  xmmsv_new_int (entry));
+		}
+
+		if (ms != last_ms) {
+			xmms_object_emit (XMMS_OBJECT (output),
+			                  XMMS_IPC_SIGNAL_PLAYBACK_PLAYTIME,
+			                  xmmsv_new_int (ms));
+			last_ms = ms;
+		}
+
+		g_mutex_lock (&output->notifier_mutex);
+
+		wakeup = g_get_monotonic_time () +
+		         g_atomic_int_get (&output->notify_interval) * G_TIME_SPAN_MILLISECOND;
+
+		while (output->notifier_running &&
+		       g_queue_is_empty (&output->notify_entries)) {
+			if (!g_cond_wait_until (&output->notifier_cond,
+			                        &output->notifier_mutex, wakeup)) {
+				break;
+			}
+		}
+	}
+
+	g_mutex_unlock (&output->notifier_mutex);
+
+	return NULL;
+}
+
 static gpointer
 xmms_output_monitor_volume_thread (gpointer data)
 {
 	xmms_output_t *output = data;
 	xmms_volume_map_t old, cur;
 
-	if (!xmms_output_plugin_method_volume_get_available (output->plugin)) {
+	/* the software volume broadcasts its changes itself */
+	if (!xmms_output_plugin_method_volume_get_available (output->plugin) ||
+	    g_atomic_int_get (&output->softvol_volume) >= 0) {
 		return NULL;
 	}
 
@@ -15,6 +15,7 @@
  */
 
 #include <xmmspriv/xmms_outputplugin.h>
+#include <xmmspriv/xmms_output.h>
 #include <xmmspriv/xmms_plugin.h>
 #include <xmmspriv/xmms_thread_name.h>
 #include <xmms/xmms_log.h>
@@ -39,6 +40,9 @@ struct xmms_output_plugin_St {
 	xmms_playback_status_t status;
 
 	xmms_output_t *write_output;
+
+	/* the loaded plugin, when this is an extra instance of it */
+	xmms_output_plugin_t *parent;
 };
 
 static gboolean xmms_output_plugin_writer_status (xmms_output_plugin_t *plugin,
@@ -62,6 +66,10 @@ xmms_output_plugin_destroy (xmms_object_t *obj)
 	g_cond_clear (&plugin->status_cond);
 	g_mutex_clear (&plugin->status_mutex);
 
+	if (plugin->parent) {
+		xmms_object_unref (plugin->parent);
+	}
+
 	xmms_plugin_destroy ((xmms_plugin_t *)obj);
 }
 
@@ -83,6 +91,41 @@ xmms_output_plugin_new (void)
 }
 
 
+/**
+ * Create another instance of a loaded output plugin.
+ *
+ * Each instance has its own writer thread and status, so several
+ * outputs can drive the same plugin at once. The instance keeps a
+ * reference to the plugin, which keeps the module loaded.
+ */
+xmms_output_plugin_t *
+xmms_output_plugin_instance_new (xmms_output_plugin_t *plugin)
+{
+	xmms_output_plugin_t *res;
+	xmms_plugin_t *p = (xmms_plugin_t *) plugin;
+	xmms_plugin_t *r;
+
+	g_return_val_if_fail (plugin, NULL);
+	g_return_val_if_fail (p->type == XMMS_PLUGIN_TYPE_OUTPUT, NULL);
+
+	res = (xmms_output_plugin_t *) xmms_output_plugin_new ();
+	r = (xmms_plugin_t *) res;
+
+	r->type = p->type;
+	r->name = p->name;
+	r->shortname = p->shortname;
+	r->description = p->description;
+	r->version = p->version;
+
+	memcpy (&res->methods, &plugin->methods, sizeof (xmms_output_methods_t));
+
+	xmms_object_ref (plugin);
+	res->parent = plugin;
+
+	return res;
+}
+
+
 void
 xmms_output_plugin_methods_set (xmms_output_plugin_t *plugin,
                                 xmms_output_methods_t *methods)
@@ -136,6 +179,10 @@ xmms_output_plugin_verify (xmms_plugin_t *_plugin)
 			XMMS_DBG ("Status type has open or close.");
 			return FALSE;
 		}
+		if (plugin->methods.fill) {
+			XMMS_DBG ("Status type has fill.");
+			return FALSE;
+		}
 	}
 
 	return TRUE;
@@ -388,8 +435,11 @@ xmms_output_plugin_writer (gpointer data)
 	xmms_output_plugin_t *plugin = (xmms_output_plugin_t *) data;
 	xmms_output_t *output = NULL;
 	gchar buffer[4096];
+	xmms_error_t err;
 	gint ret;
 
+	xmms_output_realtime_enter ("writer", 0);
+
 	g_mutex_lock (&plugin->write_mutex);
 
 	while (plugin->write_running) {
@@ -450,25 +500,25 @@ xmms_output_plugin_writer (gpointer data)
 
 			g_mutex_unlock (&plugin->write_mutex);
 
-			ret = xmms_output_read (output, buffer, 4096);
-			if (ret > 0) {
-				xmms_error_t err;
+			xmms_error_reset (&err);
 
-				xmms_error_reset (&err);
-
-				g_mutex_lock (&plugin->api_mutex);
-				plugin->methods.write (output, buffer, ret, &err);
-				g_mutex_unlock (&plugin->api_mutex);
+			if (!plugin->methods.fill || !plugin->methods.fill (output, &err)) {
+				ret = xmms_output_read (output, buffer, 4096);
+				if (ret > 0) {
+					g_mutex_lock (&plugin->api_mutex);
+					plugin->methods.write (output, buffer, ret, &err);
+					g_mutex_unlock (&plugin->api_mutex);
+				}
+			}
 
-				if (xmms_error_iserror (&err)) {
-					XMMS_DBG ("Write method set error bit");
+			if (xmms_error_iserror (&err)) {
+				XMMS_DBG ("Write method set error bit");
 
-					g_mutex_lock (&plugin->write_mutex);
-					plugin->wanted_status = XMMS_PLAYBACK_STATUS_STOP;
-					g_mutex_unlock (&plugin->write_mutex);
+				g_mutex_lock (&plugin->write_mutex);
+				plugin->wanted_status = XMMS_PLAYBACK_STATUS_STOP;
+				g_mutex_unlock (&plugin->write_mutex);
 
-					xmms_output_set_error (output, &err);
-				}
+				xmms_output_set_error (output, &err);
 			}
 			g_mutex_lock (&plugin->write_mutex);
 		}
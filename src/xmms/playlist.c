@@ -332,7 +332,7 @@ xmms_playlist_init (xmms_medialib_t *medialib, xmms_coll_dag_t *colldag)
 }
 
 static gboolean
-xmms_playlist_advance_do (xmms_playlist_t *playlist)
+xmms_playlist_advance_do (xmms_playlist_t *playlist, const gchar *plname)
 {
 	gint size, currpos;
 	gboolean ret = TRUE;
@@ -340,18 +340,22 @@ xmms_playlist_advance_do (xmms_playlist_t *playlist)
 	const gchar *jumplist;
 	xmms_error_t err;
 	xmms_playlist_t *buffer = playlist;
+	gboolean active;
 	gint newpos;
 
 	xmms_error_reset (&err);
 
-	plcoll = xmms_playlist_get_coll (playlist, XMMS_ACTIVE_PLAYLIST, NULL);
+	/* jumplists switch the active playlist, others just stop */
+	active = strcmp (plname, XMMS_ACTIVE_PLAYLIST) == 0;
+
+	plcoll = xmms_playlist_get_coll (playlist, plname, NULL);
 	if (plcoll == NULL) {
 		ret = FALSE;
 	} else if ((size = xmms_playlist_coll_get_size (plcoll)) == 0) {
-		if (xmmsv_coll_attribute_get_string (plcoll, "jumplist", &jumplist)) {
+		if (active && xmmsv_coll_attribute_get_string (plcoll, "jumplist", &jumplist)) {
 			xmms_playlist_client_load (buffer, jumplist, &err);
 			if (xmms_error_isok (&err)) {
-				ret = xmms_playlist_advance_do (playlist);
+				ret = xmms_playlist_advance_do (playlist, plname);
 			} else {
 				ret = FALSE;
 			}
@@ -362,7 +366,7 @@ xmms_playlist_advance_do (xmms_playlist_t *playlist)
 		currpos = xmms_playlist_coll_get_currpos (plcoll);
 		currpos++;
 
-		if (currpos == size && !playlist->repeat_all &&
+		if (currpos == size && !playlist->repeat_all && active &&
 		    xmmsv_coll_attribute_get_string (plcoll, "jumplist", &jumplist)) {
 
 			xmms_collection_set_int_attr (plcoll, "position", -1);
@@ -370,14 +374,14 @@ xmms_playlist_advance_do (xmms_playlist_t *playlist)
 
 			xmms_playlist_client_load (buffer, jumplist, &err);
 			if (xmms_error_isok (&err)) {
-				ret = xmms_playlist_advance_do (playlist);
+				ret = xmms_playlist_advance_do (playlist, plname);
 			} else {
 				ret = FALSE;
 			}
 		} else {
 			newpos = currpos%size;
 			xmms_collection_set_int_attr (plcoll, "position", newpos);
-			XMMS_PLAYLIST_CURRPOS_MSG (newpos, XMMS_ACTIVE_PLAYLIST);
+			XMMS_PLAYLIST_CURRPOS_MSG (newpos, plname);
 			ret = (currpos != size) || playlist->repeat_all;
 		}
 	}
@@ -395,34 +399,127 @@ xmms_playlist_advance_do (xmms_playlist_t *playlist)
  */
 gboolean
 xmms_playlist_advance (xmms_playlist_t *playlist)
+{
+	return xmms_playlist_advance_in (playlist, XMMS_ACTIVE_PLAYLIST);
+}
+
+/**
+ * Same as #xmms_playlist_advance, but in the given playlist.
+ * Only the active playlist follows jumplists.
+ */
+gboolean
+xmms_playlist_advance_in (xmms_playlist_t *playlist, const gchar *plname)
 {
 	gboolean ret;
 
 	g_return_val_if_fail (playlist, FALSE);
+	g_return_val_if_fail (plname, FALSE);
 
 	g_mutex_lock (&playlist->mutex);
-	ret = xmms_playlist_advance_do (playlist);
+	ret = xmms_playlist_advance_do (playlist, plname);
 	g_mutex_unlock (&playlist->mutex);
 
 	return ret;
 }
 
+/**
+ * Retrieve the entry #xmms_playlist_advance_in would go to, without
+ * going there. Returns 0 at the end of the playlist and where a
+ * jumplist would be followed.
+ */
+xmms_medialib_entry_t
+xmms_playlist_next_entry_in (xmms_playlist_t *playlist, const gchar *plname)
+{
+	gint size, currpos;
+	xmmsv_t *plcoll;
+	xmms_medialib_entry_t ent = 0;
+
+	g_return_val_if_fail (playlist, 0);
+	g_return_val_if_fail (plname, 0);
+
+	g_mutex_lock (&playlist->mutex);
+
+	plcoll = xmms_playlist_get_coll (playlist, plname, NULL);
+	if (plcoll != NULL) {
+		currpos = xmms_playlist_coll_get_currpos (plcoll);
+		size = xmms_playlist_coll_get_size (plcoll);
+
+		if (!playlist->repeat_one) {
+			currpos++;
+			if (currpos == size && playlist->repeat_all) {
+				currpos = 0;
+			}
+		}
+
+		if (currpos >= 0 && currpos < size) {
+			xmmsv_coll_idlist_get_index (plcoll, currpos, &ent);
+		}
+	}
+
+	g_mutex_unlock (&playlist->mutex);
+
+	return ent;
+}
+
+/**
+ * Undo #xmms_playlist_advance_in within the playlist, going back to
+ * the previous position according to the current playlist mode.
+ */
+void
+xmms_playlist_retreat_in (xmms_playlist_t *playlist, const gchar *plname)
+{
+	gint size, currpos;
+	xmmsv_t *plcoll;
+
+	g_return_if_fail (playlist);
+	g_return_if_fail (plname);
+
+	g_mutex_lock (&playlist->mutex);
+
+	plcoll = xmms_playlist_get_coll (playlist, plname, NULL);
+	if (plcoll != NULL && !playlist->repeat_one) {
+		currpos = xmms_playlist_coll_get_currpos (plcoll);
+		size = xmms_playlist_coll_get_size (plcoll);
+
+		if (currpos == 0 && playlist->repeat_all) {
+			currpos = size;
+		}
+
+		if (currpos > 0 && currpos <= size) {
+			xmms_collection_set_int_attr (plcoll, "position", currpos - 1);
+			XMMS_PLAYLIST_CURRPOS_MSG (currpos - 1, plname);
+		}
+	}
+
+	g_mutex_unlock (&playlist->mutex);
+}
+
 /**
  * Retrieve the currently active xmms_medialib_entry_t.
  *
  */
 xmms_medialib_entry_t
 xmms_playlist_current_entry (xmms_playlist_t *playlist)
+{
+	return xmms_playlist_current_entry_in (playlist, XMMS_ACTIVE_PLAYLIST);
+}
+
+/**
+ * Retrieve the current xmms_medialib_entry_t of the given playlist.
+ */
+xmms_medialib_entry_t
+xmms_playlist_current_entry_in (xmms_playlist_t *playlist, const gchar *plname)
 {
 	gint size, currpos;
 	xmmsv_t *plcoll;
 	xmms_medialib_entry_t ent = 0;
 
 	g_return_val_if_fail (playlist, 0);
+	g_return_val_if_fail (plname, 0);
 
 	g_mutex_lock (&playlist->mutex);
 
-	plcoll = xmms_playlist_get_coll (playlist, XMMS_ACTIVE_PLAYLIST, NULL);
+	plcoll = xmms_playlist_get_coll (playlist, plname, NULL);
 	if (plcoll == NULL) {
 		/* FIXME: What happens? */
 		g_mutex_unlock (&playlist->mutex);
@@ -435,7 +532,7 @@ xmms_playlist_current_entry (xmms_playlist_t *playlist)
 	if (currpos == -1 && (size > 0)) {
 		currpos = 0;
 		xmms_collection_set_int_attr (plcoll, "position", currpos);
-		XMMS_PLAYLIST_CURRPOS_MSG (0, XMMS_ACTIVE_PLAYLIST);
+		XMMS_PLAYLIST_CURRPOS_MSG (0, plname);
 	}
 
 	if (currpos < size) {
@@ -23,10 +23,14 @@
 #include <xmmspriv/xmms_playlist.h>
 #include <xmmspriv/xmms_outputplugin.h>
 #include <xmmspriv/xmms_xform.h>
+#include <xmmspriv/xmms_xform_plugin.h>
+#include <xmmsc/xmmsc_util.h>
 
 #include <gmodule.h>
+#include <glib/gstdio.h>
 #include <string.h>
 #include <stdarg.h>
+#include <sys/stat.h>
 
 #ifdef HAVE_VALGRIND
 # include <memcheck.h>
@@ -39,18 +43,46 @@
 #define get_module_ext(dir) g_module_build_path (dir, "*")
 #endif
 
+#define XMMS_PLUGIN_MANIFEST "plugins.manifest"
+
 extern xmms_plugin_desc_t *xmms_builtin_plugins[];
 
+typedef struct {
+	gint api_version;
+	xmms_plugin_t *(*allocer) (void);
+	gboolean (*verifier) (xmms_plugin_t *);
+} xmms_plugin_type_info_t;
+
+static const xmms_plugin_type_info_t xmms_plugin_output_info = {
+	XMMS_OUTPUT_API_VERSION,
+	xmms_output_plugin_new,
+	xmms_output_plugin_verify
+};
+
+static const xmms_plugin_type_info_t xmms_plugin_xform_info = {
+	XMMS_XFORM_API_VERSION,
+	xmms_xform_plugin_new,
+	xmms_xform_plugin_verify
+};
+
 /*
  * Global variables
  */
 static GList *xmms_plugin_list;
 
+/* serializes opening plugins known from the manifest */
+static GMutex xmms_plugin_load_lock;
+
+/* name/default pairs of the config properties registered while a
+ * plugin is set up, to be stored in the manifest */
+static GPtrArray *xmms_plugin_config_capture;
+
 /*
  * Function prototypes
  */
 static gboolean xmms_plugin_setup (xmms_plugin_t *plugin, const xmms_plugin_desc_t *desc);
 static gboolean xmms_plugin_scan_directory (const gchar *dir);
+static void xmms_plugin_load_failed (xmms_plugin_t *plugin);
 
 /*
  * Public functions
@@ -120,6 +152,11 @@ xmms_plugin_config_property_register (xmms_plugin_t *plugin,
 	prop = xmms_config_property_register (fullpath, default_value, cb,
 	                                      userdata);
 
+	if (xmms_plugin_config_capture) {
+		g_ptr_array_add (xmms_plugin_config_capture, g_strdup (name));
+		g_ptr_array_add (xmms_plugin_config_capture, g_strdup (default_value));
+	}
+
 	return prop;
 }
 
@@ -254,6 +291,9 @@ xmms_plugin_shutdown ()
 		;
 #endif
 
+	/* drop the references held by cached chain plans */
+	xmms_xform_plan_cache_flush ();
+
 	while (xmms_plugin_list) {
 		xmms_plugin_t *p = xmms_plugin_list->data;
 
@@ -272,6 +312,19 @@ xmms_plugin_shutdown ()
 	}
 }
 
+static const xmms_plugin_type_info_t *
+xmms_plugin_type_info_get (xmms_plugin_type_t type)
+{
+	switch (type) {
+	case XMMS_PLUGIN_TYPE_OUTPUT:
+		return &xmms_plugin_output_info;
+	case XMMS_PLUGIN_TYPE_XFORM:
+		return &xmms_plugin_xform_info;
+	default:
+		return NULL;
+	}
+}
+
 /**
  * @internal Load a plugin.
  * @param[in] desc The plugin description.
@@ -281,35 +334,23 @@ xmms_plugin_shutdown ()
 gboolean
 xmms_plugin_load (const xmms_plugin_desc_t *desc, GModule *module)
 {
+	const xmms_plugin_type_info_t *info;
 	xmms_plugin_t *plugin;
-	xmms_plugin_t *(*allocer) (void);
-	gboolean (*verifier) (xmms_plugin_t *);
-	gint expected_ver;
 
 	XMMS_DBG ("Loading plugin '%s'", desc->name);
 
-	switch (desc->type) {
-	case XMMS_PLUGIN_TYPE_OUTPUT:
-		expected_ver = XMMS_OUTPUT_API_VERSION;
-		allocer = xmms_output_plugin_new;
-		verifier = xmms_output_plugin_verify;
-		break;
-	case XMMS_PLUGIN_TYPE_XFORM:
-		expected_ver = XMMS_XFORM_API_VERSION;
-		allocer = xmms_xform_plugin_new;
-		verifier = xmms_xform_plugin_verify;
-		break;
-	default:
+	info = xmms_plugin_type_info_get (desc->type);
+	if (!info) {
 		XMMS_DBG ("Unknown plugin type!");
 		return FALSE;
 	}
 
-	if (desc->api_version != expected_ver) {
+	if (desc->api_version != info->api_version) {
 		XMMS_DBG ("Bad api version!");
 		return FALSE;
 	}
 
-	plugin = allocer ();
+	plugin = info->allocer ();
 	if (!plugin) {
 		XMMS_DBG ("Alloc failed!");
 		return FALSE;
@@ -328,7 +369,7 @@ xmms_plugin_load (const xmms_plugin_desc_t *desc, GModule *module)
 		return FALSE;
 	}
 
-	if (!verifier (plugin)) {
+	if (!info->verifier (plugin)) {
 		xmms_log_error ("Verify failed for plugin '%s'!", desc->name);
 		xmms_object_unref (plugin);
 		return FALSE;
@@ -337,9 +378,376 @@ xmms_plugin_load (const xmms_plugin_desc_t *desc, GModule *module)
 	plugin->module = module;
 
 	xmms_plugin_list = g_list_prepend (xmms_plugin_list, plugin);
+
+	/* the new plugin may win matches that were cached */
+	xmms_xform_plan_cache_flush ();
+
+	return TRUE;
+}
+
+/**
+ * @internal Open a plugin known from the manifest, if that hasn't
+ * been done yet. Plugins found in the plugin directory are only
+ * registered with what the manifest says about them, and opened the
+ * first time something needs more than that.
+ * @param[in] plugin The plugin
+ * @return TRUE if the plugin is ready to use
+ */
+gboolean
+xmms_plugin_ensure_loaded (xmms_plugin_t *plugin)
+{
+	const xmms_plugin_type_info_t *info;
+	const xmms_plugin_desc_t *desc;
+	GPtrArray *magic;
+	GModule *module;
+	gpointer sym;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail (plugin, FALSE);
+
+	/* builtin or opened while scanning */
+	if (!plugin->path) {
+		return TRUE;
+	}
+
+	g_mutex_lock (&xmms_plugin_load_lock);
+
+	if (plugin->module || xmms_plugin_failed (plugin)) {
+		ret = !xmms_plugin_failed (plugin);
+		g_mutex_unlock (&xmms_plugin_load_lock);
+		return ret;
+	}
+
+	XMMS_DBG ("Loading plugin '%s' on demand", plugin->shortname);
+
+	module = g_module_open (plugin->path, G_MODULE_BIND_LOCAL);
+	if (!module) {
+		xmms_log_error ("Failed to open plugin %s: %s",
+		                plugin->path, g_module_error ());
+		xmms_plugin_load_failed (plugin);
+		g_mutex_unlock (&xmms_plugin_load_lock);
+		return FALSE;
+	}
+
+	info = xmms_plugin_type_info_get (plugin->type);
+	desc = NULL;
+
+	if (g_module_symbol (module, "XMMS_PLUGIN_DESC", &sym)) {
+		desc = sym;
+	}
+
+	if (!desc) {
+		xmms_log_error ("Failed to find plugin header in %s", plugin->path);
+	} else if (desc->type != plugin->type ||
+	           desc->api_version != info->api_version ||
+	           strcmp (desc->shortname, plugin->shortname) != 0) {
+		xmms_log_error ("Plugin %s changed since it was scanned",
+		                plugin->path);
+	} else {
+		/* the magic was registered from the manifest already */
+		xmms_magic_capture_begin (TRUE);
+		ret = desc->setup_func (plugin) && info->verifier (plugin);
+		magic = xmms_magic_capture_end ();
+		g_ptr_array_unref (magic);
+
+		if (!ret) {
+			xmms_log_error ("Setup failed for plugin '%s'!", desc->name);
+		}
+	}
+
+	if (ret) {
+		plugin->module = module;
+	} else {
+		g_module_close (module);
+		xmms_plugin_load_failed (plugin);
+	}
+
+	g_mutex_unlock (&xmms_plugin_load_lock);
+
+	return ret;
+}
+
+/**
+ * @internal Check if opening a plugin known from the manifest failed.
+ * Such plugins stay registered, but are no candidate for anything.
+ * @param[in] plugin The plugin
+ * @return TRUE if the plugin can't be used
+ */
+gboolean
+xmms_plugin_failed (xmms_plugin_t *plugin)
+{
+	g_return_val_if_fail (plugin, TRUE);
+
+	return g_atomic_int_get (&plugin->failed);
+}
+
+static gchar *
+xmms_plugin_manifest_path (void)
+{
+	gchar cachedir[XMMS_PATH_MAX];
+
+	if (!xmms_usercachedir_get (cachedir, sizeof (cachedir))) {
+		return NULL;
+	}
+
+	return g_build_filename (cachedir, XMMS_PLUGIN_MANIFEST, NULL);
+}
+
+static gboolean
+xmms_plugin_manifest_strv_valid (const gchar * const *strv)
+{
+	for (; *strv; strv++) {
+		if (!g_utf8_validate (*strv, -1, NULL)) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @internal Record everything needed to register a plugin without
+ * opening it.
+ * @return TRUE if the manifest entry was written
+ */
+static gboolean
+xmms_plugin_manifest_store (GKeyFile *manifest, const gchar *path,
+                            const struct stat *st, xmms_plugin_t *plugin,
+                            GPtrArray *config, GPtrArray *magic)
+{
+	const GList *n;
+	gchar key[32];
+	gint i = 0;
+	guint j;
+
+	g_ptr_array_add (config, NULL);
+
+	if (!xmms_plugin_manifest_strv_valid ((const gchar * const *) config->pdata)) {
+		return FALSE;
+	}
+	for (j = 0; j < magic->len; j++) {
+		if (!xmms_plugin_manifest_strv_valid (g_ptr_array_index (magic, j))) {
+			return FALSE;
+		}
+	}
+
+	g_key_file_remove_group (manifest, path, NULL);
+
+	g_key_file_set_string (manifest, path, "xmms_version", XMMS_VERSION);
+	g_key_file_set_int64 (manifest, path, "mtime", st->st_mtime);
+	g_key_file_set_int64 (manifest, path, "size", st->st_size);
+	g_key_file_set_integer (manifest, path, "type", plugin->type);
+	g_key_file_set_string (manifest, path, "shortname", plugin->shortname);
+	g_key_file_set_string (manifest, path, "name", plugin->name);
+	g_key_file_set_string (manifest, path, "version", plugin->version);
+	g_key_file_set_string (manifest, path, "description", plugin->description);
+
+	g_key_file_set_string_list (manifest, path, "config",
+	                            (const gchar * const *) config->pdata,
+	                            config->len - 1);
+
+	if (plugin->type == XMMS_PLUGIN_TYPE_XFORM) {
+		n = xmms_xform_plugin_in_types_get ((xmms_xform_plugin_t *) plugin);
+		for (; n; n = g_list_next (n), i++) {
+			gchar **strv = xmms_stream_type_to_strv (n->data);
+
+			g_snprintf (key, sizeof (key), "intype%d", i);
+			g_key_file_set_string_list (manifest, path, key,
+			                            (const gchar * const *) strv,
+			                            g_strv_length (strv));
+			g_strfreev (strv);
+		}
+	}
+	g_key_file_set_integer (manifest, path, "intypes", i);
+
+	for (j = 0; j < magic->len; j++) {
+		gchar **strv = g_ptr_array_index (magic, j);
+
+		g_snprintf (key, sizeof (key), "magic%u", j);
+		g_key_file_set_string_list (manifest, path, key,
+		                            (const gchar * const *) strv,
+		                            g_strv_length (strv));
+	}
+	g_key_file_set_integer (manifest, path, "magics", magic->len);
+
 	return TRUE;
 }
 
+/**
+ * @internal Register a plugin from its manifest entry, if the entry
+ * is still valid for the file at path.
+ * @return TRUE if the plugin was registered
+ */
+static gboolean
+xmms_plugin_manifest_restore (GKeyFile *manifest, const gchar *path,
+                              const struct stat *st)
+{
+	const xmms_plugin_type_info_t *info;
+	xmms_plugin_t *plugin;
+	GList *in_types = NULL;
+	GPtrArray *magic;
+	gchar **config = NULL, **strv, *str;
+	gchar key[32];
+	gint i, count;
+	guint j;
+	gsize len;
+	gboolean ret = FALSE;
+
+	if (!g_key_file_has_group (manifest, path)) {
+		return FALSE;
+	}
+
+	str = g_key_file_get_string (manifest, path, "xmms_version", NULL);
+	if (g_strcmp0 (str, XMMS_VERSION) != 0 ||
+	    g_key_file_get_int64 (manifest, path, "mtime", NULL) != st->st_mtime ||
+	    g_key_file_get_int64 (manifest, path, "size", NULL) != st->st_size) {
+		g_free (str);
+		return FALSE;
+	}
+	g_free (str);
+
+	info = xmms_plugin_type_info_get (g_key_file_get_integer (manifest, path,
+	                                                          "type", NULL));
+	if (!info) {
+		return FALSE;
+	}
+
+	/* parse everything up front, so a broken entry registers nothing */
+	magic = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+
+	count = g_key_file_get_integer (manifest, path, "intypes", NULL);
+	for (i = 0; i < count; i++) {
+		xmms_stream_type_t *t = NULL;
+
+		g_snprintf (key, sizeof (key), "intype%d", i);
+		strv = g_key_file_get_string_list (manifest, path, key, NULL, NULL);
+		if (strv) {
+			t = xmms_stream_type_from_strv (strv);
+			g_strfreev (strv);
+		}
+		if (!t) {
+			goto out;
+		}
+		in_types = g_list_prepend (in_types, t);
+	}
+
+	count = g_key_file_get_integer (manifest, path, "magics", NULL);
+	for (i = 0; i < count; i++) {
+		g_snprintf (key, sizeof (key), "magic%d", i);
+		strv = g_key_file_get_string_list (manifest, path, key, NULL, NULL);
+		if (!strv) {
+			goto out;
+		}
+		g_ptr_array_add (magic, strv);
+	}
+
+	config = g_key_file_get_string_list (manifest, path, "config", &len, NULL);
+	if (!config || len % 2) {
+		goto out;
+	}
+
+	plugin = info->allocer ();
+	if (!plugin) {
+		goto out;
+	}
+
+	plugin->type = g_key_file_get_integer (manifest, path, "type", NULL);
+
+#define INTERN_KEY(field) \
+	str = g_key_file_get_string (manifest, path, #field, NULL); \
+	plugin->field = g_intern_string (str ? str : ""); \
+	g_free (str);
+
+	INTERN_KEY (shortname);
+	INTERN_KEY (name);
+	INTERN_KEY (version);
+	INTERN_KEY (description);
+
+#undef INTERN_KEY
+
+	plugin->path = g_strdup (path);
+
+	XMMS_DBG ("Registering plugin '%s' from manifest", plugin->name);
+
+	for (strv = config; *strv; strv += 2) {
+		xmms_plugin_config_property_register (plugin, strv[0], strv[1],
+		                                      NULL, NULL);
+	}
+
+	/* in_types was built reversed, prepending restores the order */
+	while (in_types) {
+		xmms_xform_plugin_indata_add_type ((xmms_xform_plugin_t *) plugin,
+		                                   in_types->data);
+		in_types = g_list_delete_link (in_types, in_types);
+	}
+
+	for (j = 0; j < magic->len; j++) {
+		xmms_magic_replay (g_ptr_array_index (magic, j));
+	}
+
+	xmms_plugin_list = g_list_prepend (xmms_plugin_list, plugin);
+	xmms_xform_plan_cache_flush ();
+
+	ret = TRUE;
+
+out:
+	g_list_free_full (in_types, xmms_object_unref);
+	g_ptr_array_unref (magic);
+	g_strfreev (config);
+
+	return ret;
+}
+
+static void
+xmms_plugin_manifest_save (GKeyFile *manifest, const gchar *manifest_path)
+{
+	GError *err = NULL;
+	gchar *dir, *data;
+	gsize len;
+
+	dir = g_path_get_dirname (manifest_path);
+	g_mkdir_with_parents (dir, 0755);
+	g_free (dir);
+
+	data = g_key_file_to_data (manifest, &len, NULL);
+	if (!g_file_set_contents (manifest_path, data, len, &err)) {
+		xmms_log_error ("Failed to write plugin manifest: %s", err->message);
+		g_error_free (err);
+	}
+	g_free (data);
+}
+
+/**
+ * @internal Mark a plugin known from the manifest as unusable, and
+ * drop its manifest entry so it is scanned again on the next start.
+ * Called with xmms_plugin_load_lock held.
+ */
+static void
+xmms_plugin_load_failed (xmms_plugin_t *plugin)
+{
+	GKeyFile *manifest;
+	gchar *manifest_path;
+
+	g_atomic_int_set (&plugin->failed, TRUE);
+
+	/* cached plans may point at it */
+	xmms_xform_plan_cache_flush ();
+
+	manifest_path = xmms_plugin_manifest_path ();
+	if (!manifest_path) {
+		return;
+	}
+
+	manifest = g_key_file_new ();
+	if (g_key_file_load_from_file (manifest, manifest_path,
+	                               G_KEY_FILE_NONE, NULL) &&
+	    g_key_file_remove_group (manifest, plugin->path, NULL)) {
+		xmms_plugin_manifest_save (manifest, manifest_path);
+	}
+
+	g_key_file_free (manifest);
+	g_free (manifest_path);
+}
+
 /**
  * @internal Scan a particular directory for plugins to load
  * @param[in] dir Absolute path to plugins directory
@@ -353,8 +761,15 @@ xmms_plugin_scan_directory (const gchar *dir)
 	gchar *path;
 	gchar *temp;
 	gchar *pattern;
+	gchar *manifest_path, **groups;
+	GKeyFile *manifest;
+	GHashTable *seen;
 	GModule *module;
+	GPtrArray *config, *magic;
+	struct stat st;
 	gpointer sym;
+	gboolean loaded, dirty = FALSE;
+	gint i;
 
 	temp = get_module_ext (dir);
 
@@ -367,20 +782,35 @@ xmms_plugin_scan_directory (const gchar *dir)
 	d = g_dir_open (dir, 0, NULL);
 	if (!d) {
 		xmms_log_error ("Failed to open plugin directory (%s)", dir);
+		g_free (pattern);
 		return FALSE;
 	}
 
+	manifest = g_key_file_new ();
+	manifest_path = xmms_plugin_manifest_path ();
+	if (manifest_path) {
+		g_key_file_load_from_file (manifest, manifest_path,
+		                           G_KEY_FILE_NONE, NULL);
+	}
+
+	seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
 	while ((name = g_dir_read_name (d))) {
 
 		if (!g_pattern_match_simple (pattern, name))
 			continue;
 
 		path = g_build_filename (dir, name, NULL);
-		if (!g_file_test (path, G_FILE_TEST_IS_REGULAR)) {
+		if (g_stat (path, &st) < 0 || !S_ISREG (st.st_mode)) {
 			g_free (path);
 			continue;
 		}
 
+		if (xmms_plugin_manifest_restore (manifest, path, &st)) {
+			g_hash_table_add (seen, path);
+			continue;
+		}
+
 		XMMS_DBG ("Trying to load file: %s", path);
 		module = g_module_open (path, G_MODULE_BIND_LOCAL);
 		if (!module) {
@@ -396,16 +826,56 @@ xmms_plugin_scan_directory (const gchar *dir)
 			g_free (path);
 			continue;
 		}
-		g_free (path);
 
-		if (!xmms_plugin_load ((const xmms_plugin_desc_t *) sym, module)) {
+		xmms_plugin_config_capture = g_ptr_array_new_with_free_func (g_free);
+		xmms_magic_capture_begin (FALSE);
+
+		loaded = xmms_plugin_load ((const xmms_plugin_desc_t *) sym, module);
+
+		magic = xmms_magic_capture_end ();
+		config = xmms_plugin_config_capture;
+		xmms_plugin_config_capture = NULL;
+
+		if (!loaded) {
 			g_module_close (module);
 		}
+
+		if (loaded && xmms_plugin_manifest_store (manifest, path, &st,
+		                                          xmms_plugin_list->data,
+		                                          config, magic)) {
+			dirty = TRUE;
+		} else if (g_key_file_remove_group (manifest, path, NULL)) {
+			dirty = TRUE;
+		}
+
+		g_ptr_array_unref (magic);
+		g_ptr_array_unref (config);
+		g_hash_table_add (seen, path);
 	}
 
 	g_dir_close (d);
 	g_free (pattern);
 
+	/* forget about plugins that have been removed */
+	groups = g_key_file_get_groups (manifest, NULL);
+	for (i = 0; groups[i]; i++) {
+		temp = g_path_get_dirname (groups[i]);
+		if (strcmp (temp, dir) == 0 && !g_hash_table_contains (seen, groups[i])) {
+			g_key_file_remove_group (manifest, groups[i], NULL);
+			dirty = TRUE;
+		}
+		g_free (temp);
+	}
+	g_strfreev (groups);
+
+	if (dirty && manifest_path) {
+		xmms_plugin_manifest_save (manifest, manifest_path);
+	}
+
+	g_hash_table_destroy (seen);
+	g_key_file_free (manifest);
+	g_free (manifest_path);
+
 	return TRUE;
 }
 
@@ -459,6 +929,12 @@ xmms_plugin_find (xmms_plugin_type_t type, const gchar *name)
 {
 	xmms_plugin_find_foreach_data_t data = {name, NULL};
 	xmms_plugin_foreach (type, xmms_plugin_find_foreach, &data);
+
+	if (data.plugin && !xmms_plugin_ensure_loaded (data.plugin)) {
+		xmms_object_unref (data.plugin);
+		return NULL;
+	}
+
 	return data.plugin;
 }
 
@@ -480,4 +956,5 @@ xmms_plugin_destroy (xmms_plugin_t *plugin)
 {
 	if (plugin->module)
 		g_module_close (plugin->module);
+	g_free (plugin->path);
 }
@@ -18,6 +18,7 @@
 
 
 #include <xmmspriv/xmms_ringbuf.h>
+#include <xmmspriv/xmms_realtime.h>
 #include <string.h>
 
 /** @defgroup Ringbuffer Ringbuffer
@@ -39,6 +40,8 @@ struct xmms_ringbuf_St {
 	/** Read and write index */
 	guint rd_index, wr_index;
 	gboolean eos;
+	/** Set if #buffer is locked in memory */
+	gboolean locked;
 
 	GQueue *hotspots;
 
@@ -112,10 +115,100 @@ xmms_ringbuf_destroy (xmms_ringbuf_t *ringbuf)
 	g_cond_clear (&ringbuf->free_cond);
 
 	g_queue_free (ringbuf->hotspots);
-	g_free (ringbuf->buffer);
+	if (ringbuf->locked) {
+		xmms_realtime_locked_free (ringbuf->buffer, ringbuf->buffer_size);
+	} else {
+		g_free (ringbuf->buffer);
+	}
 	g_free (ringbuf);
 }
 
+/**
+ * Lock the data of the ringbuffer in memory so that it is never
+ * paged out. The data moves to pages of its own, so the ringbuffer
+ * must not be in use by another thread yet.
+ *
+ * @returns TRUE if the data is locked
+ */
+gboolean
+xmms_ringbuf_mlock (xmms_ringbuf_t *ringbuf)
+{
+	guint8 *buffer;
+
+	g_return_val_if_fail (ringbuf, FALSE);
+
+	if (!ringbuf->locked) {
+		buffer = xmms_realtime_locked_alloc (ringbuf->buffer_size);
+		if (buffer) {
+			memcpy (buffer, ringbuf->buffer, ringbuf->buffer_size);
+			g_free (ringbuf->buffer);
+			ringbuf->buffer = buffer;
+			ringbuf->locked = TRUE;
+		}
+	}
+
+	return ringbuf->locked;
+}
+
+/**
+ * Change the usable size of the ringbuffer without losing any data.
+ *
+ * Growing reallocates the buffer and moves the contents to its start,
+ * shrinking only lowers the usable size so that the writer backs off
+ * until the reader has drained the buffer below the new limit.
+ *
+ * @param size The new usable size
+ */
+void
+xmms_ringbuf_resize (xmms_ringbuf_t *ringbuf, guint size)
+{
+	GList *n;
+	guint8 *buffer;
+	guint used, cnt;
+	gboolean locked;
+
+	g_return_if_fail (ringbuf);
+	g_return_if_fail (size > 0);
+	g_return_if_fail (size < G_MAXUINT);
+
+	if (size + 1 > ringbuf->buffer_size) {
+		used = xmms_ringbuf_bytes_used (ringbuf);
+		buffer = NULL;
+		if (ringbuf->locked) {
+			buffer = xmms_realtime_locked_alloc (size + 1);
+		}
+		locked = buffer != NULL;
+		if (!buffer) {
+			buffer = g_malloc (size + 1);
+		}
+
+		cnt = MIN (used, ringbuf->buffer_size - ringbuf->rd_index);
+		memcpy (buffer, ringbuf->buffer + ringbuf->rd_index, cnt);
+		memcpy (buffer + cnt, ringbuf->buffer, used - cnt);
+
+		for (n = ringbuf->hotspots->head; n; n = g_list_next (n)) {
+			xmms_ringbuf_hotspot_t *hs = n->data;
+			hs->pos = (hs->pos - ringbuf->rd_index + ringbuf->buffer_size)
+			          % ringbuf->buffer_size;
+		}
+
+		if (ringbuf->locked) {
+			xmms_realtime_locked_free (ringbuf->buffer, ringbuf->buffer_size);
+		} else {
+			g_free (ringbuf->buffer);
+		}
+		ringbuf->buffer = buffer;
+		ringbuf->locked = locked;
+		ringbuf->buffer_size = size + 1;
+		ringbuf->rd_index = 0;
+		ringbuf->wr_index = used;
+	}
+
+	ringbuf->buffer_size_usable = size;
+
+	g_cond_broadcast (&ringbuf->free_cond);
+}
+
 /**
  * Clear the ringbuffers data
  */
@@ -143,10 +236,18 @@ xmms_ringbuf_clear (xmms_ringbuf_t *ringbuf)
 guint
 xmms_ringbuf_bytes_free (const xmms_ringbuf_t *ringbuf)
 {
+	guint used;
+
 	g_return_val_if_fail (ringbuf, 0);
 
-	return ringbuf->buffer_size_usable -
-	       xmms_ringbuf_bytes_used (ringbuf);
+	used = xmms_ringbuf_bytes_used (ringbuf);
+
+	/* may be over the limit for a while after shrinking */
+	if (used >= ringbuf->buffer_size_usable) {
+		return 0;
+	}
+
+	return ringbuf->buffer_size_usable - used;
 }
 
 /**
@@ -164,21 +265,19 @@ xmms_ringbuf_bytes_used (const xmms_ringbuf_t *ringbuf)
 	return ringbuf->buffer_size - (ringbuf->rd_index - ringbuf->wr_index);
 }
 
-static guint
-read_bytes (xmms_ringbuf_t *ringbuf, guint8 *data, guint len)
+/**
+ * Run the hotspots at the read position.
+ *
+ * @returns FALSE if a hotspot asked for nothing to be read
+ */
+static gboolean
+run_hotspots (xmms_ringbuf_t *ringbuf)
 {
-	guint to_read, r = 0, cnt, tmp;
 	gboolean ok;
 
-	to_read = MIN (len, xmms_ringbuf_bytes_used (ringbuf));
-
 	while (!g_queue_is_empty (ringbuf->hotspots)) {
 		xmms_ringbuf_hotspot_t *hs = g_queue_peek_head (ringbuf->hotspots);
 		if (hs->pos != ringbuf->rd_index) {
-			/* make sure we don't cross a hotspot */
-			to_read = MIN (to_read,
-			               (hs->pos - ringbuf->rd_index + ringbuf->buffer_size)
-			               % ringbuf->buffer_size);
 			break;
 		}
 
@@ -189,13 +288,42 @@ read_bytes (xmms_ringbuf_t *ringbuf, guint8 *data, guint len)
 		g_free (hs);
 
 		if (!ok) {
-			return 0;
+			return FALSE;
 		}
 
 		/* we loop here, to see if there are multiple
 		   hotspots in same position */
 	}
 
+	return TRUE;
+}
+
+/**
+ * Number of bytes that can be read without crossing a hotspot.
+ */
+static guint
+bytes_to_hotspot (const xmms_ringbuf_t *ringbuf)
+{
+	xmms_ringbuf_hotspot_t *hs;
+	guint used;
+
+	used = xmms_ringbuf_bytes_used (ringbuf);
+
+	if (g_queue_is_empty (ringbuf->hotspots)) {
+		return used;
+	}
+
+	hs = g_queue_peek_head (ringbuf->hotspots);
+
+	return MIN (used, (hs->pos - ringbuf->rd_index + ringbuf->buffer_size)
+	                  % ringbuf->buffer_size);
+}
+
+static guint
+copy_bytes (xmms_ringbuf_t *ringbuf, guint8 *data, guint to_read)
+{
+	guint r = 0, cnt, tmp;
+
 	tmp = ringbuf->rd_index;
 
 	while (to_read > 0) {
@@ -210,6 +338,28 @@ read_bytes (xmms_ringbuf_t *ringbuf, guint8 *data, guint len)
 	return r;
 }
 
+static guint
+read_bytes (xmms_ringbuf_t *ringbuf, guint8 *data, guint len)
+{
+	if (!run_hotspots (ringbuf)) {
+		return 0;
+	}
+
+	/* make sure we don't cross a hotspot */
+	return copy_bytes (ringbuf, data, MIN (len, bytes_to_hotspot (ringbuf)));
+}
+
+static void
+advance (xmms_ringbuf_t *ringbuf, guint r)
+{
+	ringbuf->rd_index += r;
+	ringbuf->rd_index %= ringbuf->buffer_size;
+
+	if (r) {
+		g_cond_broadcast (&ringbuf->free_cond);
+	}
+}
+
 /**
  * Reads data from the ringbuffer. This is a non-blocking call and can
  * return less data than you wanted. Use #xmms_ringbuf_wait_used to
@@ -231,16 +381,74 @@ xmms_ringbuf_read (xmms_ringbuf_t *ringbuf, gpointer data, guint len)
 
 	r = read_bytes (ringbuf, (guint8 *) data, len);
 
-	ringbuf->rd_index += r;
-	ringbuf->rd_index %= ringbuf->buffer_size;
+	advance (ringbuf, r);
 
-	if (r) {
-		g_cond_broadcast (&ringbuf->free_cond);
+	return r;
+}
+
+/**
+ * Run the hotspots that are due at the read position.
+ *
+ * Lets a reader handle song changes and seeks before it sets up the
+ * memory it will read into with #xmms_ringbuf_read_nohotspots.
+ *
+ * @returns number of bytes that can be read before the next hotspot
+ */
+guint
+xmms_ringbuf_hotspots_run (xmms_ringbuf_t *ringbuf)
+{
+	g_return_val_if_fail (ringbuf, 0);
+
+	if (!run_hotspots (ringbuf)) {
+		return 0;
 	}
 
+	return bytes_to_hotspot (ringbuf);
+}
+
+/**
+ * Same as #xmms_ringbuf_read but never runs a hotspot. Reading stops
+ * in front of the next one, so nothing is read if one is due.
+ */
+guint
+xmms_ringbuf_read_nohotspots (xmms_ringbuf_t *ringbuf, gpointer data, guint len)
+{
+	guint r;
+
+	g_return_val_if_fail (ringbuf, 0);
+	g_return_val_if_fail (data, 0);
+	g_return_val_if_fail (len > 0, 0);
+
+	r = copy_bytes (ringbuf, data, MIN (len, bytes_to_hotspot (ringbuf)));
+
+	advance (ringbuf, r);
+
 	return r;
 }
 
+/**
+ * Drop len bytes at the read position as if they had been read.
+ *
+ * Nothing is dropped while a hotspot is pending, since the data
+ * around it may belong to another stream.
+ *
+ * @returns TRUE if len bytes were dropped
+ */
+gboolean
+xmms_ringbuf_skip (xmms_ringbuf_t *ringbuf, guint len)
+{
+	g_return_val_if_fail (ringbuf, FALSE);
+
+	if (!g_queue_is_empty (ringbuf->hotspots) ||
+	    len > xmms_ringbuf_bytes_used (ringbuf)) {
+		return FALSE;
+	}
+
+	advance (ringbuf, len);
+
+	return TRUE;
+}
+
 /**
  * Same as #xmms_ringbuf_read but does not advance in the buffer after
  * the data has been read.
@@ -474,3 +682,22 @@ xmms_ringbuf_hotspot_set (xmms_ringbuf_t *ringbuf, gboolean (*cb) (void *), void
 
 	g_queue_push_tail (ringbuf->hotspots, hs);
 }
+
+/**
+ * Set a hotspot at the read position, it is run before the data
+ * that is in the buffer already.
+ */
+void
+xmms_ringbuf_hotspot_set_front (xmms_ringbuf_t *ringbuf, gboolean (*cb) (void *), void (*destroy) (void *), void *arg)
+{
+	xmms_ringbuf_hotspot_t *hs;
+	g_return_if_fail (ringbuf);
+
+	hs = g_new0 (xmms_ringbuf_hotspot_t, 1);
+	hs->pos = ringbuf->rd_index;
+	hs->callback = cb;
+	hs->destroy = destroy;
+	hs->arg = arg;
+
+	g_queue_push_head (ringbuf->hotspots, hs);
+}
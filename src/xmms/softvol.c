@@ -0,0 +1,236 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/**
+ * @file
+ * Volume in software, for outputs without a mixer.
+ *
+ * Gains never exceed 1, so scaled samples can't overflow.
+ */
+
+#include <math.h>
+#include <glib.h>
+
+#include <xmmspriv/xmms_softvol.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Start out at gain, without ramping.
+ */
+void
+xmms_softvol_init (xmms_softvol_t *vol, gfloat gain)
+{
+	vol->gain = gain;
+	vol->target = gain;
+	vol->step = 0.0f;
+	vol->ramp = 0;
+	vol->channel = 0;
+}
+
+/**
+ * Change the gain, ramping to it over the next ramp frames so the
+ * change doesn't click.
+ */
+void
+xmms_softvol_set (xmms_softvol_t *vol, gfloat gain, guint ramp)
+{
+	vol->target = gain;
+
+	if (!ramp || vol->gain == gain) {
+		vol->gain = gain;
+		vol->step = 0.0f;
+		vol->ramp = 0;
+		return;
+	}
+
+	vol->step = (gain - vol->gain) / ramp;
+	vol->ramp = ramp;
+}
+
+/**
+ * Get the gain for a volume in percent. The curve is cubic, which is
+ * closer to how loud it sounds than a linear one.
+ */
+gfloat
+xmms_softvol_gain (gint volume)
+{
+	gfloat x = CLAMP (volume, 0, 100) / 100.0f;
+
+	return x * x * x;
+}
+
+static void
+scale_s16 (gpointer buf, gint len, gfloat gain)
+{
+	xmms_samples16_t *s = (xmms_samples16_t *) buf;
+	gint i = 0;
+
+#ifdef __SSE2__
+	__m128 g = _mm_set1_ps (gain);
+
+	for (; i + 8 <= len; i += 8) {
+		__m128i v;
+		__m128 lo, hi;
+
+		v = _mm_loadu_si128 ((const __m128i *) &s[i]);
+
+		lo = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16));
+		hi = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16));
+
+		v = _mm_packs_epi32 (_mm_cvtps_epi32 (_mm_mul_ps (lo, g)),
+		                     _mm_cvtps_epi32 (_mm_mul_ps (hi, g)));
+		_mm_storeu_si128 ((__m128i *) &s[i], v);
+	}
+#endif
+
+	for (; i < len; i++) {
+		s[i] = lrintf (s[i] * gain);
+	}
+}
+
+static void
+scale_float (gpointer buf, gint len, gfloat gain)
+{
+	xmms_samplefloat_t *s = (xmms_samplefloat_t *) buf;
+	gint i = 0;
+
+#ifdef __SSE2__
+	__m128 g = _mm_set1_ps (gain);
+
+	for (; i + 4 <= len; i += 4) {
+		_mm_storeu_ps (&s[i], _mm_mul_ps (_mm_loadu_ps (&s[i]), g));
+	}
+#endif
+
+	for (; i < len; i++) {
+		s[i] *= gain;
+	}
+}
+
+/* the less common formats, unsigned ones are scaled around the middle */
+static void
+scale_other (xmms_sample_format_t format, gpointer buf, gint len, gfloat gain)
+{
+	gint i;
+
+	switch (format) {
+		case XMMS_SAMPLE_FORMAT_S8: {
+			xmms_samples8_t *s = buf;
+			for (i = 0; i < len; i++) {
+				s[i] = lrintf (s[i] * gain);
+			}
+			break;
+		}
+		case XMMS_SAMPLE_FORMAT_U8: {
+			xmms_sampleu8_t *s = buf;
+			for (i = 0; i < len; i++) {
+				s[i] = 128 + lrintf ((s[i] - 128) * gain);
+			}
+			break;
+		}
+		case XMMS_SAMPLE_FORMAT_U16: {
+			xmms_sampleu16_t *s = buf;
+			for (i = 0; i < len; i++) {
+				s[i] = 32768 + lrintf ((s[i] - 32768) * gain);
+			}
+			break;
+		}
+		case XMMS_SAMPLE_FORMAT_S32: {
+			/* single precision would lose the low bits */
+			xmms_samples32_t *s = buf;
+			for (i = 0; i < len; i++) {
+				s[i] = llrint ((gdouble) s[i] * gain);
+			}
+			break;
+		}
+		case XMMS_SAMPLE_FORMAT_U32: {
+			xmms_sampleu32_t *s = buf;
+			for (i = 0; i < len; i++) {
+				s[i] = 2147483648U + llrint (((gdouble) s[i] - 2147483648.0) * gain);
+			}
+			break;
+		}
+		case XMMS_SAMPLE_FORMAT_DOUBLE: {
+			xmms_sampledouble_t *s = buf;
+			for (i = 0; i < len; i++) {
+				s[i] *= gain;
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+static void
+scale (xmms_sample_format_t format, gpointer buf, gint len, gfloat gain)
+{
+	switch (format) {
+		case XMMS_SAMPLE_FORMAT_S16:
+			scale_s16 (buf, len, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_FLOAT:
+			scale_float (buf, len, gain);
+			break;
+		default:
+			scale_other (format, buf, len, gain);
+			break;
+	}
+}
+
+/**
+ * Scale samples interleaved samples in buf by the gain, going on with
+ * a ramp started by #xmms_softvol_set. The gain changes at frame
+ * boundaries only, also when a call ends within a frame. Nothing is
+ * touched at a gain of 1.
+ */
+void
+xmms_softvol_apply (xmms_softvol_t *vol, xmms_sample_format_t format,
+                    gint channels, gpointer buf, guint samples)
+{
+	gint size;
+
+	g_return_if_fail (channels > 0);
+
+	size = xmms_sample_size_get (format);
+
+	if (vol->channel >= channels) {
+		vol->channel = 0;
+	}
+
+	/* the ramp is short, a sample at a time will do */
+	while (vol->ramp && samples) {
+		if (!vol->channel) {
+			vol->ramp--;
+			vol->gain = vol->ramp ? vol->gain + vol->step : vol->target;
+		}
+
+		scale (format, buf, 1, vol->gain);
+
+		buf = (gchar *) buf + size;
+		vol->channel = (vol->channel + 1) % channels;
+		samples--;
+	}
+
+	if (samples && vol->gain != 1.0f) {
+		scale (format, buf, samples, vol->gain);
+	}
+
+	vol->channel = (vol->channel + samples) % channels;
+}
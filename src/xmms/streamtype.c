@@ -20,6 +20,8 @@
  */
 
 #include <glib.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <xmmspriv/xmms_xform.h>
 #include <xmms/xmms_log.h>
@@ -233,6 +235,148 @@ xmms_stream_type_match (const xmms_stream_type_t *in_type, const xmms_stream_typ
 	return TRUE;
 }
 
+/**
+ * Build a string identifying an out-type for plugin matching.
+ * URLs are reduced to their scheme, so types that only differ in
+ * the location of the media share the same signature.
+ */
+gchar *
+xmms_stream_type_signature (const xmms_stream_type_t *st)
+{
+	GString *sig;
+	GList *n;
+
+	sig = g_string_sized_new (64);
+
+	for (n = st->list; n; n = g_list_next (n)) {
+		xmms_stream_type_val_t *val = n->data;
+		const gchar *end;
+
+		switch (val->type) {
+		case STRING:
+			end = NULL;
+			if (val->key == XMMS_STREAM_TYPE_URL) {
+				end = strstr (val->d.string, "://");
+			}
+			if (end) {
+				g_string_append_printf (sig, "%d=%.*s;", val->key,
+				                        (gint) (end - val->d.string),
+				                        val->d.string);
+			} else {
+				g_string_append_printf (sig, "%d=%s;", val->key,
+				                        val->d.string);
+			}
+			break;
+		case INT:
+			g_string_append_printf (sig, "%d=%d;", val->key, val->d.num);
+			break;
+		}
+	}
+
+	return g_string_free (sig, FALSE);
+}
+
+/**
+ * Check that an in-type matches URLs on their scheme only, which is
+ * what #xmms_stream_type_signature relies on.
+ */
+gboolean
+xmms_stream_type_matches_url_by_scheme (const xmms_stream_type_t *in_type)
+{
+	const gchar *url, *end;
+
+	url = xmms_stream_type_get_str (in_type, XMMS_STREAM_TYPE_URL);
+	if (!url) {
+		return TRUE;
+	}
+
+	end = strstr (url, "://");
+	if (!end || strcmp (end, "://*") != 0) {
+		return FALSE;
+	}
+
+	return strcspn (url, "*?") == end - url;
+}
+
+/**
+ * Flatten a stream type into a string vector of its name, priority
+ * and key/value pairs, as stored in the plugin manifest.
+ */
+gchar **
+xmms_stream_type_to_strv (const xmms_stream_type_t *st)
+{
+	GPtrArray *strv;
+	GList *n;
+
+	strv = g_ptr_array_new ();
+	g_ptr_array_add (strv, g_strdup (st->name));
+	g_ptr_array_add (strv, g_strdup_printf ("%d", st->priority));
+
+	for (n = st->list; n; n = g_list_next (n)) {
+		xmms_stream_type_val_t *val = n->data;
+
+		g_ptr_array_add (strv, g_strdup_printf ("%d", val->key));
+		if (val->type == STRING) {
+			g_ptr_array_add (strv, g_strdup (val->d.string));
+		} else {
+			g_ptr_array_add (strv, g_strdup_printf ("%d", val->d.num));
+		}
+	}
+
+	g_ptr_array_add (strv, NULL);
+
+	return (gchar **) g_ptr_array_free (strv, FALSE);
+}
+
+/**
+ * Rebuild a stream type flattened by #xmms_stream_type_to_strv.
+ * @return The stream type, or NULL if strv is malformed.
+ */
+xmms_stream_type_t *
+xmms_stream_type_from_strv (gchar **strv)
+{
+	xmms_stream_type_t *res;
+	guint i, len;
+
+	len = g_strv_length (strv);
+	if (len < 2 || len % 2) {
+		return NULL;
+	}
+
+	res = xmms_object_new (xmms_stream_type_t, xmms_stream_type_destroy);
+	res->name = g_strdup (strv[0]);
+	res->priority = atoi (strv[1]);
+
+	for (i = 2; i < len; i += 2) {
+		xmms_stream_type_val_t *val;
+
+		val = g_new0 (xmms_stream_type_val_t, 1);
+		val->key = atoi (strv[i]);
+
+		switch (val->key) {
+		case XMMS_STREAM_TYPE_MIMETYPE:
+		case XMMS_STREAM_TYPE_URL:
+			val->type = STRING;
+			val->d.string = g_strdup (strv[i + 1]);
+			break;
+		case XMMS_STREAM_TYPE_FMT_FORMAT:
+		case XMMS_STREAM_TYPE_FMT_CHANNELS:
+		case XMMS_STREAM_TYPE_FMT_SAMPLERATE:
+			val->type = INT;
+			val->d.num = atoi (strv[i + 1]);
+			break;
+		default:
+			g_free (val);
+			xmms_object_unref (res);
+			return NULL;
+		}
+
+		res->list = g_list_append (res->list, val);
+	}
+
+	return res;
+}
+
 /**
  * Find the best pair of formats
  */
@@ -272,7 +416,10 @@ xmms_stream_type_coerce (const xmms_stream_type_t *in, const GList *goal_types)
 		if (gsamplerate == -1) {
 			gsamplerate = samplerate;
 		}
-		if (gformat == -1 || gchannels == -1) {
+		if (gchannels == -1) {
+			gchannels = channels;
+		}
+		if (gformat == -1) {
 			continue;
 		}
 
@@ -322,10 +469,13 @@ xmms_stream_type_coerce (const xmms_stream_type_t *in, const GList *goal_types)
 	gchannels = xmms_stream_type_get_int (best, XMMS_STREAM_TYPE_FMT_CHANNELS);
 	gsamplerate = xmms_stream_type_get_int (best, XMMS_STREAM_TYPE_FMT_SAMPLERATE);
 
-	/* Use the requested samplerate if target accepts any. */
+	/* Use the requested samplerate and channels if target accepts any. */
 	if (gsamplerate == -1) {
 		gsamplerate = samplerate;
 	}
+	if (gchannels == -1) {
+		gchannels = channels;
+	}
 
 	best = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
 	                              XMMS_STREAM_TYPE_MIMETYPE, gmime,
@@ -20,6 +20,7 @@
  */
 
 #include <string.h>
+#include <time.h>
 
 #include <xmmspriv/xmms_plugin.h>
 #include <xmmspriv/xmms_xform.h>
@@ -27,10 +28,36 @@
 #include <xmmspriv/xmms_medialib.h>
 #include <xmmspriv/xmms_utils.h>
 #include <xmmspriv/xmms_xform_plugin.h>
+#include <xmmspriv/xmms_bindata.h>
+#include <xmmspriv/xmms_realtime.h>
+#include <xmms/xmms_bindata.h>
 #include <xmms/xmms_ipc.h>
 #include <xmms/xmms_log.h>
 #include <xmms/xmms_object.h>
 
+/* Reads, seeks and times are only counted while profiling is enabled.
+ * Times are in nanoseconds, the self times exclude what was spent in
+ * the previous xform. Only the thread reading from the xform writes
+ * them, with profile_lock held so others can read them whole. */
+typedef struct xmms_xform_profile_St {
+	gint64 reads;
+	gint64 read_bytes;
+	gint64 seeks;
+	gint64 moved_bytes;
+	gint64 time;
+	gint64 cpu_time;
+	gint64 self_time;
+	gint64 self_cpu_time;
+	gint64 seek_time;
+} xmms_xform_profile_t;
+
+typedef struct xmms_xform_profile_mark_St {
+	gint64 time;
+	gint64 cpu_time;
+	gint64 prev_time;
+	gint64 prev_cpu_time;
+} xmms_xform_profile_mark_t;
+
 struct xmms_xform_St {
 	xmms_object_t obj;
 	struct xmms_xform_St *prev;
@@ -54,15 +81,44 @@ struct xmms_xform_St {
 	char *buffer;
 	gint buffered;
 	gint buffersize;
+	gboolean buffer_locked;
 
 	gboolean metadata_collected;
 
 	gboolean metadata_changed;
+	/** Metadata keyed by the quark of a known property name, other
+	    keys, which may come from file contents, by a copy of the key */
 	GHashTable *metadata;
+	GHashTable *metadata_other;
 
 	GHashTable *privdata;
 	GQueue *hotspots;
 
+	/* set when the next xform applies the gain this one hands over */
+	gboolean gain_accepted;
+	gfloat gain_deferred;
+
+	/* set on the last of a run of adjacent in-place effects, which
+	 * then reads for all of them, see xmms_xform_effect_fuse */
+	GPtrArray *fused;
+	gint fused_block;
+
+	/* output served from memory, see xmms_xform_mapping_set */
+	const guchar *map;
+	gint64 map_size;
+	gint64 map_pos;
+
+	/* sorted xmms_xform_seekpoint_t, see xmms_xform_seekpoint_add */
+	GArray *seekpoints;
+	gint64 seekpoint_interval;
+	gboolean seekpoints_dirty;
+
+	GMutex profile_lock;
+	xmms_xform_profile_t profile;
+	/** Fill level of a read-ahead buffer in percent, -1 if there is
+	    none. Atomic. */
+	gint buffer_fill;
+
 	xmmsv_t *browse_list;
 	xmmsv_t *browse_dict;
 	gint browse_index;
@@ -74,6 +130,14 @@ struct xmms_xform_St {
 	} lr;
 };
 
+typedef struct xmms_xform_seekpoint_St {
+	gint64 sample;
+	gint64 offset;
+} xmms_xform_seekpoint_t;
+
+/* upper bound on the number of points kept per entry */
+#define SEEKPOINTS_MAX 16384
+
 typedef struct xmms_xform_hotspot_St {
 	guint pos;
 	gchar *key;
@@ -82,6 +146,9 @@ typedef struct xmms_xform_hotspot_St {
 
 #define READ_CHUNK 4096
 
+/* fused effects are run block by block so the data stays in cache */
+#define FUSED_BLOCK_SIZE 16384
+
 
 xmms_xform_t *xmms_xform_find (xmms_xform_t *prev, xmms_medialib_entry_t entry,
                                GList *goal_hints);
@@ -93,7 +160,10 @@ static xmms_xform_t *xmms_xform_new_effect (xmms_xform_t* last,
                                             xmms_medialib_entry_t entry,
                                             GList *goal_formats,
                                             const gchar *name);
+static void xmms_xform_effect_fuse (xmms_xform_t *xform);
+static void xmms_xform_seekpoints_save (xmms_xform_t *xform);
 static void xmms_xform_destroy (xmms_object_t *object);
+static void xmms_xform_profile_moved (xmms_xform_t *xform, gint64 bytes);
 static xmms_stream_type_t *xmms_xform_get_out_stream_type (xmms_xform_t *xform);
 
 void
@@ -315,6 +385,11 @@ xmms_xform_destroy (xmms_object_t *object)
 
 	XMMS_DBG ("Freeing xform '%s'", xmms_xform_shortname (xform));
 
+	if (xform->seekpoints) {
+		xmms_xform_seekpoints_save (xform);
+		g_array_free (xform->seekpoints, TRUE);
+	}
+
 	/* The 'destroy' method is not mandatory */
 	if (xform->plugin && xform->inited) {
 		if (xmms_xform_plugin_can_destroy (xform->plugin)) {
@@ -323,11 +398,21 @@ xmms_xform_destroy (xmms_object_t *object)
 	}
 
 	g_hash_table_destroy (xform->metadata);
+	g_hash_table_destroy (xform->metadata_other);
 
 	g_hash_table_destroy (xform->privdata);
 	g_queue_free (xform->hotspots);
+	g_mutex_clear (&xform->profile_lock);
 
-	g_free (xform->buffer);
+	if (xform->buffer_locked) {
+		xmms_realtime_locked_free (xform->buffer, xform->buffersize);
+	} else {
+		g_free (xform->buffer);
+	}
+
+	if (xform->fused) {
+		g_ptr_array_free (xform->fused, TRUE);
+	}
 
 	if (xform->out_type) {
 		xmms_object_unref (xform->out_type);
@@ -350,6 +435,10 @@ xmms_xform_new (xmms_xform_plugin_t *plugin, xmms_xform_t *prev,
 {
 	xmms_xform_t *xform;
 
+	if (plugin && !xmms_plugin_ensure_loaded ((xmms_plugin_t *) plugin)) {
+		return NULL;
+	}
+
 	xform = xmms_object_new (xmms_xform_t, xmms_xform_destroy);
 
 	xform->plugin = plugin ? xmms_object_ref (plugin) : NULL;
@@ -357,15 +446,20 @@ xmms_xform_new (xmms_xform_plugin_t *plugin, xmms_xform_t *prev,
 	xform->medialib = medialib;
 	xform->goal_hints = goal_hints;
 	xform->lr.bufend = &xform->lr.buf[0];
+	xform->gain_deferred = 1.0;
+	g_mutex_init (&xform->profile_lock);
+	xform->buffer_fill = -1;
 
 	if (prev) {
 		xmms_object_ref (prev);
 		xform->prev = prev;
 	}
 
-	xform->metadata = g_hash_table_new_full (g_str_hash, g_str_equal,
-	                                         g_free,
+	xform->metadata = g_hash_table_new_full (NULL, NULL, NULL,
 	                                         (GDestroyNotify) xmmsv_unref);
+	xform->metadata_other = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                               g_free,
+	                                               (GDestroyNotify) xmmsv_unref);
 
 	xform->privdata = g_hash_table_new_full (g_str_hash, g_str_equal,
 	                                         g_free,
@@ -484,12 +578,125 @@ xmms_xform_metadata_mapper_match (xmms_xform_t *xform, const gchar *key, const g
 	return xmms_xform_plugin_metadata_mapper_match (xform->plugin, xform, key, value, length);
 }
 
+/* the property names known to the medialib, the only keys interned */
+static const gchar *metadata_known_keys[] = {
+	XMMS_MEDIALIB_ENTRY_PROPERTY_MIME,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ID,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_URL,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ARTIST,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ARTIST_SORT,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ORIGINAL_ARTIST,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ALBUM,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ALBUM_SORT,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ALBUM_ARTIST,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ALBUM_ARTIST_SORT,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_TITLE,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_TITLE_SORT,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_YEAR,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ORIGINALYEAR,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_TRACKNR,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_TOTALTRACKS,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_GENRE,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_BITRATE,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_COMMENT,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_COMMENT_LANG,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_DURATION,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_CHANNEL,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_CHANNELS,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_SAMPLE_FMT,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_SAMPLERATE,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_LMOD,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_GAIN_TRACK,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_GAIN_ALBUM,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_PEAK_TRACK,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_PEAK_ALBUM,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_COMPILATION,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ALBUM_ID,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ARTIST_ID,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_TRACK_ID,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ADDED,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_BPM,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_LASTSTARTED,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_SIZE,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_SEEKINDEX,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_IS_VBR,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_SUBTUNES,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_CHAIN,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_TIMESPLAYED,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_PARTOFSET,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_TOTALSET,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_PICTURE_FRONT,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_PICTURE_FRONT_MIME,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_STARTMS,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_STOPMS,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_STATUS,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_DESCRIPTION,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_GROUPING,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_PERFORMER,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_CONDUCTOR,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_REMIXER,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_DJMIXER,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_MIXER,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ARRANGER,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_PRODUCER,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_PUBLISHER,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_COMPOSER,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_LYRICIST,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ASIN,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_ISRC,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_BARCODE,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_CATALOGNUMBER,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_COPYRIGHT,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_WEBSITE_ARTIST,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_WEBSITE_FILE,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_WEBSITE_PUBLISHER,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_WEBSITE_COPYRIGHT,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_RELEASE_STATUS,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_RELEASE_TYPE,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_RELEASE_COUNTRY,
+	XMMS_MEDIALIB_ENTRY_PROPERTY_RELEASE_FORMAT,
+};
+
+/* Get the quark of a key, 0 if it isn't a known property name. Quarks
+ * are never freed, so keys made up from file contents must not become
+ * ones. */
+static GQuark
+xmms_xform_metadata_quark (const gchar *key)
+{
+	static gsize interned = 0;
+
+	if (g_once_init_enter (&interned)) {
+		gint i;
+
+		for (i = 0; i < G_N_ELEMENTS (metadata_known_keys); i++) {
+			g_quark_from_static_string (metadata_known_keys[i]);
+		}
+
+		g_once_init_leave (&interned, 1);
+	}
+
+	return g_quark_try_string (key);
+}
+
+static void
+xmms_xform_metadata_insert (xmms_xform_t *xform, const gchar *key,
+                            xmmsv_t *val)
+{
+	GQuark quark = xmms_xform_metadata_quark (key);
+
+	if (quark) {
+		g_hash_table_insert (xform->metadata, GUINT_TO_POINTER (quark), val);
+	} else {
+		g_hash_table_insert (xform->metadata_other, g_strdup (key), val);
+	}
+
+	xform->metadata_changed = TRUE;
+}
+
 gboolean
 xmms_xform_metadata_set_int (xmms_xform_t *xform, const char *key, int val)
 {
-	g_hash_table_insert (xform->metadata, g_strdup (key),
-	                     xmmsv_new_int (val));
-	xform->metadata_changed = TRUE;
+	xmms_xform_metadata_insert (xform, key, xmmsv_new_int (val));
 	return TRUE;
 }
 
@@ -510,10 +717,7 @@ xmms_xform_metadata_set_str (xmms_xform_t *xform, const char *key,
 		}
 	}
 
-	g_hash_table_insert (xform->metadata, g_strdup (key),
-	                     xmmsv_new_string (val));
-
-	xform->metadata_changed = TRUE;
+	xmms_xform_metadata_insert (xform, key, xmmsv_new_string (val));
 
 	return TRUE;
 }
@@ -522,9 +726,16 @@ static const xmmsv_t *
 xmms_xform_metadata_get_val (xmms_xform_t *xform, const char *key)
 {
 	xmmsv_t *val = NULL;
+	GQuark quark;
+
+	quark = xmms_xform_metadata_quark (key);
 
 	for (; xform; xform = xform->prev) {
-		val = g_hash_table_lookup (xform->metadata, key);
+		if (quark) {
+			val = g_hash_table_lookup (xform->metadata, GUINT_TO_POINTER (quark));
+		} else {
+			val = g_hash_table_lookup (xform->metadata_other, key);
+		}
 		if (val) {
 			break;
 		}
@@ -581,7 +792,7 @@ static void
 add_metadatum (gpointer _key, gpointer _value, gpointer user_data)
 {
 	xmmsv_t *value = (xmmsv_t *) _value;
-	gchar *key = (gchar *) _key;
+	const gchar *key = (const gchar *) _key;
 	metadata_festate_t *st = (metadata_festate_t *) user_data;
 
 	if (xmmsv_get_type (value) == XMMSV_TYPE_STRING) {
@@ -605,6 +816,13 @@ add_metadatum (gpointer _key, gpointer _value, gpointer user_data)
 	}
 }
 
+static void
+add_metadatum_quark (gpointer _key, gpointer _value, gpointer user_data)
+{
+	add_metadatum ((gpointer) g_quark_to_string (GPOINTER_TO_UINT (_key)),
+	               _value, user_data);
+}
+
 static void
 xmms_xform_metadata_collect_one (xmms_xform_t *xform, metadata_festate_t *info)
 {
@@ -616,7 +834,8 @@ xmms_xform_metadata_collect_one (xmms_xform_t *xform, metadata_festate_t *info)
 	            xmms_xform_shortname (xform));
 
 	info->source = src;
-	g_hash_table_foreach (xform->metadata, add_metadatum, info);
+	g_hash_table_foreach (xform->metadata, add_metadatum_quark, info);
+	g_hash_table_foreach (xform->metadata_other, add_metadatum, info);
 	info->source = NULL;
 
 	xform->metadata_changed = FALSE;
@@ -828,6 +1047,382 @@ xmms_xform_auxdata_get_bin (xmms_xform_t *xform, const gchar *key,
 	return FALSE;
 }
 
+/**
+ * Announce that this xform multiplies what it reads by the gain
+ * returned by #xmms_xform_gain_get, so a gain effect right in front
+ * of it can hand its gain over instead of walking the samples itself.
+ * Call from the init method.
+ */
+void
+xmms_xform_gain_accept (xmms_xform_t *xform)
+{
+	g_return_if_fail (xform);
+
+	if (xform->prev) {
+		xform->prev->gain_accepted = TRUE;
+	}
+}
+
+/**
+ * Hand a constant gain over to the next xform, if it accepts one.
+ * Gain effects call this from their read method with the gain they
+ * would apply to the data just read.
+ * @return TRUE if the next xform applies the gain, in which case the
+ * caller must leave the samples untouched.
+ */
+gboolean
+xmms_xform_gain_defer (xmms_xform_t *xform, gfloat gain)
+{
+	g_return_val_if_fail (xform, FALSE);
+
+	if (!xform->gain_accepted) {
+		return FALSE;
+	}
+
+	xform->gain_deferred = gain;
+
+	return TRUE;
+}
+
+/**
+ * Get the gain handed over by the previous xform for the data it
+ * returned last, see #xmms_xform_gain_accept.
+ * @return The gain, 1.0 if there is nothing to apply.
+ */
+gfloat
+xmms_xform_gain_get (xmms_xform_t *xform)
+{
+	g_return_val_if_fail (xform, 1.0);
+
+	if (!xform->prev) {
+		return 1.0;
+	}
+
+	return xform->prev->gain_deferred;
+}
+
+void
+xmms_xform_mapping_set (xmms_xform_t *xform, gconstpointer data, gint64 size)
+{
+	g_return_if_fail (xform);
+	g_return_if_fail (data || !size);
+
+	xform->map = data;
+	xform->map_size = size;
+	xform->map_pos = 0;
+}
+
+static gint
+xmms_xform_mapping_read (xmms_xform_t *xform, gpointer buf, gint siz,
+                         gboolean peek)
+{
+	siz = MIN (siz, xform->map_size - xform->map_pos);
+
+	memcpy (buf, xform->map + xform->map_pos, siz);
+
+	if (!peek) {
+		xform->map_pos += siz;
+	}
+
+	if (!siz) {
+		xform->eos = TRUE;
+	}
+
+	return siz;
+}
+
+static gint64
+xmms_xform_mapping_seek (xmms_xform_t *xform, gint64 offset,
+                         xmms_xform_seek_mode_t whence, xmms_error_t *err)
+{
+	switch (whence) {
+		case XMMS_XFORM_SEEK_CUR:
+			offset += xform->map_pos;
+			break;
+		case XMMS_XFORM_SEEK_END:
+			offset += xform->map_size;
+			break;
+		default:
+			break;
+	}
+
+	if (offset < 0 || offset > xform->map_size) {
+		xmms_error_set (err, XMMS_ERROR_INVAL, "Couldn't seek");
+		return -1;
+	}
+
+	xform->map_pos = offset;
+	xform->eos = FALSE;
+
+	return offset;
+}
+
+static guint
+xmms_xform_seekpoint_upper (GArray *points, gint64 sample)
+{
+	guint lo = 0, hi = points->len;
+
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+
+		if (g_array_index (points, xmms_xform_seekpoint_t, mid).sample <= sample) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/* The index is stored in bindata as a serialized dict, and the medialib
+ * only keeps its hash. The dict remembers the decoder and the size of
+ * the source so an index built for other data is never used. */
+static xmmsv_t *
+xmms_xform_seekpoints_describe (xmms_xform_t *xform)
+{
+	gint32 size = -1;
+
+	xmms_xform_metadata_get_int (xform, XMMS_MEDIALIB_ENTRY_PROPERTY_SIZE,
+	                             &size);
+
+	return xmmsv_build_dict (
+		XMMSV_DICT_ENTRY_STR ("decoder", xmms_xform_shortname (xform)),
+		XMMSV_DICT_ENTRY_INT ("entry", xform->entry),
+		XMMSV_DICT_ENTRY_INT ("size", size),
+		XMMSV_DICT_END);
+}
+
+static gboolean
+xmms_xform_seekpoints_parse (xmms_xform_t *xform, xmmsv_t *dict)
+{
+	xmms_xform_seekpoint_t point;
+	xmmsv_t *expected, *bin;
+	const gchar *decoder, *want;
+	const guchar *data;
+	gint64 size, want_size;
+	guint len, i;
+
+	expected = xmms_xform_seekpoints_describe (xform);
+
+	xmmsv_dict_entry_get_string (expected, "decoder", &want);
+	xmmsv_dict_entry_get_int64 (expected, "size", &want_size);
+
+	if (!xmmsv_dict_entry_get_string (dict, "decoder", &decoder) ||
+	    !xmmsv_dict_entry_get_int64 (dict, "size", &size) ||
+	    !xmmsv_dict_get (dict, "points", &bin) ||
+	    !xmmsv_get_bin (bin, &data, &len) ||
+	    strcmp (decoder, want) != 0 || size != want_size ||
+	    len % (2 * sizeof (gint64)) != 0) {
+		xmmsv_unref (expected);
+		return FALSE;
+	}
+
+	xmmsv_unref (expected);
+
+	for (i = 0; i < len; i += 2 * sizeof (gint64)) {
+		gint64 be[2];
+
+		memcpy (be, data + i, sizeof (be));
+		point.sample = GINT64_FROM_BE (be[0]);
+		point.offset = GINT64_FROM_BE (be[1]);
+		g_array_append_val (xform->seekpoints, point);
+	}
+
+	return TRUE;
+}
+
+static void
+xmms_xform_seekpoints_load (xmms_xform_t *xform)
+{
+	xmms_medialib_session_t *session;
+	xmmsv_t *blob, *dict;
+	gchar *hash = NULL;
+	guchar *data;
+	gsize size;
+	gint rate;
+
+	if (xform->seekpoints) {
+		return;
+	}
+
+	xform->seekpoints = g_array_new (FALSE, FALSE,
+	                                 sizeof (xmms_xform_seekpoint_t));
+
+	/* about one point per second of audio */
+	rate = xmms_stream_type_get_int (xform->out_type,
+	                                 XMMS_STREAM_TYPE_FMT_SAMPLERATE);
+	xform->seekpoint_interval = rate > 0 ? rate : 44100;
+
+	if (!xform->medialib || !xform->entry) {
+		return;
+	}
+
+	do {
+		session = xmms_medialib_session_begin (xform->medialib);
+		g_free (hash);
+		hash = xmms_medialib_entry_property_get_str (session, xform->entry,
+		                                             XMMS_MEDIALIB_ENTRY_PROPERTY_SEEKINDEX);
+	} while (!xmms_medialib_session_commit (session));
+
+	if (!hash) {
+		return;
+	}
+
+	if (xmms_bindata_get (hash, &data, &size)) {
+		blob = xmmsv_new_bin (data, size);
+		dict = xmmsv_deserialize (blob);
+
+		if (!dict || !xmms_xform_seekpoints_parse (xform, dict)) {
+			XMMS_DBG ("Ignoring stale seek index %s", hash);
+			g_array_set_size (xform->seekpoints, 0);
+		}
+
+		if (dict) {
+			xmmsv_unref (dict);
+		}
+		xmmsv_unref (blob);
+		g_free (data);
+	}
+
+	g_free (hash);
+}
+
+static void
+xmms_xform_seekpoints_save (xmms_xform_t *xform)
+{
+	xmms_medialib_session_t *session;
+	xmmsv_t *dict, *blob;
+	const guchar *data;
+	gint64 *points;
+	gchar hash[33];
+	gchar *old = NULL;
+	guint len, i;
+
+	if (!xform->seekpoints_dirty || !xform->medialib || !xform->entry) {
+		return;
+	}
+
+	points = g_new (gint64, 2 * xform->seekpoints->len);
+	for (i = 0; i < xform->seekpoints->len; i++) {
+		xmms_xform_seekpoint_t *p;
+
+		p = &g_array_index (xform->seekpoints, xmms_xform_seekpoint_t, i);
+		points[2 * i] = GINT64_TO_BE (p->sample);
+		points[2 * i + 1] = GINT64_TO_BE (p->offset);
+	}
+
+	dict = xmms_xform_seekpoints_describe (xform);
+	blob = xmmsv_new_bin ((const guchar *) points,
+	                      2 * sizeof (gint64) * xform->seekpoints->len);
+	xmmsv_dict_set (dict, "points", blob);
+	xmmsv_unref (blob);
+	g_free (points);
+
+	blob = xmmsv_serialize (dict);
+	xmmsv_unref (dict);
+
+	if (!blob || !xmmsv_get_bin (blob, &data, &len) ||
+	    !xmms_bindata_plugin_add (data, len, hash)) {
+		xmms_log_error ("Couldn't store seek index for entry %d", xform->entry);
+		if (blob) {
+			xmmsv_unref (blob);
+		}
+		return;
+	}
+
+	xmmsv_unref (blob);
+
+	do {
+		session = xmms_medialib_session_begin (xform->medialib);
+		g_free (old);
+		old = xmms_medialib_entry_property_get_str (session, xform->entry,
+		                                            XMMS_MEDIALIB_ENTRY_PROPERTY_SEEKINDEX);
+		xmms_medialib_entry_property_set_str (session, xform->entry,
+		                                      XMMS_MEDIALIB_ENTRY_PROPERTY_SEEKINDEX,
+		                                      hash);
+	} while (!xmms_medialib_session_commit (session));
+
+	/* the entry id is part of the data, so nobody else refers to it */
+	if (old && strcmp (old, hash) != 0) {
+		xmms_bindata_remove (old);
+	}
+
+	g_free (old);
+}
+
+void
+xmms_xform_seekpoint_add (xmms_xform_t *xform, gint64 sample, gint64 offset)
+{
+	xmms_xform_seekpoint_t point, *p;
+	guint i;
+
+	g_return_if_fail (xform);
+	g_return_if_fail (sample >= 0 && offset >= 0);
+
+	xmms_xform_seekpoints_load (xform);
+
+	if (xform->seekpoints->len >= SEEKPOINTS_MAX) {
+		return;
+	}
+
+	i = xmms_xform_seekpoint_upper (xform->seekpoints, sample);
+
+	/* keep the index sparse, a point close to an existing one
+	 * doesn't make any seek noticeably cheaper */
+	if (i > 0) {
+		p = &g_array_index (xform->seekpoints, xmms_xform_seekpoint_t, i - 1);
+		if (sample - p->sample < xform->seekpoint_interval) {
+			return;
+		}
+	}
+
+	if (i < xform->seekpoints->len) {
+		p = &g_array_index (xform->seekpoints, xmms_xform_seekpoint_t, i);
+		if (p->sample - sample < xform->seekpoint_interval) {
+			return;
+		}
+	}
+
+	point.sample = sample;
+	point.offset = offset;
+	g_array_insert_val (xform->seekpoints, i, point);
+
+	xform->seekpoints_dirty = TRUE;
+}
+
+gboolean
+xmms_xform_seekpoint_find (xmms_xform_t *xform, gint64 sample,
+                           gint64 *found, gint64 *offset)
+{
+	xmms_xform_seekpoint_t *p;
+	guint i;
+
+	g_return_val_if_fail (xform, FALSE);
+	g_return_val_if_fail (found, FALSE);
+	g_return_val_if_fail (offset, FALSE);
+
+	xmms_xform_seekpoints_load (xform);
+
+	i = xmms_xform_seekpoint_upper (xform->seekpoints, sample);
+	if (i == 0) {
+		return FALSE;
+	}
+
+	p = &g_array_index (xform->seekpoints, xmms_xform_seekpoint_t, i - 1);
+
+	/* past the indexed part, decoding up to the target would take
+	 * longer than the decoder's own estimate */
+	if (sample - p->sample > 2 * xform->seekpoint_interval) {
+		return FALSE;
+	}
+
+	*found = p->sample;
+	*offset = p->offset;
+
+	return TRUE;
+}
+
 const char *
 xmms_xform_shortname (xmms_xform_t *xform)
 {
@@ -836,21 +1431,136 @@ xmms_xform_shortname (xmms_xform_t *xform)
 	       : "unknown";
 }
 
+/* Read through the previous xform of the first fused effect and run
+ * all of them over the data.
+ */
 static gint
-xmms_xform_this_peek (xmms_xform_t *xform, gpointer buf, gint siz,
-                      xmms_error_t *err)
+xmms_xform_fused_read (xmms_xform_t *xform, gpointer buf, gint siz,
+                       xmms_error_t *err)
 {
+	xmms_xform_t *member;
+	gint res, pos, len;
+	guint i;
+
+	member = g_ptr_array_index (xform->fused, 0);
+
+	res = xmms_xform_read (member, buf, siz, err);
+
+	for (pos = 0; pos < res; pos += len) {
+		len = MIN (res - pos, xform->fused_block);
+
+		for (i = 0; i < xform->fused->len; i++) {
+			member = g_ptr_array_index (xform->fused, i);
+			xmms_xform_plugin_process (member->plugin, member,
+			                           (gchar *) buf + pos, len);
+		}
+	}
+
+	return res;
+}
+
+static gint
+xmms_xform_plugin_read_fused (xmms_xform_t *xform, gpointer buf, gint siz,
+                              xmms_error_t *err)
+{
+	if (xform->fused) {
+		return xmms_xform_fused_read (xform, buf, siz, err);
+	}
+
+	return xmms_xform_plugin_read (xform->plugin, xform, buf, siz, err);
+}
+
+/* grow the buffer, keeping it locked if it is */
+static void
+xmms_xform_buffer_grow (xmms_xform_t *xform, gint size)
+{
+	gchar *buffer;
+
+	if (!xform->buffer_locked) {
+		xform->buffer = g_realloc (xform->buffer, size);
+		xform->buffersize = size;
+		return;
+	}
+
+	buffer = xmms_realtime_locked_alloc (size);
+	if (!buffer) {
+		buffer = g_malloc (size);
+		xform->buffer_locked = FALSE;
+	}
+
+	memcpy (buffer, xform->buffer, xform->buffered);
+	xmms_realtime_locked_free (xform->buffer, xform->buffersize);
+
+	xform->buffer = buffer;
+	xform->buffersize = size;
+}
+
+/**
+ * Lock the buffers of every xform in the chain in memory so that
+ * reading from the chain doesn't page fault. The buffers move to
+ * pages of their own for that.
+ */
+void
+xmms_xform_chain_mlock (xmms_xform_t *chain)
+{
+	xmms_xform_t *xform;
+	gchar *buffer;
+
+	for (xform = chain; xform; xform = xform->prev) {
+		if (xform->buffer_locked) {
+			continue;
+		}
+
+		buffer = xmms_realtime_locked_alloc (xform->buffersize);
+		if (!buffer) {
+			break;
+		}
+
+		memcpy (buffer, xform->buffer, xform->buffered);
+		g_free (xform->buffer);
+
+		xform->buffer = buffer;
+		xform->buffer_locked = TRUE;
+	}
+}
+
+/**
+ * Count the sample format converters in the chain.
+ */
+gint
+xmms_xform_chain_conversions (xmms_xform_t *chain)
+{
+	xmms_xform_t *xform;
+	gint count = 0;
+
+	for (xform = chain; xform; xform = xform->prev) {
+		if (xform->plugin && !strcmp (xmms_xform_shortname (xform), "converter")) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static gint
+xmms_xform_this_peek_real (xmms_xform_t *xform, gpointer buf, gint siz,
+                           xmms_error_t *err)
+{
+	if (xform->map) {
+		return xmms_xform_mapping_read (xform, buf, siz, TRUE);
+	}
+
 	while (xform->buffered < siz) {
 		gint res;
 
 		if (xform->buffered + READ_CHUNK > xform->buffersize) {
-			xform->buffersize *= 2;
-			xform->buffer = g_realloc (xform->buffer, xform->buffersize);
+			xmms_xform_buffer_grow (xform, xform->buffersize * 2);
+			xmms_xform_profile_moved (xform, xform->buffered);
 		}
 
-		res = xmms_xform_plugin_read (xform->plugin, xform,
-		                              &xform->buffer[xform->buffered],
-		                              READ_CHUNK, err);
+		res = xmms_xform_plugin_read_fused (xform,
+		                                    &xform->buffer[xform->buffered],
+		                                    READ_CHUNK, err);
 
 		if (res < -1) {
 			XMMS_DBG ("Read method of %s returned bad value (%d) - BUG IN PLUGIN",
@@ -906,9 +1616,9 @@ xmms_xform_hotspots_update (xmms_xform_t *xform)
 	return ret;
 }
 
-gint
-xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
-                      xmms_error_t *err)
+static gint
+xmms_xform_this_read_real (xmms_xform_t *xform, gpointer buf, gint siz,
+                           xmms_error_t *err)
 {
 	gint read = 0;
 	gint nexths;
@@ -918,6 +1628,10 @@ xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
 		return -1;
 	}
 
+	if (xform->map) {
+		return xmms_xform_mapping_read (xform, buf, siz, FALSE);
+	}
+
 	/* update hotspots */
 	nexths = xmms_xform_hotspots_update (xform);
 	if (nexths >= 0) {
@@ -936,6 +1650,7 @@ xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
 			/* unless we are _peek:ing often
 			   this should be fine */
 			memmove (xform->buffer, &xform->buffer[read], xform->buffered);
+			xmms_xform_profile_moved (xform, xform->buffered);
 		}
 	}
 
@@ -946,7 +1661,7 @@ xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
 	while (read < siz) {
 		gint res;
 
-		res = xmms_xform_plugin_read (xform->plugin, xform, buf + read, siz - read, err);
+		res = xmms_xform_plugin_read_fused (xform, buf + read, siz - read, err);
 		if (xform->metadata_collected && xform->metadata_changed)
 			xmms_xform_metadata_update (xform);
 
@@ -967,14 +1682,13 @@ xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
 
 			if (!g_queue_is_empty (xform->hotspots)) {
 				if (xform->buffered + res > xform->buffersize) {
-					xform->buffersize = MAX (xform->buffersize * 2,
-					                         xform->buffersize + res);
-					xform->buffer = g_realloc (xform->buffer,
-					                           xform->buffersize);
+					xmms_xform_buffer_grow (xform, MAX (xform->buffersize * 2,
+					                                    xform->buffersize + res));
 				}
 
 				memmove (xform->buffer + xform->buffered, buf + read, res);
 				xform->buffered += res;
+				xmms_xform_profile_moved (xform, res);
 				break;
 			}
 			read += res;
@@ -984,9 +1698,9 @@ xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
 	return read;
 }
 
-gint64
-xmms_xform_this_seek (xmms_xform_t *xform, gint64 offset,
-                      xmms_xform_seek_mode_t whence, xmms_error_t *err)
+static gint64
+xmms_xform_this_seek_real (xmms_xform_t *xform, gint64 offset,
+                           xmms_xform_seek_mode_t whence, xmms_error_t *err)
 {
 	gint64 res;
 
@@ -995,6 +1709,10 @@ xmms_xform_this_seek (xmms_xform_t *xform, gint64 offset,
 		return -1;
 	}
 
+	if (xform->map) {
+		return xmms_xform_mapping_seek (xform, offset, whence, err);
+	}
+
 	if (!xmms_xform_plugin_can_seek (xform->plugin)) {
 		XMMS_DBG ("Seek not implemented in '%s'", xmms_xform_shortname (xform));
 		xmms_error_set (err, XMMS_ERROR_GENERIC, "Seek not implemented");
@@ -1023,6 +1741,231 @@ xmms_xform_this_seek (xmms_xform_t *xform, gint64 offset,
 	return res;
 }
 
+static gint profile_enabled;
+
+/**
+ * Enable or disable the collection of per xform statistics.
+ * While disabled, reads and seeks are not timed at all.
+ */
+void
+xmms_xform_profile_set (gboolean enabled)
+{
+	g_atomic_int_set (&profile_enabled, !!enabled);
+}
+
+gboolean
+xmms_xform_profile_enabled (void)
+{
+	return g_atomic_int_get (&profile_enabled);
+}
+
+static gint64
+profile_clock (gboolean cpu)
+{
+	struct timespec ts;
+
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	if (cpu) {
+		clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+		return ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+	}
+#else
+	if (cpu) {
+		return 0;
+	}
+#endif
+
+#ifdef CLOCK_MONOTONIC
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+#else
+	return g_get_monotonic_time () * 1000;
+#endif
+}
+
+/* the xform this one reads from, fused effects read past the others */
+static xmms_xform_t *
+xmms_xform_profile_source (xmms_xform_t *xform)
+{
+	if (xform->fused) {
+		xform = g_ptr_array_index (xform->fused, 0);
+	}
+
+	return xform->prev;
+}
+
+static void
+xmms_xform_profile_begin (xmms_xform_t *xform, xmms_xform_profile_mark_t *mark)
+{
+	xmms_xform_t *source = xmms_xform_profile_source (xform);
+
+	if (source) {
+		mark->prev_time = source->profile.time;
+		mark->prev_cpu_time = source->profile.cpu_time;
+	}
+
+	mark->time = profile_clock (FALSE);
+	mark->cpu_time = profile_clock (TRUE);
+}
+
+static void
+xmms_xform_profile_moved (xmms_xform_t *xform, gint64 bytes)
+{
+	if (!g_atomic_int_get (&profile_enabled)) {
+		return;
+	}
+
+	g_mutex_lock (&xform->profile_lock);
+	xform->profile.moved_bytes += bytes;
+	g_mutex_unlock (&xform->profile_lock);
+}
+
+/* Reads of the source only happen from within a read or seek of this
+ * xform, so whatever it accumulated meanwhile is not ours. */
+static gint64
+xmms_xform_profile_end (xmms_xform_t *xform, xmms_xform_profile_mark_t *mark)
+{
+	xmms_xform_t *source = xmms_xform_profile_source (xform);
+	gint64 time, cpu_time;
+
+	time = profile_clock (FALSE) - mark->time;
+	cpu_time = profile_clock (TRUE) - mark->cpu_time;
+
+	/* the source is written by this thread only, no need to lock it */
+	g_mutex_lock (&xform->profile_lock);
+	xform->profile.time += time;
+	xform->profile.cpu_time += cpu_time;
+	xform->profile.self_time += time;
+	xform->profile.self_cpu_time += cpu_time;
+
+	if (source) {
+		xform->profile.self_time -= source->profile.time - mark->prev_time;
+		xform->profile.self_cpu_time -= source->profile.cpu_time - mark->prev_cpu_time;
+	}
+	g_mutex_unlock (&xform->profile_lock);
+
+	return time;
+}
+
+static gint
+xmms_xform_this_peek (xmms_xform_t *xform, gpointer buf, gint siz,
+                      xmms_error_t *err)
+{
+	xmms_xform_profile_mark_t mark;
+	gint res;
+
+	if (!g_atomic_int_get (&profile_enabled)) {
+		return xmms_xform_this_peek_real (xform, buf, siz, err);
+	}
+
+	xmms_xform_profile_begin (xform, &mark);
+	res = xmms_xform_this_peek_real (xform, buf, siz, err);
+	xmms_xform_profile_end (xform, &mark);
+
+	return res;
+}
+
+gint
+xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
+                      xmms_error_t *err)
+{
+	xmms_xform_profile_mark_t mark;
+	gint res;
+
+	if (!g_atomic_int_get (&profile_enabled)) {
+		return xmms_xform_this_read_real (xform, buf, siz, err);
+	}
+
+	xmms_xform_profile_begin (xform, &mark);
+	res = xmms_xform_this_read_real (xform, buf, siz, err);
+	xmms_xform_profile_end (xform, &mark);
+
+	g_mutex_lock (&xform->profile_lock);
+	xform->profile.reads++;
+	if (res > 0) {
+		xform->profile.read_bytes += res;
+	}
+	g_mutex_unlock (&xform->profile_lock);
+
+	return res;
+}
+
+gint64
+xmms_xform_this_seek (xmms_xform_t *xform, gint64 offset,
+                      xmms_xform_seek_mode_t whence, xmms_error_t *err)
+{
+	xmms_xform_profile_mark_t mark;
+	gint64 res, time;
+
+	if (!g_atomic_int_get (&profile_enabled)) {
+		return xmms_xform_this_seek_real (xform, offset, whence, err);
+	}
+
+	xmms_xform_profile_begin (xform, &mark);
+	res = xmms_xform_this_seek_real (xform, offset, whence, err);
+	time = xmms_xform_profile_end (xform, &mark);
+
+	g_mutex_lock (&xform->profile_lock);
+	xform->profile.seek_time += time;
+	xform->profile.seeks++;
+	g_mutex_unlock (&xform->profile_lock);
+
+	return res;
+}
+
+/**
+ * Get the statistics of every xform in a chain, ending with chain.
+ * The counters are only updated while profiling is enabled.
+ */
+xmmsv_t *
+xmms_xform_profile_get (xmms_xform_t *chain)
+{
+	xmmsv_t *list, *dict;
+	xmms_xform_t *xform;
+	gint fill;
+
+	list = xmmsv_new_list ();
+
+	for (xform = chain; xform; xform = xform->prev) {
+		xmms_xform_profile_t profile, *p = &profile;
+
+		g_mutex_lock (&xform->profile_lock);
+		profile = xform->profile;
+		g_mutex_unlock (&xform->profile_lock);
+
+		dict = xmmsv_build_dict (
+			XMMSV_DICT_ENTRY_STR ("name", xmms_xform_shortname (xform)),
+			XMMSV_DICT_ENTRY_INT ("reads", p->reads),
+			XMMSV_DICT_ENTRY_INT ("bytes", p->read_bytes),
+			XMMSV_DICT_ENTRY_INT ("time", p->time),
+			XMMSV_DICT_ENTRY_INT ("cpu_time", p->cpu_time),
+			XMMSV_DICT_ENTRY_INT ("self_time", p->self_time),
+			XMMSV_DICT_ENTRY_INT ("self_cpu_time", p->self_cpu_time),
+			XMMSV_DICT_ENTRY_INT ("seeks", p->seeks),
+			XMMSV_DICT_ENTRY_INT ("seek_time", p->seek_time),
+			XMMSV_DICT_ENTRY_INT ("moved_bytes", p->moved_bytes),
+			XMMSV_DICT_END);
+
+		fill = g_atomic_int_get (&xform->buffer_fill);
+		if (fill >= 0) {
+			xmmsv_dict_set_int (dict, "buffer_fill", fill);
+		}
+
+		xmmsv_list_insert (list, 0, dict);
+		xmmsv_unref (dict);
+	}
+
+	return list;
+}
+
+void
+xmms_xform_buffer_fill_set (xmms_xform_t *xform, gint percent)
+{
+	g_return_if_fail (xform);
+
+	g_atomic_int_set (&xform->buffer_fill, CLAMP (percent, 0, 100));
+}
+
 gint
 xmms_xform_peek (xmms_xform_t *xform, gpointer buf, gint siz,
                  xmms_error_t *err)
@@ -1122,6 +2065,10 @@ xmms_xform_match (xmms_plugin_t *plugin, gpointer user_data)
 
 	g_assert (plugin->type == XMMS_PLUGIN_TYPE_XFORM);
 
+	if (xmms_plugin_failed (plugin)) {
+		return TRUE;
+	}
+
 	XMMS_DBG ("Trying plugin '%s'", xmms_plugin_shortname_get (plugin));
 	if (!xmms_xform_plugin_supports (xform_plugin, state->out_type, &priority)) {
 		return TRUE;
@@ -1146,18 +2093,130 @@ xmms_xform_match (xmms_plugin_t *plugin, gpointer user_data)
 	return TRUE;
 }
 
+/*
+ * Chain plan cache. Remembers which plugin won the match for an
+ * out-type signature, so chains for the same kind of media go
+ * straight to it instead of asking every plugin again. Flushed
+ * whenever plugins are loaded, unloaded or change priority.
+ */
+static GMutex plan_cache_lock;
+static GHashTable *plan_cache;
+static gint64 plan_cache_hits;
+static gint64 plan_cache_misses;
+
+/**
+ * @internal Forget all cached chain plans.
+ */
+void
+xmms_xform_plan_cache_flush (void)
+{
+	g_mutex_lock (&plan_cache_lock);
+	if (plan_cache) {
+		g_hash_table_remove_all (plan_cache);
+	}
+	g_mutex_unlock (&plan_cache_lock);
+}
+
+/**
+ * @internal Get the number of plugin lookups answered from the chain
+ * plan cache, and the number that had to query all plugins.
+ */
+void
+xmms_xform_plan_cache_stats (gint64 *hits, gint64 *misses)
+{
+	g_mutex_lock (&plan_cache_lock);
+	*hits = plan_cache_hits;
+	*misses = plan_cache_misses;
+	g_mutex_unlock (&plan_cache_lock);
+}
+
+static gchar *
+xmms_xform_plan_signature (const xmms_stream_type_t *type)
+{
+	if (xmms_stream_type_get_str (type, XMMS_STREAM_TYPE_URL) &&
+	    !xmms_xform_plugin_urls_match_by_scheme ()) {
+		return NULL;
+	}
+
+	return xmms_stream_type_signature (type);
+}
+
+static xmms_xform_plugin_t *
+xmms_xform_plan_lookup (const gchar *signature)
+{
+	xmms_xform_plugin_t *plugin = NULL;
+
+	g_mutex_lock (&plan_cache_lock);
+	if (plan_cache) {
+		plugin = g_hash_table_lookup (plan_cache, signature);
+	}
+	if (plugin) {
+		xmms_object_ref (plugin);
+		plan_cache_hits++;
+	} else {
+		plan_cache_misses++;
+	}
+	g_mutex_unlock (&plan_cache_lock);
+
+	return plugin;
+}
+
+static void
+xmms_xform_plan_insert (const gchar *signature, xmms_xform_plugin_t *plugin)
+{
+	g_mutex_lock (&plan_cache_lock);
+	if (!plan_cache) {
+		plan_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+		                                    xmms_object_unref);
+	}
+	xmms_object_ref (plugin);
+	g_hash_table_replace (plan_cache, g_strdup (signature), plugin);
+	g_mutex_unlock (&plan_cache_lock);
+}
+
 xmms_xform_t *
 xmms_xform_find (xmms_xform_t *prev, xmms_medialib_entry_t entry,
                  GList *goal_hints)
 {
 	match_state_t state;
 	xmms_xform_t *xform = NULL;
+	xmms_xform_plugin_t *planned = NULL;
+	gchar *signature;
+	gint priority;
 
 	state.out_type = xmms_xform_get_out_stream_type (prev);
 	state.match = NULL;
 	state.priority = -1;
 
-	xmms_plugin_foreach (XMMS_PLUGIN_TYPE_XFORM, xmms_xform_match, &state);
+	signature = xmms_xform_plan_signature (state.out_type);
+	if (signature) {
+		planned = xmms_xform_plan_lookup (signature);
+	}
+
+	if (planned && !xmms_plugin_failed ((xmms_plugin_t *) planned) &&
+	    xmms_xform_plugin_supports (planned, state.out_type, &priority)) {
+		XMMS_DBG ("Using plugin '%s' from chain plan",
+		          xmms_plugin_shortname_get ((xmms_plugin_t *) planned));
+		state.match = planned;
+	} else {
+		xmms_plugin_foreach (XMMS_PLUGIN_TYPE_XFORM, xmms_xform_match, &state);
+		if (signature && state.match) {
+			xmms_xform_plan_insert (signature, state.match);
+		}
+	}
+
+	/* a plugin known from the manifest may fail to open, it is no
+	 * candidate anymore then and the next best one is tried */
+	while (state.match && !xmms_plugin_ensure_loaded ((xmms_plugin_t *) state.match)) {
+		state.match = NULL;
+		state.priority = -1;
+		xmms_plugin_foreach (XMMS_PLUGIN_TYPE_XFORM, xmms_xform_match, &state);
+		if (signature && state.match) {
+			xmms_xform_plan_insert (signature, state.match);
+		}
+	}
+
+	g_free (signature);
 
 	if (state.match) {
 		xform = xmms_xform_new (state.match, prev, prev->medialib, entry, goal_hints);
@@ -1165,6 +2224,10 @@ xmms_xform_find (xmms_xform_t *prev, xmms_medialib_entry_t entry,
 		XMMS_DBG ("Found no matching plugin...");
 	}
 
+	if (planned) {
+		xmms_object_unref (planned);
+	}
+
 	return xform;
 }
 
@@ -1530,6 +2593,7 @@ xmms_xform_new_effect (xmms_xform_t *last, xmms_medialib_entry_t entry,
 	if (xform) {
 		xmms_object_unref (last);
 		last = xform;
+		xmms_xform_effect_fuse (last);
 	} else {
 		xmms_log_info ("Effect '%s' failed to initialize, skipping",
 		               xmms_plugin_shortname_get (plugin));
@@ -1540,3 +2604,56 @@ xmms_xform_new_effect (xmms_xform_t *last, xmms_medialib_entry_t entry,
 	xmms_object_unref (plugin);
 	return last;
 }
+
+static gboolean
+xmms_xform_is_inplace_effect (xmms_xform_t *xform)
+{
+	const gchar *mime;
+
+	if (!xform->prev || !xform->plugin ||
+	    !xmms_xform_plugin_can_process (xform->plugin)) {
+		return FALSE;
+	}
+
+	/* the format must pass through untouched */
+	if (xform->out_type != xform->prev->out_type) {
+		return FALSE;
+	}
+
+	mime = xmms_stream_type_get_str (xform->out_type, XMMS_STREAM_TYPE_MIMETYPE);
+
+	return mime && !strcmp (mime, "audio/pcm");
+}
+
+/**
+ * Merge a new effect with the run of in-place effects right before it.
+ * The new effect takes over the run and reads for all of its members,
+ * which are left idle in the chain.
+ */
+static void
+xmms_xform_effect_fuse (xmms_xform_t *xform)
+{
+	xmms_xform_t *prev = xform->prev;
+	gint frame_size;
+
+	if (!xmms_xform_is_inplace_effect (xform) ||
+	    !xmms_xform_is_inplace_effect (prev)) {
+		return;
+	}
+
+	if (prev->fused) {
+		xform->fused = prev->fused;
+		prev->fused = NULL;
+	} else {
+		xform->fused = g_ptr_array_new ();
+		g_ptr_array_add (xform->fused, prev);
+	}
+
+	g_ptr_array_add (xform->fused, xform);
+
+	frame_size = xmms_sample_frame_size_get (xform->out_type);
+	xform->fused_block = MAX (1, FUSED_BLOCK_SIZE / frame_size) * frame_size;
+
+	XMMS_DBG ("Running %u effects in one pass, last is '%s'",
+	          xform->fused->len, xmms_xform_shortname (xform));
+}
@@ -16,6 +16,7 @@
 
 #include <xmmspriv/xmms_xform_object.h>
 #include <xmmspriv/xmms_xform.h>
+#include <xmmspriv/xmms_xform_plugin.h>
 #include <xmms/xmms_config.h>
 #include <xmms/xmms_ipc.h>
 #include <xmms/xmms_log.h>
@@ -25,6 +26,7 @@ struct xmms_xform_object_St {
 };
 
 static xmmsv_t *xmms_xform_client_browse (xmms_xform_object_t *obj, const gchar *url, xmms_error_t *error);
+static xmmsv_t *xmms_xform_client_effect_stats (xmms_xform_object_t *obj, xmms_error_t *error);
 static void xmms_xform_object_destroy (xmms_object_t *obj);
 static void xmms_xform_effect_callbacks_init (void);
 static void xmms_xform_effect_properties_update (xmms_object_t *object, xmmsv_t *data, gpointer udata);
@@ -59,6 +61,50 @@ xmms_xform_client_browse (xmms_xform_object_t *obj, const gchar *url,
 	return xmms_xform_browse (url, error);
 }
 
+static xmmsv_t *
+xmms_xform_client_effect_stats (xmms_xform_object_t *obj, xmms_error_t *error)
+{
+	xmms_config_property_t *cfg;
+	xmms_xform_plugin_t *plugin;
+	xmmsv_t *ret, *dict;
+	gint64 time, bytes;
+	gchar key[64];
+	const gchar *name;
+	gint effect_no;
+
+	ret = xmmsv_new_list ();
+
+	for (effect_no = 0; ; effect_no++) {
+		g_snprintf (key, sizeof (key), "effect.order.%i", effect_no);
+		cfg = xmms_config_lookup (key);
+		if (!cfg) {
+			break;
+		}
+
+		name = xmms_config_property_get_string (cfg);
+		if (!name[0]) {
+			continue;
+		}
+
+		plugin = xmms_xform_find_plugin (name);
+		if (!plugin) {
+			continue;
+		}
+
+		xmms_xform_plugin_process_stats_get (plugin, &time, &bytes);
+		xmms_object_unref (plugin);
+
+		dict = xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("name", name),
+		                         XMMSV_DICT_ENTRY_INT ("time", time),
+		                         XMMSV_DICT_ENTRY_INT ("bytes", bytes),
+		                         XMMSV_DICT_END);
+		xmmsv_list_append (ret, dict);
+		xmmsv_unref (dict);
+	}
+
+	return ret;
+}
+
 static void
 xmms_xform_effect_callbacks_init (void)
 {
@@ -19,14 +19,31 @@
 #include <xmmspriv/xmms_metadata_mapper.h>
 #include <xmms/xmms_log.h>
 
+#include <time.h>
+
 struct xmms_xform_plugin_St {
 	xmms_plugin_t plugin;
 	xmms_xform_methods_t methods;
 	GHashTable *metadata_mapper;
 	GList *in_types;
 	xmms_stream_type_t *default_out_type;
+
+	/* time spent in and data passed through the process method,
+	 * summed over all instances */
+	GMutex stats_lock;
+	gint64 process_time;
+	gint64 process_bytes;
 };
 
+/* cleared once a plugin matches URLs on more than their scheme */
+static gboolean urls_match_by_scheme = TRUE;
+
+static void
+priority_changed (xmms_object_t *object, xmmsv_t *data, gpointer userdata)
+{
+	xmms_xform_plan_cache_flush ();
+}
+
 static void
 destroy (xmms_object_t *obj)
 {
@@ -39,6 +56,8 @@ destroy (xmms_object_t *obj)
 		g_hash_table_unref (plugin->metadata_mapper);
 	}
 
+	g_mutex_clear (&plugin->stats_lock);
+
 	xmms_plugin_destroy ((xmms_plugin_t *) obj);
 }
 
@@ -48,6 +67,7 @@ xmms_xform_plugin_new (void)
 	xmms_xform_plugin_t *res;
 
 	res = xmms_object_new (xmms_xform_plugin_t, destroy);
+	g_mutex_init (&res->stats_lock);
 
 	return (xmms_plugin_t *)res;
 }
@@ -78,30 +98,56 @@ xmms_xform_plugin_verify (xmms_plugin_t *_plugin)
 	return TRUE;
 }
 
+/**
+ * @internal Add an input stream type to a plugin, taking over the
+ * reference to t.
+ */
 void
-xmms_xform_plugin_indata_add (xmms_xform_plugin_t *plugin, ...)
+xmms_xform_plugin_indata_add_type (xmms_xform_plugin_t *plugin,
+                                   xmms_stream_type_t *t)
 {
-	xmms_stream_type_t *t;
-	va_list ap;
 	gchar *config_key, config_value[32];
 	gint priority;
 
-	va_start (ap, plugin);
-	t = xmms_stream_type_parse (ap);
-	va_end (ap);
-
 	config_key = g_strconcat ("priority.",
 	                          xmms_stream_type_get_str (t, XMMS_STREAM_TYPE_NAME),
 	                          NULL);
 	priority = xmms_stream_type_get_int (t, XMMS_STREAM_TYPE_PRIORITY);
 	g_snprintf (config_value, sizeof (config_value), "%d", priority);
 	xmms_xform_plugin_config_property_register (plugin, config_key,
-	                                            config_value, NULL, NULL);
+	                                            config_value,
+	                                            priority_changed, NULL);
 	g_free (config_key);
 
+	if (!xmms_stream_type_matches_url_by_scheme (t)) {
+		XMMS_DBG ("'%s' matches on full URLs, not caching URL lookups",
+		          xmms_plugin_shortname_get ((xmms_plugin_t *) plugin));
+		urls_match_by_scheme = FALSE;
+	}
+
 	plugin->in_types = g_list_prepend (plugin->in_types, t);
 }
 
+void
+xmms_xform_plugin_indata_add (xmms_xform_plugin_t *plugin, ...)
+{
+	xmms_stream_type_t *t;
+	va_list ap;
+
+	va_start (ap, plugin);
+	t = xmms_stream_type_parse (ap);
+	va_end (ap);
+
+	/* a plugin loaded on demand already got its types from the
+	 * manifest, and chains may be matching against them right now */
+	if (plugin->plugin.path && !plugin->plugin.module) {
+		xmms_object_unref (t);
+		return;
+	}
+
+	xmms_xform_plugin_indata_add_type (plugin, t);
+}
+
 void
 xmms_xform_plugin_set_out_stream_type (xmms_xform_plugin_t *plugin, ...)
 {
@@ -119,6 +165,26 @@ xmms_xform_plugin_get_out_stream_type (xmms_xform_plugin_t *plugin)
 	return plugin->default_out_type;
 }
 
+/**
+ * @internal Get the input stream types of a plugin.
+ */
+const GList *
+xmms_xform_plugin_in_types_get (const xmms_xform_plugin_t *plugin)
+{
+	return plugin->in_types;
+}
+
+/**
+ * Check whether every loaded plugin picks URLs by scheme alone, in
+ * which case the result of matching an URL can be reused for other
+ * URLs of the same scheme.
+ */
+gboolean
+xmms_xform_plugin_urls_match_by_scheme (void)
+{
+	return urls_match_by_scheme;
+}
+
 gboolean
 xmms_xform_plugin_supports (const xmms_xform_plugin_t *plugin, const xmms_stream_type_t *st,
                             gint *priority)
@@ -222,7 +288,13 @@ xmms_xform_plugin_can_init (const xmms_xform_plugin_t *plugin)
 gboolean
 xmms_xform_plugin_can_read (const xmms_xform_plugin_t *plugin)
 {
-	return !!plugin->methods.read;
+	return plugin->methods.read || plugin->methods.process;
+}
+
+gboolean
+xmms_xform_plugin_can_process (const xmms_xform_plugin_t *plugin)
+{
+	return !!plugin->methods.process;
 }
 
 gboolean
@@ -255,7 +327,74 @@ gint
 xmms_xform_plugin_read (const xmms_xform_plugin_t *plugin, xmms_xform_t *xform,
                         xmms_sample_t *buf, gint length, xmms_error_t *error)
 {
-	return plugin->methods.read (xform, buf, length, error);
+	gint res;
+
+	if (plugin->methods.read) {
+		return plugin->methods.read (xform, buf, length, error);
+	}
+
+	res = xmms_xform_read (xform, buf, length, error);
+	if (res > 0) {
+		xmms_xform_plugin_process ((xmms_xform_plugin_t *) plugin,
+		                           xform, buf, res);
+	}
+
+	return res;
+}
+
+static gint64
+process_clock (void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+#else
+	return g_get_monotonic_time () * 1000;
+#endif
+}
+
+/**
+ * @internal Run the process method of a plugin over some data,
+ * accounting the time spent to the plugin while profiling is enabled.
+ */
+void
+xmms_xform_plugin_process (xmms_xform_plugin_t *plugin, xmms_xform_t *xform,
+                           xmms_sample_t *buf, gint length)
+{
+	gint64 start, spent;
+
+	/* this runs for every block on the way to the sound card */
+	if (!xmms_xform_profile_enabled ()) {
+		plugin->methods.process (xform, buf, length);
+		return;
+	}
+
+	start = process_clock ();
+	plugin->methods.process (xform, buf, length);
+	spent = process_clock () - start;
+
+	g_mutex_lock (&plugin->stats_lock);
+	plugin->process_time += spent;
+	plugin->process_bytes += length;
+	g_mutex_unlock (&plugin->stats_lock);
+}
+
+/**
+ * @internal Get the time in nanoseconds spent in the process method of
+ * a plugin, and the number of bytes it processed, while profiling was
+ * enabled.
+ */
+void
+xmms_xform_plugin_process_stats_get (xmms_xform_plugin_t *plugin,
+                                     gint64 *time, gint64 *bytes)
+{
+	g_mutex_lock (&plugin->stats_lock);
+	*time = plugin->process_time;
+	*bytes = plugin->process_bytes;
+	g_mutex_unlock (&plugin->stats_lock);
 }
 
 gint64
@@ -0,0 +1,183 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ */
+
+/* Runs the equalizer band kernels over a few seconds of stereo noise
+ * in every sample format, printing the throughput of each and the
+ * largest difference to the portable kernel.
+ *
+ * Usage: eq-bench [bands] [seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include "iir.h"
+#include "iir_fpu.h"
+#include "iir_sse.h"
+
+#define RATE 44100
+#define CHANNELS 2
+
+typedef struct {
+	const char *name;
+	iir_bands_func_t func;
+} kernel_t;
+
+static double
+now (void)
+{
+	struct timeval tv;
+
+	gettimeofday (&tv, NULL);
+
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static iir_state_t *
+new_state (iir_bands_func_t func, int bands)
+{
+	iir_state_t *st;
+	int i, j;
+
+	st = iir_new ();
+	st->bands_func = func;
+	config_iir (st, RATE, bands, 0);
+
+	/* alternate boosts and cuts so every band contributes */
+	for (i = 0; i < bands; i++) {
+		for (j = 0; j < CHANNELS; j++) {
+			set_gain (st, i, j, (i % 2) ? 0.2 : -0.1);
+		}
+	}
+
+	return st;
+}
+
+static void
+run (const kernel_t *kernel, const int16_t *input, int samples, int bands)
+{
+	iir_state_t *st, *ref;
+	int16_t *s16, *s16_ref;
+	int32_t *s32;
+	float *f;
+	double t, seconds = (double) samples / CHANNELS / RATE;
+	int i, diff = 0;
+
+	s16 = malloc (samples * sizeof (int16_t));
+	s16_ref = malloc (samples * sizeof (int16_t));
+	s32 = malloc (samples * sizeof (int32_t));
+	f = malloc (samples * sizeof (float));
+
+	for (i = 0; i < samples; i++) {
+		s16[i] = s16_ref[i] = input[i];
+		s32[i] = input[i] * 65536;
+		f[i] = input[i] / 32768.0f;
+	}
+
+	/* same dither sequence for both runs */
+	srand (1);
+	st = new_state (kernel->func, bands);
+	srand (1);
+	ref = new_state (iir_bands_fpu, bands);
+
+	t = now ();
+	iir_s16 (st, s16, samples, CHANNELS, 0);
+	t = now () - t;
+	printf ("%-6s s16:   %8.1fx realtime\n", kernel->name, seconds / t);
+
+	iir_s16 (ref, s16_ref, samples, CHANNELS, 0);
+	for (i = 0; i < samples; i++) {
+		if (abs (s16[i] - s16_ref[i]) > diff) {
+			diff = abs (s16[i] - s16_ref[i]);
+		}
+	}
+
+	clean_history (st);
+	t = now ();
+	iir_s32 (st, s32, samples, CHANNELS, 0);
+	t = now () - t;
+	printf ("%-6s s32:   %8.1fx realtime\n", kernel->name, seconds / t);
+
+	clean_history (st);
+	t = now ();
+	iir_float (st, f, samples, CHANNELS, 0);
+	t = now () - t;
+	printf ("%-6s float: %8.1fx realtime\n", kernel->name, seconds / t);
+
+	clean_history (st);
+	t = now ();
+	iir_float (st, f, samples, CHANNELS, 1);
+	t = now () - t;
+	printf ("%-6s float, extra filtering: %8.1fx realtime\n",
+	        kernel->name, seconds / t);
+
+	printf ("%-6s max s16 difference to fpu: %d\n\n", kernel->name, diff);
+
+	iir_free (st);
+	iir_free (ref);
+	free (s16);
+	free (s16_ref);
+	free (s32);
+	free (f);
+}
+
+int
+main (int argc, char **argv)
+{
+	kernel_t kernels[] = {
+		{ "fpu", iir_bands_fpu },
+#ifdef IIR_HAVE_SSE
+		{ "sse2", iir_bands_sse2 },
+		{ "avx", iir_bands_avx },
+#endif
+	};
+	int16_t *input;
+	int bands = 31, seconds = 10, samples, i;
+
+	if (argc > 1) {
+		bands = atoi (argv[1]);
+	}
+	if (argc > 2) {
+		seconds = atoi (argv[2]);
+	}
+
+	init_iir ();
+
+	samples = seconds * RATE * CHANNELS;
+	input = malloc (samples * sizeof (int16_t));
+	for (i = 0; i < samples; i++) {
+		input[i] = (rand () % 32768) - 16384;
+	}
+
+	printf ("bands: %d, %d s of %d Hz stereo\n\n", bands, seconds, RATE);
+
+	for (i = 0; i < (int) (sizeof (kernels) / sizeof (kernels[0])); i++) {
+#ifdef IIR_HAVE_SSE
+		__builtin_cpu_init ();
+		if (kernels[i].func == iir_bands_avx && !__builtin_cpu_supports ("avx")) {
+			continue;
+		}
+#endif
+		run (&kernels[i], input, samples, bands);
+	}
+
+	free (input);
+
+	return EXIT_SUCCESS;
+}
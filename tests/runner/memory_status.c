@@ -14,8 +14,40 @@
  *  Lesser General Public License for more details.
  */
 
+#include <stdio.h>
+
+#include <xmmsc/xmmsv.h>
+
 #include "memory_status.h"
 
+static int64_t _memory_baseline_values;
+static int64_t _memory_baseline_allocations;
+
+/* Keep track of values allocated between calibrate and verify, and
+ * report the ones left behind. Values may legitimately be cached
+ * across test cases, so this is informational only.
+ */
+static void
+_memory_values_calibrate (void)
+{
+	xmmsv_alloc_stats_get (&_memory_baseline_values,
+	                       &_memory_baseline_allocations, NULL);
+}
+
+static void
+_memory_values_verify (const char *marker)
+{
+	int64_t live, allocations;
+
+	xmmsv_alloc_stats_get (&live, &allocations, NULL);
+
+	if (live != _memory_baseline_values) {
+		printf ("%s: %lld value allocations still live (%lld made)\n",
+		        marker, (long long) (live - _memory_baseline_values),
+		        (long long) (allocations - _memory_baseline_allocations));
+	}
+}
+
 #if defined(HAVE_VALGRIND) && HAVE_VALGRIND == 1
 
 #include <valgrind.h>
@@ -31,6 +63,8 @@ memory_status_calibrate (const char *marker)
 
 	VALGRIND_PRINTF ("Calibrating: %s\n", marker);
 
+	_memory_values_calibrate ();
+
 	VALGRIND_DO_LEAK_CHECK;
 	VALGRIND_COUNT_LEAKS(l, d, r, s);
 	_memory_baseline_leaks = l;
@@ -45,6 +79,8 @@ memory_status_verify (const char *marker)
 
 	VALGRIND_PRINTF ("Verifying: %s\n", marker);
 
+	_memory_values_verify (marker);
+
 	status = MEMORY_OK;
 
 	if (VALGRIND_COUNT_ERRORS > _memory_baseline_errors)
@@ -63,10 +99,12 @@ memory_status_verify (const char *marker)
 
 void memory_status_calibrate (const char *marker)
 {
+	_memory_values_calibrate ();
 }
 
 int memory_status_verify (const char *marker)
 {
+	_memory_values_verify (marker);
 	return MEMORY_OK;
 }
 
@@ -0,0 +1,190 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Registers the magic of the common decoder plugins and identifies the
+ * first bytes of every file in a directory, printing the time spent
+ * per identification.
+ *
+ * Usage: magic-bench directory [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include <xmmspriv/xmms_log.h>
+#include <xmmspriv/xmms_xform.h>
+
+/* enough for the deepest rule of any plugin (mod at 1080) */
+#define HEADER_SIZE 2048
+
+typedef struct {
+	gchar *name;
+	gchar *data;
+	gsize len;
+} header_t;
+
+static void
+register_magic (void)
+{
+	xmms_magic_add ("flac header", "audio/x-flac", "0 string fLaC", NULL);
+	xmms_magic_add ("mpeg header", "audio/mpeg",
+	                "0 beshort&0xfff6 0xfff6",
+	                "0 beshort&0xfff6 0xfff4",
+	                "0 beshort&0xffe6 0xffe2",
+	                NULL);
+	xmms_magic_add ("id3 header", "audio/mpeg", "0 string ID3", NULL);
+	xmms_magic_add ("wave header", "audio/x-wav",
+	                "0 string RIFF", ">8 string WAVE",
+	                ">>12 string fmt ", NULL);
+	xmms_magic_add ("mpeg-4 header", "video/mp4",
+	                "4 string ftyp",
+	                ">8 string isom",
+	                ">8 string mp41",
+	                ">8 string mp42",
+	                NULL);
+	xmms_magic_add ("iTunes header", "audio/mp4",
+	                "4 string ftyp", ">8 string M4A ", NULL);
+	xmms_magic_add ("Opus header", "audio/ogg; codecs=opus",
+	                "0 string OggS", ">28 string OpusHead", NULL);
+	xmms_magic_add ("ogg/vorbis header", "application/ogg",
+	                "0 string OggS", ">4 byte 0",
+	                ">>28 string \x01vorbis", NULL);
+	xmms_magic_add ("ogg/speex header", "audio/x-speex",
+	                "0 string OggS", ">4 byte 0",
+	                ">>28 string Speex   ", NULL);
+	xmms_magic_add ("mpc header", "audio/x-mpc", "0 string MP+", NULL);
+	xmms_magic_add ("mpc header", "audio/x-mpc", "0 string MPCK", NULL);
+	xmms_magic_add ("wavpack header v4", "audio/x-wavpack",
+	                "0 string wvpk", NULL);
+	xmms_magic_add ("TTA header", "audio/x-tta", "0 string TTA1", NULL);
+	xmms_magic_add ("psid header", "audio/prs.sid", "0 string PSID", NULL);
+	xmms_magic_add ("rsid header", "audio/prs.sid", "0 string RSID", NULL);
+	xmms_magic_add ("monkey's audio header", "audio/x-ape",
+	                "0 string MAC ", NULL);
+	xmms_magic_add ("aiff header", "audio/x-aiff",
+	                "0 string FORM", ">8 string AIFF", NULL);
+	xmms_magic_add ("asf header", "video/x-ms-asf",
+	                "0 belong 0x3026b275", NULL);
+	xmms_magic_add ("m3u playlist", "audio/mpegurl",
+	                "0 string #EXTM3U", NULL);
+	xmms_magic_add ("pls playlist", "audio/x-scpls",
+	                "0 string/c [playlist]", NULL);
+	xmms_magic_add ("xspf playlist", "application/xspf+xml",
+	                "0 string <?xml", NULL);
+	xmms_magic_add ("Protracker module", "audio/x-mod",
+	                "1080 string M.K.", NULL);
+	xmms_magic_add ("Protracker module", "audio/x-mod",
+	                "1080 string M!K!", NULL);
+	xmms_magic_add ("Fasttracker module", "audio/x-mod",
+	                "1080 string 8CHN", NULL);
+}
+
+static GPtrArray *
+read_headers (const gchar *dir)
+{
+	GPtrArray *headers;
+	const gchar *name;
+	GDir *d;
+
+	d = g_dir_open (dir, 0, NULL);
+	if (!d) {
+		return NULL;
+	}
+
+	headers = g_ptr_array_new ();
+
+	while ((name = g_dir_read_name (d))) {
+		header_t *header;
+		gchar *path;
+		FILE *fp;
+
+		path = g_build_filename (dir, name, NULL);
+		fp = fopen (path, "rb");
+		g_free (path);
+
+		if (!fp) {
+			continue;
+		}
+
+		header = g_new0 (header_t, 1);
+		header->name = g_strdup (name);
+		header->data = g_malloc (HEADER_SIZE);
+		header->len = fread (header->data, 1, HEADER_SIZE, fp);
+		fclose (fp);
+
+		g_ptr_array_add (headers, header);
+	}
+
+	g_dir_close (d);
+
+	return headers;
+}
+
+int
+main (int argc, char **argv)
+{
+	GPtrArray *headers;
+	GTimer *timer;
+	gdouble elapsed;
+	gint iterations = 10000, matched = 0, i;
+	guint j;
+
+	if (argc < 2) {
+		fprintf (stderr, "Usage: %s directory [iterations]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (argc > 2) {
+		iterations = atoi (argv[2]);
+	}
+
+	xmms_log_init (0);
+	register_magic ();
+
+	headers = read_headers (argv[1]);
+	if (!headers || !headers->len) {
+		fprintf (stderr, "No files in %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	for (j = 0; j < headers->len; j++) {
+		header_t *header = g_ptr_array_index (headers, j);
+		const gchar *mime;
+
+		mime = xmms_magic_identify (header->data, header->len, NULL);
+		printf ("%-40s %s\n", header->name, mime ? mime : "-");
+		matched += !!mime;
+	}
+
+	timer = g_timer_new ();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < headers->len; j++) {
+			header_t *header = g_ptr_array_index (headers, j);
+			xmms_magic_identify (header->data, header->len, NULL);
+		}
+	}
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	printf ("\nfiles:          %u (%d identified)\n", headers->len, matched);
+	printf ("iterations:     %d\n", iterations);
+	printf ("per file:       %.1f ns\n",
+	        elapsed * 1e9 / ((gdouble) iterations * headers->len));
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,285 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Measures the time from a seek to the first sample at the wanted
+ * position, both through an xform chain and from decoded data still
+ * in an output buffer. The chain is fed by a synthetic decoder that,
+ * like most real ones, can only land on frame boundaries, so the
+ * output has to decode and drop the rest.
+ *
+ * Usage: seek-bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include <xmms/xmms_xformplugin.h>
+#include <xmmspriv/xmms_plugin.h>
+#include <xmmspriv/xmms_xform.h>
+#include <xmmspriv/xmms_xform_object.h>
+#include <xmmspriv/xmms_ringbuf.h>
+#include <xmmspriv/xmms_config.h>
+#include <xmmspriv/xmms_log.h>
+#include <xmmspriv/xmms_ipc.h>
+#include <xmmspriv/xmms_medialib.h>
+
+#define RATE 44100
+#define CHANNELS 2
+#define FRAME_SIZE (CHANNELS * sizeof (xmms_samples16_t))
+/* decoders land on multiples of this many samples */
+#define BLOCK_SAMPLES 1152
+#define LENGTH_SAMPLES (600 * RATE)
+/* two seconds of audio, as with a large output buffer */
+#define BUFFER_SIZE (2 * RATE * FRAME_SIZE)
+#define READ_SIZE 4096
+
+typedef struct {
+	gint64 pos;
+	guint32 state;
+} bench_decoder_t;
+
+static gboolean
+bench_init (xmms_xform_t *xform)
+{
+	xmms_xform_private_data_set (xform, g_new0 (bench_decoder_t, 1));
+	xmms_xform_outdata_type_add (xform,
+	                             XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                             XMMS_STREAM_TYPE_FMT_FORMAT, XMMS_SAMPLE_FORMAT_S16,
+	                             XMMS_STREAM_TYPE_FMT_CHANNELS, CHANNELS,
+	                             XMMS_STREAM_TYPE_FMT_SAMPLERATE, RATE,
+	                             XMMS_STREAM_TYPE_END);
+	return TRUE;
+}
+
+static void
+bench_destroy (xmms_xform_t *xform)
+{
+	g_free (xmms_xform_private_data_get (xform));
+}
+
+/* some work per sample, standing in for the decoding */
+static gint
+bench_read (xmms_xform_t *xform, gpointer buf, gint len, xmms_error_t *err)
+{
+	bench_decoder_t *data = xmms_xform_private_data_get (xform);
+	xmms_samples16_t *samples = buf;
+	gint i, j, frames;
+
+	frames = MIN (len / FRAME_SIZE, LENGTH_SAMPLES - data->pos);
+
+	for (i = 0; i < frames; i++) {
+		for (j = 0; j < 16; j++) {
+			data->state = data->state * 1664525 + 1013904223;
+		}
+		samples[i * CHANNELS] = data->state >> 16;
+		samples[i * CHANNELS + 1] = data->pos + i;
+	}
+
+	data->pos += frames;
+
+	return frames * FRAME_SIZE;
+}
+
+static gint64
+bench_seek (xmms_xform_t *xform, gint64 samples, xmms_xform_seek_mode_t whence,
+            xmms_error_t *err)
+{
+	bench_decoder_t *data = xmms_xform_private_data_get (xform);
+
+	data->pos = CLAMP (samples, 0, LENGTH_SAMPLES);
+	data->pos -= data->pos % BLOCK_SAMPLES;
+
+	return data->pos;
+}
+
+static gboolean
+bench_plugin_setup (xmms_xform_plugin_t *xform_plugin)
+{
+	xmms_xform_methods_t methods;
+
+	XMMS_XFORM_METHODS_INIT (methods);
+
+	methods.init = bench_init;
+	methods.destroy = bench_destroy;
+	methods.read = bench_read;
+	methods.seek = bench_seek;
+
+	xmms_xform_plugin_methods_set (xform_plugin, &methods);
+
+	xmms_xform_plugin_indata_add (xform_plugin,
+	                              XMMS_STREAM_TYPE_MIMETYPE, "application/x-url",
+	                              XMMS_STREAM_TYPE_URL, "seekbench://*",
+	                              XMMS_STREAM_TYPE_END);
+
+	return TRUE;
+}
+
+XMMS_XFORM_BUILTIN_DEFINE (seekbench,
+                           "seek benchmark decoder",
+                           XMMS_VERSION,
+                           "seek benchmark decoder",
+                           bench_plugin_setup);
+
+static void
+report (const gchar *name, gint64 *times, gint iterations)
+{
+	gint64 total = 0, max = 0;
+	gint i;
+
+	for (i = 0; i < iterations; i++) {
+		total += times[i];
+		max = MAX (max, times[i]);
+	}
+
+	printf ("%-8s %8.1f us mean, %8" G_GINT64_FORMAT " us max\n",
+	        name, (gdouble) total / iterations, max);
+}
+
+/* seek the chain and decode up to the first wanted sample */
+static gint64
+seek_chain (xmms_xform_t *chain, gint64 target)
+{
+	gchar buf[READ_SIZE];
+	xmms_error_t err;
+	gint64 start, skip;
+	gint ret;
+
+	xmms_error_reset (&err);
+	start = g_get_monotonic_time ();
+
+	ret = xmms_xform_this_seek (chain, target, XMMS_XFORM_SEEK_SET, &err);
+	g_assert (ret != -1);
+
+	skip = (target - ret) * FRAME_SIZE;
+	do {
+		ret = xmms_xform_this_read (chain, buf, sizeof (buf), &err);
+		g_assert (ret > 0);
+		skip -= ret;
+	} while (skip >= 0);
+
+	return g_get_monotonic_time () - start;
+}
+
+/* drop buffered data up to the wanted sample */
+static gint64
+seek_buffer (xmms_ringbuf_t *ringbuf, gint64 offset)
+{
+	gchar buf[READ_SIZE];
+	gint64 start;
+
+	start = g_get_monotonic_time ();
+
+	if (!xmms_ringbuf_skip (ringbuf, offset * FRAME_SIZE)) {
+		g_assert_not_reached ();
+	}
+	xmms_ringbuf_read (ringbuf, buf, sizeof (buf));
+
+	return g_get_monotonic_time () - start;
+}
+
+int
+main (int argc, char **argv)
+{
+	xmms_medialib_t *medialib;
+	xmms_xform_object_t *xform_object;
+	xmms_medialib_session_t *session;
+	xmms_stream_type_t *format;
+	xmms_ringbuf_t *ringbuf;
+	xmms_xform_t *chain;
+	GList *goal_format;
+	GRand *rand;
+	gint64 *chain_times, *buffer_times;
+	gint i, iterations = 200;
+	gchar buf[READ_SIZE];
+	xmms_error_t err;
+
+	if (argc > 1) {
+		iterations = MAX (1, atoi (argv[1]));
+	}
+
+	xmms_ipc_init ();
+	xmms_log_init (0);
+	xmms_config_init ("memory://");
+	xmms_config_property_register ("medialib.path", "memory://", NULL, NULL);
+
+	xform_object = xmms_xform_object_init ();
+	medialib = xmms_medialib_init ();
+
+	xmms_plugin_load (&xmms_builtin_seekbench, NULL);
+
+	format = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+	                                XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                                XMMS_STREAM_TYPE_FMT_FORMAT, XMMS_SAMPLE_FORMAT_S16,
+	                                XMMS_STREAM_TYPE_FMT_CHANNELS, CHANNELS,
+	                                XMMS_STREAM_TYPE_FMT_SAMPLERATE, RATE,
+	                                XMMS_STREAM_TYPE_END);
+	goal_format = g_list_prepend (NULL, format);
+
+	session = xmms_medialib_session_begin (medialib);
+	chain = xmms_xform_chain_setup_url_session (medialib, session, 1,
+	                                            "seekbench://", goal_format,
+	                                            TRUE);
+	xmms_medialib_session_abort (session);
+
+	if (!chain) {
+		fprintf (stderr, "Could not set up the chain\n");
+		return EXIT_FAILURE;
+	}
+
+	rand = g_rand_new_with_seed (42);
+	ringbuf = xmms_ringbuf_new (BUFFER_SIZE);
+	chain_times = g_new (gint64, iterations);
+	buffer_times = g_new (gint64, iterations);
+	xmms_error_reset (&err);
+
+	for (i = 0; i < iterations; i++) {
+		gint64 target, offset;
+
+		target = g_rand_int_range (rand, 0, LENGTH_SAMPLES - RATE * 10);
+		chain_times[i] = seek_chain (chain, target);
+
+		/* fill the buffer from the target on, then jump ahead in it
+		 * by up to a second, as when scrubbing forward */
+		xmms_ringbuf_clear (ringbuf);
+		while (xmms_ringbuf_bytes_free (ringbuf) >= sizeof (buf)) {
+			gint ret = xmms_xform_this_read (chain, buf, sizeof (buf), &err);
+			xmms_ringbuf_write (ringbuf, buf, ret);
+		}
+
+		offset = g_rand_int_range (rand, 1, RATE);
+		buffer_times[i] = seek_buffer (ringbuf, offset);
+	}
+
+	printf ("seek to first sample, %d seeks of each kind\n", iterations);
+	report ("chain", chain_times, iterations);
+	report ("buffer", buffer_times, iterations);
+
+	g_free (buffer_times);
+	g_free (chain_times);
+	g_rand_free (rand);
+	xmms_ringbuf_destroy (ringbuf);
+	xmms_object_unref (chain);
+	g_list_free (goal_format);
+	xmms_object_unref (format);
+	xmms_object_unref (medialib);
+	xmms_object_unref (xform_object);
+	xmms_config_shutdown ();
+	xmms_ipc_shutdown ();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include "xcu.h"
+
+#include <glib.h>
+#include <math.h>
+
+#include <xmmspriv/xmms_crossfade.h>
+
+SETUP (crossfade) {
+	return 0;
+}
+
+CLEANUP () {
+	return 0;
+}
+
+CASE (test_curve_parse)
+{
+	CU_ASSERT_EQUAL (XMMS_CROSSFADE_CURVE_LINEAR,
+	                 xmms_crossfade_curve_parse ("linear"));
+	CU_ASSERT_EQUAL (XMMS_CROSSFADE_CURVE_EQUAL_POWER,
+	                 xmms_crossfade_curve_parse ("equal_power"));
+	CU_ASSERT_EQUAL (XMMS_CROSSFADE_CURVE_SCURVE,
+	                 xmms_crossfade_curve_parse ("SCurve"));
+	CU_ASSERT_EQUAL (XMMS_CROSSFADE_CURVE_LINEAR,
+	                 xmms_crossfade_curve_parse ("bogus"));
+	CU_ASSERT_EQUAL (XMMS_CROSSFADE_CURVE_LINEAR,
+	                 xmms_crossfade_curve_parse (NULL));
+
+	CU_ASSERT_TRUE (xmms_crossfade_format_supported (XMMS_SAMPLE_FORMAT_S16));
+	CU_ASSERT_TRUE (xmms_crossfade_format_supported (XMMS_SAMPLE_FORMAT_FLOAT));
+	CU_ASSERT_FALSE (xmms_crossfade_format_supported (XMMS_SAMPLE_FORMAT_U8));
+}
+
+CASE (test_mix_linear_s16)
+{
+	xmms_samples16_t out[40], in[40];
+	gint i;
+
+	/* 20 stereo frames, long enough for the vector loop and a tail */
+	for (i = 0; i < G_N_ELEMENTS (out); i++) {
+		out[i] = 1000;
+		in[i] = 3000;
+	}
+
+	xmms_crossfade_mix (XMMS_SAMPLE_FORMAT_S16, 2,
+	                    XMMS_CROSSFADE_CURVE_LINEAR, out, in, 20, 0, 20);
+
+	for (i = 0; i < 20; i++) {
+		CU_ASSERT_EQUAL (1000 + 100 * i, out[2 * i]);
+		CU_ASSERT_EQUAL (out[2 * i], out[2 * i + 1]);
+	}
+}
+
+CASE (test_mix_saturates_s16)
+{
+	xmms_samples16_t out[16], in[16];
+	gint i;
+
+	for (i = 0; i < G_N_ELEMENTS (out); i++) {
+		out[i] = 30000;
+		in[i] = 30000;
+	}
+
+	/* both gains are about 0.7 in the middle of an equal power fade */
+	xmms_crossfade_mix (XMMS_SAMPLE_FORMAT_S16, 1,
+	                    XMMS_CROSSFADE_CURVE_EQUAL_POWER, out, in, 16, 50, 100);
+
+	for (i = 0; i < G_N_ELEMENTS (out); i++) {
+		CU_ASSERT_EQUAL (XMMS_SAMPLES16_MAX, out[i]);
+	}
+}
+
+CASE (test_mix_equal_power_float)
+{
+	xmms_samplefloat_t out[9], in[9];
+	gint i;
+
+	for (i = 0; i < G_N_ELEMENTS (out); i++) {
+		out[i] = 1.0;
+		in[i] = 0.0;
+	}
+
+	xmms_crossfade_mix (XMMS_SAMPLE_FORMAT_FLOAT, 1,
+	                    XMMS_CROSSFADE_CURVE_EQUAL_POWER, out, in, 9, 0, 8);
+
+	for (i = 0; i < G_N_ELEMENTS (out); i++) {
+		CU_ASSERT_DOUBLE_EQUAL (cos (G_PI_2 * MIN (i, 8) / 8), out[i], 0.0001);
+	}
+}
+
+CASE (test_mix_scurve_s32)
+{
+	xmms_samples32_t out[3] = { 0, 0, 0 };
+	xmms_samples32_t in[3] = { 1 << 30, 1 << 30, 1 << 30 };
+
+	xmms_crossfade_mix (XMMS_SAMPLE_FORMAT_S32, 1,
+	                    XMMS_CROSSFADE_CURVE_SCURVE, out, in, 3, 0, 2);
+
+	CU_ASSERT_EQUAL (0, out[0]);
+	CU_ASSERT_EQUAL (1 << 29, out[1]);
+	CU_ASSERT_EQUAL (1 << 30, out[2]);
+}
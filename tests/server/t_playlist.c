@@ -184,6 +184,75 @@ CASE(test_repeat)
 	xmms_config_property_set_data (property, "0");
 }
 
+CASE(test_advance_in)
+{
+	xmms_medialib_entry_t first, second;
+	xmms_error_t err;
+	xmmsv_t *coll;
+
+	first  = xmms_mock_entry (medialib, 1, "Red Fang", "Red Fang", "Prehistoric Dog");
+	second = xmms_mock_entry (medialib, 2, "Red Fang", "Red Fang", "Reverse Thunder");
+
+	coll = xmmsv_new_coll (XMMS_COLLECTION_TYPE_IDLIST);
+	xmms_collection_update_pointer (colldag, "Zone",
+	                                XMMS_COLLECTION_NSID_PLAYLISTS, coll);
+	xmmsv_unref (coll);
+
+	xmms_playlist_add_entry (playlist, XMMS_ACTIVE_PLAYLIST, first, &err);
+	xmms_playlist_add_entry (playlist, XMMS_ACTIVE_PLAYLIST, second, &err);
+	xmms_playlist_add_entry (playlist, "Zone", second, &err);
+	xmms_playlist_add_entry (playlist, "Zone", first, &err);
+
+	CU_ASSERT_EQUAL (first, xmms_playlist_current_entry (playlist));
+	CU_ASSERT_EQUAL (second, xmms_playlist_current_entry_in (playlist, "Zone"));
+
+	/* each playlist keeps its own position */
+	CU_ASSERT_TRUE (xmms_playlist_advance_in (playlist, "Zone"));
+	CU_ASSERT_EQUAL (first, xmms_playlist_current_entry_in (playlist, "Zone"));
+	CU_ASSERT_EQUAL (first, xmms_playlist_current_entry (playlist));
+
+	CU_ASSERT_FALSE (xmms_playlist_advance_in (playlist, "Zone"));
+	CU_ASSERT_EQUAL (0, xmms_playlist_current_entry_in (playlist, "Missing"));
+}
+
+CASE(test_next_entry_in)
+{
+	xmms_medialib_entry_t first, second;
+	xmms_config_property_t *property;
+	xmms_error_t err;
+
+	first  = xmms_mock_entry (medialib, 1, "Red Fang", "Red Fang", "Prehistoric Dog");
+	second = xmms_mock_entry (medialib, 2, "Red Fang", "Red Fang", "Reverse Thunder");
+
+	xmms_playlist_add_entry (playlist, XMMS_ACTIVE_PLAYLIST, first, &err);
+	xmms_playlist_add_entry (playlist, XMMS_ACTIVE_PLAYLIST, second, &err);
+
+	/* looking ahead doesn't move the position */
+	CU_ASSERT_EQUAL (first, xmms_playlist_current_entry (playlist));
+	CU_ASSERT_EQUAL (second, xmms_playlist_next_entry_in (playlist, XMMS_ACTIVE_PLAYLIST));
+	CU_ASSERT_EQUAL (first, xmms_playlist_current_entry (playlist));
+
+	CU_ASSERT_TRUE (xmms_playlist_advance (playlist));
+	CU_ASSERT_EQUAL (0, xmms_playlist_next_entry_in (playlist, XMMS_ACTIVE_PLAYLIST));
+
+	xmms_playlist_retreat_in (playlist, XMMS_ACTIVE_PLAYLIST);
+	CU_ASSERT_EQUAL (first, xmms_playlist_current_entry (playlist));
+
+	property = xmms_config_lookup ("playlist.repeat_all");
+	xmms_config_property_set_data (property, "1");
+
+	CU_ASSERT_TRUE (xmms_playlist_advance (playlist));
+	CU_ASSERT_EQUAL (first, xmms_playlist_next_entry_in (playlist, XMMS_ACTIVE_PLAYLIST));
+	CU_ASSERT_TRUE (xmms_playlist_advance (playlist));
+	CU_ASSERT_EQUAL (first, xmms_playlist_current_entry (playlist));
+
+	xmms_playlist_retreat_in (playlist, XMMS_ACTIVE_PLAYLIST);
+	CU_ASSERT_EQUAL (second, xmms_playlist_current_entry (playlist));
+
+	property = xmms_config_lookup ("playlist.repeat_all");
+	xmms_config_property_set_data (property, "0");
+}
+
 CASE(test_medialib_remove)
 {
 	xmms_medialib_entry_t first, second, entry;
@@ -0,0 +1,166 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include "xcu.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include <xmmspriv/xmms_ringbuf.h>
+
+static gboolean
+count_hotspot (void *arg)
+{
+	(*(gint *) arg)++;
+	return TRUE;
+}
+
+SETUP (ringbuf) {
+	return 0;
+}
+
+CLEANUP () {
+	return 0;
+}
+
+CASE (test_grow_keeps_data)
+{
+	xmms_ringbuf_t *ringbuf;
+	guint8 in[12], out[12];
+	gint i, hits = 0;
+
+	for (i = 0; i < G_N_ELEMENTS (in); i++) {
+		in[i] = i;
+	}
+
+	ringbuf = xmms_ringbuf_new (8);
+
+	/* wrap the indices around the end of the buffer */
+	xmms_ringbuf_write (ringbuf, in, 6);
+	xmms_ringbuf_read (ringbuf, out, 6);
+	xmms_ringbuf_write (ringbuf, in, 4);
+	xmms_ringbuf_hotspot_set (ringbuf, count_hotspot, NULL, &hits);
+	xmms_ringbuf_write (ringbuf, in + 4, 4);
+	CU_ASSERT_EQUAL (0, xmms_ringbuf_bytes_free (ringbuf));
+
+	xmms_ringbuf_resize (ringbuf, 16);
+	CU_ASSERT_EQUAL (16, xmms_ringbuf_size (ringbuf));
+	CU_ASSERT_EQUAL (8, xmms_ringbuf_bytes_used (ringbuf));
+	CU_ASSERT_EQUAL (4, xmms_ringbuf_write (ringbuf, in + 8, 4));
+
+	/* the hotspot still fires after the first four bytes */
+	CU_ASSERT_EQUAL (4, xmms_ringbuf_read (ringbuf, out, G_N_ELEMENTS (out)));
+	CU_ASSERT_EQUAL (0, hits);
+	CU_ASSERT_EQUAL (8, xmms_ringbuf_read (ringbuf, out + 4, 8));
+	CU_ASSERT_EQUAL (1, hits);
+
+	CU_ASSERT_EQUAL (0, memcmp (in, out, G_N_ELEMENTS (in)));
+
+	xmms_ringbuf_destroy (ringbuf);
+}
+
+CASE (test_shrink_keeps_data)
+{
+	xmms_ringbuf_t *ringbuf;
+	guint8 in[16], out[16];
+	gint i;
+
+	for (i = 0; i < G_N_ELEMENTS (in); i++) {
+		in[i] = i;
+	}
+
+	ringbuf = xmms_ringbuf_new (16);
+	CU_ASSERT_EQUAL (12, xmms_ringbuf_write (ringbuf, in, 12));
+
+	xmms_ringbuf_resize (ringbuf, 8);
+	CU_ASSERT_EQUAL (8, xmms_ringbuf_size (ringbuf));
+	CU_ASSERT_EQUAL (0, xmms_ringbuf_bytes_free (ringbuf));
+	CU_ASSERT_EQUAL (0, xmms_ringbuf_write (ringbuf, in, 4));
+
+	CU_ASSERT_EQUAL (6, xmms_ringbuf_read (ringbuf, out, 6));
+	CU_ASSERT_EQUAL (2, xmms_ringbuf_bytes_free (ringbuf));
+	CU_ASSERT_EQUAL (6, xmms_ringbuf_read (ringbuf, out + 6, 16));
+
+	CU_ASSERT_EQUAL (0, memcmp (in, out, 12));
+
+	xmms_ringbuf_destroy (ringbuf);
+}
+
+CASE (test_read_nohotspots)
+{
+	xmms_ringbuf_t *ringbuf;
+	guint8 in[8], out[8];
+	gint i, hits = 0;
+
+	for (i = 0; i < G_N_ELEMENTS (in); i++) {
+		in[i] = i;
+	}
+
+	ringbuf = xmms_ringbuf_new (16);
+	xmms_ringbuf_write (ringbuf, in, 4);
+	xmms_ringbuf_hotspot_set (ringbuf, count_hotspot, NULL, &hits);
+	xmms_ringbuf_write (ringbuf, in + 4, 4);
+
+	CU_ASSERT_EQUAL (4, xmms_ringbuf_hotspots_run (ringbuf));
+	CU_ASSERT_EQUAL (4, xmms_ringbuf_read_nohotspots (ringbuf, out, 8));
+
+	/* stops in front of a due hotspot instead of running it */
+	CU_ASSERT_EQUAL (0, xmms_ringbuf_read_nohotspots (ringbuf, out + 4, 4));
+	CU_ASSERT_EQUAL (0, hits);
+
+	CU_ASSERT_EQUAL (4, xmms_ringbuf_hotspots_run (ringbuf));
+	CU_ASSERT_EQUAL (1, hits);
+	CU_ASSERT_EQUAL (4, xmms_ringbuf_read_nohotspots (ringbuf, out + 4, 4));
+
+	CU_ASSERT_EQUAL (0, memcmp (in, out, G_N_ELEMENTS (in)));
+
+	xmms_ringbuf_destroy (ringbuf);
+}
+
+CASE (test_skip)
+{
+	xmms_ringbuf_t *ringbuf;
+	guint8 in[8], out[8];
+	gint i, hits = 0;
+
+	for (i = 0; i < G_N_ELEMENTS (in); i++) {
+		in[i] = i;
+	}
+
+	ringbuf = xmms_ringbuf_new (16);
+	xmms_ringbuf_write (ringbuf, in, 4);
+	xmms_ringbuf_hotspot_set (ringbuf, count_hotspot, NULL, &hits);
+	xmms_ringbuf_write (ringbuf, in + 4, 4);
+
+	/* refused while a hotspot is pending */
+	CU_ASSERT_FALSE (xmms_ringbuf_skip (ringbuf, 2));
+	CU_ASSERT_EQUAL (4, xmms_ringbuf_read (ringbuf, out, 8));
+	CU_ASSERT_EQUAL (4, xmms_ringbuf_read (ringbuf, out, 8));
+	CU_ASSERT_EQUAL (1, hits);
+
+	xmms_ringbuf_write (ringbuf, in, 8);
+	CU_ASSERT_FALSE (xmms_ringbuf_skip (ringbuf, 9));
+	CU_ASSERT_TRUE (xmms_ringbuf_skip (ringbuf, 5));
+	CU_ASSERT_EQUAL (3, xmms_ringbuf_bytes_used (ringbuf));
+
+	/* a hotspot at the front runs before the remaining data */
+	xmms_ringbuf_hotspot_set_front (ringbuf, count_hotspot, NULL, &hits);
+	CU_ASSERT_EQUAL (3, xmms_ringbuf_read (ringbuf, out, 8));
+	CU_ASSERT_EQUAL (2, hits);
+	CU_ASSERT_EQUAL (0, memcmp (in + 5, out, 3));
+
+	xmms_ringbuf_destroy (ringbuf);
+}
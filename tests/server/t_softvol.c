@@ -0,0 +1,156 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include "xcu.h"
+
+#include <glib.h>
+
+#include <xmmspriv/xmms_softvol.h>
+
+SETUP (softvol) {
+	return 0;
+}
+
+CLEANUP () {
+	return 0;
+}
+
+CASE (test_gain)
+{
+	CU_ASSERT_DOUBLE_EQUAL (0.0, xmms_softvol_gain (0), 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL (0.125, xmms_softvol_gain (50), 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL (1.0, xmms_softvol_gain (100), 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL (1.0, xmms_softvol_gain (150), 0.0001);
+}
+
+CASE (test_unity_s16)
+{
+	xmms_samples16_t buf[20];
+	xmms_softvol_t vol;
+	gint i;
+
+	for (i = 0; i < G_N_ELEMENTS (buf); i++) {
+		buf[i] = i * 1000 - 10000;
+	}
+
+	xmms_softvol_init (&vol, 1.0f);
+	xmms_softvol_apply (&vol, XMMS_SAMPLE_FORMAT_S16, 2, buf, 20);
+
+	for (i = 0; i < G_N_ELEMENTS (buf); i++) {
+		CU_ASSERT_EQUAL (i * 1000 - 10000, buf[i]);
+	}
+}
+
+CASE (test_constant_s16)
+{
+	xmms_samples16_t buf[21];
+	xmms_softvol_t vol;
+	gint i;
+
+	/* long enough for the vector loop and a tail */
+	for (i = 0; i < G_N_ELEMENTS (buf); i++) {
+		buf[i] = (i % 2) ? -20000 : 20000;
+	}
+
+	xmms_softvol_init (&vol, 0.25f);
+	xmms_softvol_apply (&vol, XMMS_SAMPLE_FORMAT_S16, 1, buf, 21);
+
+	for (i = 0; i < G_N_ELEMENTS (buf); i++) {
+		CU_ASSERT_EQUAL ((i % 2) ? -5000 : 5000, buf[i]);
+	}
+}
+
+CASE (test_ramp_float)
+{
+	xmms_samplefloat_t buf[24];
+	xmms_softvol_t vol;
+	gint i;
+
+	for (i = 0; i < G_N_ELEMENTS (buf); i++) {
+		buf[i] = 1.0f;
+	}
+
+	/* 12 stereo frames, ramping down over the first 4 */
+	xmms_softvol_init (&vol, 1.0f);
+	xmms_softvol_set (&vol, 0.5f, 4);
+	xmms_softvol_apply (&vol, XMMS_SAMPLE_FORMAT_FLOAT, 2, buf, 24);
+
+	for (i = 0; i < 4; i++) {
+		CU_ASSERT_DOUBLE_EQUAL (1.0 - 0.125 * (i + 1), buf[2 * i], 0.0001);
+		CU_ASSERT_EQUAL (buf[2 * i], buf[2 * i + 1]);
+	}
+	for (i = 8; i < G_N_ELEMENTS (buf); i++) {
+		CU_ASSERT_DOUBLE_EQUAL (0.5, buf[i], 0.0001);
+	}
+
+	CU_ASSERT_EQUAL (0, vol.ramp);
+}
+
+CASE (test_ramp_across_calls)
+{
+	xmms_samples32_t buf[2] = { 1 << 30, 1 << 30 };
+	xmms_softvol_t vol;
+
+	xmms_softvol_init (&vol, 0.0f);
+	xmms_softvol_set (&vol, 1.0f, 4);
+
+	xmms_softvol_apply (&vol, XMMS_SAMPLE_FORMAT_S32, 1, buf, 2);
+	CU_ASSERT_EQUAL (1 << 28, buf[0]);
+	CU_ASSERT_EQUAL (1 << 29, buf[1]);
+
+	buf[0] = buf[1] = 1 << 30;
+	xmms_softvol_apply (&vol, XMMS_SAMPLE_FORMAT_S32, 1, buf, 2);
+	CU_ASSERT_EQUAL (3 << 28, buf[0]);
+	CU_ASSERT_EQUAL (1 << 30, buf[1]);
+}
+
+CASE (test_unsigned_u8)
+{
+	xmms_sampleu8_t buf[3] = { 0, 128, 255 };
+	xmms_softvol_t vol;
+
+	xmms_softvol_init (&vol, 0.5f);
+	xmms_softvol_apply (&vol, XMMS_SAMPLE_FORMAT_U8, 1, buf, 3);
+
+	CU_ASSERT_EQUAL (64, buf[0]);
+	CU_ASSERT_EQUAL (128, buf[1]);
+	CU_ASSERT_EQUAL (192, buf[2]);
+}
+
+CASE (test_partial_frames)
+{
+	xmms_samples16_t buf[18];
+	xmms_softvol_t vol;
+	gint i;
+
+	for (i = 0; i < G_N_ELEMENTS (buf); i++) {
+		buf[i] = 8000;
+	}
+
+	/* three 6 channel frames, split within the first and second */
+	xmms_softvol_init (&vol, 1.0f);
+	xmms_softvol_set (&vol, 0.25f, 2);
+	xmms_softvol_apply (&vol, XMMS_SAMPLE_FORMAT_S16, 6, buf, 4);
+	xmms_softvol_apply (&vol, XMMS_SAMPLE_FORMAT_S16, 6, buf + 4, 5);
+	xmms_softvol_apply (&vol, XMMS_SAMPLE_FORMAT_S16, 6, buf + 9, 9);
+
+	for (i = 0; i < 6; i++) {
+		CU_ASSERT_EQUAL (5000, buf[i]);
+	}
+	for (i = 6; i < G_N_ELEMENTS (buf); i++) {
+		CU_ASSERT_EQUAL (2000, buf[i]);
+	}
+}
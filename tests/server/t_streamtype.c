@@ -314,3 +314,76 @@ CASE (test_coerce)
 	xmms_object_unref (from);
 	xmms_object_unref (to);
 }
+
+CASE (test_coerce_any_layout)
+{
+	xmms_stream_type_t *typ, *from, *to;
+	GList *list = NULL;
+
+	from = _xmms_stream_type_new ("dummy",
+	                              XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                              XMMS_STREAM_TYPE_FMT_FORMAT, XMMS_SAMPLE_FORMAT_S16,
+	                              XMMS_STREAM_TYPE_FMT_CHANNELS, 6,
+	                              XMMS_STREAM_TYPE_FMT_SAMPLERATE, 48000,
+	                              XMMS_STREAM_TYPE_END);
+
+	/* a goal without channels and samplerate takes any layout */
+	typ = _xmms_stream_type_new ("dummy",
+	                             XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                             XMMS_STREAM_TYPE_FMT_FORMAT, XMMS_SAMPLE_FORMAT_FLOAT,
+	                             XMMS_STREAM_TYPE_END);
+	list = g_list_append (list, typ);
+
+	to = xmms_stream_type_coerce (from, list);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (to);
+
+	CU_ASSERT_EQUAL (XMMS_SAMPLE_FORMAT_FLOAT,
+	                 xmms_stream_type_get_int (to, XMMS_STREAM_TYPE_FMT_FORMAT));
+	CU_ASSERT_EQUAL (48000,
+	                 xmms_stream_type_get_int (to, XMMS_STREAM_TYPE_FMT_SAMPLERATE));
+	CU_ASSERT_EQUAL (6,
+	                 xmms_stream_type_get_int (to, XMMS_STREAM_TYPE_FMT_CHANNELS));
+
+	g_list_foreach (list, destroy_list, NULL);
+	g_list_free (list);
+
+	xmms_object_unref (from);
+	xmms_object_unref (to);
+}
+
+CASE (test_strv_roundtrip)
+{
+	xmms_stream_type_t *st, *copy;
+	gchar **strv;
+
+	st = _xmms_stream_type_new ("dummy",
+	                            XMMS_STREAM_TYPE_URL, "test://*",
+	                            XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                            XMMS_STREAM_TYPE_FMT_CHANNELS, 2,
+	                            XMMS_STREAM_TYPE_PRIORITY, 60,
+	                            XMMS_STREAM_TYPE_END);
+
+	strv = xmms_stream_type_to_strv (st);
+	CU_ASSERT_PTR_NOT_NULL (strv);
+
+	copy = xmms_stream_type_from_strv (strv);
+	CU_ASSERT_PTR_NOT_NULL (copy);
+	g_strfreev (strv);
+
+	CU_ASSERT_STRING_EQUAL ("dummy",
+	                        xmms_stream_type_get_str (copy, XMMS_STREAM_TYPE_NAME));
+	CU_ASSERT_STRING_EQUAL ("test://*",
+	                        xmms_stream_type_get_str (copy, XMMS_STREAM_TYPE_URL));
+	CU_ASSERT_STRING_EQUAL ("audio/pcm",
+	                        xmms_stream_type_get_str (copy, XMMS_STREAM_TYPE_MIMETYPE));
+	CU_ASSERT_EQUAL (2, xmms_stream_type_get_int (copy, XMMS_STREAM_TYPE_FMT_CHANNELS));
+	CU_ASSERT_EQUAL (60, xmms_stream_type_get_int (copy, XMMS_STREAM_TYPE_PRIORITY));
+	CU_ASSERT_TRUE (xmms_stream_type_match (copy, st));
+
+	xmms_object_unref (st);
+	xmms_object_unref (copy);
+
+	strv = g_strsplit ("dummy;50;12345;x", ";", -1);
+	CU_ASSERT_PTR_NULL (xmms_stream_type_from_strv (strv));
+	g_strfreev (strv);
+}
@@ -286,3 +286,202 @@ CASE(test_browse)
 	CU_ASSERT_BROWSE_ENTRY (result, 5, "file:///Last_Directory", 1, 0);
 	xmmsv_unref (result);
 }
+
+static gboolean
+xmms_plan_test_xform_init (xmms_xform_t *xform)
+{
+	xmms_xform_outdata_type_add (xform, XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm", XMMS_STREAM_TYPE_END);
+	return TRUE;
+}
+
+static gboolean
+xmms_plan_test_xform_plugin_setup (xmms_xform_plugin_t *xform_plugin)
+{
+	xmms_xform_methods_t methods;
+
+	XMMS_XFORM_METHODS_INIT (methods);
+
+	methods.init = xmms_plan_test_xform_init;
+
+	xmms_xform_plugin_methods_set (xform_plugin, &methods);
+
+	xmms_xform_plugin_indata_add (xform_plugin,
+	                              XMMS_STREAM_TYPE_MIMETYPE, "application/x-url",
+	                              XMMS_STREAM_TYPE_URL, "plantest://*",
+	                              XMMS_STREAM_TYPE_END);
+
+	return TRUE;
+}
+
+XMMS_XFORM_BUILTIN_DEFINE (plan_test_xform,
+                           "plan test xform",
+                           XMMS_VERSION,
+                           "plan test xform",
+                           xmms_plan_test_xform_plugin_setup);
+
+CASE(test_xform_plan_cache)
+{
+	xmms_medialib_session_t *session;
+	xmms_stream_type_t *format;
+	xmms_xform_t *xform;
+	GList *goal_format;
+	gint64 hits, misses, hits_before, misses_before;
+
+	format = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+	                                XMMS_STREAM_TYPE_MIMETYPE,
+	                                "audio/pcm",
+	                                XMMS_STREAM_TYPE_END);
+	goal_format = g_list_prepend (NULL, format);
+
+	/* loading a plugin flushes the cache, so the first lookup misses */
+	xmms_plugin_load (&xmms_builtin_plan_test_xform, NULL);
+	xmms_xform_plan_cache_stats (&hits_before, &misses_before);
+
+	session = xmms_medialib_session_begin (medialib);
+	xform = xmms_xform_chain_setup_url_session (medialib, session, 1,
+	                                            "plantest://first", goal_format,
+	                                            TRUE);
+	CU_ASSERT_PTR_NOT_NULL (xform);
+	xmms_object_unref (xform);
+
+	xmms_xform_plan_cache_stats (&hits, &misses);
+	CU_ASSERT_EQUAL (hits_before, hits);
+	CU_ASSERT_EQUAL (misses_before + 1, misses);
+
+	/* same scheme, different location: answered from the cache */
+	xform = xmms_xform_chain_setup_url_session (medialib, session, 1,
+	                                            "plantest://second", goal_format,
+	                                            TRUE);
+	CU_ASSERT_PTR_NOT_NULL (xform);
+	xmms_object_unref (xform);
+	xmms_medialib_session_abort (session);
+
+	xmms_xform_plan_cache_stats (&hits, &misses);
+	CU_ASSERT_EQUAL (hits_before + 1, hits);
+	CU_ASSERT_EQUAL (misses_before + 1, misses);
+
+	g_list_free (goal_format);
+	xmms_object_unref (format);
+}
+
+static gboolean
+xmms_conversion_test_xform_init (xmms_xform_t *xform)
+{
+	xmms_xform_outdata_type_add (xform,
+	                             XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                             XMMS_STREAM_TYPE_FMT_FORMAT, XMMS_SAMPLE_FORMAT_S16,
+	                             XMMS_STREAM_TYPE_FMT_CHANNELS, 2,
+	                             XMMS_STREAM_TYPE_FMT_SAMPLERATE, 44100,
+	                             XMMS_STREAM_TYPE_END);
+	return TRUE;
+}
+
+static gboolean
+xmms_conversion_test_xform_plugin_setup (xmms_xform_plugin_t *xform_plugin)
+{
+	xmms_xform_methods_t methods;
+
+	XMMS_XFORM_METHODS_INIT (methods);
+
+	methods.init = xmms_conversion_test_xform_init;
+
+	xmms_xform_plugin_methods_set (xform_plugin, &methods);
+
+	xmms_xform_plugin_indata_add (xform_plugin,
+	                              XMMS_STREAM_TYPE_MIMETYPE, "application/x-url",
+	                              XMMS_STREAM_TYPE_URL, "conversiontest://*",
+	                              XMMS_STREAM_TYPE_END);
+
+	return TRUE;
+}
+
+XMMS_XFORM_BUILTIN_DEFINE (conversion_test_xform,
+                           "conversion test xform",
+                           XMMS_VERSION,
+                           "conversion test xform",
+                           xmms_conversion_test_xform_plugin_setup);
+
+static xmms_xform_t *
+conversion_test_chain (xmms_sample_format_t goal)
+{
+	xmms_medialib_session_t *session;
+	xmms_stream_type_t *format;
+	xmms_xform_t *xform;
+	GList *goal_format;
+
+	format = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+	                                XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                                XMMS_STREAM_TYPE_FMT_FORMAT, goal,
+	                                XMMS_STREAM_TYPE_FMT_CHANNELS, 2,
+	                                XMMS_STREAM_TYPE_FMT_SAMPLERATE, 44100,
+	                                XMMS_STREAM_TYPE_END);
+	goal_format = g_list_prepend (NULL, format);
+
+	session = xmms_medialib_session_begin (medialib);
+	xform = xmms_xform_chain_setup_url_session (medialib, session, 1,
+	                                            "conversiontest://", goal_format,
+	                                            TRUE);
+	xmms_medialib_session_abort (session);
+
+	g_list_free (goal_format);
+	xmms_object_unref (format);
+
+	return xform;
+}
+
+CASE(test_xform_chain_conversions)
+{
+	extern const xmms_plugin_desc_t xmms_builtin_converter;
+	xmms_xform_t *xform;
+
+	xmms_plugin_load (&xmms_builtin_conversion_test_xform, NULL);
+	xmms_plugin_load (&xmms_builtin_converter, NULL);
+
+	xform = conversion_test_chain (XMMS_SAMPLE_FORMAT_S16);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (xform);
+	CU_ASSERT_EQUAL (0, xmms_xform_chain_conversions (xform));
+	xmms_object_unref (xform);
+
+	xform = conversion_test_chain (XMMS_SAMPLE_FORMAT_FLOAT);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (xform);
+	CU_ASSERT_EQUAL (XMMS_SAMPLE_FORMAT_FLOAT,
+	                 xmms_xform_outtype_get_int (xform, XMMS_STREAM_TYPE_FMT_FORMAT));
+	CU_ASSERT_EQUAL (1, xmms_xform_chain_conversions (xform));
+	xmms_object_unref (xform);
+}
+
+CASE(test_magic_identify)
+{
+	const gchar a[] = "XMTA and some more";
+	const gchar b[] = "\xfe\x12\x34\x56";
+	const gchar c[] = "\x00\x01\x02\x03\x04\x05\x06\x07XMTC";
+	const gchar d[] = "XmTd\x01";
+	const gchar not_d[] = "XMTD\x02";
+
+	CU_ASSERT_TRUE (xmms_magic_add ("magic test a", "application/x-magictest-a",
+	                                "0 string XMTA", NULL));
+	CU_ASSERT_TRUE (xmms_magic_add ("magic test b", "application/x-magictest-b",
+	                                "0 belong 0xfe123456", NULL));
+	CU_ASSERT_TRUE (xmms_magic_add ("magic test c", "application/x-magictest-c",
+	                                "8 string XMTC", NULL));
+	CU_ASSERT_TRUE (xmms_magic_add ("magic test d", "application/x-magictest-d",
+	                                "0 string/c xmtd", ">4 byte 0x01", NULL));
+	CU_ASSERT_TRUE (xmms_magic_extension_add ("application/x-magictest-e",
+	                                          "*.xmte"));
+
+	CU_ASSERT_STRING_EQUAL ("application/x-magictest-a",
+	                        xmms_magic_identify (a, sizeof (a) - 1, NULL));
+	CU_ASSERT_STRING_EQUAL ("application/x-magictest-b",
+	                        xmms_magic_identify (b, sizeof (b) - 1, NULL));
+	CU_ASSERT_STRING_EQUAL ("application/x-magictest-c",
+	                        xmms_magic_identify (c, sizeof (c) - 1, NULL));
+	CU_ASSERT_STRING_EQUAL ("application/x-magictest-d",
+	                        xmms_magic_identify (d, sizeof (d) - 1, NULL));
+
+	/* second level doesn't match, and data that is too short */
+	CU_ASSERT_PTR_NULL (xmms_magic_identify (not_d, sizeof (not_d) - 1, NULL));
+	CU_ASSERT_PTR_NULL (xmms_magic_identify (a, 3, NULL));
+
+	CU_ASSERT_STRING_EQUAL ("application/x-magictest-e",
+	                        xmms_magic_identify (a, 3, "file:///tmp/Test.XMTE"));
+}
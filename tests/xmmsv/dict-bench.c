@@ -0,0 +1,113 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2023 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Builds, serializes and deserializes a list of dicts shaped like a
+ * medialib query result, printing the time spent in each step.
+ *
+ * Usage: dict-bench [rows]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <xmmsc/xmmsv.h>
+
+static double
+now (void)
+{
+	struct timeval tv;
+
+	gettimeofday (&tv, NULL);
+
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static xmmsv_t *
+build_result (int rows)
+{
+	xmmsv_t *result, *row;
+	char buf[32];
+	int i;
+
+	result = xmmsv_new_list ();
+
+	for (i = 0; i < rows; i++) {
+		snprintf (buf, sizeof (buf), "Title %d", i);
+
+		row = xmmsv_build_dict (
+			XMMSV_DICT_ENTRY_INT ("id", i + 1),
+			XMMSV_DICT_ENTRY_STR ("artist", "Vibrasphere"),
+			XMMSV_DICT_ENTRY_STR ("album", "Lungs of the Earth"),
+			XMMSV_DICT_ENTRY_STR ("title", buf),
+			XMMSV_DICT_ENTRY_INT ("tracknr", i % 12 + 1),
+			XMMSV_DICT_ENTRY_INT ("duration", 300000 + i % 1000),
+			XMMSV_DICT_ENTRY_STR ("url", "file:///music/track.flac"),
+			XMMSV_DICT_END);
+
+		xmmsv_list_append (result, row);
+		xmmsv_unref (row);
+	}
+
+	return result;
+}
+
+int
+main (int argc, char **argv)
+{
+	xmmsv_t *result, *bin, *copy;
+	const unsigned char *data;
+	unsigned int length;
+	double t0, build, serialize, deserialize, view;
+	int rows = 1000000;
+
+	if (argc > 1) {
+		rows = atoi (argv[1]);
+	}
+
+	t0 = now ();
+	result = build_result (rows);
+	build = now () - t0;
+
+	t0 = now ();
+	bin = xmmsv_serialize (result);
+	serialize = now () - t0;
+
+	xmmsv_unref (result);
+
+	t0 = now ();
+	copy = xmmsv_deserialize (bin);
+	xmmsv_unref (copy);
+	deserialize = now () - t0;
+
+	t0 = now ();
+	copy = xmmsv_deserialize_view (bin);
+	xmmsv_unref (copy);
+	view = now () - t0;
+
+	xmmsv_get_bin (bin, &data, &length);
+
+	printf ("rows:             %d\n", rows);
+	printf ("serialized size:  %u bytes\n", length);
+	printf ("build:            %.3f s\n", build);
+	printf ("serialize:        %.3f s\n", serialize);
+	printf ("deserialize:      %.3f s\n", deserialize);
+	printf ("deserialize view: %.3f s\n", view);
+
+	xmmsv_unref (bin);
+
+	return EXIT_SUCCESS;
+}
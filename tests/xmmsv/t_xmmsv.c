@@ -1174,3 +1174,38 @@ CASE (test_xmmsv_deep_copy_collection)
 	xmmsv_unref (u);
 	xmmsv_unref (copy);
 }
+
+CASE (test_xmmsv_alloc_stats)
+{
+	int64_t live, before, allocations, hits;
+	xmmsv_t *values[8];
+	int i;
+
+	xmmsv_alloc_stats_get (&before, &allocations, &hits);
+	if (allocations == 0) {
+		/* allocator statistics not compiled in */
+		return;
+	}
+
+	for (i = 0; i < 8; i++) {
+		values[i] = xmmsv_new_string ("a short string");
+	}
+
+	/* one value header and one string each */
+	xmmsv_alloc_stats_get (&live, NULL, NULL);
+	CU_ASSERT_EQUAL (live, before + 16);
+
+	for (i = 0; i < 8; i++) {
+		xmmsv_unref (values[i]);
+	}
+
+	xmmsv_alloc_stats_get (&live, NULL, NULL);
+	CU_ASSERT_EQUAL (live, before);
+
+	/* freed chunks are reused */
+	xmmsv_alloc_stats_get (NULL, NULL, &before);
+	values[0] = xmmsv_new_int (42);
+	xmmsv_alloc_stats_get (NULL, NULL, &hits);
+	CU_ASSERT_EQUAL (hits, before + 1);
+	xmmsv_unref (values[0]);
+}
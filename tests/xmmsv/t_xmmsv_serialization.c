@@ -617,3 +617,47 @@ CASE (test_xmmsv_serialize_dict)
 
 	xmmsv_unref (value);
 }
+
+CASE (test_xmmsv_deserialize_view)
+{
+	xmmsv_t *bin, *value, *item, *copy;
+	const unsigned char *data, *bdata;
+	unsigned int length, blength;
+	const char *s;
+
+	value = xmmsv_build_dict (
+		XMMSV_DICT_ENTRY_STR ("artist", "Vibrasphere"),
+		XMMSV_DICT_ENTRY ("picture", xmmsv_new_bin ((const unsigned char *) "\x01\x02\x03", 3)),
+		XMMSV_DICT_END);
+
+	bin = xmmsv_serialize (value);
+	xmmsv_unref (value);
+
+	CU_ASSERT_PTR_NOT_NULL (bin);
+	CU_ASSERT_TRUE (xmmsv_get_bin (bin, &data, &length));
+
+	value = xmmsv_deserialize_view (bin);
+	CU_ASSERT_PTR_NOT_NULL (value);
+
+	/* the serialized value is kept alive by the views into it */
+	xmmsv_unref (bin);
+
+	CU_ASSERT_TRUE (xmmsv_dict_entry_get_string (value, "artist", &s));
+	CU_ASSERT_STRING_EQUAL (s, "Vibrasphere");
+	CU_ASSERT_TRUE ((const unsigned char *) s > data && (const unsigned char *) s < data + length);
+
+	CU_ASSERT_TRUE (xmmsv_dict_get (value, "picture", &item));
+	CU_ASSERT_TRUE (xmmsv_get_bin (item, &bdata, &blength));
+	CU_ASSERT_EQUAL (blength, 3);
+	CU_ASSERT_EQUAL (memcmp (bdata, "\x01\x02\x03", 3), 0);
+	CU_ASSERT_TRUE (bdata > data && bdata < data + length);
+
+	/* copies own their data */
+	copy = xmmsv_copy (value);
+	xmmsv_unref (value);
+
+	CU_ASSERT_TRUE (xmmsv_dict_entry_get_string (copy, "artist", &s));
+	CU_ASSERT_STRING_EQUAL (s, "Vibrasphere");
+
+	xmmsv_unref (copy);
+}